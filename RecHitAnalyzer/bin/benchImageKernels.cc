@@ -0,0 +1,618 @@
+//
+// Standalone benchmark of the image fill kernels
+//
+// Replays synthetic rechit/track events through the kernels in
+// ImageKernels.h and reports, per kernel, the time per event
+// (mean, p50, p99) and the heap allocations per event. No cmsRun,
+// geometry or conditions are needed: an approximate ideal geometry
+// is generated for the EE crystals and HE towers.
+//
+// Usage:
+//   benchImageKernels [--events N] [--warmup N] [--occupancy F]
+//                     [--pileup N] [--seed N] [--geometry FILE] [--checksum]
+//
+// --geometry takes the calorimeter cells from a GeometrySnapshot file
+// (GeometrySnapshotDumper) instead: EB crystal centers and boxes, EE
+// crystal centers and the HBHE cells and their boxes, so the remaps
+// and projections run over the real cell shapes. The snapshot has no
+// EE DetIds: the EE image pixel of a crystal is binned from its
+// position on the ideal grid.
+//
+// --occupancy sets the fraction of calorimeter cells with a noise
+// hit at zero pileup; --pileup scales the noise occupancy and the
+// number of tracks. --checksum prints a hash of all output images,
+// useful to check that a kernel change leaves the images unchanged.
+//
+// The "taujet lists" rows fill per-jet constituent lists shaped like
+// the taujet outputs, once as flattened JaggedArrays (as the analyzer
+// does) and once as the former vector<vector> branches, to show the
+// allocator churn of the nested layout.
+//
+// The "ECALatHCAL remap" row projects the EB hits onto the HBHE
+// towers through the area-overlap SparseRemap of fillECALatHCAL.
+// The "pyramid" row makes ECAL_energy at HCAL granularity (5x5 sum)
+// and HBHE_energy at EB granularity (5x5 upsampling).
+// The "TRK hit transforms" row localises ~12 tracker hits per track
+// through the TrackerTransforms table of getTRKhits, for 16000
+// modules at random placements.
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/GeometrySnapshot.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/JaggedArray.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/SparseRemap.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/TrackerTransforms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Allocation counting ____________________________________________________//
+static std::atomic<long> nAllocs(0);
+static std::atomic<long> nAllocBytes(0);
+
+void* operator new ( std::size_t size ) {
+  nAllocs++;
+  nAllocBytes += size;
+  void* p = std::malloc( size ? size : 1 );
+  if ( !p ) throw std::bad_alloc();
+  return p;
+}
+void* operator new[] ( std::size_t size ) { return operator new( size ); }
+void operator delete ( void* p ) noexcept { std::free( p ); }
+void operator delete[] ( void* p ) noexcept { std::free( p ); }
+void operator delete ( void* p, std::size_t ) noexcept { std::free( p ); }
+void operator delete[] ( void* p, std::size_t ) noexcept { std::free( p ); }
+
+static const double PI = 3.14159265358979323846;
+
+static float wrapPhi ( double phi ) {
+  while ( phi >= PI ) phi -= 2*PI;
+  while ( phi < -PI ) phi += 2*PI;
+  return phi;
+}
+
+// Approximate ideal geometry, or the cells of a snapshot ________________//
+struct BenchGeometry {
+
+  const img::GeometrySnapshot* snapshot; // nullptr: ideal geometry
+  std::vector<img::EECell> eeCells;
+  std::vector<img::HBHETower> heTowers; // energy unused
+  std::vector<img::HBHEHit> hbheCells;  // all (ieta,iphi,depth), energy unused
+  std::vector<int> heTowerIdx;          // hbheCells -> heTowers, -1 if |ieta| <= 17
+  img::TrackerTransforms tkModules;
+  std::vector<unsigned int> tkRawIds;   // in insertion order
+
+  BenchGeometry ( const img::GeometrySnapshot* snapshot_ = nullptr ): snapshot( snapshot_ ) {
+    if ( snapshot ) {
+      fillFromSnapshot();
+    } else {
+      fillIdeal();
+    }
+    fillTracker();
+  }
+
+  void fillIdeal () {
+
+    // EE: 100x100 grid of 2.862 cm crystals at |z| = 317 cm, kept within 1.479 < |eta| < 3
+    for ( int iz = 0; iz < 2; iz++ ) {
+      for ( int iy = 0; iy < img::EE_MAX_IY; iy++ ) {
+        for ( int ix = 0; ix < img::EE_MAX_IX; ix++ ) {
+          double x = ( ix-49.5 )*2.862;
+          double y = ( iy-49.5 )*2.862;
+          double eta = std::asinh( 317./std::sqrt( x*x+y*y ) );
+          if ( eta < 1.479 || eta > 3. ) continue;
+          eeCells.push_back( img::EECell{ float( iz > 0 ? eta : -eta ), float( std::atan2( y, x ) ), ix, iy, iz } );
+        }
+      }
+    }
+
+    // HBHE: 5 deg towers starting at phi = 0, 10 deg (odd iphi only) beyond ieta 20
+    for ( int ieta = -img::HBHE_IETA_MAX_HE; ieta <= img::HBHE_IETA_MAX_HE; ieta++ ) {
+      if ( ieta == 0 ) continue;
+      int ietaAbs = std::abs( ieta );
+      int nDepth = ietaAbs <= 16 ? 1 : ( ietaAbs <= 26 ? 2 : 3 );
+      double etaLo = ietaAbs == img::HBHE_IETA_MAX_HE ? 2.9 : img::eta_bins_HBHE[img::HBHE_IETA_MAX_HE-1+ietaAbs-1];
+      double etaHi = ietaAbs == img::HBHE_IETA_MAX_HE ? 3.0 : img::eta_bins_HBHE[img::HBHE_IETA_MAX_HE-1+ietaAbs];
+      for ( int iphi = 1; iphi <= img::HBHE_IPHI_NUM; iphi++ ) {
+        bool isCoarse = ietaAbs > img::HBHE_IETA_MAX_FINE;
+        if ( isCoarse && iphi%2 == 0 ) continue;
+        int tower = -1;
+        if ( ietaAbs > img::HBHE_IETA_MAX_EB ) {
+          double phiLo = ( iphi-1 )*5.*PI/180.;
+          double phiHi = ( iphi-1 + ( isCoarse ? 2 : 1 ) )*5.*PI/180.;
+          tower = heTowers.size();
+          heTowers.push_back( img::HBHETower{ float( ieta > 0 ? etaLo : -etaHi ), float( ieta > 0 ? etaHi : -etaLo ),
+                                              wrapPhi( phiLo ), wrapPhi( phiHi ), 0. } );
+        }
+        for ( int depth = 1; depth <= nDepth; depth++ ) {
+          hbheCells.push_back( img::HBHEHit{ ieta, iphi, depth, 0. } );
+          heTowerIdx.push_back( tower );
+        }
+      }
+    }
+
+  }
+
+  void fillTracker () {
+
+    // Tracker: modules facing the beam line at random phi, rho and z,
+    // DetIds scattered so that the insertion order is not sorted
+    std::mt19937 rng( 1 );
+    std::uniform_real_distribution<double> uniform( 0., 1. );
+    for ( int i = 0; i < 16000; i++ ) {
+      double phi = uniform( rng )*2*PI-PI, rho = 3.+uniform( rng )*105., z = uniform( rng )*560.-280.;
+      double c = std::cos( phi ), s = std::sin( phi );
+      img::TrackerTransforms::Module module = {
+        { float( -s ), 0.f, float( c ),
+          float( c ),  0.f, float( s ),
+          0.f,         1.f, 0.f },
+        { float( rho*c ), float( rho*s ), float( z ) },
+        1 + i%6,
+        i%29
+      };
+      unsigned int rawId = ( 1u << 28 ) | ( ( i*7919u )%( 1u << 20 ) );
+      tkModules.add( rawId, module );
+      tkRawIds.push_back( rawId );
+    }
+    tkModules.finalize();
+
+  }
+
+  void fillFromSnapshot () {
+
+    // EE: crystal centers, pixel binned on the 2.862 cm grid at |z| = 317 cm
+    for ( const img::GeometrySnapshot::Point& p : snapshot->eeCenter ) {
+      if ( p.z == 0. ) continue;
+      double u = p.x*317./std::abs( p.z ), v = p.y*317./std::abs( p.z );
+      int ix = std::min( std::max( int( std::floor( u/2.862+50. ) ), 0 ), img::EE_MAX_IX-1 );
+      int iy = std::min( std::max( int( std::floor( v/2.862+50. ) ), 0 ), img::EE_MAX_IY-1 );
+      double eta = std::asinh( p.z/std::sqrt( p.x*p.x+p.y*p.y ) );
+      eeCells.push_back( img::EECell{ float( eta ), float( std::atan2( p.y, p.x ) ), ix, iy, p.z > 0. ? 1 : 0 } );
+    }
+
+    // HBHE: all cells, those beyond EB with their own box
+    for ( int ieta = -img::HBHE_IETA_MAX_HE; ieta <= img::HBHE_IETA_MAX_HE; ieta++ ) {
+      if ( ieta == 0 ) continue;
+      for ( int iphi = 1; iphi <= img::HBHE_IPHI_NUM; iphi++ ) {
+        for ( int depth = 1; depth <= img::GeometrySnapshot::HBHE_DEPTH_NUM; depth++ ) {
+          int idx = img::GeometrySnapshot::hbheIndex( ieta, iphi, depth );
+          if ( snapshot->hbheSubdet[idx] == 0 ) continue;
+          int tower = -1;
+          if ( std::abs( ieta ) > img::HBHE_IETA_MAX_EB ) {
+            const img::GeometrySnapshot::EtaPhiBox& box = snapshot->hbheBox[idx];
+            tower = heTowers.size();
+            heTowers.push_back( img::HBHETower{ box.minEta, box.maxEta, box.minPhi, box.maxPhi, 0. } );
+          }
+          hbheCells.push_back( img::HBHEHit{ ieta, iphi, depth, 0. } );
+          heTowerIdx.push_back( tower );
+        }
+      }
+    }
+
+  }
+
+  // Crystal center eta of EB (ieta,iphi). EB iphi = 1 is centered at phi = -9.5 deg.
+  float ebEta ( int ieta, int iphi ) const {
+    if ( snapshot ) {
+      const img::GeometrySnapshot::Point& p = snapshot->ebCenter[ img::ebIndex( ieta, iphi ) ];
+      return std::asinh( p.z/std::sqrt( p.x*p.x+p.y*p.y ) );
+    }
+    return ( ieta > 0 ? ieta-0.5 : ieta+0.5 )*0.0174;
+  }
+
+  // (eta,phi) extent of EB (ieta,iphi)
+  img::CellBox ebBox ( int ieta, int iphi ) const {
+    if ( snapshot ) {
+      const img::GeometrySnapshot::EtaPhiBox& box = snapshot->ebBox[ img::ebIndex( ieta, iphi ) ];
+      return img::CellBox{ box.minEta, box.maxEta, box.minPhi, box.maxPhi };
+    }
+    float etaLo = ( std::abs( ieta )-1 )*0.0174, etaHi = std::abs( ieta )*0.0174;
+    float phiLo = wrapPhi( ( iphi-11 )*PI/180. ), phiHi = wrapPhi( ( iphi-10 )*PI/180. );
+    return ieta > 0 ? img::CellBox{ etaLo, etaHi, phiLo, phiHi } : img::CellBox{ -etaHi, -etaLo, phiLo, phiHi };
+  }
+
+  // EB crystal containing (eta,phi)
+  void ebCell ( float eta, float phi, int& ieta, int& iphi ) const {
+    int idx = snapshot ? snapshot->findEB( eta, phi ) : -1;
+    if ( idx >= 0 ) {
+      ieta = idx/img::EB_IPHI_MAX - img::EB_IETA_MAX;
+      ieta = ieta >= 0 ? ieta+1 : ieta;
+      iphi = idx%img::EB_IPHI_MAX + 1;
+      return;
+    }
+    int ietaAbs = std::min( int( std::abs( eta )/0.0174 )+1, img::EB_IETA_MAX );
+    ieta = eta > 0 ? ietaAbs : -ietaAbs;
+    iphi = int( std::floor( phi*180./PI ) ) + 11;
+    iphi = iphi > img::EB_IPHI_MAX ? iphi-img::EB_IPHI_MAX : iphi;
+    iphi = iphi < 1 ? iphi+img::EB_IPHI_MAX : iphi;
+  }
+
+};
+
+// Synthetic events _______________________________________________________//
+struct SyntheticEvent {
+  std::vector<img::EBHit> ebHits;
+  std::vector<img::EtaPhiHit> eeHits;
+  std::vector<img::HBHEHit> hbheHits;
+  std::vector<img::HBHETower> heTowers;
+  std::vector<img::TrackAtECAL> tracks;
+  int seedIeta[2];
+  int seedIphi[2];
+  std::vector<int> jetNCharged; // tau jet constituents
+  std::vector<int> jetNNeutral;
+  std::vector<unsigned int> trkHitIds; // tracker hits: module DetId and local position
+  std::vector<float> trkHitLx;
+  std::vector<float> trkHitLy;
+};
+
+class EventGenerator {
+
+  public:
+    EventGenerator ( const BenchGeometry& geom, double occupancy, double pileup, unsigned seed ):
+      geom_( geom ), occupancy_( occupancy*( 1.+pileup/50. ) ), pileup_( pileup ), rng_( seed ), trkRng_( seed+1 ) {}
+
+    void generate ( SyntheticEvent& evt ) {
+
+      std::uniform_real_distribution<double> uniform( 0., 1. );
+      std::exponential_distribution<double> noiseE( 1./0.3 );
+      std::exponential_distribution<double> clusterE( 1./20. );
+
+      // EB: noise hits + one shower around each seed
+      evt.ebHits.clear();
+      int nEB = int( occupancy_*img::EB_NCELLS );
+      for ( int i = 0; i < nEB; i++ ) {
+        int idx = int( uniform( rng_ )*img::EB_NCELLS );
+        int ieta = idx/img::EB_IPHI_MAX - img::EB_IETA_MAX;
+        ieta = ieta >= 0 ? ieta+1 : ieta;
+        int iphi = idx%img::EB_IPHI_MAX + 1;
+        evt.ebHits.push_back( img::EBHit{ ieta, iphi, float( noiseE( rng_ ) ), float( uniform( rng_ )*10.-5. ), geom_.ebEta( ieta, iphi ) } );
+      }
+      for ( int iP = 0; iP < 2; iP++ ) {
+        evt.seedIeta[iP] = 15 + int( uniform( rng_ )*139 ); // [15,153]
+        evt.seedIphi[iP] = int( uniform( rng_ )*img::EB_IPHI_MAX );
+        double eSeed = 20. + clusterE( rng_ );
+        for ( int deta = -2; deta <= 2; deta++ ) {
+          for ( int dphi = -2; dphi <= 2; dphi++ ) {
+            int ieta = evt.seedIeta[iP] + deta - img::EB_IETA_MAX;
+            ieta = ieta >= 0 ? ieta+1 : ieta;
+            int iphi = ( evt.seedIphi[iP] + dphi + img::EB_IPHI_MAX )%img::EB_IPHI_MAX + 1;
+            float energy = eSeed*std::exp( -std::abs(deta) - std::abs(dphi) );
+            evt.ebHits.push_back( img::EBHit{ ieta, iphi, energy, 0., geom_.ebEta( ieta, iphi ) } );
+          }
+        }
+      }
+
+      // EE: noise hits
+      evt.eeHits.clear();
+      int nEE = int( occupancy_*geom_.eeCells.size() );
+      for ( int i = 0; i < nEE; i++ ) {
+        const img::EECell& cell = geom_.eeCells[ int( uniform( rng_ )*geom_.eeCells.size() ) ];
+        evt.eeHits.push_back( img::EtaPhiHit{ cell.iz, cell.eta, cell.phi, float( noiseE( rng_ ) ) } );
+      }
+
+      // HBHE: noise hits, towers beyond EB also kept by their corners
+      evt.hbheHits.clear();
+      evt.heTowers.clear();
+      int nHBHE = int( occupancy_*geom_.hbheCells.size() );
+      for ( int i = 0; i < nHBHE; i++ ) {
+        int iC = int( uniform( rng_ )*geom_.hbheCells.size() );
+        img::HBHEHit hit = geom_.hbheCells[iC];
+        hit.energy = noiseE( rng_ );
+        evt.hbheHits.push_back( hit );
+        if ( geom_.heTowerIdx[iC] < 0 ) continue;
+        img::HBHETower tower = geom_.heTowers[ geom_.heTowerIdx[iC] ];
+        tower.energy = hit.energy;
+        evt.heTowers.push_back( tower );
+      }
+
+      // Tracks: 20 from the hard scatter + 25 per pileup vertex
+      std::normal_distribution<double> z0PV( 0., 0.02 ), z0PU( 0., 5. ), d0( 0., 0.01 );
+      evt.tracks.clear();
+      int nTrk = 20 + int( 25*pileup_ );
+      for ( int i = 0; i < nTrk; i++ ) {
+        img::TrackAtECAL trk;
+        trk.eta = uniform( rng_ )*6.-3.;
+        trk.phi = uniform( rng_ )*2*PI-PI;
+        trk.pt = 0.5/( 1.-0.95*uniform( rng_ ) );
+        trk.qpt = uniform( rng_ ) > 0.5 ? trk.pt : -trk.pt;
+        trk.d0 = d0( rng_ );
+        trk.z0 = i < 20 ? z0PV( rng_ ) : z0PU( rng_ );
+        trk.d0sig = trk.d0/0.01;
+        trk.z0sig = trk.z0/0.02;
+        trk.isEB = std::abs( trk.eta ) < 1.479;
+        trk.iz = trk.eta > 0. ? 1 : 0;
+        geom_.ebCell( trk.eta, trk.phi, trk.ieta, trk.iphi );
+        evt.tracks.push_back( trk );
+      }
+
+      // Tracker hits: 12 per track on random modules. Own generator,
+      // so that the calorimeter hits do not depend on them.
+      evt.trkHitIds.clear();
+      evt.trkHitLx.clear();
+      evt.trkHitLy.clear();
+      for ( int i = 0; i < 12*nTrk; i++ ) {
+        evt.trkHitIds.push_back( geom_.tkRawIds[ int( uniform( trkRng_ )*geom_.tkRawIds.size() ) ] );
+        evt.trkHitLx.push_back( uniform( trkRng_ )*10.-5. );
+        evt.trkHitLy.push_back( uniform( trkRng_ )*10.-5. );
+      }
+
+      // Tau jets: 1-4 jets of 1 or 3 prongs and 0-3 pi0s
+      evt.jetNCharged.clear();
+      evt.jetNNeutral.clear();
+      int nJet = 1 + int( uniform( rng_ )*4 );
+      for ( int i = 0; i < nJet; i++ ) {
+        evt.jetNCharged.push_back( uniform( rng_ ) < 0.7 ? 1 : 3 );
+        evt.jetNNeutral.push_back( int( uniform( rng_ )*4 ) );
+      }
+
+    }
+
+  private:
+    const BenchGeometry& geom_;
+    double occupancy_;
+    double pileup_;
+    std::mt19937 rng_;
+    std::mt19937 trkRng_;
+
+};
+
+// Timing _________________________________________________________________//
+struct KernelStats {
+  std::string name;
+  std::vector<double> ns;
+  long allocs = 0;
+  long bytes = 0;
+};
+
+template<class F>
+void timeKernel ( KernelStats& stats, bool record, F kernel ) {
+  long allocs0 = nAllocs, bytes0 = nAllocBytes;
+  auto t0 = std::chrono::steady_clock::now();
+  kernel();
+  auto t1 = std::chrono::steady_clock::now();
+  if ( !record ) return;
+  stats.ns.push_back( std::chrono::duration<double, std::nano>( t1-t0 ).count() );
+  stats.allocs += nAllocs - allocs0;
+  stats.bytes += nAllocBytes - bytes0;
+}
+
+static double percentile ( std::vector<double> v, double q ) {
+  if ( v.empty() ) return 0.;
+  std::sort( v.begin(), v.end() );
+  return v[ std::min( v.size()-1, size_t( q*v.size() ) ) ];
+}
+
+// FNV-1a over the image bytes
+template<class T>
+static void hashImage ( uint64_t& h, const std::vector<T>& v ) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>( v.data() );
+  for ( size_t i = 0; i < v.size()*sizeof(T); i++ ) { h ^= p[i]; h *= 1099511628211ULL; }
+}
+
+// Per-jet constituent lists as in fillEvtSel_jet_taujet ________________//
+static const int nTauLists = 8; // even: charged, odd: neutral constituents
+
+struct JaggedTauLists {
+  img::JaggedArray<float>  vFloat[nTauLists];
+  img::JaggedArray<double> vDouble[nTauLists];
+  void fill ( const SyntheticEvent& evt ) {
+    for ( int iL = 0; iL < nTauLists; iL++ ) { vFloat[iL].clear(); vDouble[iL].clear(); }
+    for ( size_t iJ = 0; iJ < evt.jetNCharged.size(); iJ++ ) {
+      for ( int iL = 0; iL < nTauLists; iL++ ) {
+        int n = iL%2 == 0 ? evt.jetNCharged[iJ] : std::max( evt.jetNNeutral[iJ], 1 );
+        for ( int k = 0; k < n; k++ ) {
+          vFloat[iL].push_back( float( iJ*10+k ) );
+          vDouble[iL].push_back( 0.01*( iJ*10+k ) );
+        }
+        vFloat[iL].endRow();
+        vDouble[iL].endRow();
+      }
+    }
+  }
+};
+
+struct NestedTauLists {
+  std::vector<std::vector<float>>  vFloat[nTauLists];
+  std::vector<std::vector<double>> vDouble[nTauLists];
+  void fill ( const SyntheticEvent& evt ) {
+    for ( int iL = 0; iL < nTauLists; iL++ ) { vFloat[iL].clear(); vDouble[iL].clear(); }
+    for ( size_t iJ = 0; iJ < evt.jetNCharged.size(); iJ++ ) {
+      for ( int iL = 0; iL < nTauLists; iL++ ) {
+        std::vector<float> rowFloat;
+        std::vector<double> rowDouble;
+        int n = iL%2 == 0 ? evt.jetNCharged[iJ] : std::max( evt.jetNNeutral[iJ], 1 );
+        for ( int k = 0; k < n; k++ ) {
+          rowFloat.push_back( float( iJ*10+k ) );
+          rowDouble.push_back( 0.01*( iJ*10+k ) );
+        }
+        vFloat[iL].push_back( rowFloat );
+        vDouble[iL].push_back( rowDouble );
+      }
+    }
+  }
+};
+
+int main ( int argc, char** argv ) {
+
+  int nEvents = 1000, nWarmup = 50;
+  double occupancy = 0.05, pileup = 40.;
+  unsigned seed = 12345;
+  bool doChecksum = false;
+  std::string geometryFile;
+  for ( int i = 1; i < argc; i++ ) {
+    std::string arg( argv[i] );
+    bool hasValue = i+1 < argc;
+    if      ( arg == "--events"    && hasValue ) nEvents   = std::atoi( argv[++i] );
+    else if ( arg == "--warmup"    && hasValue ) nWarmup   = std::atoi( argv[++i] );
+    else if ( arg == "--occupancy" && hasValue ) occupancy = std::atof( argv[++i] );
+    else if ( arg == "--pileup"    && hasValue ) pileup    = std::atof( argv[++i] );
+    else if ( arg == "--seed"      && hasValue ) seed      = std::atoi( argv[++i] );
+    else if ( arg == "--geometry"  && hasValue ) geometryFile = argv[++i];
+    else if ( arg == "--checksum" ) doChecksum = true;
+    else {
+      std::fprintf( stderr, "Usage: %s [--events N] [--warmup N] [--occupancy F] [--pileup N] [--seed N] [--geometry FILE] [--checksum]\n", argv[0] );
+      return 1;
+    }
+  }
+
+  img::GeometrySnapshot snapshot;
+  if ( !geometryFile.empty() ) {
+    try {
+      snapshot.read( geometryFile );
+    } catch ( std::runtime_error& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      return 1;
+    }
+  }
+  BenchGeometry geom( geometryFile.empty() ? nullptr : &snapshot );
+  EventGenerator generator( geom, occupancy, pileup, seed );
+  SyntheticEvent evt;
+
+  // Output images, reused across events as in the analyzers
+  img::ImageBuffer vEB_energy, vEB_time, vECAL_energy, vHBHE_energy_EB, vHBHE_energy;
+  img::ImageBuffer vHBHE_energy_EE[2];
+  std::vector<int> vHBHE_EEselected;
+  img::ImageBuffer vTrk[img::nTrackChannels];
+  img::ImageBuffer* vTrkPtrs[img::nTrackChannels];
+  for ( int ch = 0; ch < img::nTrackChannels; ch++ ) vTrkPtrs[ch] = &vTrk[ch];
+  // SC crops of both photons back to back, as in SCRegressor::fillSC
+  const int nCropCells = img::SC_CROP_SIZE*img::SC_CROP_SIZE;
+  std::vector<float> vSC[4];
+  JaggedTauLists jaggedTau;
+  NestedTauLists nestedTau;
+  // EB crystals -> HBHE towers, as in fillECALatHCAL
+  img::SparseRemap ebToHBHE;
+  img::ImageBuffer vHBHE_EMenergy;
+  img::ImageBuffer vECAL_energy_down5, vHBHE_energy_up5;
+  img::TrackerHitBatch trkHits;
+  {
+    const img::EtaPhiGrid grid{ 2*(img::HBHE_IETA_MAX_HE-1), img::eta_bins_HBHE, img::HBHE_IPHI_NUM, -PI, PI };
+    std::vector<img::SparseRemap::Entry> entries;
+    std::vector<std::pair<int,float> > overlaps;
+    for ( int ieta = -img::EB_IETA_MAX; ieta <= img::EB_IETA_MAX; ieta++ ) {
+      if ( ieta == 0 ) continue;
+      for ( int iphi = 1; iphi <= img::EB_IPHI_MAX; iphi++ ) {
+        overlaps.clear();
+        img::etaPhiOverlaps( geom.ebBox( ieta, iphi ), grid, overlaps );
+        for ( auto const& overlap : overlaps ) {
+          entries.push_back( img::SparseRemap::Entry{ img::ebIndex( ieta, iphi ), overlap.first, overlap.second } );
+        }
+      }
+    }
+    ebToHBHE.build( img::EB_NCELLS, img::HBHE_NCELLS, entries );
+  }
+
+  enum { kEB, kECALstitched, kHBHE, kHCALatEE, kTracks, kSC, kTauJagged, kECALatHCAL, kPyramid, kTRKhits, kTauNested, nKernels };
+  KernelStats stats[nKernels];
+  stats[kEB].name           = "EB";
+  stats[kECALstitched].name = "ECALstitched";
+  stats[kHBHE].name         = "HBHE";
+  stats[kHCALatEE].name     = "HCALatEE";
+  stats[kTracks].name       = "TracksAtECALstitched";
+  stats[kSC].name           = "SC crops (x2)";
+  stats[kTauJagged].name    = "taujet lists";
+  stats[kECALatHCAL].name   = "ECALatHCAL remap";
+  stats[kPyramid].name      = "pyramid (x2)";
+  stats[kTRKhits].name      = "TRK hit transforms";
+  stats[kTauNested].name    = "taujet lists (nested)";
+  KernelStats total;
+  total.name = "total";
+  for ( KernelStats& s : stats ) s.ns.reserve( nEvents );
+  total.ns.reserve( nEvents );
+
+  uint64_t checksum = 14695981039346656037ULL;
+  long nHits = 0;
+  for ( int iEvt = 0; iEvt < nWarmup+nEvents; iEvt++ ) {
+
+    generator.generate( evt );
+    bool record = iEvt >= nWarmup;
+    if ( record ) nHits += evt.ebHits.size() + evt.eeHits.size() + evt.hbheHits.size() + evt.tracks.size();
+
+    timeKernel( total, record, [&] {
+      timeKernel( stats[kEB], record, [&] { img::fillEBImage( evt.ebHits, vEB_energy, vEB_time ); } );
+      timeKernel( stats[kECALstitched], record, [&] { img::fillECALstitchedImage( evt.ebHits, evt.eeHits, vECAL_energy ); } );
+      timeKernel( stats[kHBHE], record, [&] { img::fillHBHEImage( evt.hbheHits, vHBHE_energy_EB, vHBHE_energy ); } );
+      timeKernel( stats[kHCALatEE], record, [&] { img::fillHCALatEEImage( evt.heTowers, geom.eeCells, vHBHE_energy_EE, vHBHE_EEselected ); } );
+      timeKernel( stats[kTracks], record, [&] { img::fillTracksAtECALstitchedImage( evt.tracks, 0.1, vTrkPtrs ); } );
+      timeKernel( stats[kSC], record, [&] {
+        for ( int i = 0; i < 4; i++ ) vSC[i].assign( 2*nCropCells, 0. );
+        for ( int iP = 0; iP < 2; iP++ ) {
+          img::fillSCCrop( evt.ebHits, evt.seedIeta[iP], evt.seedIphi[iP],
+                           &vSC[0][iP*nCropCells], &vSC[1][iP*nCropCells], &vSC[2][iP*nCropCells], &vSC[3][iP*nCropCells] );
+        }
+      } );
+      timeKernel( stats[kTauJagged], record, [&] { jaggedTau.fill( evt ); } );
+      timeKernel( stats[kECALatHCAL], record, [&] {
+        vHBHE_EMenergy.reset( img::HBHE_NCELLS );
+        for ( const img::EBHit& hit : evt.ebHits ) {
+          if ( hit.energy <= img::zs ) continue;
+          ebToHBHE.scatter( img::ebIndex( hit.ieta, hit.iphi ), hit.energy, vHBHE_EMenergy );
+        }
+      } );
+      timeKernel( stats[kPyramid], record, [&] {
+        img::downsampleImage( vECAL_energy, 2*img::ECAL_IETA_MAX_EXT, img::EB_IPHI_MAX, 5, vECAL_energy_down5 );
+        img::upsampleImage( vHBHE_energy, 2*(img::HBHE_IETA_MAX_HE-1), img::HBHE_IPHI_NUM, 5, vHBHE_energy_up5 );
+      } );
+      timeKernel( stats[kTRKhits], record, [&] {
+        trkHits.clear();
+        for ( size_t i = 0; i < evt.trkHitIds.size(); i++ ) {
+          int idx = geom.tkModules.index( evt.trkHitIds[i] );
+          if ( idx < 0 ) continue;
+          trkHits.add( idx, evt.trkHitLx[i], evt.trkHitLy[i], 0. );
+        }
+        img::transformHits( geom.tkModules, trkHits );
+      } );
+    } );
+    // Not part of the total: reference only
+    timeKernel( stats[kTauNested], record, [&] { nestedTau.fill( evt ); } );
+
+    if ( doChecksum && record ) {
+      hashImage( checksum, vEB_energy.pixels() );
+      hashImage( checksum, vEB_time.pixels() );
+      hashImage( checksum, vECAL_energy.pixels() );
+      hashImage( checksum, vHBHE_energy_EB.pixels() );
+      hashImage( checksum, vHBHE_energy.pixels() );
+      hashImage( checksum, vHBHE_energy_EE[0].pixels() );
+      hashImage( checksum, vHBHE_energy_EE[1].pixels() );
+      for ( int ch = 0; ch < img::nTrackChannels; ch++ ) hashImage( checksum, vTrk[ch].pixels() );
+      for ( int i = 0; i < 4; i++ ) hashImage( checksum, vSC[i] );
+      hashImage( checksum, vHBHE_EMenergy.pixels() );
+      hashImage( checksum, vECAL_energy_down5.pixels() );
+      hashImage( checksum, vHBHE_energy_up5.pixels() );
+      for ( int iL = 0; iL < nTauLists; iL++ ) {
+        hashImage( checksum, jaggedTau.vFloat[iL].values );
+        hashImage( checksum, jaggedTau.vFloat[iL].offsets );
+        hashImage( checksum, jaggedTau.vDouble[iL].values );
+      }
+    }
+
+  } // events
+
+  std::printf( "events: %d (warmup %d), occupancy: %.3f, pileup: %.0f, seed: %u, geometry: %s\n",
+               nEvents, nWarmup, occupancy, pileup, seed, geometryFile.empty() ? "ideal" : geometryFile.c_str() );
+  std::printf( "hits+tracks/event: %.0f, EE crystals: %zu, HE towers: %zu, EB->HBHE remap nnz: %d\n",
+               double( nHits )/std::max( nEvents, 1 ), geom.eeCells.size(), geom.heTowers.size(), ebToHBHE.nnz() );
+  std::printf( "%-22s %12s %12s %12s %12s %14s\n", "kernel", "mean[ns]", "p50[ns]", "p99[ns]", "allocs/evt", "bytes/evt" );
+  for ( KernelStats* s : { &stats[kEB], &stats[kECALstitched], &stats[kHBHE], &stats[kHCALatEE], &stats[kTracks], &stats[kSC], &stats[kTauJagged], &stats[kECALatHCAL], &stats[kPyramid], &stats[kTRKhits], &total, &stats[kTauNested] } ) {
+    double mean = 0.;
+    for ( double ns : s->ns ) mean += ns;
+    mean /= std::max<size_t>( s->ns.size(), 1 );
+    std::printf( "%-22s %12.0f %12.0f %12.0f %12.2f %14.0f\n", s->name.c_str(), mean,
+                 percentile( s->ns, 0.50 ), percentile( s->ns, 0.99 ),
+                 double( s->allocs )/std::max( nEvents, 1 ), double( s->bytes )/std::max( nEvents, 1 ) );
+  }
+  if ( doChecksum ) std::printf( "checksum: %016llx\n", (unsigned long long)checksum );
+
+  return 0;
+}
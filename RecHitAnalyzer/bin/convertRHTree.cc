@@ -0,0 +1,813 @@
+//
+// Converter of RHTree files to training shards
+//
+// Compiled replacement of the per-entry PyROOT converters, writing the
+// same rows as
+//   jet       convert_root2pq_jet.py (RecHitAnalyzer jet outputs):
+//             X_CMSII, pt, iphi, ieta, phi, eta, DM, truth, X_jet
+//   EBshower  convert_root2pq_EBshower.py (SCRegressor outputs):
+//             idx, m, pt, iphi, ieta, A_p4, A_pteta, pho_pteta, pho_p4,
+//             pho_id, pho_vars, X, Xtz, Xtzk
+// with the same crops (crop_jet, crop_EBshower), EE resampling
+// (resample_EE) and selection, one row per selected jet or photon, in
+// entry order. The rows go to an ImageShard (ImageShard.h, read with
+// image_shard.py) instead of Parquet, <outdir>/<decay>.shard.<idx>,
+// with its event index next to it (.idx, entry = row, offset = 0).
+// Images are float32 as in the input, scalars as well, except idx
+// (int64).
+//
+// The input entries are split in chunks converted by --threads worker
+// threads, each with its own TChain reading only the used branches
+// through a TTreeCache over the chunk. Chunks are written in order, at
+// most 2 x threads of them being held in memory, so the output does
+// not depend on the thread count. check_convertRHTree.py checks this,
+// and the match with convert_root2pq_jet.py, on a synthetic RHTree.
+//
+// Usage:
+//   convertRHTree --mode jet|EBshower -i FILE [FILE ...] [-o DIR] [-d DECAY] [-n IDX]
+//                 [--tree NAME] [--threads N] [--chunk N] [--cache MB]
+//                 [--pt-min X] [--pt-max X] [--m0-min X] [--m0-max X]
+//                 [--drop COLUMN[,COLUMN ...]] [--sparse COLUMN[,COLUMN ...]]
+//                 [--quantize COLUMN:SCALE[,COLUMN:SCALE ...]]
+//                 [--augment N] [--augment-seed S]
+//
+// The cuts apply to jetPt and jetM (jet mode) or pho_pT and SC_mass
+// (EBshower mode); EBshower mode has --pt-max 100 by default, as the
+// script. --drop leaves columns out, e.g. the full event image
+// X_CMSII, which the script writes on every jet row. --sparse stores
+// image columns as their non-zero pixels and --quantize float columns
+// as int16 multiples of SCALE (see ImageShard.h): such shards are
+// read with ShardLoader (shard_loader.py), not as a numpy memmap.
+// --augment (jet mode) follows each jet row with N copies of the jet
+// rotated in phi by pairs of HCAL towers and/or reflected in eta
+// (ImageAugment.h), drawn from the seed and (run, lumi, event, jet,
+// copy), with the images, iphi, ieta, phi and eta transformed. Their
+// transform is in the int32 column 'augment' (phi shift, eta flip,
+// 0, 0; all zero for the original rows) and only the original rows
+// are in the index.
+// e.g. convertRHTree --mode jet -i output_1.root -o pq -d DYToTauTau -n 1 --threads 16
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventIndex.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/Hash.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageAugment.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageBuffer.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageShard.h"
+
+#include "TChain.h"
+#include "TLeaf.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+  std::string mode;
+  std::vector<std::string> inFiles;
+  std::string outDir = ".";
+  std::string decay = "test";
+  int idx = 0;
+  std::string treeName = "recHitAnalyzer/RHTree";
+  int nThreads = 1;
+  int chunkSize = 32;
+  int cacheMB = 64;
+  double ptMin = -std::numeric_limits<double>::infinity();
+  double ptMax = std::numeric_limits<double>::infinity();
+  double m0Min = -std::numeric_limits<double>::infinity();
+  double m0Max = std::numeric_limits<double>::infinity();
+  std::vector<std::string> drop;
+  std::vector<std::string> sparse;
+  std::map<std::string, float> scales;
+  int nAugment = 0;
+  unsigned long long augmentSeed = 0;
+};
+
+// Branch reader of one worker __________________________________________//
+// Branches are enabled, cached and bound by name; scalars of any
+// integer or floating point type are read as long long.
+struct Inputs {
+  std::vector<std::string> vectors;     // vector<float>
+  std::vector<std::string> optVectors;  // vector<float>, optional
+  std::vector<std::string> intVectors;  // vector<int>, optional
+  std::vector<std::string> scalars;
+};
+
+class EntryReader {
+
+  public:
+
+    EntryReader ( const Options& opts, const Inputs& inputs )
+      : chain_( new TChain( opts.treeName.c_str() ) ) {
+
+      for ( const std::string& file : opts.inFiles ) chain_->Add( file.c_str() );
+      chain_->SetBranchStatus( "*", 0 );
+      chain_->SetCacheSize( (long long)opts.cacheMB << 20 );
+
+      vectors_.assign( inputs.vectors.size(), nullptr );
+      for ( unsigned int iV = 0; iV < inputs.vectors.size(); iV++ ) {
+        bind( inputs.vectors[iV], &vectors_[iV], true );
+      }
+      optVectors_.assign( inputs.optVectors.size(), nullptr );
+      for ( unsigned int iV = 0; iV < inputs.optVectors.size(); iV++ ) {
+        bind( inputs.optVectors[iV], &optVectors_[iV], false );
+      }
+      intVectors_.assign( inputs.intVectors.size(), nullptr );
+      for ( unsigned int iV = 0; iV < inputs.intVectors.size(); iV++ ) {
+        bind( inputs.intVectors[iV], &intVectors_[iV], false );
+      }
+      scalars_.resize( inputs.scalars.size() );
+      for ( unsigned int iS = 0; iS < inputs.scalars.size(); iS++ ) {
+        const std::string& name = inputs.scalars[iS];
+        TLeaf* leaf = chain_->GetLeaf( name.c_str() );
+        if ( !leaf ) throw std::runtime_error( "no branch " + name + " in " + opts.treeName );
+        scalars_[iS].type = leaf->GetTypeName();
+        chain_->SetBranchStatus( name.c_str(), 1 );
+        chain_->SetBranchAddress( name.c_str(), (void*)&scalars_[iS].value );
+        chain_->AddBranchToCache( name.c_str(), true );
+      }
+      chain_->StopCacheLearningPhase();
+
+    }
+
+    void setRange ( long long first, long long last ) { chain_->SetCacheEntryRange( first, last ); }
+
+    void read ( long long entry ) {
+      if ( chain_->GetEntry( entry ) <= 0 ) throw std::runtime_error( "cannot read entry " + std::to_string( entry ) );
+    }
+
+    const std::vector<float>& vec ( int i ) const { return *vectors_[i]; }
+    // nullptr if the branch is missing
+    const std::vector<float>* optVec ( int i ) const { return optVectors_[i]; }
+    const std::vector<int>* intVec ( int i ) const { return intVectors_[i]; }
+
+    long long integer ( int i ) const {
+      const Scalar& s = scalars_[i];
+      if ( s.type == "Int_t" )     return s.value.i;
+      if ( s.type == "UInt_t" )    return s.value.u;
+      if ( s.type == "Long64_t" )  return s.value.l;
+      if ( s.type == "ULong64_t" ) return s.value.ul;
+      if ( s.type == "Float_t" )   return s.value.f;
+      if ( s.type == "Double_t" )  return s.value.d;
+      throw std::runtime_error( "unsupported scalar type " + s.type );
+    }
+
+  private:
+
+    template <typename T>
+    void bind ( const std::string& name, std::vector<T>** address, bool required ) {
+      if ( !chain_->GetBranch( name.c_str() ) ) {
+        if ( required ) throw std::runtime_error( "no branch " + name + " in " + chain_->GetName() );
+        return;
+      }
+      *address = new std::vector<T>;
+      owned_.emplace_back( *address, []( void* p ) { delete static_cast<std::vector<T>*>( p ); } );
+      chain_->SetBranchStatus( name.c_str(), 1 );
+      chain_->SetBranchAddress( name.c_str(), address );
+      chain_->AddBranchToCache( name.c_str(), true );
+    }
+
+    struct Scalar {
+      std::string type;
+      union { float f; double d; int i; unsigned int u; long long l; unsigned long long ul; } value;
+    };
+
+    std::vector<std::unique_ptr<void, void (*)( void* )>> owned_; // outlives the chain
+    std::unique_ptr<TChain> chain_;
+    std::vector<std::vector<float>*> vectors_;
+    std::vector<std::vector<float>*> optVectors_;
+    std::vector<std::vector<int>*> intVectors_;
+    std::vector<Scalar> scalars_;
+
+};
+
+// Rows of a chunk of entries ___________________________________________//
+struct Chunk {
+  std::vector<char> rows;
+  size_t nRows = 0;
+  std::vector<img::IndexRecord> index; // entry = row in the chunk
+};
+
+class RowBuilder {
+
+  public:
+
+    RowBuilder ( const img::ShardWriter& writer, Chunk& chunk ) : writer_( writer ), chunk_( chunk ) {}
+
+    // New zeroed row
+    void add () {
+      chunk_.rows.resize( ( chunk_.nRows+1 )*writer_.rowBytes(), 0 );
+      chunk_.nRows++;
+    }
+    // Column data of the current row, nullptr if dropped
+    template <typename T>
+    T* at ( int column ) {
+      if ( column < 0 ) return nullptr;
+      char* row = chunk_.rows.data() + ( chunk_.nRows-1 )*writer_.rowBytes();
+      return reinterpret_cast<T*>( row + writer_.columns()[column].offset );
+    }
+    void set ( int column, float value ) {
+      if ( float* p = at<float>( column ) ) *p = value;
+    }
+    void set ( int column, std::initializer_list<float> values ) {
+      if ( float* p = at<float>( column ) ) std::copy( values.begin(), values.end(), p );
+    }
+    void index ( unsigned int run, unsigned int lumi, unsigned long long event, int item ) {
+      img::IndexRecord record;
+      record.key = img::IndexKey{ run, lumi, event, item };
+      record.entry = chunk_.nRows-1;
+      record.offset = 0;
+      chunk_.index.push_back( record );
+    }
+
+  private:
+
+    const img::ShardWriter& writer_;
+    Chunk& chunk_;
+
+};
+
+// Per-mode conversion, one instance per worker
+class Converter {
+  public:
+    virtual ~Converter () {}
+    virtual void convert ( const EntryReader& reader, RowBuilder& rows ) = 0;
+};
+
+struct ColumnSpec {
+  std::string name;
+  img::ShardType type;
+  std::vector<int> shape;
+};
+
+static bool pass ( double x, double lo, double hi ) { return x >= lo && x <= hi; }
+
+static void checkSize ( const std::vector<float>& v, size_t size, const char* name ) {
+  if ( v.size() != size ) {
+    throw std::runtime_error( std::string( name ) + ": " + std::to_string( v.size() ) + " pixels, expected " + std::to_string( size ) );
+  }
+}
+
+// jet mode _____________________________________________________________//
+static const int ECAL_NROWS = 2*img::ECAL_IETA_MAX_EXT;       // 280
+static const int ECAL_NCOLS = img::EB_IPHI_MAX;               // 360
+static const int HBHE_NROWS = 2*(img::HBHE_IETA_MAX_HE-1);    // 56
+static const int HBHE_NCOLS = img::HBHE_IPHI_NUM;             // 72
+static const int HBHE_SCALE = ECAL_NCOLS/HBHE_NCOLS;          // 5
+static const int JET_CROP   = 125;
+
+static const Inputs jetInputs = {
+  { "ECAL_tracksPt", "ECAL_energy", "HBHE_energy", "jetPt", "jetPhi", "jetEta",
+    "jetSeed_iphi", "jetSeed_ieta", "jet_truthLabel", "jet_truthDM" },
+  { "jetM" },
+  { "jetIdx" },
+  { "runId", "lumiId", "eventId" }
+};
+enum { kJetTracksPt, kJetECAL, kJetHBHE, kJetPt, kJetPhi, kJetEta, kJetIphi, kJetIeta, kJetTruth, kJetDM };
+
+static const std::vector<ColumnSpec> jetColumns = {
+  { "X_CMSII", img::ShardType::Float32, { 3, ECAL_NROWS, ECAL_NCOLS } },
+  { "pt",      img::ShardType::Float32, {} },
+  { "iphi",    img::ShardType::Float32, {} },
+  { "ieta",    img::ShardType::Float32, {} },
+  { "phi",     img::ShardType::Float32, {} },
+  { "eta",     img::ShardType::Float32, {} },
+  { "DM",      img::ShardType::Float32, {} },
+  { "truth",   img::ShardType::Float32, {} },
+  { "X_jet",   img::ShardType::Float32, { 3, JET_CROP, JET_CROP } }
+};
+
+// resample_EE(): each endcap (the 55 rows at either end) is summed in
+// 2x2 blocks and spread back over them, /16 as the script (which
+// divides by the block area twice). The blocks of EE- start one row
+// before the image, those of EE+ end one row after it.
+static void resampleEE ( std::vector<float>& img ) {
+
+  const int nEE = img::EE_PROJ_NETA;
+  float sums[ECAL_NCOLS/2];
+  for ( int side = 0; side < 2; side++ ) {
+    int first = side == 0 ? -1 : ECAL_NROWS-nEE; // first row of the first block
+    for ( int r0 = first; r0 < first+nEE+1; r0 += 2 ) {
+      for ( int c = 0; c < ECAL_NCOLS/2; c++ ) {
+        float sum = 0.;
+        for ( int dr = 0; dr < 2; dr++ ) {
+          int r = r0+dr;
+          if ( r < 0 || r >= ECAL_NROWS ) continue;
+          sum += img[r*ECAL_NCOLS + 2*c];
+          sum += img[r*ECAL_NCOLS + 2*c+1];
+        }
+        sums[c] = sum/4.f/4.f;
+      }
+      for ( int dr = 0; dr < 2; dr++ ) {
+        int r = r0+dr;
+        if ( r < 0 || r >= ECAL_NROWS ) continue;
+        for ( int c = 0; c < ECAL_NCOLS; c++ ) img[r*ECAL_NCOLS + c] = sums[c/2];
+      }
+    }
+  }
+
+} // resampleEE()
+
+class JetConverter : public Converter {
+
+  public:
+
+    JetConverter ( const img::ShardWriter& writer, const Options& opts ) : opts_( opts ) {
+      for ( unsigned int iC = 0; iC < jetColumns.size(); iC++ ) columns_[iC] = writer.column( jetColumns[iC].name );
+      augmentColumn_ = writer.column( "augment" );
+      for ( img::ImageBuffer& image : images_ ) image.pixels().assign( ECAL_NROWS*ECAL_NCOLS, 0. );
+      jetCrop_.resize( 3*JET_CROP*JET_CROP );
+    }
+
+    void convert ( const EntryReader& reader, RowBuilder& rows ) override {
+
+      const std::vector<float>& pts = reader.vec( kJetPt );
+      const std::vector<float>* m0s = reader.optVec( 0 );
+      const std::vector<int>* jetIdxs = reader.intVec( 0 ); // older outputs: position
+      if ( !m0s && ( opts_.m0Min > -std::numeric_limits<double>::infinity() || opts_.m0Max < std::numeric_limits<double>::infinity() ) ) {
+        throw std::runtime_error( "m0 cut without a jetM branch" );
+      }
+      bool loaded = false;
+
+      for ( unsigned int iJ = 0; iJ < pts.size(); iJ++ ) {
+
+        if ( !pass( pts[iJ], opts_.ptMin, opts_.ptMax ) || ( m0s && !pass( (*m0s)[iJ], opts_.m0Min, opts_.m0Max ) ) ) continue;
+        if ( !loaded ) {
+          loadImages( reader );
+          loaded = true;
+        }
+
+        rows.add();
+        float iphi = reader.vec( kJetIphi )[iJ];
+        float ieta = reader.vec( kJetIeta )[iJ];
+        float phi = reader.vec( kJetPhi )[iJ];
+        float eta = reader.vec( kJetEta )[iJ];
+        if ( float* out = rows.at<float>( columns_[0] ) ) {
+          for ( const img::ImageBuffer& image : images_ ) out = std::copy( image.pixels().begin(), image.pixels().end(), out );
+        }
+        rows.set( columns_[1], pts[iJ] );
+        rows.set( columns_[2], iphi );
+        rows.set( columns_[3], ieta );
+        rows.set( columns_[4], phi );
+        rows.set( columns_[5], eta );
+        rows.set( columns_[6], reader.vec( kJetDM )[iJ] );
+        rows.set( columns_[7], reader.vec( kJetTruth )[iJ] );
+        // crop_jet(): centered on the middle crystal of the seed tower
+        if ( columns_[8] >= 0 ) {
+          float* out = jetCrop_.data();
+          for ( const img::ImageBuffer& image : images_ ) {
+            img::cropImage( image, ECAL_NROWS, ECAL_NCOLS, int( ieta )*HBHE_SCALE + HBHE_SCALE/2, int( iphi )*HBHE_SCALE + HBHE_SCALE/2,
+                            JET_CROP, out, JET_CROP, 1 );
+            out += JET_CROP*JET_CROP;
+          }
+          std::copy( jetCrop_.begin(), jetCrop_.end(), rows.at<float>( columns_[8] ) );
+        }
+        int jet = jetIdxs ? (*jetIdxs)[iJ] : iJ;
+        rows.index( reader.integer( 0 ), reader.integer( 1 ), reader.integer( 2 ), jet );
+
+        // Key of the copies of this jet, as Prescaler::uniform
+        uint64_t jetKey = img::mix( ( uint64_t( reader.integer( 0 ) ) << 32 ) | uint32_t( reader.integer( 1 ) ) );
+        jetKey = img::mix( jetKey ^ uint64_t( reader.integer( 2 ) ) );
+        for ( int iA = 0; iA < opts_.nAugment; iA++ ) {
+          img::AugmentConfig config;
+          config.rotate = true;
+          config.reflect = true;
+          // Whole towers and whole resample_EE 2x2 blocks
+          config.step = 2*HBHE_SCALE;
+          uint64_t key = img::mix( jetKey ^ ( ( uint64_t( uint32_t( jet ) ) << 32 ) | uint32_t( iA ) ) );
+          img::Augmentation aug = img::drawAugmentation( config, ECAL_NROWS, ECAL_NCOLS, opts_.augmentSeed, key );
+          augment( rows, aug, pts[iJ], iphi, ieta, phi, eta, reader.vec( kJetDM )[iJ], reader.vec( kJetTruth )[iJ] );
+        }
+
+      } // jets
+
+    } // convert()
+
+  private:
+
+    // Row of the jet transformed by aug. The reflection and rotations
+    // by an even number of towers map the tower grid and the 2x2 blocks
+    // of resampleEE() onto themselves, so the transformed images are
+    // those of the transformed jet. The labels follow: iphi (towers) and phi
+    // by the shift, ieta (tower rows) and eta reflected. The crop is
+    // centered on the transformed seed, so only the reflection changes
+    // its pixels (JET_CROP is odd, see ImageAugment.h).
+    void augment ( RowBuilder& rows, const img::Augmentation& aug, float pt, float iphi, float ieta, float phi, float eta,
+                   float dm, float truth ) {
+
+      rows.add();
+      if ( float* out = rows.at<float>( columns_[0] ) ) {
+        for ( const img::ImageBuffer& image : images_ ) {
+          img::transformImages( image.pixels().data(), 1, 1, ECAL_NROWS, ECAL_NCOLS, &aug, ECAL_NROWS, ECAL_NCOLS, out );
+          out += ECAL_NROWS*ECAL_NCOLS;
+        }
+      }
+      rows.set( columns_[1], pt );
+      rows.set( columns_[2], ( int( iphi ) + aug.phiShift/HBHE_SCALE ) % HBHE_NCOLS );
+      rows.set( columns_[3], aug.etaFlip ? HBHE_NROWS-1 - ieta : ieta );
+      rows.set( columns_[4], std::remainder( phi + aug.phiShift*2.*M_PI/ECAL_NCOLS, 2.*M_PI ) );
+      rows.set( columns_[5], aug.etaFlip ? -eta : eta );
+      rows.set( columns_[6], dm );
+      rows.set( columns_[7], truth );
+      if ( float* out = rows.at<float>( columns_[8] ) ) {
+        img::Augmentation flip;
+        flip.etaFlip = aug.etaFlip;
+        img::transformImages( jetCrop_.data(), 1, 3, JET_CROP, JET_CROP, &flip, JET_CROP, JET_CROP, out );
+      }
+      if ( int* out = rows.at<int>( augmentColumn_ ) ) {
+        out[0] = aug.phiShift;
+        out[1] = aug.etaFlip;
+      }
+
+    } // augment()
+
+    // [TracksAtECAL_pt, ECAL_energy, HBHE_energy] at ECAL granularity.
+    // The buffers are only used as dense images here, overwritten
+    // through pixels() on every event.
+    void loadImages ( const EntryReader& reader ) {
+
+      const std::vector<float>& tracksPt = reader.vec( kJetTracksPt );
+      const std::vector<float>& ecal = reader.vec( kJetECAL );
+      const std::vector<float>& hbhe = reader.vec( kJetHBHE );
+      checkSize( tracksPt, ECAL_NROWS*ECAL_NCOLS, "ECAL_tracksPt" );
+      checkSize( ecal, ECAL_NROWS*ECAL_NCOLS, "ECAL_energy" );
+      checkSize( hbhe, HBHE_NROWS*HBHE_NCOLS, "HBHE_energy" );
+
+      images_[0].pixels() = tracksPt;
+      images_[1].pixels() = ecal;
+      resampleEE( images_[1].pixels() );
+      // upsample_array(HBHE_energy, 5, 5)
+      std::vector<float>& up = images_[2].pixels();
+      for ( int r = 0; r < ECAL_NROWS; r++ ) {
+        for ( int c = 0; c < ECAL_NCOLS; c++ ) {
+          up[r*ECAL_NCOLS + c] = hbhe[( r/HBHE_SCALE )*HBHE_NCOLS + c/HBHE_SCALE]/float( HBHE_SCALE*HBHE_SCALE );
+        }
+      }
+
+    } // loadImages()
+
+    const Options& opts_;
+    int columns_[9];
+    int augmentColumn_;
+    img::ImageBuffer images_[3];
+    std::vector<float> jetCrop_;
+
+};
+
+// EBshower mode ________________________________________________________//
+static const int EB_NROWS = 2*img::EB_IETA_MAX; // 170
+static const int EB_NCOLS = img::EB_IPHI_MAX;   // 360
+static const int SC_CROP  = img::SC_CROP_SIZE;  // 32
+
+static const Inputs showerInputs = {
+  { "TracksPt_EB", "SC_energy", "SC_energyT", "SC_energyZ",
+    "SC_mass", "SC_pT", "SC_iphi", "SC_ieta", "SC_E", "SC_eta", "SC_phi",
+    "pho_pT", "pho_E", "pho_eta", "pho_phi",
+    // pho_id
+    "pho_r9", "pho_sieie", "pho_phoIso", "pho_chgIso", "pho_chgIsoWrongVtx", "pho_Eraw",
+    "pho_phiWidth", "pho_etaWidth", "pho_scEta", "pho_sieip", "pho_s4",
+    // pho_vars, after pho_r9 and pho_sieie
+    "pho_HoE", "pho_hasPxlSeed", "pho_trkIso", "pho_chgIsoCorr", "pho_neuIsoCorr", "pho_phoIsoCorr", "pho_bdt" },
+  {},
+  {},
+  { "runId", "lumiId", "eventId" }
+};
+enum { kShTracksPt, kShSCEnergy, kShSCEnergyT, kShSCEnergyZ,
+       kShSCMass, kShSCPt, kShSCIphi, kShSCIeta, kShSCE, kShSCEta, kShSCPhi,
+       kShPhoPt, kShPhoE, kShPhoEta, kShPhoPhi,
+       kShR9, kShSieie, kShPhoIso, kShChgIso, kShChgIsoWrongVtx, kShEraw,
+       kShPhiWidth, kShEtaWidth, kShScEta, kShSieip, kShS4,
+       kShHoE, kShHasPxlSeed, kShTrkIso, kShChgIsoCorr, kShNeuIsoCorr, kShPhoIsoCorr, kShBdt };
+
+static const std::vector<ColumnSpec> showerColumns = {
+  { "idx",       img::ShardType::Int64,   { 4 } },
+  { "m",         img::ShardType::Float32, {} },
+  { "pt",        img::ShardType::Float32, {} },
+  { "iphi",      img::ShardType::Float32, {} },
+  { "ieta",      img::ShardType::Float32, {} },
+  { "A_p4",      img::ShardType::Float32, { 4 } },
+  { "A_pteta",   img::ShardType::Float32, { 2 } },
+  { "pho_pteta", img::ShardType::Float32, { 2 } },
+  { "pho_p4",    img::ShardType::Float32, { 4 } },
+  { "pho_id",    img::ShardType::Float32, { 11 } },
+  { "pho_vars",  img::ShardType::Float32, { 10 } },
+  { "X",         img::ShardType::Float32, { 1, SC_CROP, SC_CROP } },
+  { "Xtz",       img::ShardType::Float32, { 2, SC_CROP, SC_CROP } },
+  { "Xtzk",      img::ShardType::Float32, { 3, SC_CROP, SC_CROP } }
+};
+
+class ShowerConverter : public Converter {
+
+  public:
+
+    ShowerConverter ( const img::ShardWriter& writer, const Options& opts ) : opts_( opts ) {
+      for ( unsigned int iC = 0; iC < showerColumns.size(); iC++ ) columns_[iC] = writer.column( showerColumns[iC].name );
+    }
+
+    void convert ( const EntryReader& reader, RowBuilder& rows ) override {
+
+      const int nCrop = SC_CROP*SC_CROP;
+      const std::vector<float>& masses = reader.vec( kShSCMass );
+      bool loaded = false;
+
+      for ( unsigned int iP = 0; iP < masses.size(); iP++ ) {
+
+        auto v = [&]( int branch ) { return reader.vec( branch )[iP]; };
+        // Crops must fit in EB
+        if ( v( kShSCIeta ) >= EB_NROWS-SC_CROP/2 ) continue;
+        if ( !pass( v( kShPhoPt ), opts_.ptMin, opts_.ptMax ) || !pass( masses[iP], opts_.m0Min, opts_.m0Max ) ) continue;
+        if ( !loaded ) {
+          checkSize( reader.vec( kShTracksPt ), EB_NROWS*EB_NCOLS, "TracksPt_EB" );
+          tracksPt_.pixels() = reader.vec( kShTracksPt );
+          loaded = true;
+        }
+
+        rows.add();
+        unsigned int run = reader.integer( 0 ), lumi = reader.integer( 1 );
+        unsigned long long event = reader.integer( 2 );
+        if ( long long* idx = rows.at<long long>( columns_[0] ) ) {
+          idx[0] = run;
+          idx[1] = lumi;
+          idx[2] = event;
+          idx[3] = iP;
+        }
+        rows.set( columns_[1], masses[iP] );
+        rows.set( columns_[2], v( kShSCPt ) );
+        rows.set( columns_[3], v( kShSCIphi ) );
+        rows.set( columns_[4], v( kShSCIeta ) );
+        rows.set( columns_[5], { v( kShSCE ), v( kShSCPt ), v( kShSCEta ), v( kShSCPhi ) } );
+        rows.set( columns_[6], { v( kShSCPt ), v( kShSCEta ) } );
+        rows.set( columns_[7], { v( kShPhoPt ), v( kShPhoEta ) } );
+        rows.set( columns_[8], { v( kShPhoE ), v( kShPhoPt ), v( kShPhoEta ), v( kShPhoPhi ) } );
+        rows.set( columns_[9], { v( kShR9 ), v( kShSieie ), v( kShPhoIso ), v( kShChgIso ), v( kShChgIsoWrongVtx ), v( kShEraw ),
+                                 v( kShPhiWidth ), v( kShEtaWidth ), v( kShScEta ), v( kShSieip ), v( kShS4 ) } );
+        rows.set( columns_[10], { v( kShR9 ), v( kShHoE ), v( kShHasPxlSeed ), v( kShSieie ), v( kShPhoIso ), v( kShTrkIso ),
+                                  v( kShChgIsoCorr ), v( kShNeuIsoCorr ), v( kShPhoIsoCorr ), v( kShBdt ) } );
+
+        // SC_* hold the crops of all photons back to back
+        const float* energy  = crop( reader, kShSCEnergy, iP, masses.size() );
+        const float* energyT = crop( reader, kShSCEnergyT, iP, masses.size() );
+        const float* energyZ = crop( reader, kShSCEnergyZ, iP, masses.size() );
+        if ( float* out = rows.at<float>( columns_[11] ) ) std::copy( energy, energy+nCrop, out );
+        if ( float* out = rows.at<float>( columns_[12] ) ) {
+          std::copy( energyT, energyT+nCrop, out );
+          std::copy( energyZ, energyZ+nCrop, out+nCrop );
+        }
+        // crop_EBshower(): seed at [15,15]
+        if ( float* out = rows.at<float>( columns_[13] ) ) {
+          img::cropImage( tracksPt_, EB_NROWS, EB_NCOLS, int( v( kShSCIeta ) )+1, int( v( kShSCIphi ) )+1, SC_CROP, out, SC_CROP, 1 );
+          std::copy( energyT, energyT+nCrop, out+nCrop );
+          std::copy( energyZ, energyZ+nCrop, out+2*nCrop );
+        }
+        rows.index( run, lumi, event, iP );
+
+      } // photons
+
+    } // convert()
+
+  private:
+
+    static const float* crop ( const EntryReader& reader, int branch, unsigned int iP, size_t nPho ) {
+      const std::vector<float>& crops = reader.vec( branch );
+      if ( crops.size() != nPho*SC_CROP*SC_CROP ) throw std::runtime_error( "SC crops do not match the photons" );
+      return crops.data() + iP*SC_CROP*SC_CROP;
+    }
+
+    const Options& opts_;
+    int columns_[14];
+    img::ImageBuffer tracksPt_; // dense, see JetConverter::loadImages()
+
+};
+
+// Worker pool __________________________________________________________//
+// Chunks are handed out in order and written by the main thread in
+// order; a worker may run at most maxAhead chunks ahead of the writer.
+static long long convert ( const Options& opts, const Inputs& inputs, img::ShardWriter& writer,
+                           img::EventIndexWriter& index, long long nEntries ) {
+
+  long long nChunks = ( nEntries + opts.chunkSize-1 )/opts.chunkSize;
+  long long maxAhead = 2*opts.nThreads;
+  std::atomic<long long> nextChunk( 0 );
+  long long nextWrite = 0;
+  std::map<long long, Chunk> done;
+  std::mutex mutex;
+  std::condition_variable doneCv, writtenCv;
+  std::exception_ptr error;
+
+  auto work = [&] {
+    try {
+      EntryReader reader( opts, inputs );
+      std::unique_ptr<Converter> converter;
+      if ( opts.mode == "jet" ) converter.reset( new JetConverter( writer, opts ) );
+      else                      converter.reset( new ShowerConverter( writer, opts ) );
+      while ( true ) {
+        long long iC = nextChunk++;
+        if ( iC >= nChunks ) return;
+        {
+          std::unique_lock<std::mutex> lock( mutex );
+          writtenCv.wait( lock, [&] { return iC < nextWrite + maxAhead || error; } );
+          if ( error ) return;
+        }
+        long long first = iC*opts.chunkSize;
+        long long last = std::min( first + opts.chunkSize, nEntries );
+        Chunk chunk;
+        RowBuilder rows( writer, chunk );
+        reader.setRange( first, last );
+        for ( long long iEvt = first; iEvt < last; iEvt++ ) {
+          reader.read( iEvt );
+          converter->convert( reader, rows );
+        }
+        {
+          std::lock_guard<std::mutex> lock( mutex );
+          done[iC] = std::move( chunk );
+        }
+        doneCv.notify_one();
+      }
+    } catch ( ... ) {
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( !error ) error = std::current_exception();
+      }
+      doneCv.notify_one();
+      writtenCv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for ( int iT = 0; iT < opts.nThreads; iT++ ) workers.emplace_back( work );
+
+  long long nRows = 0;
+  while ( nextWrite < nChunks ) {
+    Chunk chunk;
+    {
+      std::unique_lock<std::mutex> lock( mutex );
+      doneCv.wait( lock, [&] { return done.count( nextWrite ) || error; } );
+      if ( error ) break;
+      chunk = std::move( done[nextWrite] );
+      done.erase( nextWrite );
+    }
+    // On a write error, stop the workers before rethrowing
+    try {
+      writer.write( chunk.rows.data(), chunk.nRows );
+      for ( const img::IndexRecord& record : chunk.index ) {
+        index.add( record.key.run, record.key.lumi, record.key.event, record.key.jet, nRows + record.entry, record.offset );
+      }
+    } catch ( ... ) {
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( !error ) error = std::current_exception();
+      }
+      writtenCv.notify_all();
+      break;
+    }
+    nRows += chunk.nRows;
+    {
+      std::lock_guard<std::mutex> lock( mutex );
+      nextWrite++;
+    }
+    writtenCv.notify_all();
+    if ( nextWrite % std::max( 1, 10000/opts.chunkSize ) == 0 ) {
+      std::printf( " .. Processed entry %lld\n", std::min( nextWrite*opts.chunkSize, nEntries ) );
+    }
+  }
+
+  for ( std::thread& worker : workers ) worker.join();
+  if ( error ) std::rethrow_exception( error );
+  return nRows;
+
+} // convert()
+
+// Comma separated list
+static std::vector<std::string> splitList ( const std::string& list ) {
+  std::vector<std::string> items;
+  for ( size_t begin = 0, end; begin <= list.size(); begin = end+1 ) {
+    end = std::min( list.find( ',', begin ), list.size() );
+    if ( end > begin ) items.push_back( list.substr( begin, end-begin ) );
+  }
+  return items;
+}
+
+static void usage ( const char* name ) {
+  std::fprintf( stderr, "Usage: %s --mode jet|EBshower -i FILE [FILE ...] [-o DIR] [-d DECAY] [-n IDX]\n"
+                        "          [--tree NAME] [--threads N] [--chunk N] [--cache MB]\n"
+                        "          [--pt-min X] [--pt-max X] [--m0-min X] [--m0-max X] [--drop COLUMN[,COLUMN ...]]\n"
+                        "          [--sparse COLUMN[,COLUMN ...]] [--quantize COLUMN:SCALE[,COLUMN:SCALE ...]]\n"
+                        "          [--augment N] [--augment-seed S]\n", name );
+}
+
+int main ( int argc, char** argv ) {
+
+  Options opts;
+  bool ptMaxSet = false;
+  for ( int i = 1; i < argc; i++ ) {
+    std::string arg( argv[i] );
+    bool hasValue = i+1 < argc;
+    if      ( arg == "--mode"    && hasValue ) opts.mode      = argv[++i];
+    else if ( arg == "-o"        && hasValue ) opts.outDir    = argv[++i];
+    else if ( arg == "-d"        && hasValue ) opts.decay     = argv[++i];
+    else if ( arg == "-n"        && hasValue ) opts.idx       = std::atoi( argv[++i] );
+    else if ( arg == "--tree"    && hasValue ) opts.treeName  = argv[++i];
+    else if ( arg == "--threads" && hasValue ) opts.nThreads  = std::atoi( argv[++i] );
+    else if ( arg == "--chunk"   && hasValue ) opts.chunkSize = std::atoi( argv[++i] );
+    else if ( arg == "--cache"   && hasValue ) opts.cacheMB   = std::atoi( argv[++i] );
+    else if ( arg == "--pt-min"  && hasValue ) opts.ptMin     = std::atof( argv[++i] );
+    else if ( arg == "--pt-max"  && hasValue ) { opts.ptMax   = std::atof( argv[++i] ); ptMaxSet = true; }
+    else if ( arg == "--m0-min"  && hasValue ) opts.m0Min     = std::atof( argv[++i] );
+    else if ( arg == "--m0-max"  && hasValue ) opts.m0Max     = std::atof( argv[++i] );
+    else if ( arg == "--drop"    && hasValue ) opts.drop      = splitList( argv[++i] );
+    else if ( arg == "--sparse"  && hasValue ) opts.sparse    = splitList( argv[++i] );
+    else if ( arg == "--augment" && hasValue ) opts.nAugment  = std::atoi( argv[++i] );
+    else if ( arg == "--augment-seed" && hasValue ) opts.augmentSeed = std::strtoull( argv[++i], nullptr, 10 );
+    else if ( arg == "--quantize" && hasValue ) {
+      for ( const std::string& item : splitList( argv[++i] ) ) {
+        size_t colon = item.find( ':' );
+        float scale = colon == std::string::npos ? 0. : std::atof( item.c_str() + colon+1 );
+        if ( !( scale > 0. ) ) {
+          usage( argv[0] );
+          return 1;
+        }
+        opts.scales[item.substr( 0, colon )] = scale;
+      }
+    }
+    else if ( arg == "-i" && hasValue ) {
+      while ( i+1 < argc && argv[i+1][0] != '-' ) opts.inFiles.push_back( argv[++i] );
+    }
+    else {
+      usage( argv[0] );
+      return 1;
+    }
+  }
+  if ( ( opts.mode != "jet" && opts.mode != "EBshower" ) || opts.inFiles.empty()
+       || opts.nThreads < 1 || opts.chunkSize < 1 || opts.cacheMB < 0
+       || opts.nAugment < 0 || ( opts.nAugment > 0 && opts.mode != "jet" ) ) {
+    usage( argv[0] );
+    return 1;
+  }
+  if ( opts.mode == "EBshower" && !ptMaxSet ) opts.ptMax = 100.;
+
+  try {
+
+    ROOT::EnableThreadSafety();
+
+    const Inputs& inputs = opts.mode == "jet" ? jetInputs : showerInputs;
+
+    img::ShardWriter writer;
+    for ( const ColumnSpec& spec : opts.mode == "jet" ? jetColumns : showerColumns ) {
+      if ( std::find( opts.drop.begin(), opts.drop.end(), spec.name ) != opts.drop.end() ) continue;
+      bool sparse = std::find( opts.sparse.begin(), opts.sparse.end(), spec.name ) != opts.sparse.end();
+      float scale = opts.scales.count( spec.name ) ? opts.scales.at( spec.name ) : 0.;
+      writer.addColumn( spec.name, spec.type, spec.shape, sparse, scale );
+    }
+    if ( opts.nAugment > 0 ) writer.addColumn( "augment", img::ShardType::Int32, { 4 } );
+    for ( const std::string& name : opts.sparse ) {
+      if ( writer.column( name ) < 0 ) throw std::runtime_error( "no column " + name + " to make sparse" );
+    }
+    for ( const auto& scale : opts.scales ) {
+      if ( writer.column( scale.first ) < 0 ) throw std::runtime_error( "no column " + scale.first + " to quantize" );
+    }
+
+    long long nEntries;
+    {
+      TChain chain( opts.treeName.c_str() );
+      for ( const std::string& file : opts.inFiles ) chain.Add( file.c_str() );
+      nEntries = chain.GetEntries();
+    }
+    if ( nEntries <= 0 ) throw std::runtime_error( "no entries in " + opts.treeName );
+    std::string outName = opts.decay + ".shard." + std::to_string( opts.idx );
+    std::string outFile = opts.outDir + "/" + outName;
+    std::printf( " >> Input files: %zu, nEvts: %lld\n", opts.inFiles.size(), nEntries );
+    std::printf( " >> Output file: %s (%zu bytes/row)\n", outFile.c_str(), writer.rowBytes() );
+
+    auto t0 = std::chrono::steady_clock::now();
+    img::EventIndexWriter index;
+    writer.open( outFile );
+    long long nRows = convert( opts, inputs, writer, index, nEntries );
+    writer.close();
+    index.write( outFile + ".idx", outName );
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+
+    std::printf( " >> %s: %lld\n", opts.mode == "jet" ? "nJets" : "nPhos", nRows );
+    std::printf( " >> Real time: %.2f minutes (%.1f entries/s)\n", seconds/60., nEntries/seconds );
+
+  } catch ( std::exception& e ) {
+    std::fprintf( stderr, "convertRHTree: %s\n", e.what() );
+    return 1;
+  }
+  return 0;
+
+}
@@ -0,0 +1,93 @@
+#ifndef RecHitAnalyzer_AsyncTreeWriter_h
+#define RecHitAnalyzer_AsyncTreeWriter_h
+//
+// TTree filling on a dedicated writer thread.
+//
+// TTree::Fill() serializes and compresses all branches, which for the
+// image trees takes longer than most of the event processing. Once
+// started, push() replaces Fill(): it copies the current contents of
+// every branch object into a free slot and queues it, and the writer
+// thread points the branches to the slot and calls Fill(). There are
+// queueSize+1 slots, so the event loop runs ahead by at most queueSize
+// entries and then waits for the writer (back-pressure). A single
+// writer draining the queue in order keeps the entries in push order,
+// as with synchronous filling.
+//
+// All branches must be set up before start(): top-level object
+// branches (any class with a dictionary, std::vectors copied directly)
+// or single-leaf branches of a fundamental type. Between start() and
+// stop() the tree must not be touched by anything else. ROOT thread
+// safety must be enabled (cmsRun does it). The writer thread writes
+// baskets to the tree's file without any framework lock, so nothing
+// else may write to that file meanwhile: under cmsRun, the owning
+// module must be the only TFileService user.
+//
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TTree;
+class TBranch;
+class TClass;
+
+namespace img {
+
+  class AsyncTreeWriter {
+
+    public:
+
+      typedef void (*CopyFn) ( TClass*, const void*, void* );
+
+      ~AsyncTreeWriter ();
+
+      // Throw std::runtime_error for unsupported branches
+      void start ( TTree* tree, int queueSize );
+      bool running () const { return tree_ != nullptr; }
+
+      // Queue the current branch contents, rethrow a writer error
+      void push ();
+      // Write what is queued, join the writer and restore the
+      // branch addresses, rethrow a writer error
+      void stop ();
+
+      long long nPushed () const { return nPushed_; }
+      // push() calls that had to wait for the writer
+      long long nWaits () const { return nWaits_; }
+
+    private:
+
+      struct Column {
+        TBranch* branch;
+        TClass* cl;    // nullptr for leaf branches
+        size_t nBytes; // leaf branches
+        CopyFn copy;
+        void* live;    // address set by the owner of the tree
+      };
+
+      void run ();
+      void bind ( const std::vector<void*>& objects );
+      void release ();
+
+      TTree* tree_ = nullptr;
+      std::vector<Column> columns_;
+      std::vector<std::vector<void*>> slots_; // [slot][column]
+      std::deque<int> queue_;
+      std::vector<int> free_;
+      std::mutex mutex_;
+      std::condition_variable queued_;
+      std::condition_variable freed_;
+      std::thread thread_;
+      bool stopping_ = false;
+      std::exception_ptr error_;
+      long long nPushed_ = 0;
+      long long nWaits_ = 0;
+
+  };
+
+} // namespace img
+
+#endif
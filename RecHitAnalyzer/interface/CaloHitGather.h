@@ -0,0 +1,62 @@
+#ifndef RecHitAnalyzer_CaloHitGather_h
+#define RecHitAnalyzer_CaloHitGather_h
+//
+// Conversion of the calorimeter rechit collections into the hit
+// records of ImageKernels.h.
+//
+// Shared by the RecHitAnalyzer fills and DetectorImageProducer so
+// both make their images from the same hits: rechits with
+// energy <= zs are dropped, detector ordinals are kept as they are.
+// The EE cell centers are given by the caller, from the EventSetup
+// geometry or a GeometrySnapshot.
+//
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+#include "DataFormats/HcalDetId/interface/HcalDetId.h"
+#include "DataFormats/HcalRecHit/interface/HcalRecHitCollections.h"
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+
+#include <vector>
+
+namespace img {
+
+  // EB rechits
+  inline void gatherEBHits ( const EcalRecHitCollection& rechits, std::vector<EBHit>& hits ) {
+    hits.clear();
+    for ( const EcalRecHit& rechit : rechits ) {
+      if ( rechit.energy() <= zs ) continue;
+      EBDetId ebId( rechit.id() );
+      hits.push_back( EBHit{ ebId.ieta(), ebId.iphi(), rechit.energy(), rechit.time(), 0. } );
+    }
+  }
+
+  // EE rechits at the eta,phi of their cell centers, cellPosition(EEDetId)
+  // returns the center as a GlobalPoint
+  template <class CellPosition>
+  void gatherEEHits ( const EcalRecHitCollection& rechits, const CellPosition& cellPosition,
+                      std::vector<EtaPhiHit>& hits ) {
+    hits.clear();
+    for ( const EcalRecHit& rechit : rechits ) {
+      if ( rechit.energy() <= zs ) continue;
+      EEDetId eeId( rechit.id() );
+      const auto pos = cellPosition( eeId );
+      hits.push_back( EtaPhiHit{ eeId.zside() > 0 ? 1 : 0, pos.eta(), pos.phi(), rechit.energy() } );
+    }
+  }
+
+  // HBHE rechits, indexed by (ieta,iphi,depth)
+  inline void gatherHBHEHits ( const HBHERecHitCollection& rechits, std::vector<HBHEHit>& hits ) {
+    hits.clear();
+    for ( const HBHERecHit& rechit : rechits ) {
+      if ( rechit.energy() <= zs ) continue;
+      HcalDetId hId( rechit.id() );
+      hits.push_back( HBHEHit{ hId.ieta(), hId.iphi(), hId.depth(), rechit.energy() } );
+    }
+  }
+
+} // namespace img
+
+#endif
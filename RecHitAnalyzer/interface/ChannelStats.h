@@ -0,0 +1,81 @@
+#ifndef RecHitAnalyzer_ChannelStats_h
+#define RecHitAnalyzer_ChannelStats_h
+//
+// Streaming per-channel pixel statistics, for input normalisation.
+//
+// Count, non-zero count, min/max, mean and variance (Welford, merged
+// with Chan et al.'s pairwise formula) and approximate quantiles from
+// a log-bucket sketch: a non-zero value v goes to bucket
+// ceil(log|v| / log gamma), gamma = (1+ALPHA)/(1-ALPHA), so any
+// quantile is known to a relative accuracy of ALPHA. Zeros, most of
+// the pixels, are only counted. Everything is additive, so the stats
+// of separate jobs merge exactly as if accumulated in one pass.
+//
+// Only the non-zero pixels of an image need to be visited: add() them
+// one by one, then addZeros() for the rest.
+//
+
+#include <vector>
+
+namespace img {
+
+  class QuantileSketch {
+
+    public:
+
+      static constexpr double ALPHA = 0.01;
+      // Bucket index range, |v| ~ 1e-6 to 1e8; beyond, values are clamped
+      static const int IDX_MIN = -700;
+      static const int IDX_MAX = 930;
+      static const int NBUCKETS = IDX_MAX - IDX_MIN + 1;
+
+      QuantileSketch () : pos_( NBUCKETS, 0 ), neg_( NBUCKETS, 0 ), nZero_( 0 ) {}
+
+      void add ( float v );
+      void addZeros ( long long n ) { nZero_ += n; }
+      void merge ( const QuantileSketch& other );
+
+      // Value below which a fraction q of all entries lie, zeros included
+      double quantile ( double q ) const;
+      long long count () const;
+
+      // Bucket counts, for writing out and reading back
+      std::vector<long long>& pos () { return pos_; }
+      std::vector<long long>& neg () { return neg_; }
+      long long& nZero () { return nZero_; }
+
+      static int bucket ( double absV );
+      static double bucketValue ( int idx );
+
+    private:
+
+      std::vector<long long> pos_; // v > 0, by bucket-IDX_MIN
+      std::vector<long long> neg_; // v < 0, by bucket of |v|
+      long long nZero_;
+
+  };
+
+  class ChannelStats {
+
+    public:
+
+      long long count = 0;
+      long long nNonZero = 0;
+      double mean = 0.;
+      double m2 = 0.; // sum of squared deviations from the mean
+      float min = 0.;
+      float max = 0.;
+      QuantileSketch sketch;
+
+      void add ( float v );
+      void addZeros ( long long n );
+      void merge ( const ChannelStats& other );
+
+      double variance () const { return count > 1 ? m2/( count-1 ) : 0.; }
+      double occupancy () const { return count > 0 ? double( nNonZero )/count : 0.; }
+
+  };
+
+} // namespace img
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef RecHitAnalyzer_DetectorImage_h
+#define RecHitAnalyzer_DetectorImage_h
+//
+// Detector images of an event as an EDM product, made by
+// DetectorImageProducer and read by RecHitAnalyzer, SCRegressor and
+// SCAnalyzer ('detectorImages'), so that the images are built once per
+// event and can be kept in skims.
+//
+// Each channel has the name and nRows x nCols shape of the analyzer
+// branch it replaces. Its row-major pixels are stored sparse, as
+// (index, value) pairs of the non-zero pixels, when that is smaller
+// than the dense vector, i.e. for occupancies below 1/2.
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageBuffer.h"
+
+#include <string>
+#include <vector>
+
+namespace img {
+
+  struct DetectorImageChannel {
+    std::string name;
+    int nRows = 0;
+    int nCols = 0;
+    bool sparse = false;
+    std::vector<unsigned int> index; // sparse only
+    std::vector<float> value;        // non-zero pixels if sparse, else all
+  };
+
+  class DetectorImage {
+
+    public:
+
+      // Only the tiles written in 'image' are read (see ImageBuffer)
+      void add ( const std::string& name, const ImageBuffer& image, int nRows, int nCols );
+      void add ( const std::string& name, const std::vector<float>& image, int nRows, int nCols );
+
+      // nullptr if there is no such channel
+      const DetectorImageChannel* find ( const std::string& name ) const;
+
+      // Reset 'image' to the channel shape and write its pixels,
+      // throw std::runtime_error if there is no such channel
+      void decode ( const std::string& name, ImageBuffer& image ) const;
+      void decode ( const std::string& name, std::vector<float>& image ) const;
+
+      const std::vector<DetectorImageChannel>& channels () const { return channels_; }
+
+    private:
+
+      DetectorImageChannel& newChannel ( const std::string& name, int nRows, int nCols );
+      const DetectorImageChannel& get ( const std::string& name ) const;
+
+      std::vector<DetectorImageChannel> channels_;
+
+  };
+
+} // namespace img
+
+#endif
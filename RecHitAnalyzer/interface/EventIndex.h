@@ -0,0 +1,118 @@
+#ifndef RecHitAnalyzer_EventIndex_h
+#define RecHitAnalyzer_EventIndex_h
+//
+// Sorted (run, lumi, event, jet) -> (entry, offset) index of an
+// output file, kept next to it as <data file>.idx.
+//
+// entry/offset locate the image in the data file: RHTree entry and
+// position of the jet in the entry's jet list for ROOT output, row
+// group and row for Parquet, row and 0 for image shards (ImageShard.h).
+// jet is the index in the jet collection (photon for EBshower shards),
+// -1 for EventLevel output.
+//
+// File layout, little-endian:
+//
+//   Record[nRecords]   sorted by key, 40 bytes each
+//   char[nameLength]   data file name, relative to the .idx directory
+//   Footer             80 bytes: magic, sizes, min and max key
+//
+// Readers only load the footer when opened, then binary search the
+// records on disk, so a lookup over thousands of files reads a few
+// hundred bytes of each file whose key range matches, and nothing
+// of the others.
+//
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace img {
+
+  struct IndexKey {
+    uint32_t run;
+    uint32_t lumi;
+    uint64_t event;
+    int32_t  jet;
+    int32_t  pad_ = 0;
+  };
+  bool operator< ( const IndexKey& a, const IndexKey& b );
+
+  struct IndexRecord {
+    IndexKey key;
+    int64_t  entry;
+    int64_t  offset;
+  };
+
+  class EventIndexWriter {
+
+    public:
+
+      void add ( unsigned int run, unsigned int lumi, unsigned long long event, int jet,
+                 long long entry, long long offset );
+      size_t size () const { return records_.size(); }
+      // Sort and write, throw std::runtime_error on failure
+      void write ( const std::string& indexFile, const std::string& dataFile );
+
+    private:
+
+      std::vector<IndexRecord> records_;
+
+  };
+
+  class EventIndexReader {
+
+    public:
+
+      // Read the footer only, throw std::runtime_error if not an index
+      void open ( const std::string& indexFile );
+
+      // Records with lo <= key <= hi, appended to out
+      void scan ( const IndexKey& lo, const IndexKey& hi, std::vector<IndexRecord>& out ) const;
+
+      const std::string& indexFile () const { return indexFile_; }
+      // Data file path, resolved against the index directory
+      const std::string& dataFile () const { return dataFile_; }
+      uint64_t size () const { return nRecords_; }
+      const IndexKey& minKey () const { return minKey_; }
+      const IndexKey& maxKey () const { return maxKey_; }
+
+    private:
+
+      std::string indexFile_;
+      std::string dataFile_;
+      uint64_t nRecords_ = 0;
+      IndexKey minKey_;
+      IndexKey maxKey_;
+
+  };
+
+  // Index over the files of a dataset
+  class EventIndexSet {
+
+    public:
+
+      struct Hit {
+        IndexRecord record;
+        int file; // see dataFile()
+      };
+
+      void add ( const std::string& indexFile );
+
+      // All jets of an event if jet < 0
+      std::vector<Hit> find ( unsigned int run, unsigned int lumi, unsigned long long event, int jet = -1 ) const;
+      std::vector<Hit> scan ( const IndexKey& lo, const IndexKey& hi ) const;
+
+      size_t nFiles () const { return readers_.size(); }
+      const std::string& dataFile ( int file ) const { return readers_[file].dataFile(); }
+      uint64_t size () const;
+
+    private:
+
+      std::vector<EventIndexReader> readers_; // in order of add()
+
+  };
+
+} // namespace img
+
+#endif
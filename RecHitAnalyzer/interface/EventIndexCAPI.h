@@ -0,0 +1,45 @@
+#ifndef RecHitAnalyzer_EventIndexCAPI_h
+#define RecHitAnalyzer_EventIndexCAPI_h
+//
+// C interface to img::EventIndexSet, for ctypes (event_index.py).
+// Functions returning a count return -1 on error, see
+// img_index_error(). Lookups fill at most maxHits hits and return
+// the number found, which may be larger: call again with more room.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct img_index_hit {
+    unsigned int run;
+    unsigned int lumi;
+    unsigned long long event;
+    int jet;
+    int file;
+    long long entry;
+    long long offset;
+  };
+
+  // nullptr on error
+  void* img_index_open ( const char** indexFiles, int nFiles );
+  void img_index_close ( void* index );
+
+  int img_index_find ( void* index, unsigned int run, unsigned int lumi, unsigned long long event, int jet,
+                       struct img_index_hit* hits, int maxHits );
+  int img_index_scan ( void* index,
+                       unsigned int runLo, unsigned int lumiLo, unsigned long long eventLo, int jetLo,
+                       unsigned int runHi, unsigned int lumiHi, unsigned long long eventHi, int jetHi,
+                       struct img_index_hit* hits, int maxHits );
+
+  int img_index_nfiles ( void* index );
+  long long img_index_size ( void* index );
+  const char* img_index_file ( void* index, int file );
+  // Last error of this thread
+  const char* img_index_error ();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef RecHitAnalyzer_EventList_h
+#define RecHitAnalyzer_EventList_h
+//
+// List of selected events for the two-pass workflow.
+//
+// A selection-only pass of RecHitAnalyzer writes one line per
+// accepted event,
+//
+//   run lumi event nJets jetIdx_1 ... jetIdx_nJets
+//
+// with the indices of the jets that passed the selection (vJetIdxs).
+// The image pass reads the list back, restricts its input
+// to these events (ConfFile_cfg.py sets the source eventsToProcess)
+// and skips any other event it is given. Lines starting with '#'
+// are comments.
+//
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace img {
+
+  class EventList {
+
+    public:
+
+      struct Entry {
+        unsigned int run;
+        unsigned int lumi;
+        unsigned long long event;
+        std::vector<int> jetIdxs;
+      };
+
+      // Throw std::runtime_error if the file cannot be read or parsed
+      void read ( const std::string& fileName );
+      // Accepted event, or nullptr
+      const Entry* find ( unsigned int run, unsigned int lumi, unsigned long long event ) const;
+      size_t size () const { return entries_.size(); }
+
+      // Writing: open() throws std::runtime_error if the file cannot be created
+      void open ( const std::string& fileName );
+      void write ( unsigned int run, unsigned int lumi, unsigned long long event, const std::vector<int>& jetIdxs );
+      void close ();
+
+    private:
+
+      std::vector<Entry> entries_; // sorted by (run,lumi,event)
+      std::ofstream out_;
+
+  };
+
+} // namespace img
+
+#endif
@@ -30,25 +30,25 @@ namespace reco {
 
 
     // get p4 for charged component of tau
-    LorentzVector charge_p4() { return charge_p4_; }
+    LorentzVector charge_p4() const { return charge_p4_; }
     // get p4 for neutral component of tau (from summing together pi0's)
-    LorentzVector neutral_p4() { return neutral_p4_; }
+    LorentzVector neutral_p4() const { return neutral_p4_; }
     // get p4 for the leading pi0
-    LorentzVector lead_pi0_p4() { return lead_pi0_p4_; }
+    LorentzVector lead_pi0_p4() const { return lead_pi0_p4_; }
     // get p4 for the neutrino
-    LorentzVector nu_p4() { return nu_p4_; }
+    LorentzVector nu_p4() const { return nu_p4_; }
     // get p4 for the visible component of the tau
-    LorentzVector vis_p4() { return this->p4()-nu_p4_; }
+    LorentzVector vis_p4() const { return this->p4()-nu_p4_; }
     // get tau decay mode
-    int decay_mode() { return dm_; }
+    int decay_mode() const { return dm_; }
     // get vector of charged p4 contributions
-    std::vector<LorentzVector> charge_p4_indv() { return charge_p4_indv_; }
+    std::vector<LorentzVector> charge_p4_indv() const { return charge_p4_indv_; }
     // get vector of charged p4 contributions
-    std::vector<LorentzVector> neutral_p4_indv() { return neutral_p4_indv_; }
+    std::vector<LorentzVector> neutral_p4_indv() const { return neutral_p4_indv_; }
     // get positions and energies of charged pions at ecal entrance 
-    std::vector<std::pair<math::XYZVector, double>> pis_at_ecal() { return pis_at_ecal_;}
+    std::vector<std::pair<math::XYZVector, double>> pis_at_ecal() const { return pis_at_ecal_;}
     // get positions and enerties of neutral pions at ecal entrance 
-    std::vector<std::pair<math::XYZVector, double>> pi0s_at_ecal() { return pi0s_at_ecal_;}
+    std::vector<std::pair<math::XYZVector, double>> pi0s_at_ecal() const { return pi0s_at_ecal_;}
 
   private:
 
@@ -0,0 +1,103 @@
+#ifndef RecHitAnalyzer_GeometrySnapshot_h
+#define RecHitAnalyzer_GeometrySnapshot_h
+//
+// Local snapshot of the calorimeter geometry used to make the images.
+//
+// Holds the cell centers of EB, EE, ES and HBHE, the (eta,phi) extent
+// of the EB and HBHE cells given by their REP corners nearest the IP
+// and of the EE crystals given by their front face corners (see
+// cornerBox()), and the magnetic field at the origin. It is written once by the
+// GeometrySnapshotDumper plugin and read back by RecHitAnalyzer when
+// its 'geometrySnapshot' parameter is set, so image production does
+// not need the geometry DB or a GlobalTag.
+//
+// Cells are indexed by the hashed index of their DetId (EBDetId,
+// EEDetId, ESDetId) or, for HBHE, by hbheIndex(ieta,iphi,depth).
+// The file is a plain binary dump in host byte order.
+//
+
+#include <string>
+#include <vector>
+
+namespace img {
+
+  class GeometrySnapshot {
+
+    public:
+
+      // Cell center
+      struct Point {
+        float x;
+        float y;
+        float z;
+      };
+
+      // (eta,phi) extent of a cell: REP corners [2] (min) and [0] (max)
+      struct EtaPhiBox {
+        float minEta;
+        float maxEta;
+        float minPhi;
+        float maxPhi;
+      };
+
+      static const int EE_NCELLS      = 2*7324;       // EEDetId::kSizeForDenseIndexing
+      static const int ES_NCELLS      = 2*2*40*40*32; // ESDetId::kSizeForDenseIndexing
+      static const int HBHE_IETA_NUM  = 2*29;
+      static const int HBHE_IPHI_NUM  = 72;
+      static const int HBHE_DEPTH_NUM = 7;
+      static const int HBHE_NCELLS    = HBHE_IETA_NUM*HBHE_IPHI_NUM*HBHE_DEPTH_NUM;
+      // Dense index over (ieta,iphi,depth), ieta=[-29,...,-1,1,...,29]
+      static int hbheIndex ( int ieta, int iphi, int depth ) {
+        int ieta_ = ieta > 0 ? ieta-1 : ieta;
+        return ( ( ieta_+HBHE_IETA_NUM/2 )*HBHE_IPHI_NUM + iphi-1 )*HBHE_DEPTH_NUM + depth-1;
+      }
+
+      float bFieldZ; // [T] at (0,0,0)
+
+      std::vector<Point>     ebCenter;   // EBDetId::kSizeForDenseIndexing
+      std::vector<EtaPhiBox> ebBox;
+      std::vector<Point>     eeCenter;   // EEDetId::kSizeForDenseIndexing
+      std::vector<EtaPhiBox> eeBox;
+      std::vector<Point>     esCenter;   // ESDetId::kSizeForDenseIndexing, (0,0,0) if invalid
+      std::vector<char>      hbheSubdet; // HBHE_NCELLS: 0 if no such cell, else HcalSubdetector
+      std::vector<Point>     hbheCenter;
+      std::vector<EtaPhiBox> hbheBox;
+
+      GeometrySnapshot () : bFieldZ(0.) {}
+
+      // Extent of n corners: min,max eta, and min,max phi relative to
+      // the first corner, so boxes across phi = +-pi have minPhi > maxPhi
+      static EtaPhiBox cornerBox ( const float* eta, const float* phi, int n );
+
+      // Throw std::runtime_error on I/O or format errors
+      void write ( const std::string& fileName ) const;
+      void read  ( const std::string& fileName );
+
+      // Build the lookup tables used by the find* functions.
+      // Called by read(); call it after filling the arrays by hand.
+      void index ();
+
+      // Closest EB/EE crystal to the ECAL front face point along (eta,phi),
+      // as spr::findDetIdECAL. Returns the hashed index, or -1.
+      int findEB ( double eta, double phi ) const;
+      int findEE ( double eta, double phi ) const;
+      // HBHE cell of depth 1 whose (eta,phi) extent contains (eta,phi),
+      // as spr::findDetIdHCAL. Returns the hbheIndex, or -1.
+      int findHBHE ( double eta, double phi ) const;
+
+    private:
+
+      // EB: mean center eta of each ieta row, mean center phi of each iphi column
+      std::vector<float> ebRowEta_;
+      std::vector<float> ebColPhi_;
+      // EE: crystals bucketed by (x/|z|,y/|z|) of their centers, per endcap
+      std::vector<int> eeBucketStart_;
+      std::vector<int> eeBucketCells_;
+      // HBHE: depth 1 cells
+      std::vector<int> hbheDepth1_;
+
+  };
+
+} // namespace img
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef RecHitAnalyzer_Hash_h
+#define RecHitAnalyzer_Hash_h
+//
+// splitmix64 finalizer: every input bit affects every output bit.
+//
+// The deterministic streams of the package (Prescaler, ShardLoader,
+// ImageAugment, convertRHTree augmentations) are all built on this
+// one function, so they reproduce across platforms and releases.
+//
+
+#include <cstdint>
+
+namespace img {
+
+  inline uint64_t mix ( uint64_t x ) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = ( x ^ ( x >> 30 ) )*0xbf58476d1ce4e5b9ULL;
+    x = ( x ^ ( x >> 27 ) )*0x94d049bb133111ebULL;
+    return x ^ ( x >> 31 );
+  }
+
+} // namespace img
+
+#endif
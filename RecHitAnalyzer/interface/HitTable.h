@@ -0,0 +1,79 @@
+#ifndef RecHitAnalyzer_HitTable_h
+#define RecHitAnalyzer_HitTable_h
+//
+// Flat hit table for point-cloud / graph-network inputs.
+//
+// One row per calorimeter rechit or charged PF candidate at the ECAL
+// entrance, stored column-wise (one vector per attribute) so each column is
+// written as its own branch "hits_<column>". Like JaggedArray, the
+// columns are only cleared between events and stop allocating once
+// they have grown to the largest event seen.
+//
+// Calorimeter rows have d0 = z0 = 0 and charge = 0. PF candidate rows
+// have detId = 0 and take d0, z0 and charge from their best track.
+// 'jet' is the position of the nearest selected jet in
+// vJetIdxs when the table is restricted to jets, -1 otherwise.
+//
+
+#include <vector>
+
+namespace img {
+
+  enum HitSubdet { kHitEB, kHitEE, kHitES, kHitHBHE, kHitPFCand };
+
+  struct HitRow {
+    unsigned int detId;
+    int subdet;
+    int jet;
+    float eta;
+    float phi;
+    float x;
+    float y;
+    float z;
+    float energy;
+    float time;
+    float d0;
+    float z0;
+    int charge;
+  };
+
+  class HitTable {
+
+    public:
+
+      std::vector<unsigned int> detId;
+      std::vector<int>   subdet;
+      std::vector<int>   jet;
+      std::vector<float> eta;
+      std::vector<float> phi;
+      std::vector<float> x;
+      std::vector<float> y;
+      std::vector<float> z;
+      std::vector<float> energy;
+      std::vector<float> time;
+      std::vector<float> d0;
+      std::vector<float> z0;
+      std::vector<int>   charge;
+
+      // Start a new event, keeping the capacity
+      void clear () {
+        detId.clear(); subdet.clear(); jet.clear();
+        eta.clear(); phi.clear(); x.clear(); y.clear(); z.clear();
+        energy.clear(); time.clear(); d0.clear(); z0.clear(); charge.clear();
+      }
+
+      void push_back ( const HitRow& row ) {
+        detId.push_back( row.detId ); subdet.push_back( row.subdet ); jet.push_back( row.jet );
+        eta.push_back( row.eta ); phi.push_back( row.phi );
+        x.push_back( row.x ); y.push_back( row.y ); z.push_back( row.z );
+        energy.push_back( row.energy ); time.push_back( row.time );
+        d0.push_back( row.d0 ); z0.push_back( row.z0 ); charge.push_back( row.charge );
+      }
+
+      int size () const { return detId.size(); }
+
+  };
+
+} // namespace img
+
+#endif
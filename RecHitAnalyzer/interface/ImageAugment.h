@@ -0,0 +1,69 @@
+#ifndef RecHitAnalyzer_ImageAugment_h
+#define RecHitAnalyzer_ImageAugment_h
+//
+// Geometry-aware augmentation of batched detector images.
+//
+// Images are float32 (N, C, H, W), rows in eta and columns in phi, as
+// the image columns of the shards. Each image is rotated in phi (the
+// columns wrap around), reflected in eta and cropped, in one pass that
+// copies whole contiguous row segments, the same transform for all
+// its channels.
+//
+// Eta reflection maps row r to H-1-r. The stitched layouts are
+// symmetric about eta = 0, so this is the detector reflection:
+// on the 280-row ECAL image EE- (rows [0,55)) and EE+ ([225,280)) swap
+// and EB ([55,225)) maps onto itself, the 2x2 EE resampling blocks of
+// convertRHTree onto each other, and on the 56-row HBHE image tower
+// row t onto 55-t, which covers the ECAL rows of the reflected tower.
+// A crop of odd size reflects onto the crop centered on the reflected
+// row. One of even size reflects onto the crop centered one row
+// further, so a seed at row size/2-1 (SC crops) moves to row size/2.
+//
+// An HBHE tower is 5x5 ECAL crystals, so transforms drawn with
+// step = 5 move the ECAL image by whole towers and apply unchanged,
+// divided by 5 (scaled()), to HBHE images: the ECAL and HBHE
+// channels of an event stay aligned. ECAL images with the EE resampled
+// in 2x2 blocks, as written by convertRHTree, need step = 10: the
+// blocks start on even columns, so an odd rotation would split them.
+//
+
+#include <cstdint>
+
+namespace img {
+
+  // Transform of one image, in pixels of its reference granularity
+  struct Augmentation {
+    int phiShift = 0;  // column c goes to (c + phiShift) mod W
+    bool etaFlip = false;
+    int cropRow = 0;   // first row and column of the output in the
+    int cropCol = 0;   // rotated and reflected image
+  };
+
+  struct AugmentConfig {
+    bool rotate = false;  // random phi rotation
+    bool reflect = false; // eta reflection half of the time
+    int step = 1;         // rotations and crop offsets in multiples of step
+    int cropRows = 0;     // output size, 0 for the full image size
+    int cropCols = 0;
+    int jitter = 0;       // crop offset from the image center, up to +-jitter
+  };
+
+  // Transform of image 'key' of an nRows x nCols reference image: a
+  // function of (seed, key) only, so the same for any thread count
+  Augmentation drawAugmentation ( const AugmentConfig& config, int nRows, int nCols, uint64_t seed, uint64_t key );
+
+  // Transform of an image 'ratio' times coarser than the reference,
+  // throw std::runtime_error if not a whole number of its pixels
+  Augmentation scaled ( const Augmentation& aug, int ratio );
+
+  // n (nChannels, nRows, nCols) images to (nChannels, outRows, outCols)
+  // ones, image i transformed by aug[i]. Output rows beyond the first
+  // or last input row are set to pad[c] for channel c (0 if pad is
+  // nullptr). in and out must not overlap.
+  void transformImages ( const float* in, int n, int nChannels, int nRows, int nCols,
+                         const Augmentation* aug, int outRows, int outCols, float* out,
+                         const float* pad = nullptr );
+
+} // namespace img
+
+#endif
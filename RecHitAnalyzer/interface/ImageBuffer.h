@@ -0,0 +1,79 @@
+#ifndef RecHitAnalyzer_ImageBuffer_h
+#define RecHitAnalyzer_ImageBuffer_h
+//
+// Dense image vector that is cleared by zeroing only what was written.
+//
+// The fill functions used to assign() their full images to zero at
+// the start of every event, although only a small fraction of the
+// pixels is ever filled. ImageBuffer records, in tiles of TILE_SIZE
+// pixels, where operator[] was used since the last reset() and
+// reset() zeroes those tiles only. The pixel vector itself is what
+// gets written to the TTree, so the output is unchanged.
+//
+// Writes must go through operator[]: the vector returned by pixels()
+// is for the branch address and for reading, writes through it are
+// not tracked. Use get() or pixels() to scan an image without marking
+// it as dirty.
+//
+
+#include <algorithm>
+#include <vector>
+
+namespace img {
+
+  class ImageBuffer {
+
+    public:
+
+      static const int TILE_SIZE = 64;
+
+      // Zero what was written since the last call and set the size
+      void reset ( int nPixels ) {
+        if ( int( pixels_.size() ) != nPixels ) {
+          pixels_.assign( nPixels, 0. );
+          isDirty_.assign( ( nPixels+TILE_SIZE-1 )/TILE_SIZE, 0 );
+          dirtyTiles_.clear();
+          dirtyTiles_.reserve( isDirty_.size() );
+          return;
+        }
+        for ( int iT : dirtyTiles_ ) {
+          auto begin = pixels_.begin() + iT*TILE_SIZE;
+          auto end   = pixels_.begin() + std::min( ( iT+1 )*TILE_SIZE, nPixels );
+          std::fill( begin, end, 0. );
+          isDirty_[iT] = 0;
+        }
+        dirtyTiles_.clear();
+      }
+
+      float& operator[] ( int idx ) {
+        int iT = idx/TILE_SIZE;
+        if ( !isDirty_[iT] ) {
+          isDirty_[iT] = 1;
+          dirtyTiles_.push_back( iT );
+        }
+        return pixels_[idx];
+      }
+      float get ( int idx ) const { return pixels_[idx]; }
+
+      int size () const { return pixels_.size(); }
+      int nDirtyTiles () const { return dirtyTiles_.size(); }
+      // Tiles written since the last reset(), all others are zero
+      const std::vector<int>& dirtyTiles () const { return dirtyTiles_; }
+      // Pixel range [tileBegin(iT), tileEnd(iT)) of tile iT
+      int tileBegin ( int iT ) const { return iT*TILE_SIZE; }
+      int tileEnd ( int iT ) const { return std::min( ( iT+1 )*TILE_SIZE, size() ); }
+
+      std::vector<float>&       pixels ()       { return pixels_; }
+      const std::vector<float>& pixels () const { return pixels_; }
+
+    private:
+
+      std::vector<float> pixels_;
+      std::vector<char>  isDirty_;
+      std::vector<int>   dirtyTiles_;
+
+  };
+
+} // namespace img
+
+#endif
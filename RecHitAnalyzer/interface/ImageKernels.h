@@ -0,0 +1,279 @@
+#ifndef RecHitAnalyzer_ImageKernels_h
+#define RecHitAnalyzer_ImageKernels_h
+//
+// Geometry-independent cores of the image fill functions.
+//
+// The kernels take plain hit records (detector ordinals, cell
+// positions and energies) instead of EDM collections and write
+// the dense images (ImageBuffer) exactly as the fill functions in
+// plugins/ used to. The analyzers convert their collections
+// into these records; the standalone benchmark in bin/ feeds
+// them synthetic events, so neither cmsRun nor conditions are
+// needed to exercise the image production.
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageBuffer.h"
+
+#include <utility>
+#include <vector>
+
+namespace img {
+
+  //
+  // constants, enums and typedefs
+  //
+  static const float zs = 0.;
+
+  static const int EB_IPHI_MAX = 360;
+  static const int EB_IETA_MAX = 85;
+  static const int EB_NCELLS = 2*EB_IETA_MAX*EB_IPHI_MAX; // == EBDetId::kSizeForDenseIndexing
+  static const int EE_MAX_IX = 100;
+  static const int EE_MAX_IY = 100;
+  static const int EE_NC_PER_ZSIDE = EE_MAX_IX*EE_MAX_IY;
+  static const int HBHE_IPHI_NUM = 72;
+  static const int HBHE_IPHI_MAX = 72;
+  static const int HBHE_IETA_MAX_FINE = 20;
+  static const int HBHE_IETA_MAX_HE = 29;
+  static const int HBHE_IETA_MAX_EB = 17;
+  static const int HBHE_NCELLS_EB = 2*HBHE_IPHI_NUM*HBHE_IETA_MAX_EB;
+  static const int HBHE_NCELLS = 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1);
+  static const int ECAL_IETA_MAX_EXT = 140;
+  static const int ECAL_NCELLS = 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX;
+  static const int EE_PROJ_NETA = 5*(HBHE_IETA_MAX_HE-1-HBHE_IETA_MAX_EB); // 55 rows per endcap
+  static const int SC_CROP_SIZE = 32;
+  static const int EB_DIGI_NSAMPLES = 10;   // == EcalDataFrame::MAXSAMPLES
+  static const int EB_DIGI_NPRESAMPLES = 3; // pedestal samples
+
+  // EE-(phi,eta) projection eta edges
+  // These are generated by requiring 5 fictional crystals
+  // to uniformly span each HCAL tower in eta (as in EB).
+  static const double eta_bins_EEm[EE_PROJ_NETA+1] =
+                    {-3.    , -2.93  , -2.86  , -2.79  , -2.72  , -2.65  , -2.62  ,
+                     -2.59  , -2.56  , -2.53  , -2.5   , -2.4644, -2.4288, -2.3932,
+                     -2.3576, -2.322 , -2.292 , -2.262 , -2.232 , -2.202 , -2.172 ,
+                     -2.1462, -2.1204, -2.0946, -2.0688, -2.043 , -2.0204, -1.9978,
+                     -1.9752, -1.9526, -1.93  , -1.91  , -1.89  , -1.87  , -1.85  ,
+                     -1.83  , -1.812 , -1.794 , -1.776 , -1.758 , -1.74  , -1.7226,
+                     -1.7052, -1.6878, -1.6704, -1.653 , -1.6356, -1.6182, -1.6008,
+                     -1.5834, -1.566 , -1.5486, -1.5312, -1.5138, -1.4964, -1.479 }; // 56
+  // EE+(phi,eta) projection eta edges
+  static const double eta_bins_EEp[EE_PROJ_NETA+1] =
+                     {1.479 ,  1.4964,  1.5138,  1.5312,  1.5486,  1.566 ,  1.5834,
+                      1.6008,  1.6182,  1.6356,  1.653 ,  1.6704,  1.6878,  1.7052,
+                      1.7226,  1.74  ,  1.758 ,  1.776 ,  1.794 ,  1.812 ,  1.83  ,
+                      1.85  ,  1.87  ,  1.89  ,  1.91  ,  1.93  ,  1.9526,  1.9752,
+                      1.9978,  2.0204,  2.043 ,  2.0688,  2.0946,  2.1204,  2.1462,
+                      2.172 ,  2.202 ,  2.232 ,  2.262 ,  2.292 ,  2.322 ,  2.3576,
+                      2.3932,  2.4288,  2.4644,  2.5   ,  2.53  ,  2.56  ,  2.59  ,
+                      2.62  ,  2.65  ,  2.72  ,  2.79  ,  2.86  ,  2.93  ,  3.    }; // 56
+
+  // HBHE eta bin edges
+  static const double eta_bins_HBHE[2*(HBHE_IETA_MAX_HE-1)+1] =
+                    {-3.000, -2.650, -2.500, -2.322, -2.172, -2.043, -1.930, -1.830, -1.740, -1.653, -1.566, -1.479, -1.392, -1.305,
+                     -1.218, -1.131, -1.044, -0.957, -0.870, -0.783, -0.695, -0.609, -0.522, -0.435, -0.348, -0.261, -0.174, -0.087, 0.000,
+                      0.087,  0.174,  0.261,  0.348,  0.435,  0.522,  0.609,  0.695,  0.783,  0.870,  0.957,  1.044,  1.131,  1.218,
+                      1.305,  1.392,  1.479,  1.566,  1.653,  1.740,  1.830,  1.930,  2.043,  2.172,  2.322,  2.500,  2.650,  3.000}; // 57
+
+  // Track image channels, in the order of the ECAL_tracks* branches
+  enum TrackChannel { kTrkPt, kTrkQPt,
+                      kTrkPt_PV, kTrkQPt_PV, kTrkd0_PV, kTrkz0_PV, kTrkd0sig_PV, kTrkz0sig_PV,
+                      kTrkPt_nPV, kTrkQPt_nPV,
+                      nTrackChannels };
+
+  // Order of the EB digi samples in memory:
+  // sample-major [iS][crystal], one EB image per sample, or
+  // crystal-major [crystal][iS], the pulse of a crystal contiguous
+  enum DigiLayout { kSampleMajor, kCrystalMajor };
+
+  //
+  // hit records
+  //
+
+  // EB rechit in EBDetId ordinals: ieta=[-85,...,-1,1,...,85], iphi=[1,...,360]
+  // 'eta' is the cell center and is only needed for the SC crops.
+  struct EBHit {
+    int ieta;
+    int iphi;
+    float energy;
+    float time;
+    float eta;
+  };
+
+  // EB digi in EBDetId ordinals, ADC counts of its samples
+  struct EBDigi {
+    int ieta;
+    int iphi;
+    float adc[EB_DIGI_NSAMPLES];
+  };
+
+  // Hit given by the (eta,phi) position of its cell center
+  // iz: 0 for EE-, 1 for EE+
+  struct EtaPhiHit {
+    int iz;
+    float eta;
+    float phi;
+    float energy;
+  };
+
+  // HBHE rechit in HcalDetId ordinals
+  struct HBHEHit {
+    int ieta;
+    int iphi;
+    int depth;
+    float energy;
+  };
+
+  // HBHE cell given by the REP corners nearest the IP
+  struct HBHETower {
+    float minEta;
+    float maxEta;
+    float minPhi;
+    float maxPhi;
+    float energy;
+  };
+
+  // EE crystal center, ix,iy=[0,...,99], iz: 0 for EE-, 1 for EE+
+  struct EECell {
+    float eta;
+    float phi;
+    int ix;
+    int iy;
+    int iz;
+  };
+
+  // Track extrapolated to ECAL. EB tracks use the crystal
+  // ordinals (ieta,iphi), EE tracks the (eta,phi) position.
+  // d0 and z0 are kept in double as the EE histograms were
+  // filled with double weights.
+  struct TrackAtECAL {
+    bool isEB;
+    int ieta;
+    int iphi;
+    int iz;
+    float eta;
+    float phi;
+    float pt;
+    float qpt;
+    double d0;
+    double z0;
+    float d0sig;
+    float z0sig;
+  };
+
+  //
+  // coordinate helpers
+  //
+
+  // EBDetId ordinals -> row-major [ieta][iphi] index, same as EBDetId::hashedIndex()
+  inline int ebIndex ( int ieta, int iphi ) {
+    int ieta_ = ieta > 0 ? ieta-1 : ieta;
+    return ( ieta_+EB_IETA_MAX )*EB_IPHI_MAX + iphi-1;
+  }
+
+  // HBHE iphi -> image column
+  // NOTE: HBHE iphi = 1 does not correspond to EB iphi = 1!
+  // => Need to shift by 2 HBHE towers: HBHE::iphi: [1,...,71,72]->[3,4,...,71,72,1,2]
+  inline int hbheImageIphi ( int iphi ) {
+    int iphi_ = iphi + 2; // shift
+    iphi_ = iphi_ > HBHE_IPHI_MAX ? iphi_-HBHE_IPHI_MAX : iphi_; // wrap-around
+    return iphi_ - 1; // make histogram-friendly
+  }
+
+  // HBHE signed ieta -> signed image row in [-28,27]
+  inline int hbheImageIeta ( int ieta ) {
+    int ietaAbs = ieta > 0 ? ieta : -ieta;
+    int ietaAbs_ = ietaAbs == HBHE_IETA_MAX_HE ? HBHE_IETA_MAX_HE-1 : ietaAbs; // last HBHE ieta embedded
+    return ieta > 0 ? ietaAbs_-1 : -ietaAbs_;
+  }
+
+  // Column of the stitched ECAL image for a (phi) projection bin
+  // NOTE: EB iphi = 1 does not correspond to physical phi = -pi so need to shift!
+  inline int ecalProjIphi ( int iphiBin ) {
+    int iphi_ = iphiBin + 5*38; // shift
+    iphi_ = iphi_ > EB_IPHI_MAX ? iphi_-EB_IPHI_MAX : iphi_; // wrap-around
+    return iphi_ - 1;
+  }
+
+  // First row of EE-, EB and EE+ in the stitched ECAL image
+  inline int ecalRowOffset ( int region ) {
+    static const int offsets[3] = { 0, EE_PROJ_NETA, ECAL_IETA_MAX_EXT+EB_IETA_MAX };
+    return offsets[region];
+  }
+
+  // Same bin finding as TAxis::FindBin:
+  // 0 is underflow, nbins+1 is overflow
+  int findFixBin ( double x, int nbins, double xmin, double xmax );
+  int findVarBin ( double x, int nbins, const double* edges );
+
+  //
+  // kernels
+  //
+
+  // EB image (ieta:170 x iphi:360)
+  void fillEBImage ( const std::vector<EBHit>& hits,
+                     ImageBuffer& vEnergy, ImageBuffer& vTime );
+
+  // Stitched EE-,EB,EE+ image at EB granularity (ieta:280 x iphi:360)
+  // EE hits are projected on the (phi,eta) grid given by eta_bins_EE[m,p].
+  void fillECALstitchedImage ( const std::vector<EBHit>& ebHits, const std::vector<EtaPhiHit>& eeHits,
+                               ImageBuffer& vEnergy );
+
+  // HBHE images summed over depth:
+  // EB overlap (ieta:34 x iphi:72) and full HBHE (ieta:56 x iphi:72)
+  void fillHBHEImage ( const std::vector<HBHEHit>& hits,
+                       ImageBuffer& vEnergyEB, ImageBuffer& vEnergy );
+
+  // HE towers beyond EB split evenly over the EE crystals whose
+  // centers fall inside the tower. 'selected' is scratch space for the
+  // crystals of a tower, kept by the caller across events. If given,
+  // 'monitor' receives the (EE hashed cell, tower energy) pairs used to
+  // fill histograms.
+  void fillHCALatEEImage ( const std::vector<HBHETower>& towers, const std::vector<EECell>& eeCells,
+                           ImageBuffer vEnergy[2], std::vector<int>& selected,
+                           std::vector<std::pair<int,float> >* monitor = nullptr );
+
+  // Stitched track images, one vector per TrackChannel
+  void fillTracksAtECALstitchedImage ( const std::vector<TrackAtECAL>& tracks, double z0PVCut,
+                                       ImageBuffer* vChannels[nTrackChannels] );
+
+  // SC_CROP_SIZE x SC_CROP_SIZE crop of EB hits around a seed given in
+  // image coordinates ieta=[0,...,169], iphi=[0,...,359]. The seed sits
+  // at [15,15]. Output arrays must be zeroed by the caller.
+  void fillSCCrop ( const std::vector<EBHit>& hits, int ietaSeed, int iphiSeed,
+                    float* energy, float* energyT, float* energyZ, float* time );
+
+  // EB digis unpacked in 'layout' into EB_DIGI_NSAMPLES x EB_NCELLS
+  // values, each pedestal subtracted: minus the mean of its first
+  // EB_DIGI_NPRESAMPLES samples. Crystals without a digi are zero.
+  // The seed is the crystal of largest sample 'seedSample' (the first
+  // one in EB hashed index order on ties), in image coordinates
+  // ieta=[0,...,169], iphi=[0,...,359], -1 if there are no digis.
+  void fillEBDigiImage ( const std::vector<EBDigi>& digis, DigiLayout layout, int seedSample,
+                         ImageBuffer& vAdc, int& ietaSeed, int& iphiSeed );
+
+  // size x size crop of all samples of fillEBDigiImage around (ieta,iphi),
+  // in the same layout: (EB_DIGI_NSAMPLES, size, size) or (size, size,
+  // EB_DIGI_NSAMPLES). The crop is placed as in cropImage: phi wraps
+  // around, rows beyond EB are zero.
+  void cropEBDigiImage ( const ImageBuffer& vAdc, DigiLayout layout, int ieta, int iphi, int size, float* out );
+
+  // Image pyramid levels of a nRows x nCols image, row-major.
+  // Only the tiles written in 'src' are read (see ImageBuffer).
+  // Downsampling sums factor x factor blocks into a
+  // ceil(nRows/factor) x ceil(nCols/factor) image, incomplete blocks
+  // at the end being zero padded (as skimage block_reduce).
+  // Upsampling spreads each pixel evenly over a factor x factor block,
+  // keeping the image sum (as upsample_array in convert_root2pq_jet.py).
+  void downsampleImage ( const ImageBuffer& src, int nRows, int nCols, int factor, ImageBuffer& dst );
+  void upsampleImage   ( const ImageBuffer& src, int nRows, int nCols, int factor, ImageBuffer& dst );
+
+  // size x size crop of a nRows x nCols image centered on (row,col):
+  // rows [row-size/2, row-size/2+size), columns likewise but wrapping
+  // around (phi), zero beyond the first/last row. Crop pixel (r,c) goes
+  // to out[r*rowStride + c*colStride], so channels can be interleaved.
+  void cropImage ( const ImageBuffer& src, int nRows, int nCols, int row, int col, int size,
+                   float* out, int rowStride, int colStride );
+
+} // namespace img
+
+#endif
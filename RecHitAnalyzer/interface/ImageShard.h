@@ -0,0 +1,142 @@
+#ifndef RecHitAnalyzer_ImageShard_h
+#define RecHitAnalyzer_ImageShard_h
+//
+// Training shard: a table of rows that can be memory-mapped and read
+// without a decoding library, written by convertRHTree and read by
+// ShardLoader (ShardLoader.h) or, if dense, as a numpy structured array
+// (image_shard.py).
+//
+// Each row holds the columns back to back, every column a scalar or an
+// array of up to 4 dimensions of float32, int32 or int64, aligned to
+// its element size. Rows are padded to a multiple of 8 bytes. A float32
+// column can be stored
+//   quantized  as int16 q, the value being q*scale
+//   sparse     as the non-zero elements only: the column slot holds
+//              their number n and the position of (uint32 index[n],
+//              value[n]) after the fixed part of the row
+// or both. A shard with sparse columns has rows of varying size.
+//
+// File layout, little-endian:
+//
+//   Row[nRows]                   rowBytes each, or variable
+//   uint64 rowOffset[nRows+1]    only if variable (rowBytes = 0)
+//   Column[nColumns]             80 bytes each: name, type, shape,
+//                                offset in the row, sparse, scale
+//   Footer                       40 bytes: magic, version, sizes
+//
+// The rows start at offset 0, so with fixed-size rows row i is at
+// i*rowBytes. Version 1 shards (dense float32/int32/int64 only, names
+// of up to 47 characters) are still read.
+//
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace img {
+
+  enum class ShardType : uint32_t { Float32 = 0, Int32 = 1, Int64 = 2 };
+
+  struct ShardColumn {
+    std::string name;
+    ShardType type;
+    std::vector<int> shape; // empty for scalars
+    bool sparse = false;
+    float scale = 0.;       // > 0: quantized
+    size_t offset = 0;      // in the dense row given to ShardWriter::write()
+    size_t storedOffset = 0; // in the stored row
+    size_t size () const;   // elements
+    size_t nBytes () const; // dense
+    size_t elementBytes () const; // stored
+  };
+
+  class ShardWriter {
+
+    public:
+
+      static const int MAX_NAME = 39;
+      static const int MAX_DIMS = 4;
+
+      ~ShardWriter ();
+
+      // Columns are defined before open(), throw std::runtime_error.
+      // Only float32 arrays can be sparse, only float32 quantized.
+      void addColumn ( const std::string& name, ShardType type, const std::vector<int>& shape = {},
+                       bool sparse = false, float scale = 0. );
+      const std::vector<ShardColumn>& columns () const { return columns_; }
+      // -1 if there is no such column
+      int column ( const std::string& name ) const;
+      // Of the dense rows given to write()
+      size_t rowBytes () const { return rowBytes_; }
+
+      // Throw std::runtime_error on failure
+      void open ( const std::string& file );
+      // nRows dense rows of rowBytes() each, encoded as stored
+      void write ( const char* rows, size_t nRows );
+      // Write the row offsets, schema and footer
+      void close ();
+
+      long long nRows () const { return nRows_; }
+
+    private:
+
+      void encode ( const char* row );
+
+      std::vector<ShardColumn> columns_;
+      size_t rowBytes_ = 0;
+      size_t storedBytes_ = 0; // fixed part
+      bool encoded_ = false;   // any sparse or quantized column
+      bool variable_ = false;  // any sparse column
+      std::string file_;
+      std::ofstream out_;
+      long long nRows_ = 0;
+      uint64_t position_ = 0;
+      std::vector<uint64_t> rowOffsets_; // variable only
+      std::vector<char> encodedRow_;
+
+  };
+
+  // Memory-mapped shard
+  class ShardReader {
+
+    public:
+
+      ~ShardReader ();
+
+      // Throw std::runtime_error if not a shard
+      void open ( const std::string& file );
+      void close ();
+
+      const std::string& file () const { return file_; }
+      long long nRows () const { return nRows_; }
+      const std::vector<ShardColumn>& columns () const { return columns_; }
+      int column ( const std::string& name ) const;
+
+      const char* row ( long long i ) const {
+        return data_ + ( rowBytes_ ? i*rowBytes_ : rowOffsets_[i] );
+      }
+      // Column of a row, expanded and dequantized into 'size()'
+      // floats, each channel (first dimension, one channel for
+      // scalars) transformed as (x - shift[c])*factor[c] if given
+      void decodeFloat ( const char* row, const ShardColumn& column, float* out,
+                         const float* shift = nullptr, const float* factor = nullptr ) const;
+      // Column of a row in its own type, int32 or int64 columns only
+      void decodeInt ( const char* row, const ShardColumn& column, void* out ) const;
+
+    private:
+
+      std::string file_;
+      int fd_ = -1;
+      const char* data_ = nullptr;
+      size_t mapBytes_ = 0;
+      long long nRows_ = 0;
+      uint64_t rowBytes_ = 0;
+      const uint64_t* rowOffsets_ = nullptr;
+      std::vector<ShardColumn> columns_;
+
+  };
+
+} // namespace img
+
+#endif
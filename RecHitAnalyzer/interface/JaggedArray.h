@@ -0,0 +1,52 @@
+#ifndef RecHitAnalyzer_JaggedArray_h
+#define RecHitAnalyzer_JaggedArray_h
+//
+// Flattened variable-length output: one value array for all rows
+// of the event plus an offset array, row i being
+// values[offsets[i]] ... values[offsets[i+1]-1].
+//
+// Used instead of std::vector<std::vector<T>> branches, which
+// allocate one inner vector per row and event. The two arrays are
+// owned by the analyzer and only cleared between events, so once
+// they have grown to the largest event seen they act as a per-module
+// arena and filling them does not allocate.
+//
+// Stored as two branches, "<name>" (values) and "<name>_offsets"
+// (nRows+1 entries, starting at 0).
+//
+
+#include <vector>
+
+namespace img {
+
+  template<class T>
+  class JaggedArray {
+
+    public:
+
+      std::vector<T>   values;
+      std::vector<int> offsets;
+
+      JaggedArray () : offsets( 1, 0 ) {}
+
+      // Start a new event, keeping the capacity
+      void clear () {
+        values.clear();
+        offsets.resize( 1 );
+        offsets[0] = 0;
+      }
+
+      // Append to the row being filled
+      void push_back ( const T& v ) { values.push_back( v ); }
+      // Close the row being filled, possibly empty
+      void endRow () { offsets.push_back( values.size() ); }
+
+      int nRows () const { return offsets.size()-1; }
+      int rowSize ( int i ) const { return offsets[i+1] - offsets[i]; }
+      const T* row ( int i ) const { return values.data() + offsets[i]; }
+
+  };
+
+} // namespace img
+
+#endif
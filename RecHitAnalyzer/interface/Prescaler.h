@@ -0,0 +1,53 @@
+#ifndef RecHitAnalyzer_Prescaler_h
+#define RecHitAnalyzer_Prescaler_h
+//
+// Deterministic random prescale of selected events or jets.
+//
+// The keep probability p(x,y) is looked up in a 2D table, binned in
+// x and y edges, e.g. (m0, pT) of the diphoton or (pT, |eta|) of a
+// jet. Outside the table everything is kept. The random number is a
+// hash of (run, lumi, event, index) and the seed, not a generator
+// state, so the decision for a given event or jet is the same in
+// every job, pass and thread, whatever the event order. A kept
+// candidate carries the weight 1/p, so weighted distributions are
+// those before sampling.
+//
+
+#include <vector>
+
+namespace img {
+
+  class Prescaler {
+
+    public:
+
+      // keepProb: nX*nY probabilities in [0,1], x-major (iX*nY + iY).
+      // Throw std::runtime_error if the table is inconsistent.
+      // No edges: disabled, everything kept with weight 1
+      void configure ( const std::vector<double>& xEdges, const std::vector<double>& yEdges,
+                       const std::vector<double>& keepProb, unsigned int seed );
+      bool empty () const { return xEdges_.empty(); }
+
+      // Keep probability at (x,y), 1 outside the table
+      double keepProb ( double x, double y ) const;
+      // Weight 1/p if kept, 0 if dropped. idx tells apart the jets
+      // of an event, -1 for a whole event
+      double sample ( double x, double y, unsigned int run, unsigned int lumi,
+                      unsigned long long event, int idx ) const;
+
+      // Uniform in [0,1) from the hash of (run, lumi, event, idx, seed)
+      static double uniform ( unsigned int run, unsigned int lumi,
+                              unsigned long long event, int idx, unsigned int seed );
+
+    private:
+
+      std::vector<double> xEdges_;
+      std::vector<double> yEdges_;
+      std::vector<double> keepProb_;
+      unsigned int seed_ = 0;
+
+  };
+
+} // namespace img
+
+#endif
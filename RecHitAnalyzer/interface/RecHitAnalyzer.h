@@ -13,6 +13,7 @@
 
 // system include files
 #include <memory>
+#include <map>
 #include <vector>
 
 // user include files
@@ -59,6 +60,7 @@
 #include "TH1.h"
 #include "TH2.h"
 #include "TH3.h"
+#include "TProfile.h"
 #include "TProfile2D.h"
 #include "TTree.h"
 #include "TCanvas.h"
@@ -79,6 +81,16 @@
 #include "DataFormats/BTauReco/interface/JetTag.h"
 #include "DataFormats/BTauReco/interface/CandIPTagInfo.h"
 #include "MLAnalyzer/RecHitAnalyzer/interface/GenTau.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/GeometrySnapshot.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventList.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/TriggerSelector.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/TrackerTransforms.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ChannelStats.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/Prescaler.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventIndex.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/AsyncTreeWriter.h"
 
 #include "MagneticField/Engine/interface/MagneticField.h"
 #include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
@@ -138,7 +150,6 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     //edm::InputTag trackTags_; //used to select what tracks to read from configuration file
 
     // Diagnostic histograms
-    //TH2D * hEB_adc[EcalDataFrame::MAXSAMPLES]; 
     //TH1D * hHBHE_depth; 
     TH1F *h_sel;
 
@@ -146,7 +157,6 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     TTree* RHTree;
 
     // Objects used to fill RHTree branches
-    //std::vector<float> vEB_adc_[EcalDataFrame::MAXSAMPLES];
     //std::vector<float> vFC_inputs_;
     //math::PtEtaPhiELorentzVectorD vPho_[2];
   
@@ -154,6 +164,7 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void branchesEvtSel         ( TTree*, edm::Service<TFileService>& );
     void branchesEvtSel_jet     ( TTree*, edm::Service<TFileService>& );
     void branchesEB             ( TTree*, edm::Service<TFileService>& );
+    void branchesEBdigis        ( TTree*, edm::Service<TFileService>& );
     void branchesEE             ( TTree*, edm::Service<TFileService>& );
     void branchesES             ( TTree*, edm::Service<TFileService>& );
     //void branchesESatEE         ( TTree*, edm::Service<TFileService>& );
@@ -172,10 +183,15 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void branchesJetInfoAtECALstitched   ( TTree*, edm::Service<TFileService>& );
     void branchesPFEB             ( TTree*, edm::Service<TFileService>& );
     void branchesPFHBHE           ( TTree*, edm::Service<TFileService>& );
+    void branchesImagePyramid     ( TTree*, edm::Service<TFileService>& );
+    void branchesHitList          ( TTree*, edm::Service<TFileService>& );
+    void branchesChannelStats     ( TTree*, edm::Service<TFileService>& );
 
     bool runEvtSel          ( const edm::Event&, const edm::EventSetup& );
     bool runEvtSel_jet      ( const edm::Event&, const edm::EventSetup& );
+    void fillEvtSel_jet     ( const edm::Event&, const edm::EventSetup& );
     void fillEB             ( const edm::Event&, const edm::EventSetup& );
+    void fillEBdigis        ( const edm::Event&, const edm::EventSetup& );
     void fillEE             ( const edm::Event&, const edm::EventSetup& );
     void fillES             ( const edm::Event&, const edm::EventSetup& );
     //void fillESatEE         ( const edm::Event&, const edm::EventSetup& );
@@ -194,12 +210,19 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void fillJetInfoAtECALstitched   ( const edm::Event&, const edm::EventSetup& );
     void fillPFEB             ( const edm::Event&, const edm::EventSetup& );
     void fillPFHBHE           ( const edm::Event&, const edm::EventSetup& );
+    void fillImagePyramid     ( const edm::Event&, const edm::EventSetup& );
+    void fillHitList          ( const edm::Event&, const edm::EventSetup& );
+    void fillChannelStats     ( const edm::Event&, const edm::EventSetup& );
+    void writeChannelStats    ();
+    void runFills             ( const edm::Event&, const edm::EventSetup& );
     void TrackMatching ( const edm::Event& iEvent, const edm::EventSetup& iSetup );
 
     const reco::PFCandidate* getPFCand(edm::Handle<PFCollection> pfCands, float eta, float phi, float& minDr, bool debug = false);
     const reco::Track* getTrackCand(edm::Handle<reco::TrackCollection> trackCands, float eta, float phi, float& minDr, bool debug = false);
     int   getTruthLabel(const reco::PFJetRef& recJet, edm::Handle<reco::GenParticleCollection> genParticles, float dRMatch = 0.4, bool debug = false);
-    std::pair<int, reco::GenTau*>  getTruthLabelForTauJets(const reco::PFJetRef& recJet, edm::Handle<reco::GenParticleCollection> genParticles, edm::Handle<reco::GenJetCollection> genJets, double magneticField, float dRMatch = 0.4, bool debug = false);
+    std::pair<int, reco::GenTau>  getTruthLabelForTauJets(const reco::PFJetRef& recJet, edm::Handle<reco::GenParticleCollection> genParticles, const std::vector<reco::GenTau>& gen_taus, const std::vector<reco::GenTau>& gen_taus_like_jets, float dRMatch = 0.4, bool debug = false);
+    static std::vector<reco::GenTau> BuildTauJets(edm::Handle<reco::GenParticleCollection> genParticles, double magneticField, bool include_leptonic, bool use_prompt);
+    static std::vector<reco::GenTau> BuildTauLikeJets(edm::Handle<reco::GenJetCollection> genJets, double magneticField);
     float getBTaggingValue(const reco::PFJetRef& recJet, edm::Handle<edm::View<reco::Jet> >& recoJetCollection, edm::Handle<reco::JetTagCollection>& btagCollection, float dRMatch = 0.1, bool debug= false );
     math::XYZVector GetPi0Direction(math::XYZPoint vertex, double releta, double relphi, double seedeta, double seedphi);
 
@@ -220,10 +243,119 @@ class RecHitAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void fillEvtSel_jet_dijet      ( const edm::Event&, const edm::EventSetup& );
     void fillEvtSel_jet_dijet_gg_qq( const edm::Event&, const edm::EventSetup& );
     void fillEvtSel_jet_taujet      ( const edm::Event&, const edm::EventSetup& );
+    struct TaujetJet;
+    void processJet_taujet         ( const reco::PFJetRef&, const edm::Handle<reco::GenParticleCollection>&,
+                                     const std::vector<reco::GenTau>&, const std::vector<reco::GenTau>&, TaujetJet& );
 
 
     int nTotal, nPassed;
 
+    // Random prescale of the selected events ((m0,pT) of the diphoton)
+    // or jets ((pT,|eta|)), from the 'prescale' table, applied at the
+    // end of the selection so dropped candidates cost no image work.
+    // Kept ones are written with weight 1/p
+    img::Prescaler prescaler_;
+    int nPrescaled_;
+
+    // Images that can be resampled into pyramid levels, by branch name.
+    // Registered by the branches*() functions.
+    struct ImageChannel {
+      img::ImageBuffer* image;
+      int nRows;
+      int nCols;
+    };
+    std::map<std::string, ImageChannel> imageChannels_;
+    void registerImage ( const std::string& name, img::ImageBuffer& image, int nRows, int nCols ) {
+      imageChannels_[name] = ImageChannel{ &image, nRows, nCols };
+    }
+    // Configured by 'imagePyramid', branch <channel>_down<factor> or _up<factor>
+    struct PyramidLevel {
+      std::string channel;
+      int factor;
+      bool upsample;
+      ImageChannel source;
+      img::ImageBuffer image;
+    };
+    std::vector<PyramidLevel> pyramidLevels_;
+    // Per-channel pixel statistics over the job, if 'channelStats'
+    bool doChannelStats_;
+    std::map<std::string, img::ChannelStats> channelStats_;
+
+    // Output mode: dense image branches ('writeImages') and/or a flat
+    // hit table for point-cloud models ('writeHits', see HitTable.h),
+    // restricted to hits within 'hitListJetDR' of a selected jet if > 0
+    bool writeImages_;
+    bool writeHits_;
+    double hitListJetDR_;
+    // Tracker hits per layer as a sparse tensor, see fillTRKlayersAtEBEE
+    bool doTRKlayers_;
+    // Pedestal-subtracted EB digi crop around the max crystal, see fillEBdigis
+    bool doEBdigis_;
+    img::DigiLayout ebDigiLayout_;
+    int ebDigiSeedSample_;
+    // Run the independent fills as parallel tasks, see runFills(),
+    // and the taujet jets in parallel, see fillEvtSel_jet_taujet()
+    bool parallelFills_;
+    // Images of a DetectorImageProducer product ('detectorImages'),
+    // decoded instead of filled when given, see getDetectorImages()
+    bool useDetectorImages_;
+    edm::EDGetTokenT<img::DetectorImage> detectorImagesT_;
+    bool  getDetectorImages ( const edm::Event&, const std::vector<std::string>& names );
+
+    // Two-pass workflow: 'selectionOnly' runs the event selection and
+    // writes the accepted events to 'eventList', without any images;
+    // otherwise a non-empty 'eventList' is read and restricts the
+    // image pass to the listed events
+    bool selectionOnly_;
+    std::string eventListName_;
+    std::unique_ptr<img::EventList> eventList_;
+    int nJetIdxMismatch_;
+
+    // Sorted (run,lumi,event,jet) -> (RHTree entry, jet position) index
+    // of the output, written at endJob next to it as <output>.idx
+    bool writeEventIndex_;
+    img::EventIndexWriter eventIndex_;
+
+    // RHTree filled on a writer thread, at most 'asyncOutputQueue'
+    // entries behind the event loop; synchronous Fill() if 0. Outside
+    // the TFileService resource: only with no other TFileService user
+    int asyncOutputQueue_;
+    img::AsyncTreeWriter treeWriter_;
+
+    // In-situ inference if 'inference' has a modelPath: the images
+    // are scored by an ONNX model in batches and only the scores are
+    // written, see RHAnalyzer_runInference.cc
+    bool doInference_;
+    void branchesInference ( const edm::ParameterSet&, edm::Service<TFileService>& );
+    void queueInference ( const edm::Event& );
+    void runInferenceBatch ();
+    void endInference ();
+
+    // Optional HLT requirement: any of the 'hltPaths' patterns
+    edm::EDGetTokenT<edm::TriggerResults> trgResultsT_;
+    img::TriggerSelector hltSelector_;
+
+    // Geometry access: from the EventSetup, or from a local
+    // snapshot if 'geometrySnapshot' is set (no conditions needed)
+    std::unique_ptr<img::GeometrySnapshot> geoSnapshot_;
+    const CaloGeometry* caloGeom_;
+    double magneticField_;
+    void  setupCaloGeometry  ( const edm::EventSetup& );
+    void  setupMagneticField ( const edm::EventSetup& );
+    GlobalPoint getCellPosition ( const DetId& ) const;
+    void  getCellEtaPhiBox ( const DetId&, float& minEta, float& maxEta, float& minPhi, float& maxPhi ) const;
+    DetId findDetIdECAL ( double eta, double phi ) const;
+    DetId findDetIdHCAL ( double eta, double phi ) const;
+
+    // Tracker module placements, rebuilt when the tracker geometry
+    // changes. getTRKhits() gives the valid tracker rechits of the
+    // event in global coordinates, with the module layer as in
+    // fillTRKlayersAtEBEE.
+    img::TrackerTransforms tkTransforms_;
+    unsigned long long tkTransformsCacheId_;
+    void  setupTrackerTransforms ( const edm::EventSetup& );
+    void  getTRKhits ( const edm::Event&, const edm::EventSetup&, img::TrackerHitBatch& );
+
 }; // class RecHitAnalyzer
 
 //
@@ -240,6 +372,15 @@ static const int nTIB = 4;
 static const int nTID = 3;
 static const int nBPIX = 4;
 static const int nFPIX = 3;
+// Tracker layers numbered across subdetectors: TOB 0-5, TEC 6-14,
+// TIB 15-18, TID 19-21, BPIX 22-25, FPIX 26-28
+static const int TRK_LAYER_OFFSET_TOB  = 0;
+static const int TRK_LAYER_OFFSET_TEC  = TRK_LAYER_OFFSET_TOB + nTOB;
+static const int TRK_LAYER_OFFSET_TIB  = TRK_LAYER_OFFSET_TEC + nTEC;
+static const int TRK_LAYER_OFFSET_TID  = TRK_LAYER_OFFSET_TIB + nTIB;
+static const int TRK_LAYER_OFFSET_BPIX = TRK_LAYER_OFFSET_TID + nTID;
+static const int TRK_LAYER_OFFSET_FPIX = TRK_LAYER_OFFSET_BPIX + nBPIX;
+static const int TRK_NLAYERS           = TRK_LAYER_OFFSET_FPIX + nFPIX; // 29
 
 static const int EB_IPHI_MIN = EBDetId::MIN_IPHI;//1;
 static const int EB_IPHI_MAX = EBDetId::MAX_IPHI;//360;
@@ -268,35 +409,11 @@ static const int ES_NC_PER_ZSIDE = ESDetId::IX_MAX*ESDetId::IY_MAX;
 
 static const float zs = 0.;
 
-// EE-(phi,eta) projection eta edges
-// These are generated by requiring 5 fictional crystals
-// to uniformly span each HCAL tower in eta (as in EB).
-static const double eta_bins_EEm[5*(hcaldqm::constants::IETA_MAX_HE-1-HBHE_IETA_MAX_EB)+1] =
-                  {-3.    , -2.93  , -2.86  , -2.79  , -2.72  , -2.65  , -2.62  ,
-                   -2.59  , -2.56  , -2.53  , -2.5   , -2.4644, -2.4288, -2.3932,
-                   -2.3576, -2.322 , -2.292 , -2.262 , -2.232 , -2.202 , -2.172 ,
-                   -2.1462, -2.1204, -2.0946, -2.0688, -2.043 , -2.0204, -1.9978,
-                   -1.9752, -1.9526, -1.93  , -1.91  , -1.89  , -1.87  , -1.85  ,
-                   -1.83  , -1.812 , -1.794 , -1.776 , -1.758 , -1.74  , -1.7226,
-                   -1.7052, -1.6878, -1.6704, -1.653 , -1.6356, -1.6182, -1.6008,
-                   -1.5834, -1.566 , -1.5486, -1.5312, -1.5138, -1.4964, -1.479 }; // 56
-// EE+(phi,eta) projection eta edges
-static const double eta_bins_EEp[5*(hcaldqm::constants::IETA_MAX_HE-1-HBHE_IETA_MAX_EB)+1] =
-                   {1.479 ,  1.4964,  1.5138,  1.5312,  1.5486,  1.566 ,  1.5834,
-                    1.6008,  1.6182,  1.6356,  1.653 ,  1.6704,  1.6878,  1.7052,
-                    1.7226,  1.74  ,  1.758 ,  1.776 ,  1.794 ,  1.812 ,  1.83  ,
-                    1.85  ,  1.87  ,  1.89  ,  1.91  ,  1.93  ,  1.9526,  1.9752,
-                    1.9978,  2.0204,  2.043 ,  2.0688,  2.0946,  2.1204,  2.1462,
-                    2.172 ,  2.202 ,  2.232 ,  2.262 ,  2.292 ,  2.322 ,  2.3576,
-                    2.3932,  2.4288,  2.4644,  2.5   ,  2.53  ,  2.56  ,  2.59  ,
-                    2.62  ,  2.65  ,  2.72  ,  2.79  ,  2.86  ,  2.93  ,  3.    }; // 56
-
-// HBHE eta bin edges
-static const double eta_bins_HBHE[2*(hcaldqm::constants::IETA_MAX_HE-1)+1] =
-                  {-3.000, -2.650, -2.500, -2.322, -2.172, -2.043, -1.930, -1.830, -1.740, -1.653, -1.566, -1.479, -1.392, -1.305,
-                   -1.218, -1.131, -1.044, -0.957, -0.870, -0.783, -0.695, -0.609, -0.522, -0.435, -0.348, -0.261, -0.174, -0.087, 0.000,
-                    0.087,  0.174,  0.261,  0.348,  0.435,  0.522,  0.609,  0.695,  0.783,  0.870,  0.957,  1.044,  1.131,  1.218,
-                    1.305,  1.392,  1.479,  1.566,  1.653,  1.740,  1.830,  1.930,  2.043,  2.172,  2.322,  2.500,  2.650,  3.000}; // 57
+// EE-,EE+(phi,eta) projection and HBHE eta bin edges
+// are shared with the image kernels
+using img::eta_bins_EEm;
+using img::eta_bins_EEp;
+using img::eta_bins_HBHE;
 //
 // static data member definitions
 //
@@ -60,6 +60,9 @@
 #include "DataFormats/Math/interface/deltaPhi.h"
 #include "Calibration/IsolatedParticles/interface/DetIdFromEtaPhi.h"
 #include "RecoEcal/EgammaCoreTools/interface/EcalClusterLazyTools.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/TriggerSelector.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
 
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
 #include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
@@ -118,8 +121,12 @@ class SCRegressor : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     edm::EDGetTokenT<pat::IsolatedTrackCollection> trackCollectionT_;
     edm::EDGetTokenT<double> rhoLabel_;
     edm::EDGetTokenT<edm::TriggerResults> trgResultsT_;
+    img::TriggerSelector hltSelector_; // hltPaths, resolved once per trigger menu
     edm::EDGetTokenT<GenEventInfoProduct> genInfoT_;
     edm::EDGetTokenT<LHEEventProduct> lheEventT_;
+    // EB images from a DetectorImageProducer product, if 'detectorImages' is set
+    bool useDetectorImages_;
+    edm::EDGetTokenT<img::DetectorImage> detectorImagesT_;
 
     static const int nPhotons = 2;
     //static const int nPhotons = 1;
@@ -154,6 +161,7 @@ class SCRegressor : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void branchesTracksAtEBEE ( TTree*, edm::Service<TFileService>& );
     void branchesPhoVars ( TTree*, edm::Service<TFileService>& );
     void branchesEvtWgt ( TTree*, edm::Service<TFileService>& );
+    void branchesMvPt ( TTree*, edm::Service<TFileService>& );
 
     void fillSC     ( const edm::Event&, const edm::EventSetup& );
     void fillSCaod  ( const edm::Event&, const edm::EventSetup& );
@@ -162,6 +170,7 @@ class SCRegressor : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     void fillTracksAtEBEE ( const edm::Event&, const edm::EventSetup& );
     void fillPhoVars ( const edm::Event&, const edm::EventSetup& );
     void fillEvtWgt ( const edm::Event&, const edm::EventSetup& );
+    void fillMvPt ( const edm::Event&, const edm::EventSetup& );
 
     void branchesPiSel       ( TTree*, edm::Service<TFileService>& );
     void branchesPhotonSel   ( TTree*, edm::Service<TFileService>& );
@@ -195,10 +204,11 @@ class SCRegressor : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     std::vector<float> vIeta_Emax_;
 
     //std::vector<std::vector<float>> vEB_SCenergy_;
-    std::vector<std::vector<float>> vSC_energy_;
-    std::vector<std::vector<float>> vSC_energyT_;
-    std::vector<std::vector<float>> vSC_energyZ_;
-    std::vector<std::vector<float>> vSC_time_;
+    // nPho crops of crop_size*crop_size, back to back
+    std::vector<float> vSC_energy_;
+    std::vector<float> vSC_energyT_;
+    std::vector<float> vSC_energyZ_;
+    std::vector<float> vSC_time_;
 
     TProfile2D * hSCaod_energy;
     TProfile2D * hSCaod_time;
@@ -294,6 +304,11 @@ class SCRegressor : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     //TProfile2D * hnPho;
     TH2F * hnPho;
     TH2F * hnPhoGt2;
+    // (m0,pT) occupancy for the flattening weights, see SCRegressor_fillMvPt.cc
+    TH2F * hMvPt;
+    edm::ParameterSet mvptCfg_;
+    float mvptMinPt_;
+    float mvptMaxDR_;
     TH1F * hdR_nPhoGt2;
     TH2F * hdPhidEta_nPhoGt2;
     TProfile2D * hdPhidEta_jphoPt_o_iphoPt;
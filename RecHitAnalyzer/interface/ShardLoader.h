@@ -0,0 +1,133 @@
+#ifndef RecHitAnalyzer_ShardLoader_h
+#define RecHitAnalyzer_ShardLoader_h
+//
+// Prefetching batch loader over image shards (ImageShard.h), for
+// training.
+//
+// The shards are memory-mapped and the rows of each epoch are decoded
+// into batches by nThreads worker threads, up to 'prefetch' batches
+// ahead of the consumer, so reading and decoding overlap the training
+// step. Float columns come out as float32, sparse and quantized ones
+// expanded, optionally normalised per channel (first dimension) as
+// (x - mean)/std; integer columns come out in their own type.
+//
+// The order of an epoch depends only on the seed, the epoch number and
+// the shards: with a shuffle buffer of n > 1, the shards are taken in a
+// random order, each in blocks of rows in a random order, and the rows
+// go through a buffer of n from which they are drawn at random, as
+// tf.data shuffle(). With n <= 1 the rows are read in order.
+//
+// Image columns can be augmented (ImageAugment.h), each row by its own
+// random transform, drawn from the seed, the epoch and the position in
+// the epoch. The transform is added as an int32 column 'augment':
+// phi shift, eta flip, first crop row and column, in pixels of the
+// first augmented column.
+//
+// next() returns the columns of the next batch in buffers owned by the
+// loader, valid until the following next() or startEpoch(). Not thread
+// safe: one consumer per loader.
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageAugment.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageShard.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace img {
+
+  class ShardLoader {
+
+    public:
+
+      struct Config {
+        std::vector<std::string> files;
+        std::vector<std::string> columns; // all if empty
+        int batchSize = 32;
+        int nThreads = 4;
+        int shuffleBuffer = 0;
+        uint64_t seed = 0;
+        bool dropLast = false;
+        int prefetch = 8;                  // batches
+      };
+
+      ~ShardLoader ();
+
+      // Throw std::runtime_error if a shard cannot be read or the shards
+      // differ in the columns used
+      void open ( const Config& config );
+
+      // (x - mean[c])/std[c] for channel c of a float column, from the
+      // next epoch on (ends the current one), throw std::runtime_error
+      // if not as many values as channels
+      void setNormalization ( const std::string& column, const std::vector<float>& mean, const std::vector<float>& std );
+
+      // Transform the (C,H,W) float columns by config, from the next
+      // epoch on (ends the current one). Columns coarser than the first
+      // by an integer ratio (HBHE at ECAL) get the transform scaled
+      // down, throw std::runtime_error if it is not whole pixels.
+      void setAugmentation ( const std::vector<std::string>& columns, const AugmentConfig& config );
+
+      // Output columns: name, type and shape of one row
+      const std::vector<ShardColumn>& columns () const { return columns_; }
+      long long nRows () const { return nRows_; }
+      long long nBatches () const;
+
+      // Start reading epoch 'epoch', from its first batch
+      void startEpoch ( int epoch );
+      // Rows in the next batch (0 at the end of the epoch) and its
+      // columns in data, throw std::runtime_error if reading failed
+      int next ( std::vector<const void*>& data );
+
+    private:
+
+      struct Sample {
+        int file;
+        long long row;
+      };
+      struct Batch {
+        std::vector<std::vector<char>> columns;
+        long long index = -1; // filled, -1 if free
+      };
+
+      void stop ();
+      void work ();
+      void fill ( long long iB, Batch& batch );
+
+      Config config_;
+      std::vector<std::unique_ptr<ShardReader>> readers_;
+      std::vector<std::vector<int>> columnIndex_; // [file][column]
+      std::vector<ShardColumn> columns_;           // then 'augment' if set
+      size_t nShardColumns_ = 0;
+      std::vector<size_t> outBytes_;               // of a row
+      std::vector<std::vector<float>> shift_, factor_;
+      AugmentConfig augment_;
+      std::vector<int> augmentRatio_;              // per column, 0 if not augmented
+      int augmentRows_ = 0, augmentCols_ = 0;      // of the first augmented column
+      int epoch_ = 0;
+      long long nRows_ = 0;
+
+      std::vector<Sample> order_;
+      long long nEpochBatches_ = 0;
+      std::vector<Batch> batches_;                 // ring of prefetch
+      std::vector<std::thread> workers_;
+      std::mutex mutex_;
+      std::condition_variable filled_, freed_;
+      long long nextFill_ = 0;                     // next batch to assign
+      long long nextRead_ = 0;                     // next batch to return
+      bool holding_ = false;                       // previous batch not yet freed
+      bool stopping_ = false;
+      std::exception_ptr error_;
+
+  };
+
+} // namespace img
+
+#endif
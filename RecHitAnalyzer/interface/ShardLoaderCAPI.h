@@ -0,0 +1,42 @@
+#ifndef RecHitAnalyzer_ShardLoaderCAPI_h
+#define RecHitAnalyzer_ShardLoaderCAPI_h
+//
+// C interface to img::ShardLoader, for ctypes (shard_loader.py).
+// Functions return -1 on error, see img_loader_error().
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  // nullptr on error, all columns if nColumns = 0
+  void* img_loader_open ( const char** files, int nFiles, const char** columns, int nColumns,
+                          int batchSize, int nThreads, int shuffleBuffer, unsigned long long seed,
+                          int dropLast, int prefetch );
+  void img_loader_close ( void* loader );
+
+  int img_loader_ncolumns ( void* loader );
+  const char* img_loader_column_name ( void* loader, int column );
+  // Dimensions of a row of the column, its ShardType in type and its
+  // shape in shape[4]
+  int img_loader_column_shape ( void* loader, int column, int* type, int* shape );
+  long long img_loader_rows ( void* loader );
+  long long img_loader_batches ( void* loader );
+
+  // n = channels of the column, see ShardLoader::setNormalization()
+  int img_loader_set_norm ( void* loader, const char* column, const float* mean, const float* std, int n );
+  // See ShardLoader::setAugmentation() and AugmentConfig
+  int img_loader_set_augment ( void* loader, const char** columns, int nColumns, int rotate, int reflect,
+                               int step, int cropRows, int cropCols, int jitter );
+  int img_loader_start_epoch ( void* loader, int epoch );
+  // Rows of the next batch, 0 at the end of the epoch, and a pointer
+  // to each column in data, valid until the next call
+  int img_loader_next ( void* loader, const void** data );
+  // Last error of this thread
+  const char* img_loader_error ();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
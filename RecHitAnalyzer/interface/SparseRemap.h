@@ -0,0 +1,83 @@
+#ifndef RecHitAnalyzer_SparseRemap_h
+#define RecHitAnalyzer_SparseRemap_h
+//
+// Precomputed resampling of one detector grid onto another.
+//
+// The transform is a sparse matrix W with W[src][dst] the fraction
+// of source cell src that falls into target cell dst, stored in CSR
+// form with one row per source cell. It is built once per geometry
+// from the (eta,phi) extent of the source cells, so each cell shares
+// its energy among the target cells it overlaps, by area, instead of
+// going entirely into the bin of its center. Per event the remap is
+// a sparse matrix-vector product: scatter() adds one source hit,
+// apply() a whole dense source image.
+//
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageBuffer.h"
+
+#include <utility>
+#include <vector>
+
+namespace img {
+
+  // (eta,phi) extent of a cell. maxPhi < minPhi if it crosses phi = +/-pi.
+  // A cell without extent is binned by its (minEta,minPhi) corner.
+  struct CellBox {
+    float minEta;
+    float maxEta;
+    float minPhi;
+    float maxPhi;
+  };
+
+  // Target grid with variable eta edges and nPhi uniform bins in
+  // [phiMin,phiMax). Cell (etaBin,phiBin) is etaBin*nPhi+phiBin.
+  struct EtaPhiGrid {
+    int nEta;
+    const double* etaEdges; // nEta+1
+    int nPhi;
+    double phiMin;
+    double phiMax;
+  };
+
+  // Area fractions of 'box' in the cells of 'grid', as (cell, fraction)
+  // pairs appended to 'overlaps'. Parts outside the grid in eta are lost.
+  void etaPhiOverlaps ( const CellBox& box, const EtaPhiGrid& grid,
+                        std::vector<std::pair<int,float> >& overlaps );
+
+  class SparseRemap {
+
+    public:
+
+      struct Entry {
+        int src;
+        int dst;
+        float weight;
+      };
+
+      // Build from entries in any order; duplicates are summed
+      void build ( int nSrc, int nDst, std::vector<Entry>& entries );
+
+      bool empty () const { return rowStart_.empty(); }
+      int nSrc () const { return int( rowStart_.size() ) - 1; }
+      int nDst () const { return nDst_; }
+      int nnz () const { return dst_.size(); }
+
+      // dst += value * W[src]
+      void scatter ( int src, float value, ImageBuffer& dst ) const {
+        for ( int k = rowStart_[src]; k < rowStart_[src+1]; k++ ) dst[ dst_[k] ] += value*weight_[k];
+      }
+      // dst += W^T src, for a dense source image of nSrc() pixels
+      void apply ( const float* src, ImageBuffer& dst ) const;
+
+    private:
+
+      int nDst_ = 0;
+      std::vector<int>   rowStart_; // nSrc+1
+      std::vector<int>   dst_;
+      std::vector<float> weight_;
+
+  };
+
+} // namespace img
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef RecHitAnalyzer_SparseTensor_h
+#define RecHitAnalyzer_SparseTensor_h
+//
+// Packed sparse (layer, region, pixel) tensor, e.g. tracker hits
+// per layer on the EB and EE crystal grids.
+//
+// Each non-zero voxel is one 32-bit key, layer << 18 | region << 16
+// | pixel, and one value. Hits are appended in any order and merged
+// by finalize(), after which the keys are sorted and unique and the
+// values are the sums of the hits of each voxel. Like JaggedArray,
+// the arrays are only cleared between events.
+//
+// Stored as two branches, "<name>_key" and "<name>_value".
+//
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace img {
+
+  class SparseTensor3D {
+
+    public:
+
+      static const int PIXEL_BITS  = 16;
+      static const int REGION_BITS = 2;
+      static const int LAYER_BITS  = 32 - PIXEL_BITS - REGION_BITS;
+
+      std::vector<unsigned int> keys;
+      std::vector<float> values;
+
+      static unsigned int pack ( int layer, int region, int pixel ) {
+        return ( unsigned(layer) << ( PIXEL_BITS+REGION_BITS ) ) | ( unsigned(region) << PIXEL_BITS ) | unsigned(pixel);
+      }
+      static int layer  ( unsigned int key ) { return key >> ( PIXEL_BITS+REGION_BITS ); }
+      static int region ( unsigned int key ) { return ( key >> PIXEL_BITS ) & ( ( 1u << REGION_BITS )-1 ); }
+      static int pixel  ( unsigned int key ) { return key & ( ( 1u << PIXEL_BITS )-1 ); }
+
+      // Start a new event, keeping the capacity
+      void clear () { keys.clear(); values.clear(); }
+
+      void add ( int layer, int region, int pixel, float value = 1. ) {
+        keys.push_back( pack( layer, region, pixel ) );
+        values.push_back( value );
+      }
+
+      // Sort by key and sum the values of equal keys
+      void finalize () {
+        if ( keys.empty() ) return;
+        order_.clear();
+        for ( unsigned int i = 0; i < keys.size(); i++ ) order_.push_back( std::make_pair( keys[i], values[i] ) );
+        std::sort( order_.begin(), order_.end(), []( const std::pair<unsigned int,float>& a, const std::pair<unsigned int,float>& b ) {
+          return a.first < b.first;
+        } );
+        keys.clear();
+        values.clear();
+        for ( const std::pair<unsigned int,float>& v : order_ ) {
+          if ( !keys.empty() && keys.back() == v.first ) {
+            values.back() += v.second;
+            continue;
+          }
+          keys.push_back( v.first );
+          values.push_back( v.second );
+        }
+      }
+
+      int size () const { return keys.size(); }
+
+    private:
+
+      std::vector<std::pair<unsigned int,float> > order_;
+
+  };
+
+} // namespace img
+
+#endif
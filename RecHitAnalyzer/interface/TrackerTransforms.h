@@ -0,0 +1,69 @@
+#ifndef RecHitAnalyzer_TrackerTransforms_h
+#define RecHitAnalyzer_TrackerTransforms_h
+//
+// Flat table of the tracker module (DetUnit) placements.
+//
+// Built once per tracker geometry, one row per module at a dense
+// index, with the local -> global rotation and translation of the
+// module surface and its precomputed subdetector and layer. Hits are
+// then localised in batches: their dense module indices are looked up
+// once, and the affine transform runs over plain arrays, instead of an
+// idToDet() lookup and a virtual surface call per hit.
+//
+
+#include <vector>
+
+namespace img {
+
+  class TrackerTransforms {
+
+    public:
+
+      struct Module {
+        float rot[9]; // global = rot * local + pos, row-major
+        float pos[3];
+        int subdet;   // DetId::subdetId()
+        int layer;    // user classification, e.g. global layer, -1 if unused
+      };
+
+      // Rows are added in any order, then finalize() sorts the DetIds
+      void clear ();
+      void add ( unsigned int rawId, const Module& module );
+      void finalize ();
+
+      bool empty () const { return modules_.empty(); }
+      int size () const { return modules_.size(); }
+      // Dense index of a module, -1 if not in the table
+      int index ( unsigned int rawId ) const;
+      const Module& module ( int idx ) const { return modules_[idx]; }
+
+    private:
+
+      std::vector<unsigned int> rawIds_; // sorted, parallel to modules_
+      std::vector<Module> modules_;
+
+  };
+
+  // Hits of one event, structure of arrays. 'module' is the dense
+  // index in the TrackerTransforms table.
+  struct TrackerHitBatch {
+    std::vector<int>   module;
+    std::vector<float> lx, ly, lz; // local position
+    std::vector<float> gx, gy, gz; // global position, set by transformHits()
+
+    void clear () {
+      module.clear(); lx.clear(); ly.clear(); lz.clear();
+      gx.clear(); gy.clear(); gz.clear();
+    }
+    void add ( int idx, float x, float y, float z ) {
+      module.push_back( idx ); lx.push_back( x ); ly.push_back( y ); lz.push_back( z );
+    }
+    int size () const { return module.size(); }
+  };
+
+  // Global positions of all hits of the batch
+  void transformHits ( const TrackerTransforms& table, TrackerHitBatch& hits );
+
+} // namespace img
+
+#endif
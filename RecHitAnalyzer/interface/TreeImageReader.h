@@ -0,0 +1,87 @@
+#ifndef RecHitAnalyzer_TreeImageReader_h
+#define RecHitAnalyzer_TreeImageReader_h
+//
+// Bulk reader of RHTree image branches into a dense batch.
+//
+// read() fills a caller-owned float buffer with the images of an entry
+// range, (N, H, W, C) or (N, C, H, W), channel c being branches[c].
+// The branches must be fixed-length vector<float> of nRows x nCols
+// pixels, as written by the analyzers.
+//
+// Such a branch stores every entry in its basket as a 10-byte header
+// (byte count, version, size) followed by the big-endian floats. The
+// baskets of the range are loaded once and the floats are byte-swapped
+// straight into place, without going through a vector<float> per
+// entry. Branches in another layout (e.g. written by an older ROOT or
+// split) are read through the streamer instead, entry by entry.
+//
+// Not thread safe: use one reader per thread.
+//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+class TBranch;
+
+namespace img {
+
+  class TreeImageReader {
+
+    public:
+
+      TreeImageReader ();
+      ~TreeImageReader ();
+
+      // Open the files and check the branches of each tree, throw
+      // std::runtime_error on failure
+      void open ( const std::vector<std::string>& files, const std::string& treeName,
+                  const std::vector<std::string>& branches, int nRows, int nCols );
+
+      long long nEntries () const { return nEntries_; }
+      int nChannels () const { return branchNames_.size(); }
+      int nRows () const { return nRows_; }
+      int nCols () const { return nCols_; }
+
+      // Entries [first, last) into out, (last-first) x nChannels x
+      // nRows x nCols floats, throw std::runtime_error on failure
+      void read ( long long first, long long last, float* out, bool channelsLast );
+
+      // Branches read from the baskets / through the streamer
+      int nRaw () const;
+      int nStreamed () const;
+
+    private:
+
+      struct Column {
+        TBranch* branch;
+        bool raw;
+        std::vector<float>* object; // streamed only
+      };
+      struct File {
+        std::unique_ptr<TFile> file;
+        TTree* tree;
+        long long first; // in the chain
+        long long nEntries;
+        std::vector<Column> columns;
+      };
+
+      void openColumns ( File& file );
+      void readRaw ( const Column& column, long long first, long long last, float* out,
+                     size_t entryStride, size_t pixelStride );
+      void readStreamed ( const File& file, const Column& column, long long first, long long last, float* out,
+                          size_t entryStride, size_t pixelStride );
+
+      std::vector<File> files_;
+      std::vector<std::string> branchNames_;
+      int nRows_ = 0;
+      int nCols_ = 0;
+      long long nEntries_ = 0;
+
+  };
+
+} // namespace img
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef RecHitAnalyzer_TreeImageReaderCAPI_h
+#define RecHitAnalyzer_TreeImageReaderCAPI_h
+//
+// C interface to img::TreeImageReader, for ctypes (rhtree_reader.py).
+// Functions return -1 on error, see img_treereader_error().
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  // nullptr on error
+  void* img_treereader_open ( const char** files, int nFiles, const char* treeName,
+                              const char** branches, int nBranches, int nRows, int nCols );
+  void img_treereader_close ( void* reader );
+
+  long long img_treereader_entries ( void* reader );
+  // Branches decoded from the baskets, the others are streamed
+  int img_treereader_nraw ( void* reader );
+  // Entries [first, last) into out, see TreeImageReader::read()
+  int img_treereader_read ( void* reader, long long first, long long last, float* out, int channelsLast );
+  // Last error of this thread
+  const char* img_treereader_error ();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef RecHitAnalyzer_TriggerSelector_h
+#define RecHitAnalyzer_TriggerSelector_h
+//
+// HLT decision for a list of path patterns, e.g. "HLT_Diphoton30PV_*_v*".
+//
+// The patterns are matched against the trigger menu with
+// edm::regexMatch only when the menu changes, i.e. when the
+// parameterSetID of the TriggerNames differs from the last event.
+// The matched path indices are kept, one bit per matched path, and
+// every event only tests these paths in the TriggerResults.
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DataFormats/Common/interface/TriggerResults.h"
+#include "FWCore/Common/interface/TriggerNames.h"
+
+namespace img {
+
+  class TriggerSelector {
+
+    public:
+
+      TriggerSelector () {}
+      explicit TriggerSelector ( const std::vector<std::string>& pathPatterns ) : patterns_( pathPatterns ) {}
+
+      bool empty () const { return patterns_.empty(); }
+
+      // Resolve the patterns if the menu changed since the last call.
+      // Throws std::runtime_error if more than 64 paths are matched.
+      void setMenu ( const edm::TriggerNames& );
+
+      // One bit per matched path, set if the path accepted the event
+      uint64_t acceptedPaths ( const edm::TriggerResults& ) const;
+
+      // -1 if no path of the menu matches the patterns, else 0 or 1
+      int acceptAny ( const edm::TriggerResults& results ) const {
+        if ( pathMask_ == 0 ) return -1;
+        return acceptedPaths( results ) != 0 ? 1 : 0;
+      }
+      int acceptAll ( const edm::TriggerResults& results ) const {
+        if ( pathMask_ == 0 ) return -1;
+        return acceptedPaths( results ) == pathMask_ ? 1 : 0;
+      }
+
+      const std::vector<std::string>& matchedPaths () const { return pathNames_; }
+
+    private:
+
+      std::vector<std::string>  patterns_;
+      edm::ParameterSetID       menuId_;
+      std::vector<unsigned int> pathIdxs_;
+      std::vector<std::string>  pathNames_;
+      uint64_t                  pathMask_ = 0;
+
+  };
+
+} // namespace img
+
+#endif
@@ -0,0 +1,164 @@
+// -*- C++ -*-
+//
+// Package:    MLAnalyzer/RecHitAnalyzer
+// Class:      DetectorImageProducer
+//
+/**\class DetectorImageProducer DetectorImageProducer.cc MLAnalyzer/RecHitAnalyzer/plugins/DetectorImageProducer.cc
+
+Description: Build the calorimeter images of an event once and put
+them in the event as an img::DetectorImage (see DetectorImage.h).
+
+Implementation:
+Same hit collection (CaloHitGather.h) and image kernels (ImageKernels.h) as the
+RecHitAnalyzer fills, so the channels are identical to its EB_energy,
+EB_time, HBHE_energy_EB, HBHE_energy and ECAL_energy branches.
+EB_energy_noZS has all EB rechits, negative ones included, as the
+full EB image of SCAnalyzer. RecHitAnalyzer, SCRegressor and
+SCAnalyzer read them back with 'detectorImages'; keep the product
+in a skim with 'keep img::DetectorImage_*_*_*'. With
+'geometrySnapshot' set, the EE cell centers come from the same
+snapshot as RecHitAnalyzer::getCellPosition.
+*/
+//
+
+// system include files
+#include <memory>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+#include "DataFormats/HcalDetId/interface/HcalDetId.h"
+#include "DataFormats/HcalRecHit/interface/HcalRecHitCollections.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/CaloHitGather.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/GeometrySnapshot.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+
+#include <stdexcept>
+
+//
+// class declaration
+//
+
+class DetectorImageProducer : public edm::stream::EDProducer<> {
+  public:
+    explicit DetectorImageProducer(const edm::ParameterSet&);
+    ~DetectorImageProducer() {}
+
+  private:
+    virtual void produce(edm::Event&, const edm::EventSetup&) override;
+
+    edm::EDGetTokenT<EcalRecHitCollection> EBRecHitCollectionT_;
+    edm::EDGetTokenT<EcalRecHitCollection> EERecHitCollectionT_;
+    edm::EDGetTokenT<HBHERecHitCollection> HBHERecHitCollectionT_;
+
+    // EE cell centers from a local snapshot instead of the EventSetup
+    std::unique_ptr<img::GeometrySnapshot> geoSnapshot_;
+
+    // Reused across events
+    std::vector<img::EBHit> vEBhits_;
+    std::vector<img::EtaPhiHit> vEEhits_;
+    std::vector<img::HBHEHit> vHBHEhits_;
+    img::ImageBuffer vEB_energy_;
+    img::ImageBuffer vEB_energy_noZS_;
+    img::ImageBuffer vEB_time_;
+    img::ImageBuffer vHBHE_energy_EB_;
+    img::ImageBuffer vHBHE_energy_;
+    img::ImageBuffer vECAL_energy_;
+};
+
+//
+// constructors and destructor
+//
+DetectorImageProducer::DetectorImageProducer(const edm::ParameterSet& iConfig)
+{
+  EBRecHitCollectionT_   = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedEBRecHitCollection"));
+  EERecHitCollectionT_   = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedEERecHitCollection"));
+  HBHERecHitCollectionT_ = consumes<HBHERecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedHBHERecHitCollection"));
+
+  std::string geometrySnapshot = iConfig.getParameter<std::string>("geometrySnapshot");
+  if ( !geometrySnapshot.empty() ) {
+    geoSnapshot_.reset( new img::GeometrySnapshot );
+    try {
+      geoSnapshot_->read( geometrySnapshot );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("DetectorImageProducer") << e.what();
+    }
+  }
+
+  produces<img::DetectorImage>();
+}
+
+//
+// member functions
+//
+
+// ------------ method called for each event  ------------
+void
+DetectorImageProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
+{
+
+  edm::Handle<EcalRecHitCollection> EBRecHitsH_;
+  iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_ );
+  edm::Handle<EcalRecHitCollection> EERecHitsH_;
+  iEvent.getByToken( EERecHitCollectionT_, EERecHitsH_ );
+  edm::Handle<HBHERecHitCollection> HBHERecHitsH_;
+  iEvent.getByToken( HBHERecHitCollectionT_, HBHERecHitsH_ );
+
+  const CaloGeometry* caloGeom = nullptr;
+  if ( !geoSnapshot_ ) {
+    edm::ESHandle<CaloGeometry> caloGeomH_;
+    iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
+    caloGeom = caloGeomH_.product();
+  }
+
+  // EB, EE at the cell centers and HBHE, as the RecHitAnalyzer fills
+  img::gatherEBHits( *EBRecHitsH_, vEBhits_ );
+  img::gatherEEHits( *EERecHitsH_, [&]( const EEDetId& eeId ) {
+    if ( !geoSnapshot_ ) return caloGeom->getPosition( eeId );
+    const img::GeometrySnapshot::Point& p = geoSnapshot_->eeCenter[ eeId.hashedIndex() ];
+    return GlobalPoint( p.x, p.y, p.z );
+  }, vEEhits_ );
+  img::gatherHBHEHits( *HBHERecHitsH_, vHBHEhits_ );
+
+  // EB unsuppressed, as SCAnalyzer
+  vEB_energy_noZS_.reset( img::EB_NCELLS );
+  for ( const EcalRecHit& rechit : *EBRecHitsH_ ) {
+    vEB_energy_noZS_[ EBDetId( rechit.id() ).hashedIndex() ] = rechit.energy();
+  }
+
+  img::fillEBImage( vEBhits_, vEB_energy_, vEB_time_ );
+  img::fillHBHEImage( vHBHEhits_, vHBHE_energy_EB_, vHBHE_energy_ );
+  img::fillECALstitchedImage( vEBhits_, vEEhits_, vECAL_energy_ );
+
+  std::unique_ptr<img::DetectorImage> images( new img::DetectorImage );
+  try {
+    images->add( "EB_energy",      vEB_energy_,      2*img::EB_IETA_MAX,           img::EB_IPHI_MAX );
+    images->add( "EB_energy_noZS", vEB_energy_noZS_, 2*img::EB_IETA_MAX,           img::EB_IPHI_MAX );
+    images->add( "EB_time",        vEB_time_,        2*img::EB_IETA_MAX,           img::EB_IPHI_MAX );
+    images->add( "HBHE_energy_EB", vHBHE_energy_EB_, 2*img::HBHE_IETA_MAX_EB,      img::HBHE_IPHI_NUM );
+    images->add( "HBHE_energy",    vHBHE_energy_,    2*(img::HBHE_IETA_MAX_HE-1),  img::HBHE_IPHI_NUM );
+    images->add( "ECAL_energy",    vECAL_energy_,    2*img::ECAL_IETA_MAX_EXT,     img::EB_IPHI_MAX );
+  } catch ( std::runtime_error& e ) {
+    throw cms::Exception("DetectorImageProducer") << e.what();
+  }
+  iEvent.put( std::move( images ) );
+
+} // produce()
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(DetectorImageProducer);
@@ -0,0 +1,187 @@
+// -*- C++ -*-
+//
+// Package:    MLAnalyzer/RecHitAnalyzer
+// Class:      GeometrySnapshotDumper
+//
+/**\class GeometrySnapshotDumper GeometrySnapshotDumper.cc MLAnalyzer/RecHitAnalyzer/plugins/GeometrySnapshotDumper.cc
+
+Description: Dump the calorimeter geometry and magnetic field used by
+RecHitAnalyzer into a local snapshot file (see GeometrySnapshot.h).
+
+Implementation:
+Runs once, on the first event, and needs only the geometry and field
+from the EventSetup, e.g. with an EmptySource (GeometrySnapshotDumper_cfg.py).
+*/
+//
+
+// system include files
+#include <memory>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalDetId/interface/ESDetId.h"
+#include "DataFormats/HcalDetId/interface/HcalDetId.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/CaloGeometry/interface/CaloCellGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "MagneticField/Engine/interface/MagneticField.h"
+#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
+
+#include "MLAnalyzer/RecHitAnalyzer/interface/GeometrySnapshot.h"
+
+#include <stdexcept>
+
+//
+// class declaration
+//
+
+class GeometrySnapshotDumper : public edm::one::EDAnalyzer<>  {
+  public:
+    explicit GeometrySnapshotDumper(const edm::ParameterSet&);
+    ~GeometrySnapshotDumper() {}
+
+  private:
+    virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
+
+    std::string outputFile_;
+    bool done_;
+};
+
+//
+// constructors and destructor
+//
+GeometrySnapshotDumper::GeometrySnapshotDumper(const edm::ParameterSet& iConfig)
+{
+  outputFile_ = iConfig.getParameter<std::string>("outputFile");
+  done_ = false;
+}
+
+//
+// member functions
+//
+
+// Store the cell center, and the (eta,phi) extent if requested ____________//
+static void fillCell ( const CaloGeometry* caloGeom, const DetId& id,
+                       img::GeometrySnapshot::Point& center, img::GeometrySnapshot::EtaPhiBox* box ) {
+
+  auto cell = caloGeom->getGeometry( id );
+  if ( !cell ) return;
+  GlobalPoint pos = cell->getPosition();
+  center = img::GeometrySnapshot::Point{ pos.x(), pos.y(), pos.z() };
+  if ( !box ) return;
+  // Min,max phi,eta at plane closest to IP
+  // See illustration in RHAnalyzer_fillHCALatEBEE.cc
+  const auto repCorners = cell->getCornersREP();
+  *box = img::GeometrySnapshot::EtaPhiBox{ repCorners[2].eta(), repCorners[0].eta(),
+                                           repCorners[2].phi(), repCorners[0].phi() };
+
+} // fillCell()
+
+// EE crystal: front face corners, as RecHitAnalyzer::getCellEtaPhiBox
+static void fillEECell ( const CaloGeometry* caloGeom, const DetId& id,
+                         img::GeometrySnapshot::Point& center, img::GeometrySnapshot::EtaPhiBox& box ) {
+
+  auto cell = caloGeom->getGeometry( id );
+  if ( !cell ) return;
+  GlobalPoint pos = cell->getPosition();
+  center = img::GeometrySnapshot::Point{ pos.x(), pos.y(), pos.z() };
+  const auto corners = cell->getCorners();
+  float eta[4], phi[4];
+  for ( int iC = 0; iC < 4; iC++ ) {
+    eta[iC] = corners[iC].eta();
+    phi[iC] = corners[iC].phi();
+  }
+  box = img::GeometrySnapshot::cornerBox( eta, phi, 4 );
+
+} // fillEECell()
+
+// ------------ method called for each event  ------------
+void
+GeometrySnapshotDumper::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
+{
+
+  if ( done_ ) return;
+
+  edm::ESHandle<CaloGeometry> caloGeomH_;
+  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
+  const CaloGeometry* caloGeom = caloGeomH_.product();
+
+  edm::ESHandle<MagneticField> magfield;
+  iSetup.get<IdealMagneticFieldRecord>().get(magfield);
+
+  static_assert( img::GeometrySnapshot::EE_NCELLS == EEDetId::kSizeForDenseIndexing, "EE cell count" );
+  static_assert( img::GeometrySnapshot::ES_NCELLS == ESDetId::kSizeForDenseIndexing, "ES cell count" );
+
+  img::GeometrySnapshot snapshot;
+  snapshot.bFieldZ = magfield.product() ? magfield.product()->inTesla(GlobalPoint(0., 0., 0.)).z() : 0.0;
+
+  const img::GeometrySnapshot::Point origin{ 0., 0., 0. };
+  const img::GeometrySnapshot::EtaPhiBox noBox{ 0., 0., 0., 0. };
+
+  // EB
+  snapshot.ebCenter.assign( EBDetId::kSizeForDenseIndexing, origin );
+  snapshot.ebBox.assign( EBDetId::kSizeForDenseIndexing, noBox );
+  for ( int iC = 0; iC < EBDetId::kSizeForDenseIndexing; iC++ ) {
+    fillCell( caloGeom, EBDetId::unhashIndex(iC), snapshot.ebCenter[iC], &snapshot.ebBox[iC] );
+  }
+
+  // EE
+  snapshot.eeCenter.assign( EEDetId::kSizeForDenseIndexing, origin );
+  snapshot.eeBox.assign( EEDetId::kSizeForDenseIndexing, noBox );
+  for ( int iC = 0; iC < EEDetId::kSizeForDenseIndexing; iC++ ) {
+    fillEECell( caloGeom, EEDetId::unhashIndex(iC), snapshot.eeCenter[iC], snapshot.eeBox[iC] );
+  }
+
+  // ES: not all hashed indices correspond to a sensor
+  snapshot.esCenter.assign( ESDetId::kSizeForDenseIndexing, origin );
+  for ( int iC = 0; iC < ESDetId::kSizeForDenseIndexing; iC++ ) {
+    ESDetId esId( ESDetId::unhashIndex(iC) );
+    if ( esId.rawId() == 0 || !caloGeom->present( esId ) ) continue;
+    fillCell( caloGeom, esId, snapshot.esCenter[iC], nullptr );
+  }
+
+  // HBHE: only cells present in the geometry are stored
+  snapshot.hbheSubdet.assign( img::GeometrySnapshot::HBHE_NCELLS, 0 );
+  snapshot.hbheCenter.assign( img::GeometrySnapshot::HBHE_NCELLS, origin );
+  snapshot.hbheBox.assign( img::GeometrySnapshot::HBHE_NCELLS, noBox );
+  int nHBHE = 0;
+  for ( int ieta = -29; ieta <= 29; ieta++ ) {
+    if ( ieta == 0 ) continue;
+    for ( int iphi = 1; iphi <= img::GeometrySnapshot::HBHE_IPHI_NUM; iphi++ ) {
+      for ( int depth = 1; depth <= img::GeometrySnapshot::HBHE_DEPTH_NUM; depth++ ) {
+        for ( HcalSubdetector subdet : { HcalBarrel, HcalEndcap } ) {
+          if ( !HcalDetId::validDetId( subdet, ieta, iphi, depth ) ) continue;
+          HcalDetId hId( subdet, ieta, iphi, depth );
+          if ( !caloGeom->present( hId ) ) continue;
+          int idx = img::GeometrySnapshot::hbheIndex( ieta, iphi, depth );
+          snapshot.hbheSubdet[idx] = subdet;
+          fillCell( caloGeom, hId, snapshot.hbheCenter[idx], &snapshot.hbheBox[idx] );
+          nHBHE++;
+        }
+      }
+    }
+  }
+
+  try {
+    snapshot.write( outputFile_ );
+  } catch ( std::runtime_error& e ) {
+    throw cms::Exception("GeometrySnapshotDumper") << e.what();
+  }
+  std::cout << " >> Wrote geometry snapshot " << outputFile_ << ": B_z=" << snapshot.bFieldZ
+            << " T, HBHE cells: " << nHBHE << std::endl;
+  done_ = true;
+
+} // analyze()
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(GeometrySnapshotDumper);
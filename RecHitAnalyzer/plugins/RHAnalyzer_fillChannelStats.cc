@@ -0,0 +1,89 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+
+// Fill channel statistics /////////////////////////////////
+// Pixel statistics of each registered image channel, over all
+// selected events of the job: count, occupancy, min/max, mean,
+// variance and a quantile sketch (see ChannelStats.h). Written
+// at endJob as the ChannelStats tree, one entry per channel;
+// merge_ChannelStats.py merges them across jobs and prints the
+// normalisation constants. Must run after the fill functions.
+
+TTree* ChannelStatsTree;
+std::string vCS_name_;
+long long vCS_count_;
+long long vCS_nNonZero_;
+double vCS_mean_;
+double vCS_m2_;
+float vCS_min_;
+float vCS_max_;
+long long vCS_nZero_;
+std::vector<long long> vCS_pos_;
+std::vector<long long> vCS_neg_;
+
+// Initialize branches _____________________________________________________//
+void RecHitAnalyzer::branchesChannelStats ( TTree* tree, edm::Service<TFileService> &fs ) {
+
+  // Not in RHTree: one entry per channel, filled at endJob
+  ChannelStatsTree = fs->make<TTree>("ChannelStats", "Image channel statistics");
+  ChannelStatsTree->Branch("name",     &vCS_name_);
+  ChannelStatsTree->Branch("count",    &vCS_count_);
+  ChannelStatsTree->Branch("nNonZero", &vCS_nNonZero_);
+  ChannelStatsTree->Branch("mean",     &vCS_mean_);
+  ChannelStatsTree->Branch("m2",       &vCS_m2_);
+  ChannelStatsTree->Branch("min",      &vCS_min_);
+  ChannelStatsTree->Branch("max",      &vCS_max_);
+  ChannelStatsTree->Branch("sketch_nZero", &vCS_nZero_);
+  ChannelStatsTree->Branch("sketch_pos",   &vCS_pos_);
+  ChannelStatsTree->Branch("sketch_neg",   &vCS_neg_);
+
+  for ( auto const& channel : imageChannels_ ) channelStats_[channel.first];
+
+} // branchesChannelStats()
+
+// Fill channel statistics _________________________________________________//
+void RecHitAnalyzer::fillChannelStats ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
+
+  for ( auto const& channel : imageChannels_ ) {
+
+    const img::ImageBuffer& image = *channel.second.image;
+    img::ChannelStats& stats = channelStats_[channel.first];
+
+    // Only the written tiles can have non-zero pixels
+    long long nNonZero = 0;
+    for ( int iT : image.dirtyTiles() ) {
+      int end = std::min( ( iT+1 )*img::ImageBuffer::TILE_SIZE, image.size() );
+      for ( int idx = iT*img::ImageBuffer::TILE_SIZE; idx < end; idx++ ) {
+        float v = image.get( idx );
+        if ( v == 0. ) continue;
+        stats.add( v );
+        nNonZero++;
+      }
+    }
+    stats.addZeros( image.size() - nNonZero );
+
+  } // channels
+
+} // fillChannelStats()
+
+// Write channel statistics ________________________________________________//
+void RecHitAnalyzer::writeChannelStats () {
+
+  for ( auto& channel : channelStats_ ) {
+    img::ChannelStats& stats = channel.second;
+    vCS_name_     = channel.first;
+    vCS_count_    = stats.count;
+    vCS_nNonZero_ = stats.nNonZero;
+    vCS_mean_     = stats.mean;
+    vCS_m2_       = stats.m2;
+    vCS_min_      = stats.min;
+    vCS_max_      = stats.max;
+    vCS_nZero_    = stats.sketch.nZero();
+    vCS_pos_      = stats.sketch.pos();
+    vCS_neg_      = stats.sketch.neg();
+    ChannelStatsTree->Fill();
+    std::cout << " >> " << channel.first << ": occupancy " << stats.occupancy()
+              << ", mean " << stats.mean << ", std " << std::sqrt( stats.variance() )
+              << ", q99.9 " << stats.sketch.quantile( 0.999 ) << std::endl;
+  }
+
+} // writeChannelStats()
@@ -1,4 +1,5 @@
 #include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/CaloHitGather.h"
 
 // Fill EB rec hits ////////////////////////////////
 // Store event rechits in a vector of length equal
@@ -6,15 +7,18 @@
 
 TProfile2D *hEB_energy;
 TProfile2D *hEB_time;
-std::vector<float> vEB_energy_;
-std::vector<float> vEB_time_;
+img::ImageBuffer vEB_energy_;
+img::ImageBuffer vEB_time_;
+std::vector<img::EBHit> vEB_hits_;
 
 // Initialize branches _____________________________________________________//
 void RecHitAnalyzer::branchesEB ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("EB_energy", &vEB_energy_);
-  tree->Branch("EB_time",   &vEB_time_);
+  tree->Branch("EB_energy", &vEB_energy_.pixels());
+  tree->Branch("EB_time",   &vEB_time_.pixels());
+  registerImage( "EB_energy", vEB_energy_, 2*EB_IETA_MAX, EB_IPHI_MAX );
+  registerImage( "EB_time",   vEB_time_,   2*EB_IETA_MAX, EB_IPHI_MAX );
 
   // Histograms for monitoring
   hEB_energy = fs->make<TProfile2D>("EB_energy", "E(i#phi,i#eta);i#phi;i#eta",
@@ -29,40 +33,35 @@ void RecHitAnalyzer::branchesEB ( TTree* tree, edm::Service<TFileService> &fs )
 // Fill EB rechits _________________________________________________________________//
 void RecHitAnalyzer::fillEB ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
-  int iphi_, ieta_, idx_; // rows:ieta, cols:iphi
+  int iphi_, ieta_; // rows:ieta, cols:iphi
   float energy_;
 
-  vEB_energy_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEB_time_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-
-  edm::Handle<EcalRecHitCollection> EBRecHitsH_;
-  iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_);
-
-  // Fill EB rechits 
-  for ( EcalRecHitCollection::const_iterator iRHit = EBRecHitsH_->begin();
-        iRHit != EBRecHitsH_->end(); ++iRHit ) {
-
-    energy_ = iRHit->energy();
-    if ( energy_ <= zs ) continue;
-    // Get detector id and convert to histogram-friendly coordinates
-    EBDetId ebId( iRHit->id() );
-    iphi_ = ebId.iphi() - 1;
-    ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
-    // Fill histograms for monitoring 
-    hEB_energy->Fill( iphi_,ieta_,energy_ );
-    hEB_time->Fill( iphi_,ieta_,iRHit->time() );
-    // Get Hashed Index: provides convenient 
-    // index mapping from [ieta][iphi] -> [idx]
-    idx_ = ebId.hashedIndex(); // (ieta_+EB_IETA_MAX)*EB_IPHI_MAX + iphi_
-    // Fill vectors for images
-    vEB_energy_[idx_] = energy_;
-    vEB_time_[idx_] = iRHit->time();
+  // Images from the DetectorImage product, else from the rechits
+  if ( !getDetectorImages( iEvent, {"EB_energy", "EB_time"} ) ) {
+
+    edm::Handle<EcalRecHitCollection> EBRecHitsH_;
+    iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_);
 
-  } // EB rechits
+    // Fill vectors for images
+    img::gatherEBHits( *EBRecHitsH_, vEB_hits_ );
+    img::fillEBImage( vEB_hits_, vEB_energy_, vEB_time_ );
+
+  } // rechits
+
+  // Fill histograms for monitoring, only filled tiles can be nonzero
+  for ( int iT : vEB_energy_.dirtyTiles() ) {
+    for ( int idx = vEB_energy_.tileBegin(iT); idx < vEB_energy_.tileEnd(iT); idx++ ) {
+      energy_ = vEB_energy_.get(idx);
+      if ( energy_ <= zs ) continue;
+      ieta_ = idx/EB_IPHI_MAX - EB_IETA_MAX;
+      iphi_ = idx%EB_IPHI_MAX;
+      hEB_energy->Fill( iphi_,ieta_,energy_ );
+      hEB_time->Fill( iphi_,ieta_,vEB_time_.get(idx) );
+    } // idx
+  } // tiles
 
 } // fillEB()
 
-/*
 // EB digis //
 // This contains the raw EB digi collection:
 // Each digi is unpacked as a data frame containing info
@@ -71,63 +70,70 @@ void RecHitAnalyzer::fillEB ( const edm::Event& iEvent, const edm::EventSetup& i
 // iS=[3-9]: Nominal pulse shape
 // NOTE: This is the raw collection and includes
 // selective-readout and bad channel effects!
+//
+// The samples are pedestal subtracted (presample mean) and only a
+// SC_CROP_SIZE x SC_CROP_SIZE crop around the crystal with the largest
+// sample 'ebDigiSeedSample' is written, all samples in one branch:
+// EB_adc as (10,32,32) with ebDigiLayout "sampleMajor" or (32,32,10)
+// with "crystalMajor". The seed sits at [16,16].
+
+TProfile *hEB_adcPulse;
+img::ImageBuffer vEB_adcImage_;
+std::vector<float> vEB_adc_;
+int vEB_adcSeedIeta_;
+int vEB_adcSeedIphi_;
+std::vector<img::EBDigi> vEB_digis_;
+
+// Initialize branches _____________________________________________________//
+void RecHitAnalyzer::branchesEBdigis ( TTree* tree, edm::Service<TFileService> &fs ) {
+
+  tree->Branch("EB_adc",         &vEB_adc_);
+  tree->Branch("EB_adcSeedIeta", &vEB_adcSeedIeta_);
+  tree->Branch("EB_adcSeedIphi", &vEB_adcSeedIphi_);
+  vEB_adc_.assign( img::EB_DIGI_NSAMPLES*img::SC_CROP_SIZE*img::SC_CROP_SIZE, 0. );
+
+  // Histograms for monitoring
+  hEB_adcPulse = fs->make<TProfile>("EB_adcPulse", "Seed pulse;iS;ADC - pedestal",
+      img::EB_DIGI_NSAMPLES, 0., img::EB_DIGI_NSAMPLES );
+
+} // branchesEBdigis()
 
 //____ Fill EB digis _____//
 void RecHitAnalyzer::fillEBdigis ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
-  int iphi_, ieta_, idx;
-
-  // Initialize data collection pointers
   edm::Handle<EBDigiCollection> EBDigisH;
   iEvent.getByToken(EBDigiCollectionT_, EBDigisH);
 
-  // Provides access to global cell position and coordinates below
-  edm::ESHandle<CaloGeometry> caloGeomH;
-  iSetup.get<CaloGeometryRecord>().get(caloGeomH);
-  caloGeom = caloGeomH.product();
-
-  // Initialize arrays
-  for(int iS(0); iS < EcalDataFrame::MAXSAMPLES; ++iS)
-    vEB_adc_[iS].assign(EBDetId::kSizeForDenseIndexing,0);
-
-  // Record signal-full entries
+  // Unpack the digis into dataframes
+  vEB_digis_.clear();
   for(EBDigiCollection::const_iterator iDigi = EBDigisH->begin();
       iDigi != EBDigisH->end();
       ++iDigi) {
 
-    // Get detector id and convert to histogram-friendly coordinates
     EBDetId ebId( iDigi->id() );
-    //DetId id( iDigi->id() );
-    iphi_ = ebId.iphi()-1;
-    ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
-
-    // Get Hashed Index & Cell Geometry
-    // Hashed index provides a convenient index mapping
-    // from [ieta][iphi] -> [idx]
-    idx = ebId.hashedIndex(); // (ieta_+EB_IETA_MAX)*EB_IPHI_MAX + iphi_
-    // Cell geometry provides access to (rho,eta,phi) coordinates of cell center
-    //cell  = caloGeom->getGeometry(ebId);
-
-    // Unpack the digi into a dataframe
     EcalDataFrame df(*iDigi);
-    for(int iS(0); iS < EcalDataFrame::MAXSAMPLES; ++iS) {
-
-      // Get the iS-th sample
+    img::EBDigi digi{ ebId.ieta(), ebId.iphi(), {} };
+    for(int iS(0); iS < std::min( df.size(), int(img::EB_DIGI_NSAMPLES) ); ++iS) {
       EcalMGPASample digiSample( df.sample(iS) );
-
-      // Fill some histograms to monitor distributions
-      // These will contain *cumulative* statistics and as such
-      // should be used for monitoring purposes only
-      hEB_adc[iS]->Fill( iphi_, ieta_, digiSample.adc() );
-
-      // Fill event arrays
-      // These are the actual inputs to the detector images
-      vEB_adc_[iS][idx] += digiSample.adc();
-      //vEB_adc_[iS][idx] += digiSample.adc()/TMath::CosH(cell->etaPos()); // pick out only transverse component
-
+      digi.adc[iS] = digiSample.adc();
     } // sample
+    vEB_digis_.push_back( digi );
 
   } // EB digi
 
+  // Fill vectors for images
+  img::fillEBDigiImage( vEB_digis_, ebDigiLayout_, ebDigiSeedSample_, vEB_adcImage_, vEB_adcSeedIeta_, vEB_adcSeedIphi_ );
+  if ( vEB_adcSeedIeta_ < 0 ) {
+    std::fill( vEB_adc_.begin(), vEB_adc_.end(), 0. );
+    return;
+  }
+  img::cropEBDigiImage( vEB_adcImage_, ebDigiLayout_, vEB_adcSeedIeta_, vEB_adcSeedIphi_, img::SC_CROP_SIZE, vEB_adc_.data() );
+
+  // Fill histograms for monitoring
+  int seedIdx = vEB_adcSeedIeta_*EB_IPHI_MAX + vEB_adcSeedIphi_;
+  for(int iS(0); iS < img::EB_DIGI_NSAMPLES; ++iS) {
+    int idx = ebDigiLayout_ == img::kCrystalMajor ? seedIdx*img::EB_DIGI_NSAMPLES + iS : iS*img::EB_NCELLS + seedIdx;
+    hEB_adcPulse->Fill( iS, vEB_adcImage_.get( idx ) );
+  }
+
 } // fillEBdigis()
-*/
@@ -1,4 +1,5 @@
 #include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/SparseRemap.h"
 
 // Fill ECAL rechits at HCAL granularity /////////////////
 // Project ECAL event rechits into a vector of length
@@ -7,22 +8,23 @@
 // NOTE: We do not decrease the iphi granularity as
 // happens in the real HE. The findDetIdCalo() enforces
 // the even iphi numbering in the coarse region so must
-// resort to intermediate helper histograms. Since helper
-// histograms are binned by eta,phi some approx. involved.
+// resort to a (phi,eta) grid binned as eta_bins_HBHE.
+//
+// Each crystal shares its energy among the towers its
+// (eta,phi) extent overlaps, by area, through a remap
+// matrix built once per geometry (see SparseRemap.h).
 
-TH2F *hEvt_HBHE_EMenergy;
 TProfile2D *hHBHE_EMenergy;
-std::vector<float> vHBHE_EMenergy_;
+img::ImageBuffer vHBHE_EMenergy_;
+img::SparseRemap ecalToHBHE_; // EB then EE hashed indices -> vHBHE_EMenergy_
+unsigned long long ecalToHBHE_cacheId_ = 0;
 
 // Initialize branches _____________________________________________________________//
 void RecHitAnalyzer::branchesECALatHCAL ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("HBHE_EMenergy",    &vHBHE_EMenergy_);
-  // Intermediate helper histogram (single event only)
-  hEvt_HBHE_EMenergy = new TH2F("evt_HBHE_EMenergy", "E(#phi,#eta);#phi;#eta",
-      HBHE_IPHI_NUM,         -TMath::Pi(),     TMath::Pi(),
-      2*(HBHE_IETA_MAX_HE-1), eta_bins_HBHE );
+  tree->Branch("HBHE_EMenergy",    &vHBHE_EMenergy_.pixels());
+  registerImage( "HBHE_EMenergy", vHBHE_EMenergy_, 2*(HBHE_IETA_MAX_HE-1), HBHE_IPHI_NUM );
 
   // Histograms for monitoring
   hHBHE_EMenergy = fs->make<TProfile2D>("HBHE_EMenergy", "E(i#phi,i#eta);i#phi;i#eta",
@@ -34,20 +36,46 @@ void RecHitAnalyzer::branchesECALatHCAL ( TTree* tree, edm::Service<TFileService
 // Fill ECAL rechits at HBHE granularity ___________________________________________________//
 void RecHitAnalyzer::fillECALatHCAL ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
-  int ieta_, iphi_, idx_;
-  float eta,  phi, energy_;
-  GlobalPoint pos;
-
-  vHBHE_EMenergy_.assign( 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1),0. );
-  hEvt_HBHE_EMenergy->Reset();
+  int idx_;
+  float energy_;
+
+  // Only needs rebuilding when the geometry changes
+  unsigned long long cacheId = geoSnapshot_ ? 1 : iSetup.get<CaloGeometryRecord>().cacheIdentifier();
+  if ( cacheId != ecalToHBHE_cacheId_ ) {
+
+    const img::EtaPhiGrid grid{ 2*(HBHE_IETA_MAX_HE-1), eta_bins_HBHE, HBHE_IPHI_NUM, -TMath::Pi(), TMath::Pi() };
+    std::vector<img::SparseRemap::Entry> entries;
+    std::vector<std::pair<int,float> > overlaps;
+    img::CellBox box;
+    int iphi_, ieta_;
+
+    int nSrc = EBDetId::kSizeForDenseIndexing + EEDetId::kSizeForDenseIndexing;
+    for ( int iS = 0; iS < nSrc; iS++ ) {
+      DetId id = iS < EBDetId::kSizeForDenseIndexing ? DetId( EBDetId::unhashIndex( iS ) )
+                                                     : DetId( EEDetId::unhashIndex( iS-EBDetId::kSizeForDenseIndexing ) );
+      getCellEtaPhiBox( id, box.minEta, box.maxEta, box.minPhi, box.maxPhi );
+      overlaps.clear();
+      img::etaPhiOverlaps( box, grid, overlaps );
+      for ( auto const& overlap : overlaps ) {
+        ieta_ = overlap.first/HBHE_IPHI_NUM;
+        // NOTE: EB iphi = 1 does not correspond to physical phi = -pi so need to shift!
+        iphi_ = overlap.first%HBHE_IPHI_NUM + 1 + 38; // shift
+        iphi_ = iphi_ > HBHE_IPHI_MAX ? iphi_-HBHE_IPHI_MAX : iphi_; // wrap-around
+        iphi_ = iphi_ - 1;
+        entries.push_back( img::SparseRemap::Entry{ iS, ieta_*HBHE_IPHI_NUM + iphi_, overlap.second } );
+      }
+    }
+    ecalToHBHE_.build( nSrc, 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1), entries );
+    ecalToHBHE_cacheId_ = cacheId;
+
+  }
+
+  vHBHE_EMenergy_.reset( 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1) );
 
   edm::Handle<EcalRecHitCollection> EBRecHitsH_;
   iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_ );
   edm::Handle<EcalRecHitCollection> EERecHitsH_;
   iEvent.getByToken( EERecHitCollectionT_, EERecHitsH_ );
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
 
   // Fill EB rechits
   for ( EcalRecHitCollection::const_iterator iRHit = EBRecHitsH_->begin();
@@ -55,14 +83,7 @@ void RecHitAnalyzer::fillECALatHCAL ( const edm::Event& iEvent, const edm::Event
 
     energy_ = iRHit->energy();
     if ( energy_ <= zs ) continue;
-    // Get position of cell centers
-    pos = caloGeom->getPosition( iRHit->id() );
-    eta = pos.eta();
-    phi = pos.phi();
-    // Fill intermediate helper histogram by eta,phi
-    hEvt_HBHE_EMenergy->Fill( phi, eta, energy_ );
-
-    //HcalDetId hId( spr::findDetIdHCAL( caloGeom, eta, phi, false ) );
+    ecalToHBHE_.scatter( EBDetId( iRHit->id() ).hashedIndex(), energy_, vHBHE_EMenergy_ );
 
   } // EB rechits
 
@@ -72,35 +93,19 @@ void RecHitAnalyzer::fillECALatHCAL ( const edm::Event& iEvent, const edm::Event
 
     energy_ = iRHit->energy();
     if ( energy_ <= zs ) continue;
-    // Get position of cell centers
-    pos = caloGeom->getPosition( iRHit->id() );
-    eta = pos.eta();
-    phi = pos.phi();
-    // Fill intermediate helper histogram by eta,phi
-    hEvt_HBHE_EMenergy->Fill( phi, eta, energy_ );
-
-    //HcalDetId hId( spr::findDetIdHCAL( caloGeom, eta, phi, false ) );
+    idx_ = EBDetId::kSizeForDenseIndexing + EEDetId( iRHit->id() ).hashedIndex();
+    ecalToHBHE_.scatter( idx_, energy_, vHBHE_EMenergy_ );
 
   } // EE rechits
 
-  // Fill vector for full ECAL@HCAL image using helper histograms
-  for (int ieta = 1; ieta < hEvt_HBHE_EMenergy->GetNbinsY()+1; ieta++) {
-    ieta_ = ieta - 1;
-    for (int iphi = 1; iphi < hEvt_HBHE_EMenergy->GetNbinsX()+1; iphi++) {
-
-      energy_ = hEvt_HBHE_EMenergy->GetBinContent( iphi, ieta );
-      if ( energy_ <= zs ) continue;
-      // NOTE: EB iphi = 1 does not correspond to physical phi = -pi so need to shift!
-      iphi_ = iphi  + 38; // shift
-      iphi_ = iphi_ > HBHE_IPHI_MAX ? iphi_-HBHE_IPHI_MAX : iphi_; // wrap-around
-      iphi_ = iphi_ - 1;
-      idx_  = ieta_*HBHE_IPHI_NUM + iphi_;
-      // Fill vector for image
-      vHBHE_EMenergy_[idx_] = energy_;
-      // Fill histogram for monitoring
-      hHBHE_EMenergy->Fill( iphi_, ieta_-(HBHE_IETA_MAX_HE-1), energy_ );
-
-    } // iphi
-  } // ieta
+  // Zero suppress the tower sums and fill histogram for monitoring
+  for ( idx_ = 0; idx_ < vHBHE_EMenergy_.size(); idx_++ ) {
+    energy_ = vHBHE_EMenergy_.get( idx_ );
+    if ( energy_ <= zs ) {
+      if ( energy_ != 0. ) vHBHE_EMenergy_[idx_] = 0.;
+      continue;
+    }
+    hHBHE_EMenergy->Fill( idx_%HBHE_IPHI_NUM, idx_/HBHE_IPHI_NUM-(HBHE_IETA_MAX_HE-1), energy_ );
+  }
 
 } // fillECALatHCAL()
@@ -6,8 +6,8 @@
 
 TProfile2D *hEE_energy[nEE];
 TProfile2D *hEE_time[nEE];
-std::vector<float> vEE_energy_[nEE];
-std::vector<float> vEE_time_[nEE];
+img::ImageBuffer vEE_energy_[nEE];
+img::ImageBuffer vEE_time_[nEE];
 
 // Initialize branches _____________________________________________________//
 void RecHitAnalyzer::branchesEE ( TTree* tree, edm::Service<TFileService> &fs ) {
@@ -17,9 +17,9 @@ void RecHitAnalyzer::branchesEE ( TTree* tree, edm::Service<TFileService> &fs )
     // Branches for images
     const char *zside = (iz > 0) ? "p" : "m";
     sprintf(hname, "EE%s_energy",zside);
-    tree->Branch(hname,        &vEE_energy_[iz]);
+    tree->Branch(hname,        &vEE_energy_[iz].pixels());
     sprintf(hname, "EE%s_time",  zside);
-    tree->Branch(hname,        &vEE_time_[iz]);
+    tree->Branch(hname,        &vEE_time_[iz].pixels());
 
     // Histograms for monitoring
     sprintf(hname, "EE%s_energy",zside);
@@ -43,8 +43,8 @@ void RecHitAnalyzer::fillEE ( const edm::Event& iEvent, const edm::EventSetup& i
   float energy_;
 
   for ( int iz(0); iz < nEE; iz++ ) {
-    vEE_energy_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEE_time_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vEE_energy_[iz].reset( EE_NC_PER_ZSIDE );
+    vEE_time_[iz].reset( EE_NC_PER_ZSIDE );
   }
 
   edm::Handle<EcalRecHitCollection> EERecHitsH_;
@@ -6,8 +6,8 @@
 
 TProfile2D *hES_energy[nES];
 TProfile2D *hES_time[nES];
-std::vector<float> vES_energy_[nES];
-std::vector<float> vES_time_[nES];
+img::ImageBuffer vES_energy_[nES];
+img::ImageBuffer vES_time_[nES];
 
 // Initialize branches _____________________________________________________//
 void RecHitAnalyzer::branchesES ( TTree* tree, edm::Service<TFileService> &fs ) {
@@ -17,9 +17,9 @@ void RecHitAnalyzer::branchesES ( TTree* tree, edm::Service<TFileService> &fs )
     // Branches for images
     const char *zside = (iz > 0) ? "p" : "m";
     sprintf(hname, "ES%s_energy",zside);
-    tree->Branch(hname,        &vES_energy_[iz]);
+    tree->Branch(hname,        &vES_energy_[iz].pixels());
     sprintf(hname, "ES%s_time",  zside);
-    tree->Branch(hname,        &vES_time_[iz]);
+    tree->Branch(hname,        &vES_time_[iz].pixels());
 
     // Histograms for monitoring
     sprintf(hname, "ES%s_energy",zside);
@@ -43,8 +43,8 @@ void RecHitAnalyzer::fillES ( const edm::Event& iEvent, const edm::EventSetup& i
   float energy_;
 
   for ( int iz(0); iz < nES; iz++ ) {
-    vES_energy_[iz].assign( ES_NC_PER_ZSIDE, 0. );
-    vES_time_[iz].assign( ES_NC_PER_ZSIDE, 0. );
+    vES_energy_[iz].reset( ES_NC_PER_ZSIDE );
+    vES_time_[iz].reset( ES_NC_PER_ZSIDE );
   }
 
   edm::Handle<EcalRecHitCollection> ESRecHitsH_;
@@ -1,4 +1,5 @@
 #include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/CaloHitGather.h"
 
 // Fill HBHE rec hits ////////////////////////////////////
 // Store event rechits in a vector of length equal
@@ -8,27 +9,26 @@
 //
 // NOTE: The iphi granularity drops partway into HE
 // and the final ieta tower in HE is embedded in 
-// the 2nd to last one. Due to these complications,
-// more intuitive to fill an intermediate histogram first.
-// As this is binned in ieta,iphi, assignment is exact.
+// the 2nd to last one. These complications are handled
+// in img::fillHBHEImage, which sums the towers exactly as
+// an intermediate histogram binned in ieta,iphi would.
+// The monitoring histograms are filled from the images,
+// i.e. with the depth-summed tower energies.
 
-TH2F *hEvt_HBHE_energy;
 TProfile2D *hHBHE_energy_EB;
 TProfile2D *hHBHE_energy;
-std::vector<float> vHBHE_energy_EB_;
-std::vector<float> vHBHE_energy_;
+img::ImageBuffer vHBHE_energy_EB_;
+img::ImageBuffer vHBHE_energy_;
+std::vector<img::HBHEHit> vHBHE_hits_;
 
 // Initialize branches _______________________________________________________//
 void RecHitAnalyzer::branchesHBHE ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("HBHE_energy_EB", &vHBHE_energy_EB_); // LR: BARREL ENERGY BRANCH DEFINED HERE
-  tree->Branch("HBHE_energy",    &vHBHE_energy_);
-
-  // Intermediate helper histogram (single event only)
-  hEvt_HBHE_energy = new TH2F("evt_HBHE_energy", "E(i#phi,i#eta);i#phi;i#eta",
-      HBHE_IPHI_NUM,           HBHE_IPHI_MIN-1,    HBHE_IPHI_MAX,
-      2*(HBHE_IETA_MAX_HE-1),-(HBHE_IETA_MAX_HE-1),HBHE_IETA_MAX_HE-1 );
+  tree->Branch("HBHE_energy_EB", &vHBHE_energy_EB_.pixels()); // LR: BARREL ENERGY BRANCH DEFINED HERE
+  tree->Branch("HBHE_energy",    &vHBHE_energy_.pixels());
+  registerImage( "HBHE_energy_EB", vHBHE_energy_EB_, 2*HBHE_IETA_MAX_EB,    HBHE_IPHI_NUM );
+  registerImage( "HBHE_energy",    vHBHE_energy_,    2*(HBHE_IETA_MAX_HE-1), HBHE_IPHI_NUM );
 
   // Histograms for monitoring
   hHBHE_energy = fs->make<TProfile2D>("HBHE_energy", "E(i#phi,i#eta);i#phi;i#eta",
@@ -43,94 +43,40 @@ void RecHitAnalyzer::branchesHBHE ( TTree* tree, edm::Service<TFileService> &fs
 // Fill HBHE rechits _________________________________________________________________//
 void RecHitAnalyzer::fillHBHE ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
-  int iphi_, ieta_, ietaAbs_, idx_;
+  int iphi_, ieta_;
   float energy_;
-  //float eta, GlobalPoint pos;
-
-  vHBHE_energy_EB_.assign( 2*HBHE_IPHI_NUM*HBHE_IETA_MAX_EB, 0. ); 
-  vHBHE_energy_.assign( 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1), 0. );
-  hEvt_HBHE_energy->Reset();
-
-  edm::Handle<HBHERecHitCollection> HBHERecHitsH_;
-  iEvent.getByToken( HBHERecHitCollectionT_, HBHERecHitsH_ );
 
-  /*
-  // Provides access to global cell position
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom;
-  caloGeom = caloGeomH_.product();
-  */
+  // Images from the DetectorImage product, else from the rechits
+  if ( !getDetectorImages( iEvent, {"HBHE_energy_EB", "HBHE_energy"} ) ) {
 
-  // Fill HBHE rechits 
-  for ( HBHERecHitCollection::const_iterator iRHit = HBHERecHitsH_->begin();
-        iRHit != HBHERecHitsH_->end(); ++iRHit ) {
+    edm::Handle<HBHERecHitCollection> HBHERecHitsH_;
+    iEvent.getByToken( HBHERecHitCollectionT_, HBHERecHitsH_ );
 
-    energy_ = iRHit->energy();
-    // std::cout << energy_ << std::endl;
-    if ( energy_ <= zs ) continue;
-    // Get detector id and convert to histogram-friendly coordinates
-    // NOTE: HBHE detector ids are indexed by (ieta,iphi,depth)!
-    HcalDetId hId( iRHit->id() );
-    // NOTE: HBHE iphi = 1 does not correspond to EB iphi = 1!
-    // => Need to shift by 2 HBHE towers: HBHE::iphi: [1,...,71,72]->[3,4,...,71,72,1,2]
-    iphi_  = hId.iphi() + 2; // shift
-    iphi_  = iphi_ > HBHE_IPHI_MAX ? iphi_-HBHE_IPHI_MAX : iphi_; // wrap-around
-    iphi_  = iphi_ - 1; // make histogram-friendly
-    ietaAbs_  = hId.ietaAbs() == HBHE_IETA_MAX_HE ? HBHE_IETA_MAX_HE-1 : hId.ietaAbs(); // last HBHE ieta embedded
-    ieta_  = hId.zside() > 0 ? ietaAbs_-1 : -ietaAbs_;
-    //depth_ = hId.depth();
+    // Fill vectors for images
+    // NOTE: energies are summed over depth for a given (ieta,iphi)
+    img::gatherHBHEHits( *HBHERecHitsH_, vHBHE_hits_ );
+    img::fillHBHEImage( vHBHE_hits_, vHBHE_energy_EB_, vHBHE_energy_ );
 
-    // Fill vectors/histos by ieta range: /////////////////////////
+  } // rechits
 
-    // (A) hId.ieta() > 20: full extent of HBHE
-    // NOTE: HBHE iphis only occur in even numbers in coarse region
-    // => Fill adjacent (odd) iphi bin and split energy evenly.
-    if ( hId.ietaAbs() > HBHE_IETA_MAX_FINE ) {
-      // Fill histograms for monitoring
-      hHBHE_energy->Fill( iphi_  , ieta_, energy_*0.5 );
-      hHBHE_energy->Fill( iphi_+1, ieta_, energy_*0.5 );
-      // Fill intermediate helper histogram
-      hEvt_HBHE_energy->Fill( iphi_  , ieta_, energy_*0.5 );
-      hEvt_HBHE_energy->Fill( iphi_+1, ieta_, energy_*0.5 );
-      continue;
-    }
-
-    // (B) hId.ieta() <= 20: fine iphi granularity (beyond this, iphi granularity is halved)
-    // Fill histograms normally
-    else {
+  // Fill histograms for monitoring, only filled tiles can be nonzero
+  for ( int iT : vHBHE_energy_.dirtyTiles() ) {
+    for ( int idx = vHBHE_energy_.tileBegin(iT); idx < vHBHE_energy_.tileEnd(iT); idx++ ) {
+      energy_ = vHBHE_energy_.get(idx);
+      if ( energy_ <= zs ) continue;
+      ieta_ = idx/HBHE_IPHI_NUM - (HBHE_IETA_MAX_HE-1);
+      iphi_ = idx%HBHE_IPHI_NUM;
       hHBHE_energy->Fill( iphi_,ieta_,energy_ );
-      hEvt_HBHE_energy->Fill( iphi_,ieta_,energy_ );
-    }
-
-    // (C) hId.ieta() <= 17: overlap with EB 
-    // Additionally, fill EB-overlap-only vectors/histograms
-    if ( hId.ietaAbs() > HBHE_IETA_MAX_EB ) continue;
-    // Fill histograms for monitoring
-    hHBHE_energy_EB->Fill( iphi_,ieta_,energy_ );
-    // Create hashed index: maps from [ieta][iphi][:] -> [idx_]
-    // Effectively sums energies over depth for a given (ieta,iphi)
-    idx_ = ( ieta_+HBHE_IETA_MAX_EB )*HBHE_IPHI_NUM + iphi_;
-    // Fill vector for image
-    // NOTE: Must use '+=' since different depths can map to same iphi,ieta
-    vHBHE_energy_EB_[idx_] += energy_;
-    //pos = caloGeom->getPosition( hId );
-    //eta = pos.eta();
-    //vHBHE_energy_EB_[idx_] += energy_/TMath::CosH(eta); // pick out transverse component only
-
-  } // HBHE rechits
-
-  // Fill vector for full HBHE image using helper histogram
-  for (int ieta = 1; ieta < hEvt_HBHE_energy->GetNbinsY()+1; ieta++) {
-    for (int iphi = 1; iphi < hEvt_HBHE_energy->GetNbinsX()+1; iphi++) {
-
-      energy_ = hEvt_HBHE_energy->GetBinContent( iphi, ieta );
+    } // idx
+  } // tiles
+  for ( int iT : vHBHE_energy_EB_.dirtyTiles() ) {
+    for ( int idx = vHBHE_energy_EB_.tileBegin(iT); idx < vHBHE_energy_EB_.tileEnd(iT); idx++ ) {
+      energy_ = vHBHE_energy_EB_.get(idx);
       if ( energy_ <= zs ) continue;
-      idx_ = (ieta-1)*HBHE_IPHI_NUM + (iphi-1);
-      // Fill vector for image
-      vHBHE_energy_[idx_] = energy_;
-
-    } // iphi
-  } // ieta
+      ieta_ = idx/HBHE_IPHI_NUM - HBHE_IETA_MAX_EB;
+      iphi_ = idx%HBHE_IPHI_NUM;
+      hHBHE_energy_EB->Fill( iphi_,ieta_,energy_ );
+    } // idx
+  } // tiles
 
 } // fillHBHE()
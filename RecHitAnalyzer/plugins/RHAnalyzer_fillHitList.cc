@@ -0,0 +1,162 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/HitTable.h"
+#include "DataFormats/EcalDetId/interface/ESDetId.h"
+
+// Fill hit list ///////////////////////////////////////////
+// Store the EB, EE, ES and HBHE rechits and the charged PF
+// candidates (the tracks) at the ECAL entrance as one flat table
+// (see HitTable.h), instead of or next to the dense images. In JetLevel mode with
+// hitListJetDR > 0, only hits within that dR of a selected
+// jet are kept.
+//
+// Cell positions are cached per dense cell index the first
+// time a cell is hit, and dropped when the geometry changes.
+
+struct CachedCell {
+  float x;
+  float y;
+  float z;
+  float eta;
+  float phi;
+  bool  isSet;
+};
+
+img::HitTable vHits_;
+std::vector<CachedCell> vHitCells_[4]; // kHitEB, kHitEE, kHitES, kHitHBHE
+unsigned long long vHitCells_cacheId_ = 0;
+
+// Initialize branches _____________________________________________________//
+void RecHitAnalyzer::branchesHitList ( TTree* tree, edm::Service<TFileService> &fs ) {
+
+  tree->Branch("hits_detId",  &vHits_.detId);
+  tree->Branch("hits_subdet", &vHits_.subdet);
+  tree->Branch("hits_jet",    &vHits_.jet);
+  tree->Branch("hits_eta",    &vHits_.eta);
+  tree->Branch("hits_phi",    &vHits_.phi);
+  tree->Branch("hits_x",      &vHits_.x);
+  tree->Branch("hits_y",      &vHits_.y);
+  tree->Branch("hits_z",      &vHits_.z);
+  tree->Branch("hits_energy", &vHits_.energy);
+  tree->Branch("hits_time",   &vHits_.time);
+  tree->Branch("hits_d0",     &vHits_.d0);
+  tree->Branch("hits_z0",     &vHits_.z0);
+  tree->Branch("hits_charge", &vHits_.charge);
+
+} // branchesHitList()
+
+// Fill hit list ___________________________________________________________//
+void RecHitAnalyzer::fillHitList ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
+
+  vHits_.clear();
+
+  unsigned long long cacheId = geoSnapshot_ ? 1 : iSetup.get<CaloGeometryRecord>().cacheIdentifier();
+  if ( cacheId != vHitCells_cacheId_ ) {
+    const CachedCell unset{ 0., 0., 0., 0., 0., false };
+    vHitCells_[img::kHitEB].assign( EBDetId::kSizeForDenseIndexing, unset );
+    vHitCells_[img::kHitEE].assign( EEDetId::kSizeForDenseIndexing, unset );
+    vHitCells_[img::kHitES].assign( ESDetId::kSizeForDenseIndexing, unset );
+    vHitCells_[img::kHitHBHE].assign( img::GeometrySnapshot::HBHE_NCELLS, unset );
+    vHitCells_cacheId_ = cacheId;
+  }
+
+  // Selected jets, if hits are restricted to jets
+  edm::Handle<reco::PFJetCollection> jets;
+  bool byJet = doJets_ && hitListJetDR_ > 0.;
+  if ( byJet ) iEvent.getByToken( jetCollectionT_, jets );
+
+  // Nearest selected jet within hitListJetDR_: its position in vJetIdxs,
+  // -1 if not restricted to jets, -2 if too far from all jets
+  auto nearestJet = [&]( float eta, float phi ) {
+    if ( !byJet ) return -1;
+    int nearest = -2;
+    float minDR = hitListJetDR_;
+    for ( unsigned int iJ = 0; iJ < vJetIdxs.size(); iJ++ ) {
+      reco::PFJetRef iJet( jets, vJetIdxs[iJ] );
+      float dR = reco::deltaR( eta, phi, iJet->eta(), iJet->phi() );
+      if ( dR > minDR ) continue;
+      minDR = dR;
+      nearest = iJ;
+    }
+    return nearest;
+  };
+
+  // Calorimeter rechit, cell position from the cache
+  auto addRecHit = [&]( int subdet, int idx, const DetId& id, float energy, float time ) {
+    CachedCell& cell = vHitCells_[subdet][idx];
+    if ( !cell.isSet ) {
+      GlobalPoint pos = getCellPosition( id );
+      cell = CachedCell{ pos.x(), pos.y(), pos.z(), pos.eta(), pos.phi(), true };
+    }
+    int jet = nearestJet( cell.eta, cell.phi );
+    if ( jet == -2 ) return;
+    vHits_.push_back( img::HitRow{ id.rawId(), subdet, jet, cell.eta, cell.phi, cell.x, cell.y, cell.z,
+                                   energy, time, 0., 0., 0 } );
+  };
+
+  edm::Handle<EcalRecHitCollection> EBRecHitsH_;
+  iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_ );
+  for ( EcalRecHitCollection::const_iterator iRHit = EBRecHitsH_->begin();
+        iRHit != EBRecHitsH_->end(); ++iRHit ) {
+    if ( iRHit->energy() <= zs ) continue;
+    EBDetId ebId( iRHit->id() );
+    addRecHit( img::kHitEB, ebId.hashedIndex(), ebId, iRHit->energy(), iRHit->time() );
+  } // EB rechits
+
+  edm::Handle<EcalRecHitCollection> EERecHitsH_;
+  iEvent.getByToken( EERecHitCollectionT_, EERecHitsH_ );
+  for ( EcalRecHitCollection::const_iterator iRHit = EERecHitsH_->begin();
+        iRHit != EERecHitsH_->end(); ++iRHit ) {
+    if ( iRHit->energy() <= zs ) continue;
+    EEDetId eeId( iRHit->id() );
+    addRecHit( img::kHitEE, eeId.hashedIndex(), eeId, iRHit->energy(), iRHit->time() );
+  } // EE rechits
+
+  edm::Handle<EcalRecHitCollection> ESRecHitsH_;
+  iEvent.getByToken( ESRecHitCollectionT_, ESRecHitsH_ );
+  for ( EcalRecHitCollection::const_iterator iRHit = ESRecHitsH_->begin();
+        iRHit != ESRecHitsH_->end(); ++iRHit ) {
+    if ( iRHit->energy() <= zs ) continue;
+    ESDetId esId( iRHit->id() );
+    addRecHit( img::kHitES, esId.hashedIndex(), esId, iRHit->energy(), iRHit->time() );
+  } // ES rechits
+
+  edm::Handle<HBHERecHitCollection> HBHERecHitsH_;
+  iEvent.getByToken( HBHERecHitCollectionT_, HBHERecHitsH_ );
+  for ( HBHERecHitCollection::const_iterator iRHit = HBHERecHitsH_->begin();
+        iRHit != HBHERecHitsH_->end(); ++iRHit ) {
+    if ( iRHit->energy() <= zs ) continue;
+    HcalDetId hId( iRHit->id() );
+    addRecHit( img::kHitHBHE, img::GeometrySnapshot::hbheIndex( hId.ieta(), hId.iphi(), hId.depth() ),
+               hId, iRHit->energy(), iRHit->time() );
+  } // HBHE rechits
+
+  // Charged PF candidates at the ECAL entrance: neutrals are
+  // already in the table as calorimeter rechits
+  edm::Handle<PFCollection> pfCandsH_;
+  iEvent.getByToken( pfCollectionT_, pfCandsH_ );
+  edm::Handle<reco::VertexCollection> vertexInfo;
+  iEvent.getByToken( vertexCollectionT_, vertexInfo );
+  const reco::VertexCollection& vtxs = *vertexInfo;
+
+  for ( PFCollection::const_iterator iPFC = pfCandsH_->begin();
+        iPFC != pfCandsH_->end(); ++iPFC ) {
+
+    if ( iPFC->charge() == 0 ) continue;
+    const math::XYZPointF& ecalPos = iPFC->positionAtECALEntrance();
+    float eta = ecalPos.eta();
+    float phi = ecalPos.phi();
+    int jet = nearestJet( eta, phi );
+    if ( jet == -2 ) continue;
+
+    float d0 = 0., z0 = 0.;
+    const reco::Track* thisTrk = iPFC->bestTrack();
+    if ( thisTrk ) {
+      d0 = !vtxs.empty() ? thisTrk->dxy( vtxs[0].position() ) : thisTrk->dxy();
+      z0 = !vtxs.empty() ? thisTrk->dz( vtxs[0].position() )  : thisTrk->dz();
+    }
+    vHits_.push_back( img::HitRow{ 0, img::kHitPFCand, jet, eta, phi, ecalPos.x(), ecalPos.y(), ecalPos.z(),
+                                   float( iPFC->energy() ), 0., d0, z0, iPFC->charge() } );
+
+  } // pfCands
+
+} // fillHitList()
@@ -0,0 +1,43 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+// Fill image pyramid levels ///////////////////////////////
+// Store up/downsampled copies of the registered image
+// channels, as configured by 'imagePyramid', e.g. ECAL_energy
+// summed over 5x5 crystals (HCAL granularity) or HBHE_energy
+// spread over 5x5 crystals (EB granularity). Must run after
+// the fill functions of the source channels.
+
+// Initialize branches _____________________________________________________//
+void RecHitAnalyzer::branchesImagePyramid ( TTree* tree, edm::Service<TFileService> &fs ) {
+
+  char bname[100];
+  for ( PyramidLevel& level : pyramidLevels_ ) {
+
+    auto channel = imageChannels_.find( level.channel );
+    if ( channel == imageChannels_.end() ) {
+      throw cms::Exception("RecHitAnalyzer") << "imagePyramid: no image channel " << level.channel;
+    }
+    level.source = channel->second;
+
+    sprintf(bname, "%s_%s%d", level.channel.c_str(), level.upsample ? "up" : "down", level.factor);
+    // pyramidLevels_ is not resized after this point, so the address stays valid
+    tree->Branch(bname, &level.image.pixels());
+    std::cout << " >> Image pyramid level " << bname << std::endl;
+
+  } // levels
+
+} // branchesImagePyramid()
+
+// Fill pyramid levels _____________________________________________________//
+void RecHitAnalyzer::fillImagePyramid ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
+
+  for ( PyramidLevel& level : pyramidLevels_ ) {
+    if ( level.upsample ) {
+      img::upsampleImage( *level.source.image, level.source.nRows, level.source.nCols, level.factor, level.image );
+    } else {
+      img::downsampleImage( *level.source.image, level.source.nRows, level.source.nCols, level.factor, level.image );
+    }
+  } // levels
+
+} // fillImagePyramid()
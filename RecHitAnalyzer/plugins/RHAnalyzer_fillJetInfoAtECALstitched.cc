@@ -7,19 +7,19 @@ TH2F *hEvt_EE_tracksIP3D[nEE];
 TH2F *hEvt_EE_tracksIP2Dsig[nEE];
 TH2F *hEvt_EE_tracksIP3Dsig[nEE];
 
-std::vector<float> vECAL_tracksIP2D_;
-std::vector<float> vECAL_tracksIP3D_;
-std::vector<float> vECAL_tracksIP2Dsig_;
-std::vector<float> vECAL_tracksIP3Dsig_;
+img::ImageBuffer vECAL_tracksIP2D_;
+img::ImageBuffer vECAL_tracksIP3D_;
+img::ImageBuffer vECAL_tracksIP2Dsig_;
+img::ImageBuffer vECAL_tracksIP3Dsig_;
 
 // Initialize branches _______________________________________________________________//
 void RecHitAnalyzer::branchesJetInfoAtECALstitched ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("ECAL_tracksIP2D",       &vECAL_tracksIP2D_);
-  tree->Branch("ECAL_tracksIP3D",       &vECAL_tracksIP3D_);
-  tree->Branch("ECAL_tracksIP2Dsig",    &vECAL_tracksIP2Dsig_);
-  tree->Branch("ECAL_tracksIP3Dsig",    &vECAL_tracksIP3Dsig_);
+  tree->Branch("ECAL_tracksIP2D",       &vECAL_tracksIP2D_.pixels());
+  tree->Branch("ECAL_tracksIP3D",       &vECAL_tracksIP3D_.pixels());
+  tree->Branch("ECAL_tracksIP2Dsig",    &vECAL_tracksIP2Dsig_.pixels());
+  tree->Branch("ECAL_tracksIP3Dsig",    &vECAL_tracksIP3Dsig_.pixels());
 
   static const std::string strIndex[2] = {"m","p"};
   static const double* binIndex[2] = {eta_bins_EEm, eta_bins_EEp};
@@ -94,10 +94,10 @@ void RecHitAnalyzer::fillJetInfoAtECALstitched ( const edm::Event& iEvent, const
   float eta, phi, trackIP2D_, trackIP3D_, trackIP2Dsig_, trackIP3Dsig_;
   GlobalPoint pos;
 
-  vECAL_tracksIP2D_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_tracksIP3D_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_tracksIP2Dsig_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_tracksIP3Dsig_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
+  vECAL_tracksIP2D_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_tracksIP3D_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_tracksIP2Dsig_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_tracksIP3Dsig_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
   for ( int iz(0); iz < nEE; ++iz ){
     hEvt_EE_tracksIP2D[iz]->Reset();
     hEvt_EE_tracksIP3D[iz]->Reset();
@@ -105,9 +105,6 @@ void RecHitAnalyzer::fillJetInfoAtECALstitched ( const edm::Event& iEvent, const
     hEvt_EE_tracksIP3Dsig[iz]->Reset();
   }
 
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
 
   edm::Handle<edm::View<reco::Jet> > recoJetCollection;
   iEvent.getByToken(recoJetsT_, recoJetCollection);
@@ -165,7 +162,7 @@ void RecHitAnalyzer::fillJetInfoAtECALstitched ( const edm::Event& iEvent, const
 	  float IP3Dsig = ipData[idTrk].ip3d.significance();
 
 	  if ( std::abs(eta) > 3. ) continue;
-	  DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+	  DetId id( findDetIdECAL( eta, phi ) );
 	  if ( id.subdetId() == EcalBarrel ) {
 	    // Fill middle part of ECAL(iphi,ieta) with the EB rechits.
 	    ieta_global_offset = 55;
@@ -4,59 +4,59 @@
 // Fill PFCands in EB+EE ////////////////////////////////
 // Store PFCands in EB+EE projection
 
-std::vector<float> vEndTracksPt_EE_[nEE];
-std::vector<float> vEndTracksQPt_EE_[nEE];
-std::vector<float> vEndTracksPt_EE_PV_[nEE];
-std::vector<float> vEndTracksQPt_EE_PV_[nEE];
-std::vector<float> vEndTracksPt_EE_nPV_[nEE];
-std::vector<float> vEndTracksQPt_EE_nPV_[nEE];
-
-std::vector<float> vMuonsPt_EE_[nEE];
-std::vector<float> vMuonsQPt_EE_[nEE];
-std::vector<float> vMuonsPt_EE_PV_[nEE];
-std::vector<float> vMuonsQPt_EE_PV_[nEE];
-
-std::vector<float> vEndTracksPt_EB_;
-std::vector<float> vEndTracksQPt_EB_;
-std::vector<float> vEndTracksPt_EB_PV_;
-std::vector<float> vEndTracksQPt_EB_PV_;
-std::vector<float> vEndTracksPt_EB_nPV_;
-std::vector<float> vEndTracksQPt_EB_nPV_;
-std::vector<float> vMuonsPt_EB_;
-std::vector<float> vMuonsQPt_EB_;
-std::vector<float> vMuonsPt_EB_PV_;
-std::vector<float> vMuonsQPt_EB_PV_;
+img::ImageBuffer vEndTracksPt_EE_[nEE];
+img::ImageBuffer vEndTracksQPt_EE_[nEE];
+img::ImageBuffer vEndTracksPt_EE_PV_[nEE];
+img::ImageBuffer vEndTracksQPt_EE_PV_[nEE];
+img::ImageBuffer vEndTracksPt_EE_nPV_[nEE];
+img::ImageBuffer vEndTracksQPt_EE_nPV_[nEE];
+
+img::ImageBuffer vMuonsPt_EE_[nEE];
+img::ImageBuffer vMuonsQPt_EE_[nEE];
+img::ImageBuffer vMuonsPt_EE_PV_[nEE];
+img::ImageBuffer vMuonsQPt_EE_PV_[nEE];
+
+img::ImageBuffer vEndTracksPt_EB_;
+img::ImageBuffer vEndTracksQPt_EB_;
+img::ImageBuffer vEndTracksPt_EB_PV_;
+img::ImageBuffer vEndTracksQPt_EB_PV_;
+img::ImageBuffer vEndTracksPt_EB_nPV_;
+img::ImageBuffer vEndTracksQPt_EB_nPV_;
+img::ImageBuffer vMuonsPt_EB_;
+img::ImageBuffer vMuonsQPt_EB_;
+img::ImageBuffer vMuonsPt_EB_PV_;
+img::ImageBuffer vMuonsQPt_EB_PV_;
 
 // Initialize branches ____________________________________________________________//
 void RecHitAnalyzer::branchesPFCandsAtEBEE ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("EndTracksPt_EB",  &vEndTracksPt_EB_);
-  tree->Branch("EndTracksQPt_EB", &vEndTracksQPt_EB_);
-  tree->Branch("EndTracksPt_EB_PV",  &vEndTracksPt_EB_PV_);
-  tree->Branch("EndTracksQPt_EB_PV", &vEndTracksQPt_EB_PV_);
-  tree->Branch("EndTracksPt_EB_nPV",  &vEndTracksPt_EB_nPV_);
-  tree->Branch("EndTracksQPt_EB_npPV", &vEndTracksQPt_EB_nPV_);
-  tree->Branch("MuonsPt_EB",  &vMuonsPt_EB_);
-  tree->Branch("MuonsQPt_EB", &vMuonsQPt_EB_);
-  tree->Branch("MuonsPt_EB_PV",  &vMuonsPt_EB_PV_);
-  tree->Branch("MuonsQPt_EB_PV", &vMuonsQPt_EB_PV_);
+  tree->Branch("EndTracksPt_EB",  &vEndTracksPt_EB_.pixels());
+  tree->Branch("EndTracksQPt_EB", &vEndTracksQPt_EB_.pixels());
+  tree->Branch("EndTracksPt_EB_PV",  &vEndTracksPt_EB_PV_.pixels());
+  tree->Branch("EndTracksQPt_EB_PV", &vEndTracksQPt_EB_PV_.pixels());
+  tree->Branch("EndTracksPt_EB_nPV",  &vEndTracksPt_EB_nPV_.pixels());
+  tree->Branch("EndTracksQPt_EB_npPV", &vEndTracksQPt_EB_nPV_.pixels());
+  tree->Branch("MuonsPt_EB",  &vMuonsPt_EB_.pixels());
+  tree->Branch("MuonsQPt_EB", &vMuonsQPt_EB_.pixels());
+  tree->Branch("MuonsPt_EB_PV",  &vMuonsPt_EB_PV_.pixels());
+  tree->Branch("MuonsQPt_EB_PV", &vMuonsQPt_EB_PV_.pixels());
 
   char hname[50];
   for ( int iz(0); iz < nEE; iz++ ) {
     // Branches for images
     const char *zside = (iz > 0) ? "p" : "m";
-    sprintf(hname, "EndTracksPt_EE%s",zside);      tree->Branch(hname,        &vEndTracksPt_EE_[iz]);
-    sprintf(hname, "EndTracksQPt_EE%s",zside);     tree->Branch(hname,        &vEndTracksQPt_EE_[iz]);
-    sprintf(hname, "EndTracksPt_PV_EE%s",zside);   tree->Branch(hname,        &vEndTracksPt_EE_PV_[iz]);
-    sprintf(hname, "EndTracksQPt_PV_EE%s",zside);  tree->Branch(hname,        &vEndTracksQPt_EE_PV_[iz]);
-    sprintf(hname, "EndTracksPt_nPV_EE%s",zside);  tree->Branch(hname,        &vEndTracksPt_EE_nPV_[iz]);
-    sprintf(hname, "EndTracksQPt_nPV_EE%s",zside); tree->Branch(hname,        &vEndTracksQPt_EE_nPV_[iz]);
-
-    sprintf(hname, "MuonsPt_EE%s",zside);          tree->Branch(hname,        &vMuonsPt_EE_[iz]);
-    sprintf(hname, "MuonsQPt_EE%s",zside);         tree->Branch(hname,        &vMuonsQPt_EE_[iz]);
-    sprintf(hname, "MuonsPt_PV_EE%s",zside);       tree->Branch(hname,        &vMuonsPt_EE_PV_[iz]);
-    sprintf(hname, "MuonsQPt_PV_EE%s",zside);      tree->Branch(hname,        &vMuonsQPt_EE_PV_[iz]);
+    sprintf(hname, "EndTracksPt_EE%s",zside);      tree->Branch(hname,        &vEndTracksPt_EE_[iz].pixels());
+    sprintf(hname, "EndTracksQPt_EE%s",zside);     tree->Branch(hname,        &vEndTracksQPt_EE_[iz].pixels());
+    sprintf(hname, "EndTracksPt_PV_EE%s",zside);   tree->Branch(hname,        &vEndTracksPt_EE_PV_[iz].pixels());
+    sprintf(hname, "EndTracksQPt_PV_EE%s",zside);  tree->Branch(hname,        &vEndTracksQPt_EE_PV_[iz].pixels());
+    sprintf(hname, "EndTracksPt_nPV_EE%s",zside);  tree->Branch(hname,        &vEndTracksPt_EE_nPV_[iz].pixels());
+    sprintf(hname, "EndTracksQPt_nPV_EE%s",zside); tree->Branch(hname,        &vEndTracksQPt_EE_nPV_[iz].pixels());
+
+    sprintf(hname, "MuonsPt_EE%s",zside);          tree->Branch(hname,        &vMuonsPt_EE_[iz].pixels());
+    sprintf(hname, "MuonsQPt_EE%s",zside);         tree->Branch(hname,        &vMuonsQPt_EE_[iz].pixels());
+    sprintf(hname, "MuonsPt_PV_EE%s",zside);       tree->Branch(hname,        &vMuonsPt_EE_PV_[iz].pixels());
+    sprintf(hname, "MuonsQPt_PV_EE%s",zside);      tree->Branch(hname,        &vMuonsQPt_EE_PV_[iz].pixels());
     
   } // iz
 
@@ -70,37 +70,32 @@ void RecHitAnalyzer::fillPFCandsAtEBEE ( const edm::Event& iEvent, const edm::Ev
   float eta, phi;
   GlobalPoint pos;
 
-  vEndTracksPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEndTracksQPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEndTracksPt_EB_PV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEndTracksQPt_EB_PV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEndTracksPt_EB_nPV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vEndTracksQPt_EB_nPV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vMuonsPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vMuonsQPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vMuonsPt_EB_PV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vMuonsQPt_EB_PV_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vEndTracksPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vEndTracksQPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vEndTracksPt_EB_PV_.reset( EBDetId::kSizeForDenseIndexing );
+  vEndTracksQPt_EB_PV_.reset( EBDetId::kSizeForDenseIndexing );
+  vEndTracksPt_EB_nPV_.reset( EBDetId::kSizeForDenseIndexing );
+  vEndTracksQPt_EB_nPV_.reset( EBDetId::kSizeForDenseIndexing );
+  vMuonsPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vMuonsQPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vMuonsPt_EB_PV_.reset( EBDetId::kSizeForDenseIndexing );
+  vMuonsQPt_EB_PV_.reset( EBDetId::kSizeForDenseIndexing );
   for ( int iz(0); iz < nEE; iz++ ) {
-    vEndTracksPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEndTracksQPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEndTracksPt_EE_PV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEndTracksQPt_EE_PV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEndTracksPt_EE_nPV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vEndTracksQPt_EE_nPV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vMuonsPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vMuonsQPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vMuonsPt_EE_PV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vMuonsQPt_EE_PV_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vEndTracksPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vEndTracksQPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vEndTracksPt_EE_PV_[iz].reset( EE_NC_PER_ZSIDE );
+    vEndTracksQPt_EE_PV_[iz].reset( EE_NC_PER_ZSIDE );
+    vEndTracksPt_EE_nPV_[iz].reset( EE_NC_PER_ZSIDE );
+    vEndTracksQPt_EE_nPV_[iz].reset( EE_NC_PER_ZSIDE );
+    vMuonsPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vMuonsQPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vMuonsPt_EE_PV_[iz].reset( EE_NC_PER_ZSIDE );
+    vMuonsQPt_EE_PV_[iz].reset( EE_NC_PER_ZSIDE );
   }
 
   edm::Handle<PFCollection> pfCandsH_;
   iEvent.getByToken( pfCollectionT_, pfCandsH_ );
 
-  // Provides access to global cell position
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
-
   edm::Handle<reco::VertexCollection> vertexInfo;
   iEvent.getByToken(vertexCollectionT_, vertexInfo);
   const reco::VertexCollection& vtxs = *vertexInfo;
@@ -117,7 +112,7 @@ void RecHitAnalyzer::fillPFCandsAtEBEE ( const edm::Event& iEvent, const edm::Ev
     float z0    =  ( !vtxs.empty() ? thisTrk->dz(vtxs[0].position())  : thisTrk->dz() );
     
     if ( std::abs(eta) > 3. ) continue;
-    DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+    DetId id( findDetIdECAL( eta, phi ) );
 
     float thisTrkPt = thisTrk->pt();
     float thisTrkQPt = (thisTrk->pt()*thisTrk->charge());
@@ -17,35 +17,35 @@ TH2F *hEvt_EE_muonsQPt_PV[nEE];
 
 TProfile2D *hECAL_EndtracksPt;
 TProfile2D *hECAL_muonsPt;
-std::vector<float> vECAL_EndtracksPt_;
-std::vector<float> vECAL_EndtracksQPt_;
-std::vector<float> vECAL_EndtracksPt_PV_;
-std::vector<float> vECAL_EndtracksQPt_PV_;
-std::vector<float> vECAL_EndtracksPt_nPV_;
-std::vector<float> vECAL_EndtracksQPt_nPV_;
-std::vector<float> vECAL_muonsPt_;
-std::vector<float> vECAL_muonsQPt_;
-std::vector<float> vECAL_muonsPt_PV_;
-std::vector<float> vECAL_muonsQPt_PV_;
+img::ImageBuffer vECAL_EndtracksPt_;
+img::ImageBuffer vECAL_EndtracksQPt_;
+img::ImageBuffer vECAL_EndtracksPt_PV_;
+img::ImageBuffer vECAL_EndtracksQPt_PV_;
+img::ImageBuffer vECAL_EndtracksPt_nPV_;
+img::ImageBuffer vECAL_EndtracksQPt_nPV_;
+img::ImageBuffer vECAL_muonsPt_;
+img::ImageBuffer vECAL_muonsQPt_;
+img::ImageBuffer vECAL_muonsPt_PV_;
+img::ImageBuffer vECAL_muonsQPt_PV_;
 
 // Initialize branches _______________________________________________________________//
 void RecHitAnalyzer::branchesPFCandsAtECALstitched ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("ECAL_EndtracksPt",    &vECAL_EndtracksPt_);
-  tree->Branch("ECAL_EndtracksQPt",   &vECAL_EndtracksQPt_);
+  tree->Branch("ECAL_EndtracksPt",    &vECAL_EndtracksPt_.pixels());
+  tree->Branch("ECAL_EndtracksQPt",   &vECAL_EndtracksQPt_.pixels());
 
-  tree->Branch("ECAL_EndtracksPt_PV",    &vECAL_EndtracksPt_PV_);
-  tree->Branch("ECAL_EndtracksQPt_PV",   &vECAL_EndtracksQPt_PV_);
+  tree->Branch("ECAL_EndtracksPt_PV",    &vECAL_EndtracksPt_PV_.pixels());
+  tree->Branch("ECAL_EndtracksQPt_PV",   &vECAL_EndtracksQPt_PV_.pixels());
 
-  tree->Branch("ECAL_EndtracksPt_nPV",    &vECAL_EndtracksPt_nPV_);
-  tree->Branch("ECAL_EndtracksQPt_nPV",   &vECAL_EndtracksQPt_nPV_);
+  tree->Branch("ECAL_EndtracksPt_nPV",    &vECAL_EndtracksPt_nPV_.pixels());
+  tree->Branch("ECAL_EndtracksQPt_nPV",   &vECAL_EndtracksQPt_nPV_.pixels());
 
-  tree->Branch("ECAL_muonsPt",        &vECAL_muonsPt_);
-  tree->Branch("ECAL_muonsQPt",       &vECAL_muonsQPt_);
+  tree->Branch("ECAL_muonsPt",        &vECAL_muonsPt_.pixels());
+  tree->Branch("ECAL_muonsQPt",       &vECAL_muonsQPt_.pixels());
 
-  tree->Branch("ECAL_muonsPt_PV",        &vECAL_muonsPt_PV_);
-  tree->Branch("ECAL_muonsQPt_PV",       &vECAL_muonsQPt_PV_);
+  tree->Branch("ECAL_muonsPt_PV",        &vECAL_muonsPt_PV_.pixels());
+  tree->Branch("ECAL_muonsQPt_PV",       &vECAL_muonsQPt_PV_.pixels());
 
   static const std::string strIndex[2] = {"m","p"};
   static const double* binIndex[2] = {eta_bins_EEm, eta_bins_EEp};
@@ -174,16 +174,16 @@ void RecHitAnalyzer::fillPFCandsAtECALstitched ( const edm::Event& iEvent, const
   float eta, phi, trackPt_, trackQ_;
   GlobalPoint pos;
 
-  vECAL_EndtracksPt_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_EndtracksQPt_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_EndtracksPt_PV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_EndtracksQPt_PV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_EndtracksPt_nPV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_EndtracksQPt_nPV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_muonsPt_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_muonsQPt_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_muonsPt_PV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
-  vECAL_muonsQPt_PV_.assign( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX, 0. );
+  vECAL_EndtracksPt_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_EndtracksQPt_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_EndtracksPt_PV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_EndtracksQPt_PV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_EndtracksPt_nPV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_EndtracksQPt_nPV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_muonsPt_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_muonsQPt_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_muonsPt_PV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
+  vECAL_muonsQPt_PV_.reset( 2*ECAL_IETA_MAX_EXT*EB_IPHI_MAX );
   for ( int iz(0); iz < nEE; ++iz ) {
     hEvt_EE_EndtracksPt[iz]->Reset();
     hEvt_EE_EndtracksQPt[iz]->Reset();
@@ -199,9 +199,6 @@ void RecHitAnalyzer::fillPFCandsAtECALstitched ( const edm::Event& iEvent, const
   iEvent.getByToken( EBRecHitCollectionT_, EBRecHitsH_ );
   edm::Handle<EcalRecHitCollection> EERecHitsH_;
   iEvent.getByToken( EERecHitCollectionT_, EERecHitsH_ );
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
 
   edm::Handle<PFCollection> pfCandsH_;
   iEvent.getByToken( pfCollectionT_, pfCandsH_ );
@@ -221,7 +218,7 @@ void RecHitAnalyzer::fillPFCandsAtECALstitched ( const edm::Event& iEvent, const
     phi = ecalPos.phi();
 
     if ( std::abs(eta) > 3. ) continue;
-    DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+    DetId id( findDetIdECAL( eta, phi ) );
     if ( id.subdetId() == EcalBarrel ) continue;
     if ( id.subdetId() == EcalEndcap ) {
       iz_ = (eta > 0.) ? 1 : 0;
@@ -288,7 +285,7 @@ void RecHitAnalyzer::fillPFCandsAtECALstitched ( const edm::Event& iEvent, const
     float trackz0_ =  ( !vtxs.empty() ? thisTrk->dz(vtxs[0].position()) : thisTrk->dz() );
 
     if ( std::abs(eta) > 3. ) continue;
-    DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+    DetId id( findDetIdECAL( eta, phi ) );
     if ( id.subdetId() == EcalEndcap ) continue;
     if ( id.subdetId() == EcalBarrel ) { 
       EBDetId ebId( id );
@@ -6,15 +6,15 @@
 
 TProfile2D *hPFEB_energy;
 TProfile2D *hPFEB_time;
-std::vector<float> vPFEB_energy_;
-std::vector<float> vPFEB_time_;
+img::ImageBuffer vPFEB_energy_;
+img::ImageBuffer vPFEB_time_;
 
 // Initialize branches _____________________________________________________//
 void RecHitAnalyzer::branchesPFEB ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("PFEB_energy", &vPFEB_energy_);
-  tree->Branch("PFEB_time",   &vPFEB_time_);
+  tree->Branch("PFEB_energy", &vPFEB_energy_.pixels());
+  tree->Branch("PFEB_time",   &vPFEB_time_.pixels());
 
   // Histograms for monitoring
   hPFEB_energy = fs->make<TProfile2D>("PFEB_energy", "E(i#phi,i#eta);i#phi;i#eta",
@@ -32,8 +32,8 @@ void RecHitAnalyzer::fillPFEB ( const edm::Event& iEvent, const edm::EventSetup&
   int iphi_, ieta_, idx_; // rows:ieta, cols:iphi
   float energy_;
 
-  vPFEB_energy_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vPFEB_time_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vPFEB_energy_.reset( EBDetId::kSizeForDenseIndexing );
+  vPFEB_time_.reset( EBDetId::kSizeForDenseIndexing );
 
   edm::Handle<std::vector<reco::PFRecHit>> EBRecHitsH_;
   iEvent.getByToken( PFEBRecHitCollectionT_, EBRecHitsH_);
@@ -15,15 +15,15 @@
 TH2F *hEvt_PFHBHE_energy;
 TProfile2D *hPFHBHE_energy_EB;
 TProfile2D *hPFHBHE_energy;
-std::vector<float> vPFHBHE_energy_EB_;
-std::vector<float> vPFHBHE_energy_;
+img::ImageBuffer vPFHBHE_energy_EB_;
+img::ImageBuffer vPFHBHE_energy_;
 
 // Initialize branches _______________________________________________________//
 void RecHitAnalyzer::branchesPFHBHE ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("PFHBHE_energy_EB", &vPFHBHE_energy_EB_);
-  tree->Branch("PFHBHE_energy",    &vPFHBHE_energy_);
+  tree->Branch("PFHBHE_energy_EB", &vPFHBHE_energy_EB_.pixels());
+  tree->Branch("PFHBHE_energy",    &vPFHBHE_energy_.pixels());
   // Intermediate helper histogram (single event only)
   hEvt_PFHBHE_energy = new TH2F("evt_PFHBHE_energy", "E(i#phi,i#eta);i#phi;i#eta",
       HBHE_IPHI_NUM,           HBHE_IPHI_MIN-1,    HBHE_IPHI_MAX,
@@ -46,8 +46,8 @@ void RecHitAnalyzer::fillPFHBHE ( const edm::Event& iEvent, const edm::EventSetu
   float energy_;
   //float eta, GlobalPoint pos;
 
-  vPFHBHE_energy_EB_.assign( 2*HBHE_IPHI_NUM*HBHE_IETA_MAX_EB, 0. );
-  vPFHBHE_energy_.assign( 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1), 0. );
+  vPFHBHE_energy_EB_.reset( 2*HBHE_IPHI_NUM*HBHE_IETA_MAX_EB );
+  vPFHBHE_energy_.reset( 2*HBHE_IPHI_NUM*(HBHE_IETA_MAX_HE-1) );
   hEvt_PFHBHE_energy->Reset();
 
   edm::Handle<std::vector<reco::PFRecHit>> PFHBHERecHitsH_;
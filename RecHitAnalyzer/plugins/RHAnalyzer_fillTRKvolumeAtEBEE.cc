@@ -9,14 +9,15 @@ TH1F *hTRK_EB_eta;
 TH1F *hTRK_EB_phi;
 TH1F *hTRK_EB_rho;
 TH1F *hTRK_EE_z;
-std::vector<float> vTRK_EE_[nEE];
-std::vector<float> vTRK_EB_;
+img::ImageBuffer vTRK_EE_[nEE];
+img::ImageBuffer vTRK_EB_;
+img::TrackerHitBatch vTRKvolume_hits_;
 
 // Initialize branches ____________________________________________________________//
 void RecHitAnalyzer::branchesTRKvolumeAtEBEE ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("TRK_volume_EB",   &vTRK_EB_);
+  tree->Branch("TRK_volume_EB",   &vTRK_EB_.pixels());
 
   // Histograms for monitoring
   /*
@@ -42,7 +43,7 @@ void RecHitAnalyzer::branchesTRKvolumeAtEBEE ( TTree* tree, edm::Service<TFileSe
     // Branches for images
     const char *zside = (iz > 0) ? "p" : "m";
     sprintf(hname, "TRK_volume_EE%s",zside);
-    tree->Branch(hname,        &vTRK_EE_[iz]);
+    tree->Branch(hname,        &vTRK_EE_[iz].pixels());
 
     // Histograms for monitoring
     zMax = (iz > 0) ? 270. :    0.;
@@ -67,30 +68,16 @@ void RecHitAnalyzer::fillTRKvolumeAtEBEE ( const edm::Event& iEvent, const edm::
   float eta, phi, rho, x, y, z;
   GlobalPoint pos;
 
-  vTRK_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vTRK_EB_.reset( EBDetId::kSizeForDenseIndexing );
   for ( int iz(0); iz < nEE; iz++ ) {
-    vTRK_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vTRK_EE_[iz].reset( EE_NC_PER_ZSIDE );
   }
 
-  edm::Handle<TrackingRecHitCollection> TRKRecHitsH_;
-  iEvent.getByToken( TRKRecHitCollectionT_, TRKRecHitsH_ );
-  // Provides access to global cell position
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
+  getTRKhits( iEvent, iSetup, vTRKvolume_hits_ );
 
-  edm::ESHandle<TrackerGeometry> tkGeomH_;
-  iSetup.get<TrackerDigiGeometryRecord>().get( tkGeomH_ );
-  const TrackerGeometry* tkGeom = tkGeomH_.product();
+  for ( int iH = 0; iH < vTRKvolume_hits_.size(); iH++ ) {
 
-  for ( TrackingRecHitCollection::const_iterator iRHit = TRKRecHitsH_->begin();
-        iRHit != TRKRecHitsH_->end(); ++iRHit ) {
-
-    if ( !iRHit->isValid() ) continue;
-    DetId tkId( iRHit->geographicalId() );
-    if ( tkId.det() != DetId::Tracker ) continue;
-
-    pos = tkGeom->idToDet( tkId )->surface().toGlobal( iRHit->localPosition() );
+    pos = GlobalPoint( vTRKvolume_hits_.gx[iH], vTRKvolume_hits_.gy[iH], vTRKvolume_hits_.gz[iH] );
     phi = pos.phi();
     eta = pos.eta();
     rho = pos.perp();
@@ -109,7 +96,7 @@ void RecHitAnalyzer::fillTRKvolumeAtEBEE ( const edm::Event& iEvent, const edm::
     } else if ( eta < -1.479 ) {
     }
 
-    DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+    DetId id( findDetIdECAL( eta, phi ) );
     if ( id.subdetId() == EcalBarrel ) {
       EBDetId ebId( id );
       iphi_ = ebId.iphi() - 1;
@@ -127,7 +114,7 @@ void RecHitAnalyzer::fillTRKvolumeAtEBEE ( const edm::Event& iEvent, const edm::
     }
 
     /*
-    DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
+    DetId id( findDetIdECAL( eta, phi ) );
     if ( id.subdetId() == EcalBarrel ) {
       EBDetId ebId( id );
       iphi_ = ebId.iphi() - 1;
@@ -10,60 +10,60 @@ TH2F *hTracks_EE[nEE];
 TH2F *hTracks_EB;
 TH2F *hTracksPt_EE[nEE];
 TH2F *hTracksPt_EB;
-std::vector<float> vTracksPt_EE_[nEE];
-std::vector<float> vTracksQPt_EE_[nEE];
-std::vector<float> vTracks_EE_[nEE];
-
-std::vector<float> vTracksPt_PV_EE_[nEE];
-std::vector<float> vTracksQPt_PV_EE_[nEE];
-std::vector<float> vTracksd0_PV_EE_[nEE];
-std::vector<float> vTracksz0_PV_EE_[nEE];
-std::vector<float> vTracksd0sig_PV_EE_[nEE];
-std::vector<float> vTracksz0sig_PV_EE_[nEE];
-
-std::vector<float> vTracksPt_nPV_EE_[nEE];
-std::vector<float> vTracksQPt_nPV_EE_[nEE];
-
-std::vector<float> vTracksPt_EB_;
-std::vector<float> vTracksE_EB_;
-std::vector<float> vTracksQPt_EB_;
-std::vector<float> vTracks_EB_;
-
-std::vector<float> vTracksPt_PV_EB_;
-std::vector<float> vTracksQPt_PV_EB_;
-std::vector<float> vTracksd0_PV_EB_;
-std::vector<float> vTracksz0_PV_EB_;
-std::vector<float> vTracksd0sig_PV_EB_;
-std::vector<float> vTracksz0sig_PV_EB_;
-
-std::vector<float> vTracksPt_nPV_EB_;
-std::vector<float> vTracksQPt_nPV_EB_;
+img::ImageBuffer vTracksPt_EE_[nEE];
+img::ImageBuffer vTracksQPt_EE_[nEE];
+img::ImageBuffer vTracks_EE_[nEE];
+
+img::ImageBuffer vTracksPt_PV_EE_[nEE];
+img::ImageBuffer vTracksQPt_PV_EE_[nEE];
+img::ImageBuffer vTracksd0_PV_EE_[nEE];
+img::ImageBuffer vTracksz0_PV_EE_[nEE];
+img::ImageBuffer vTracksd0sig_PV_EE_[nEE];
+img::ImageBuffer vTracksz0sig_PV_EE_[nEE];
+
+img::ImageBuffer vTracksPt_nPV_EE_[nEE];
+img::ImageBuffer vTracksQPt_nPV_EE_[nEE];
+
+img::ImageBuffer vTracksPt_EB_;
+img::ImageBuffer vTracksE_EB_;
+img::ImageBuffer vTracksQPt_EB_;
+img::ImageBuffer vTracks_EB_;
+
+img::ImageBuffer vTracksPt_PV_EB_;
+img::ImageBuffer vTracksQPt_PV_EB_;
+img::ImageBuffer vTracksd0_PV_EB_;
+img::ImageBuffer vTracksz0_PV_EB_;
+img::ImageBuffer vTracksd0sig_PV_EB_;
+img::ImageBuffer vTracksz0sig_PV_EB_;
+
+img::ImageBuffer vTracksPt_nPV_EB_;
+img::ImageBuffer vTracksQPt_nPV_EB_;
 
 // HCAL info:
-std::vector<float> vPF_HCAL_EB_;
-std::vector<float> vPF_HCAL_EB_raw_;
+img::ImageBuffer vPF_HCAL_EB_;
+img::ImageBuffer vPF_HCAL_EB_raw_;
 
 // Initialize branches ____________________________________________________________//
 void RecHitAnalyzer::branchesTracksAtEBEE ( TTree* tree, edm::Service<TFileService> &fs ) {
 
   // Branches for images
-  tree->Branch("Tracks_EB",    &vTracks_EB_);
-  tree->Branch("TracksPt_EB",  &vTracksPt_EB_);
-  tree->Branch("TracksE_EB",  &vTracksE_EB_);
-  tree->Branch("TracksQPt_EB", &vTracksQPt_EB_);
+  tree->Branch("Tracks_EB",    &vTracks_EB_.pixels());
+  tree->Branch("TracksPt_EB",  &vTracksPt_EB_.pixels());
+  tree->Branch("TracksE_EB",  &vTracksE_EB_.pixels());
+  tree->Branch("TracksQPt_EB", &vTracksQPt_EB_.pixels());
 
-  tree->Branch("TracksPt_PV_EB",     &vTracksPt_PV_EB_);
-  tree->Branch("TracksQPt_PV_EB",    &vTracksQPt_PV_EB_);
-  tree->Branch("Tracksd0_PV_EB",     &vTracksd0_PV_EB_);
-  tree->Branch("Tracksz0_PV_EB",     &vTracksz0_PV_EB_);
-  tree->Branch("Tracksd0sig_PV_EB",  &vTracksd0sig_PV_EB_);
-  tree->Branch("Tracksz0sig_PV_EB",  &vTracksz0sig_PV_EB_);
+  tree->Branch("TracksPt_PV_EB",     &vTracksPt_PV_EB_.pixels());
+  tree->Branch("TracksQPt_PV_EB",    &vTracksQPt_PV_EB_.pixels());
+  tree->Branch("Tracksd0_PV_EB",     &vTracksd0_PV_EB_.pixels());
+  tree->Branch("Tracksz0_PV_EB",     &vTracksz0_PV_EB_.pixels());
+  tree->Branch("Tracksd0sig_PV_EB",  &vTracksd0sig_PV_EB_.pixels());
+  tree->Branch("Tracksz0sig_PV_EB",  &vTracksz0sig_PV_EB_.pixels());
 
-  tree->Branch("TracksPt_nPV_EB",     &vTracksPt_nPV_EB_);
-  tree->Branch("TracksQPt_nPV_EB",    &vTracksQPt_nPV_EB_);
+  tree->Branch("TracksPt_nPV_EB",     &vTracksPt_nPV_EB_.pixels());
+  tree->Branch("TracksQPt_nPV_EB",    &vTracksQPt_nPV_EB_.pixels());
 
-  tree->Branch("PF_HCAL_EB",     &vPF_HCAL_EB_);
-  tree->Branch("PF_HCAL_EB_raw", &vPF_HCAL_EB_raw_);
+  tree->Branch("PF_HCAL_EB",     &vPF_HCAL_EB_.pixels());
+  tree->Branch("PF_HCAL_EB_raw", &vPF_HCAL_EB_raw_.pixels());
 
   // Histograms for monitoring
   hTracks_EB = fs->make<TH2F>("Tracks_EB", "N(i#phi,i#eta);i#phi;i#eta",
@@ -79,29 +79,29 @@ void RecHitAnalyzer::branchesTracksAtEBEE ( TTree* tree, edm::Service<TFileServi
     // Branches for images
     const char *zside = (iz > 0) ? "p" : "m";
     sprintf(hname, "Tracks_EE%s",zside);
-    tree->Branch(hname,        &vTracks_EE_[iz]);
+    tree->Branch(hname,        &vTracks_EE_[iz].pixels());
     sprintf(hname, "TracksPt_EE%s",zside);
-    tree->Branch(hname,        &vTracksPt_EE_[iz]);
+    tree->Branch(hname,        &vTracksPt_EE_[iz].pixels());
     sprintf(hname, "TracksQPt_EE%s",zside);
-    tree->Branch(hname,        &vTracksQPt_EE_[iz]);
+    tree->Branch(hname,        &vTracksQPt_EE_[iz].pixels());
 
     sprintf(hname, "TracksPt_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksPt_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksPt_PV_EE_[iz].pixels());
     sprintf(hname, "TracksQPt_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksQPt_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksQPt_PV_EE_[iz].pixels());
     sprintf(hname, "Tracksd0_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksd0_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksd0_PV_EE_[iz].pixels());
     sprintf(hname, "Tracksz0_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksz0_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksz0_PV_EE_[iz].pixels());
     sprintf(hname, "Tracksd0sig_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksd0sig_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksd0sig_PV_EE_[iz].pixels());
     sprintf(hname, "Tracksz0sig_PV_EE%s",zside);
-    tree->Branch(hname,        &vTracksz0sig_PV_EE_[iz]);
+    tree->Branch(hname,        &vTracksz0sig_PV_EE_[iz].pixels());
 
     sprintf(hname, "TracksPt_nPV_EE%s",zside);
-    tree->Branch(hname,        &vTracksPt_nPV_EE_[iz]);
+    tree->Branch(hname,        &vTracksPt_nPV_EE_[iz].pixels());
     sprintf(hname, "TracksQPt_nPV_EE%s",zside);
-    tree->Branch(hname,        &vTracksQPt_nPV_EE_[iz]);
+    tree->Branch(hname,        &vTracksQPt_nPV_EE_[iz].pixels());
 
     // Histograms for monitoring
     sprintf(hname, "Tracks_EE%s",zside);
@@ -126,39 +126,39 @@ void RecHitAnalyzer::fillTracksAtEBEE ( const edm::Event& iEvent, const edm::Eve
   float eta, phi, pt, qpt, d0, z0, d0sig, z0sig, energy;
   GlobalPoint pos;
 
-  vTracks_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksE_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksQPt_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vTracks_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksE_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksQPt_EB_.reset( EBDetId::kSizeForDenseIndexing );
 
-  vTracksPt_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksQPt_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksd0_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksz0_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksd0sig_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksz0sig_PV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vTracksPt_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksQPt_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksd0_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksz0_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksd0sig_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksz0sig_PV_EB_.reset( EBDetId::kSizeForDenseIndexing );
 
-  vTracksPt_nPV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vTracksQPt_nPV_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vTracksPt_nPV_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vTracksQPt_nPV_EB_.reset( EBDetId::kSizeForDenseIndexing );
 
   // HCAL on same grid resolution
-  vPF_HCAL_EB_.assign( EBDetId::kSizeForDenseIndexing, 0. );
-  vPF_HCAL_EB_raw_.assign( EBDetId::kSizeForDenseIndexing, 0. );
+  vPF_HCAL_EB_.reset( EBDetId::kSizeForDenseIndexing );
+  vPF_HCAL_EB_raw_.reset( EBDetId::kSizeForDenseIndexing );
 
   for ( int iz(0); iz < nEE; iz++ ) {
-    vTracks_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksQPt_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vTracks_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksQPt_EE_[iz].reset( EE_NC_PER_ZSIDE );
 
-    vTracksPt_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksQPt_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksd0_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksz0_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksd0sig_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksz0sig_PV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vTracksPt_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksQPt_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksd0_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksz0_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksd0sig_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksz0sig_PV_EE_[iz].reset( EE_NC_PER_ZSIDE );
 
-    vTracksPt_nPV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
-    vTracksQPt_nPV_EE_[iz].assign( EE_NC_PER_ZSIDE, 0. );
+    vTracksPt_nPV_EE_[iz].reset( EE_NC_PER_ZSIDE );
+    vTracksQPt_nPV_EE_[iz].reset( EE_NC_PER_ZSIDE );
 
   }
 
@@ -167,19 +167,12 @@ void RecHitAnalyzer::fillTracksAtEBEE ( const edm::Event& iEvent, const edm::Eve
 
 
 
-  // Provides access to global cell position
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
-
   edm::Handle<reco::VertexCollection> vertexInfo;
   iEvent.getByToken(vertexCollectionT_, vertexInfo);
   const reco::VertexCollection& vtxs = *vertexInfo;
 
   reco::Track::TrackQuality tkQt_ = reco::Track::qualityByName("highPurity");
 
-  edm::ESHandle<MagneticField> magfield;
-  iSetup.get<IdealMagneticFieldRecord>().get(magfield);
 
   // load jets to loop through
   edm::Handle<reco::PFJetCollection> jets;
@@ -211,7 +204,7 @@ void RecHitAnalyzer::fillTracksAtEBEE ( const edm::Event& iEvent, const edm::Eve
       z0sig = z0/iTk->dzError();
 
       // get B field
-      double magneticField = (magfield.product() ? magfield.product()->inTesla(GlobalPoint(0., 0., 0.)).z() : 0.0);
+      double magneticField = magneticField_;
       math::XYZTLorentzVector  track_p4(iTk->px(),iTk->py(),iTk->pz(),sqrt(pow(iTk->p(),2)+0.14*0.14)); //setup 4-vector assuming mass is mass of charged pion
       BaseParticlePropagator propagator = BaseParticlePropagator(
           RawParticle(track_p4,
@@ -225,7 +218,7 @@ void RecHitAnalyzer::fillTracksAtEBEE ( const edm::Event& iEvent, const edm::Eve
 
       if ( std::abs(position.eta()) > 3. ) continue;
  
-      DetId id( spr::findDetIdECAL( caloGeom, position.eta(), position.phi(), false ) );
+      DetId id( findDetIdECAL( position.eta(), position.phi() ) );
       if ( id.subdetId() == EcalBarrel ) {
         EBDetId ebId( id );
         iphi_ = ebId.iphi() - 1;
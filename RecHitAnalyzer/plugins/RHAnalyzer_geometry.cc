@@ -0,0 +1,217 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "DataFormats/EcalDetId/interface/ESDetId.h"
+#include "DataFormats/TrackerCommon/interface/TrackerTopology.h"
+#include "Geometry/Records/interface/TrackerTopologyRcd.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+// Geometry access ////////////////////////////////////////
+// All cell positions, cell extents, eta,phi -> DetId lookups
+// and the magnetic field go through these functions. They use
+// the CaloGeometry and MagneticField from the EventSetup or,
+// if a geometry snapshot was loaded, the snapshot only.
+// Tracker hits are localised with a table of the module
+// placements from the TrackerGeometry.
+
+// Get geometry for this event ____________________________________________//
+// Only for the events that reach the selection (calorimeter
+// geometry, used by the jet seeds) and the fills (magnetic field):
+// events dropped by the event list, and the selection-only pass,
+// skip the rest.
+void RecHitAnalyzer::setupCaloGeometry ( const edm::EventSetup& iSetup ) {
+
+  if ( geoSnapshot_ ) return;
+
+  edm::ESHandle<CaloGeometry> caloGeomH_;
+  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
+  caloGeom_ = caloGeomH_.product();
+
+} // setupCaloGeometry()
+
+void RecHitAnalyzer::setupMagneticField ( const edm::EventSetup& iSetup ) {
+
+  if ( geoSnapshot_ ) {
+    magneticField_ = geoSnapshot_->bFieldZ;
+    return;
+  }
+
+  edm::ESHandle<MagneticField> magfield;
+  iSetup.get<IdealMagneticFieldRecord>().get(magfield);
+  magneticField_ = (magfield.product() ? magfield.product()->inTesla(GlobalPoint(0., 0., 0.)).z() : 0.0);
+
+} // setupMagneticField()
+
+// Cell center ____________________________________________________________//
+GlobalPoint RecHitAnalyzer::getCellPosition ( const DetId& id ) const {
+
+  if ( !geoSnapshot_ ) return caloGeom_->getPosition( id );
+
+  const img::GeometrySnapshot::Point* p = nullptr;
+  if ( id.det() == DetId::Ecal && id.subdetId() == EcalBarrel ) {
+    p = &geoSnapshot_->ebCenter[ EBDetId(id).hashedIndex() ];
+  } else if ( id.det() == DetId::Ecal && id.subdetId() == EcalEndcap ) {
+    p = &geoSnapshot_->eeCenter[ EEDetId(id).hashedIndex() ];
+  } else if ( id.det() == DetId::Ecal && id.subdetId() == EcalPreshower ) {
+    p = &geoSnapshot_->esCenter[ ESDetId(id).hashedIndex() ];
+  } else if ( id.det() == DetId::Hcal ) {
+    HcalDetId hId( id );
+    p = &geoSnapshot_->hbheCenter[ img::GeometrySnapshot::hbheIndex( hId.ieta(), hId.iphi(), hId.depth() ) ];
+  } else {
+    throw cms::Exception("RecHitAnalyzer") << "No snapshot geometry for DetId " << id.rawId();
+  }
+  return GlobalPoint( p->x, p->y, p->z );
+
+} // getCellPosition()
+
+// Min,max eta,phi of the REP corners nearest the IP, EB and HBHE ________//
+// See illustration in RHAnalyzer_fillHCALatEBEE.cc
+// EE: min,max over the front face corners, see GeometrySnapshot::cornerBox
+void RecHitAnalyzer::getCellEtaPhiBox ( const DetId& id, float& minEta, float& maxEta, float& minPhi, float& maxPhi ) const {
+
+  if ( id.det() == DetId::Ecal && id.subdetId() == EcalEndcap && !geoSnapshot_ ) {
+    const auto corners = caloGeom_->getGeometry(id)->getCorners();
+    float eta[4], phi[4];
+    for ( int iC = 0; iC < 4; iC++ ) {
+      eta[iC] = corners[iC].eta();
+      phi[iC] = corners[iC].phi();
+    }
+    img::GeometrySnapshot::EtaPhiBox box = img::GeometrySnapshot::cornerBox( eta, phi, 4 );
+    minEta = box.minEta;
+    maxEta = box.maxEta;
+    minPhi = box.minPhi;
+    maxPhi = box.maxPhi;
+    return;
+  }
+
+  if ( !geoSnapshot_ ) {
+    const auto repCorners = caloGeom_->getGeometry(id)->getCornersREP();
+    minEta = repCorners[2].eta();
+    maxEta = repCorners[0].eta();
+    minPhi = repCorners[2].phi();
+    maxPhi = repCorners[0].phi();
+    return;
+  }
+
+  const img::GeometrySnapshot::EtaPhiBox* box = nullptr;
+  if ( id.det() == DetId::Ecal && id.subdetId() == EcalBarrel ) {
+    box = &geoSnapshot_->ebBox[ EBDetId(id).hashedIndex() ];
+  } else if ( id.det() == DetId::Ecal && id.subdetId() == EcalEndcap ) {
+    box = &geoSnapshot_->eeBox[ EEDetId(id).hashedIndex() ];
+  } else if ( id.det() == DetId::Hcal ) {
+    HcalDetId hId( id );
+    box = &geoSnapshot_->hbheBox[ img::GeometrySnapshot::hbheIndex( hId.ieta(), hId.iphi(), hId.depth() ) ];
+  } else {
+    throw cms::Exception("RecHitAnalyzer") << "No snapshot cell corners for DetId " << id.rawId();
+  }
+  minEta = box->minEta;
+  maxEta = box->maxEta;
+  minPhi = box->minPhi;
+  maxPhi = box->maxPhi;
+
+} // getCellEtaPhiBox()
+
+// ECAL crystal at eta,phi, as spr::findDetIdECAL ____________________________//
+DetId RecHitAnalyzer::findDetIdECAL ( double eta, double phi ) const {
+
+  if ( !geoSnapshot_ ) return spr::findDetIdECAL( caloGeom_, eta, phi, false );
+
+  int iC;
+  if ( std::abs(eta) > 1.479 ) { // spr::etaBEEcal
+    iC = geoSnapshot_->findEE( eta, phi );
+    return iC < 0 ? DetId() : DetId( EEDetId::unhashIndex(iC) );
+  }
+  iC = geoSnapshot_->findEB( eta, phi );
+  return iC < 0 ? DetId() : DetId( EBDetId::unhashIndex(iC) );
+
+} // findDetIdECAL()
+
+// HBHE tower at eta,phi, as spr::findDetIdHCAL _____________________________//
+DetId RecHitAnalyzer::findDetIdHCAL ( double eta, double phi ) const {
+
+  if ( !geoSnapshot_ ) return spr::findDetIdHCAL( caloGeom_, eta, phi, false );
+
+  int idx = geoSnapshot_->findHBHE( eta, phi );
+  if ( idx < 0 ) return DetId();
+  // Invert hbheIndex()
+  int depth = idx%img::GeometrySnapshot::HBHE_DEPTH_NUM + 1;
+  idx /= img::GeometrySnapshot::HBHE_DEPTH_NUM;
+  int iphi = idx%img::GeometrySnapshot::HBHE_IPHI_NUM + 1;
+  int ieta = idx/img::GeometrySnapshot::HBHE_IPHI_NUM - img::GeometrySnapshot::HBHE_IETA_NUM/2;
+  ieta = ieta >= 0 ? ieta+1 : ieta;
+  HcalSubdetector subdet = HcalSubdetector( geoSnapshot_->hbheSubdet[ img::GeometrySnapshot::hbheIndex( ieta, iphi, depth ) ] );
+  return HcalDetId( subdet, ieta, iphi, depth );
+
+} // findDetIdHCAL()
+
+// Global layer of a tracker module, see RecHitAnalyzer.h ____________________//
+static int getTRKlayer ( const DetId& tkId, const TrackerTopology* tTopo ) {
+  // layer() is the layer in the barrels, wheel or disk in the endcaps
+  int layer = tTopo->layer( tkId ) - 1;
+  int offset, nLayers;
+  switch ( tkId.subdetId() ) {
+    case StripSubdetector::TOB:          offset = TRK_LAYER_OFFSET_TOB;  nLayers = nTOB;  break;
+    case StripSubdetector::TEC:          offset = TRK_LAYER_OFFSET_TEC;  nLayers = nTEC;  break;
+    case StripSubdetector::TIB:          offset = TRK_LAYER_OFFSET_TIB;  nLayers = nTIB;  break;
+    case StripSubdetector::TID:          offset = TRK_LAYER_OFFSET_TID;  nLayers = nTID;  break;
+    case PixelSubdetector::PixelBarrel:  offset = TRK_LAYER_OFFSET_BPIX; nLayers = nBPIX; break;
+    case PixelSubdetector::PixelEndcap:  offset = TRK_LAYER_OFFSET_FPIX; nLayers = nFPIX; break;
+    default: return -1;
+  }
+  if ( layer < 0 || layer >= nLayers ) return -1;
+  return offset + layer;
+}
+
+// Tracker module placements ______________________________________________//
+void RecHitAnalyzer::setupTrackerTransforms ( const edm::EventSetup& iSetup ) {
+
+  unsigned long long cacheId = iSetup.get<TrackerDigiGeometryRecord>().cacheIdentifier();
+  if ( cacheId == tkTransformsCacheId_ ) return;
+
+  edm::ESHandle<TrackerGeometry> tkGeomH_;
+  iSetup.get<TrackerDigiGeometryRecord>().get( tkGeomH_ );
+  edm::ESHandle<TrackerTopology> tTopoH_;
+  iSetup.get<TrackerTopologyRcd>().get( tTopoH_ );
+
+  // All dets, not only the units: matched strip hits are on the glued dets
+  tkTransforms_.clear();
+  for ( const GeomDet* det : tkGeomH_->dets() ) {
+    const Surface& surface = det->surface();
+    const Surface::RotationType& r = surface.rotation();
+    // Surface::toGlobal applies the inverse (transpose) rotation
+    img::TrackerTransforms::Module module = {
+      { r.xx(), r.yx(), r.zx(),
+        r.xy(), r.yy(), r.zy(),
+        r.xz(), r.yz(), r.zz() },
+      { surface.position().x(), surface.position().y(), surface.position().z() },
+      det->geographicalId().subdetId(),
+      getTRKlayer( det->geographicalId(), tTopoH_.product() )
+    };
+    tkTransforms_.add( det->geographicalId().rawId(), module );
+  }
+  tkTransforms_.finalize();
+  tkTransformsCacheId_ = cacheId;
+  std::cout << " >> Tracker transforms: " << tkTransforms_.size() << " modules" << std::endl;
+
+} // setupTrackerTransforms()
+
+// Tracker rechits in global coordinates __________________________________//
+void RecHitAnalyzer::getTRKhits ( const edm::Event& iEvent, const edm::EventSetup& iSetup, img::TrackerHitBatch& hits ) {
+
+  setupTrackerTransforms( iSetup );
+
+  edm::Handle<TrackingRecHitCollection> TRKRecHitsH_;
+  iEvent.getByToken( TRKRecHitCollectionT_, TRKRecHitsH_ );
+
+  hits.clear();
+  for ( TrackingRecHitCollection::const_iterator iRHit = TRKRecHitsH_->begin();
+        iRHit != TRKRecHitsH_->end(); ++iRHit ) {
+    if ( !iRHit->isValid() ) continue;
+    DetId tkId( iRHit->geographicalId() );
+    if ( tkId.det() != DetId::Tracker ) continue;
+    int idx = tkTransforms_.index( tkId.rawId() );
+    if ( idx < 0 ) continue;
+    LocalPoint lp = iRHit->localPosition();
+    hits.add( idx, lp.x(), lp.y(), lp.z() );
+  }
+  img::transformHits( tkTransforms_, hits );
+
+} // getTRKhits()
@@ -21,6 +21,7 @@ float m0_;
 //float nJet_;
 float diPhoE_;
 float diPhoPt_;
+float evtWeight_;
 std::vector<float> vFC_inputs_;
 
 float m0cut = 90.;
@@ -52,6 +53,7 @@ void RecHitAnalyzer::branchesEvtSel ( TTree* tree, edm::Service<TFileService> &f
   tree->Branch("FC_inputs",      &vFC_inputs_);
   tree->Branch("diPhoE",         &diPhoE_);
   tree->Branch("diPhoPt",        &diPhoPt_);
+  tree->Branch("evtWeight",      &evtWeight_);
 
 } // branchesEvtSel()
 
@@ -143,6 +145,14 @@ bool RecHitAnalyzer::runEvtSel ( const edm::Event& iEvent, const edm::EventSetup
   //if ( nJet != 2 ) return false;
   */
 
+  // Prescale, before anything is filled: keep with p(m0,pT)
+  evtWeight_ = prescaler_.sample( m0, vDiPho.pt(),
+      iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), -1 );
+  if ( evtWeight_ == 0. ) {
+    nPrescaled_++;
+    return false;
+  }
+
   // Get photon order
   int ptOrder[2] = {0, 1};
   if ( leadPho == 1 ) {
@@ -16,6 +16,7 @@ unsigned long long jet_eventId_;
 vector<float> vJetSeed_iphi_;
 vector<float> vJetSeed_ieta_;
 vector<int>   vFailedJetIdx_;
+vector<float> vJetWeight_;
 
 
 // const std::string jetSelection = "dijet_gg_qq"; // TODO: put switch at cfg level
@@ -31,6 +32,8 @@ void RecHitAnalyzer::branchesEvtSel_jet ( TTree* tree, edm::Service<TFileService
   tree->Branch("lumiId",         &jet_lumiId_);
   tree->Branch("jetSeed_iphi",   &vJetSeed_iphi_);
   tree->Branch("jetSeed_ieta",   &vJetSeed_ieta_);
+  tree->Branch("jetWeight",      &vJetWeight_);
+  tree->Branch("jetIdx",         &vJetIdxs);
 
   // Fill branches in explicit jet selection
   if ( jetSelection == "dijet_gg_qq" ) {
@@ -66,9 +69,6 @@ bool RecHitAnalyzer::runEvtSel_jet ( const edm::Event& iEvent, const edm::EventS
     }
   }
 
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
 
   edm::Handle<HBHERecHitCollection> HBHERecHitsH_;
   iEvent.getByToken( HBHERecHitCollectionT_, HBHERecHitsH_ );
@@ -95,7 +95,7 @@ bool RecHitAnalyzer::runEvtSel_jet ( const edm::Event& iEvent, const edm::EventS
     
     // Get closest HBHE tower to jet position
     // This will not always be the most energetic deposit
-    HcalDetId hId( spr::findDetIdHCAL( caloGeom, iJet->eta(), iJet->phi(), false ) );
+    HcalDetId hId( findDetIdHCAL( iJet->eta(), iJet->phi() ) );
     if ( hId.subdet() != HcalBarrel && hId.subdet() != HcalEndcap ){
       vFailedJetIdx_.push_back(thisJetIdx);
       continue;
@@ -178,14 +178,61 @@ bool RecHitAnalyzer::runEvtSel_jet ( const edm::Event& iEvent, const edm::EventS
 
   
   if ( (nJets_ > 0) && nJet != nJets_ ) return false;
+
+  vJetWeight_.clear();
+  if ( nJets_ > 0 ) {
+    // Exactly nJets_ jets required: prescale the event as a whole,
+    // with p(pT,|eta|) of its leading jet, so it is never kept with
+    // fewer jets. All its jets get the event weight
+    reco::PFJetRef leadJet( jets, vJetIdxs[0] );
+    float weight = prescaler_.sample( leadJet->pt(), std::abs(leadJet->eta()),
+        iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), -1 );
+    if ( weight == 0. ) {
+      nPrescaled_ += vJetIdxs.size();
+      if ( debug ) std::cout << " Event prescaled away " << std::endl;
+      return false;
+    }
+    vJetWeight_.assign( vJetIdxs.size(), weight );
+  } else {
+    // Prescale each selected jet with p(pT,|eta|), keyed by its index
+    // in the jet collection. vJetSeed_* are in vJetIdxs order
+    unsigned int nKept = 0;
+    for ( unsigned int iJ = 0; iJ < vJetIdxs.size(); iJ++ ) {
+      reco::PFJetRef iJet( jets, vJetIdxs[iJ] );
+      float weight = prescaler_.sample( iJet->pt(), std::abs(iJet->eta()),
+          iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), vJetIdxs[iJ] );
+      if ( weight == 0. ) {
+        nPrescaled_++;
+        continue;
+      }
+      vJetIdxs[nKept] = vJetIdxs[iJ];
+      vJetSeed_iphi_[nKept] = vJetSeed_iphi_[iJ];
+      vJetSeed_ieta_[nKept] = vJetSeed_ieta_[iJ];
+      vJetWeight_.push_back( weight );
+      nKept++;
+    }
+    vJetIdxs.resize( nKept );
+    vJetSeed_iphi_.resize( nKept );
+    vJetSeed_ieta_.resize( nKept );
+    if ( nKept == 0 ) {
+      if ( debug ) std::cout << " All jets prescaled away " << std::endl;
+      return false;
+    }
+  }
   if ( debug ) std::cout << " >> analyze: passed" << std::endl;
 
   jet_eventId_ = iEvent.id().event();
   jet_runId_ = iEvent.id().run();
   jet_lumiId_ = iEvent.id().luminosityBlock();
 
+  return true;
 
+} // runEvtSel_jet()
 
+// Fill jet selection branches ___________________________________________________________//
+// Kept apart from runEvtSel_jet() so that a selection-only pass
+// does not pay for the per-jet truth matching
+void RecHitAnalyzer::fillEvtSel_jet ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
   if ( jetSelection == "dijet_gg_qq" ) {
     fillEvtSel_jet_dijet_gg_qq( iEvent, iSetup );
@@ -195,6 +242,4 @@ bool RecHitAnalyzer::runEvtSel_jet ( const edm::Event& iEvent, const edm::EventS
     fillEvtSel_jet_dijet( iEvent, iSetup );
   }
 
-  return true;
-
-} // runEvtSel_jet()
+} // fillEvtSel_jet()
@@ -3,6 +3,9 @@
 #include "CommonTools/BaseParticlePropagator/interface/BaseParticlePropagator.h"
 #include "CommonTools/BaseParticlePropagator/interface/RawParticle.h"
 #include "TVector2.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/JaggedArray.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 
 using std::vector;
 using std::cout;
@@ -23,24 +26,24 @@ vector<float> vTaujet_jet_neutral_pT_;
 vector<float> vTaujet_jet_neutral_m0_;
 vector<float> vTaujet_jet_neutral_eta_;
 vector<float> vTaujet_jet_neutral_phi_;
-vector<vector<float>> vTaujet_jet_charged_indv_p_;
-vector<vector<float>> vTaujet_jet_neutral_indv_p_;
-vector<vector<float>> vTaujet_jet_charged_indv_eta_;
-vector<vector<float>> vTaujet_jet_neutral_indv_eta_;
-vector<vector<float>> vTaujet_jet_charged_indv_phi_;
-vector<vector<float>> vTaujet_jet_neutral_indv_phi_;
-
-vector<vector<double>> vTaujet_jet_charged_indv_relp_;
-vector<vector<double>> vTaujet_jet_neutral_indv_relp_;
-vector<vector<double>> vTaujet_jet_charged_indv_releta_;
-vector<vector<double>> vTaujet_jet_neutral_indv_releta_;
-vector<vector<double>> vTaujet_jet_charged_indv_relphi_;
-vector<vector<double>> vTaujet_jet_neutral_indv_relphi_;
-
-vector<vector<float>> vTaujet_jet_charged_indv_releta_crystal_;
-vector<vector<float>> vTaujet_jet_neutral_indv_releta_crystal_;
-vector<vector<float>> vTaujet_jet_charged_indv_relphi_crystal_;
-vector<vector<float>> vTaujet_jet_neutral_indv_relphi_crystal_;
+img::JaggedArray<float> vTaujet_jet_charged_indv_p_;
+img::JaggedArray<float> vTaujet_jet_neutral_indv_p_;
+img::JaggedArray<float> vTaujet_jet_charged_indv_eta_;
+img::JaggedArray<float> vTaujet_jet_neutral_indv_eta_;
+img::JaggedArray<float> vTaujet_jet_charged_indv_phi_;
+img::JaggedArray<float> vTaujet_jet_neutral_indv_phi_;
+
+img::JaggedArray<double> vTaujet_jet_charged_indv_relp_;
+img::JaggedArray<double> vTaujet_jet_neutral_indv_relp_;
+img::JaggedArray<double> vTaujet_jet_charged_indv_releta_;
+img::JaggedArray<double> vTaujet_jet_neutral_indv_releta_;
+img::JaggedArray<double> vTaujet_jet_charged_indv_relphi_;
+img::JaggedArray<double> vTaujet_jet_neutral_indv_relphi_;
+
+img::JaggedArray<float> vTaujet_jet_charged_indv_releta_crystal_;
+img::JaggedArray<float> vTaujet_jet_neutral_indv_releta_crystal_;
+img::JaggedArray<float> vTaujet_jet_charged_indv_relphi_crystal_;
+img::JaggedArray<float> vTaujet_jet_neutral_indv_relphi_crystal_;
 
 // for centering:
 vector<float> vTaujet_jet_leading_eta_;
@@ -65,6 +68,14 @@ vector<float> vTaujet_jet_centre2_iphi_;
 vector<double> vTaujet_jet_centre2_eta_;
 vector<double> vTaujet_jet_centre2_phi_;
 
+// Per-jet constituent lists, flattened over the jets of the event.
+// The values and offsets keep their capacity across events.
+template<class T>
+static void branchJagged ( TTree* tree, const std::string& name, img::JaggedArray<T>& arr ) {
+  tree->Branch(name.c_str(), &arr.values);
+  tree->Branch((name+"_offsets").c_str(), &arr.offsets);
+}
+
 // Initialize branches _____________________________________________________//
 void RecHitAnalyzer::branchesEvtSel_jet_taujet( TTree* tree, edm::Service<TFileService> &fs ) {
 
@@ -85,24 +96,24 @@ void RecHitAnalyzer::branchesEvtSel_jet_taujet( TTree* tree, edm::Service<TFileS
   tree->Branch("neutralM", &vTaujet_jet_neutral_m0_);
   tree->Branch("neutralEta", &vTaujet_jet_neutral_eta_);
   tree->Branch("neutralPhi", &vTaujet_jet_neutral_phi_);
-  tree->Branch("jet_charged_indv_p", &vTaujet_jet_charged_indv_p_);
-  tree->Branch("jet_neutral_indv_p", &vTaujet_jet_neutral_indv_p_);
-  tree->Branch("jet_charged_indv_ieta", &vTaujet_jet_charged_indv_eta_);
-  tree->Branch("jet_neutral_indv_ieta", &vTaujet_jet_neutral_indv_eta_);
-  tree->Branch("jet_charged_indv_iphi", &vTaujet_jet_charged_indv_phi_);
-  tree->Branch("jet_neutral_indv_iphi", &vTaujet_jet_neutral_indv_phi_);
-
-  tree->Branch("jet_charged_indv_relp", &vTaujet_jet_charged_indv_relp_);
-  tree->Branch("jet_neutral_indv_relp", &vTaujet_jet_neutral_indv_relp_);
-  tree->Branch("jet_charged_indv_releta", &vTaujet_jet_charged_indv_releta_);
-  tree->Branch("jet_neutral_indv_releta", &vTaujet_jet_neutral_indv_releta_);
-  tree->Branch("jet_charged_indv_relphi", &vTaujet_jet_charged_indv_relphi_);
-  tree->Branch("jet_neutral_indv_relphi", &vTaujet_jet_neutral_indv_relphi_);
-
-  tree->Branch("jet_charged_indv_releta_crystal", &vTaujet_jet_charged_indv_releta_crystal_);
-  tree->Branch("jet_neutral_indv_releta_crystal", &vTaujet_jet_neutral_indv_releta_crystal_);
-  tree->Branch("jet_charged_indv_relphi_crystal", &vTaujet_jet_charged_indv_relphi_crystal_);
-  tree->Branch("jet_neutral_indv_relphi_crystal", &vTaujet_jet_neutral_indv_relphi_crystal_);
+  branchJagged( tree, "jet_charged_indv_p", vTaujet_jet_charged_indv_p_ );
+  branchJagged( tree, "jet_neutral_indv_p", vTaujet_jet_neutral_indv_p_ );
+  branchJagged( tree, "jet_charged_indv_ieta", vTaujet_jet_charged_indv_eta_ );
+  branchJagged( tree, "jet_neutral_indv_ieta", vTaujet_jet_neutral_indv_eta_ );
+  branchJagged( tree, "jet_charged_indv_iphi", vTaujet_jet_charged_indv_phi_ );
+  branchJagged( tree, "jet_neutral_indv_iphi", vTaujet_jet_neutral_indv_phi_ );
+
+  branchJagged( tree, "jet_charged_indv_relp", vTaujet_jet_charged_indv_relp_ );
+  branchJagged( tree, "jet_neutral_indv_relp", vTaujet_jet_neutral_indv_relp_ );
+  branchJagged( tree, "jet_charged_indv_releta", vTaujet_jet_charged_indv_releta_ );
+  branchJagged( tree, "jet_neutral_indv_releta", vTaujet_jet_neutral_indv_releta_ );
+  branchJagged( tree, "jet_charged_indv_relphi", vTaujet_jet_charged_indv_relphi_ );
+  branchJagged( tree, "jet_neutral_indv_relphi", vTaujet_jet_neutral_indv_relphi_ );
+
+  branchJagged( tree, "jet_charged_indv_releta_crystal", vTaujet_jet_charged_indv_releta_crystal_ );
+  branchJagged( tree, "jet_neutral_indv_releta_crystal", vTaujet_jet_neutral_indv_releta_crystal_ );
+  branchJagged( tree, "jet_charged_indv_relphi_crystal", vTaujet_jet_charged_indv_relphi_crystal_ );
+  branchJagged( tree, "jet_neutral_indv_relphi_crystal", vTaujet_jet_neutral_indv_relphi_crystal_ );
 
   tree->Branch("leading_eta", &vTaujet_jet_leading_eta_);
   tree->Branch("leading_phi", &vTaujet_jet_leading_phi_);
@@ -219,7 +230,324 @@ bool RecHitAnalyzer::runEvtSel_jet_taujet( const edm::Event& iEvent, const edm::
 
 } // runEvtSel_jet_taujet() 
 
+// Per-jet record ____________________________________________________________//
+// Everything fillEvtSel_jet_taujet() writes for one jet. Jagged
+// branches get one row per jet
+struct RecHitAnalyzer::TaujetJet {
+  float pT, m0, eta, phi, E;
+  float truthLabel, truthDM;
+  float neutral_pT, neutral_m0, neutral_eta, neutral_phi;
+  vector<float> charged_indv_p, neutral_indv_p;
+  vector<float> charged_indv_eta, neutral_indv_eta;
+  vector<float> charged_indv_phi, neutral_indv_phi;
+  vector<double> charged_indv_relp, neutral_indv_relp;
+  vector<double> charged_indv_releta, neutral_indv_releta;
+  vector<double> charged_indv_relphi, neutral_indv_relphi;
+  vector<float> charged_indv_releta_crystal, neutral_indv_releta_crystal;
+  vector<float> charged_indv_relphi_crystal, neutral_indv_relphi_crystal;
+  float leading_eta, leading_phi, leading_ieta, leading_iphi, leading_energy;
+  float neutralsum_eta, neutralsum_phi, neutralsum_ieta, neutralsum_iphi, neutralsum_pt, neutralsum_ECAL;
+  float centre_ieta, centre_iphi, centre1_ieta, centre1_iphi, centre2_ieta, centre2_iphi;
+  double centre2_eta, centre2_phi;
+};
+
+template<class T, class U>
+static void appendRow ( img::JaggedArray<T>& arr, const vector<U>& row ) {
+  for ( const U& v : row ) arr.push_back( v );
+  arr.endRow();
+}
+
+// Process one jet ___________________________________________________________//
+// Only reads the event and the geometry and writes to its own record,
+// so jets can be processed concurrently
+void RecHitAnalyzer::processJet_taujet( const reco::PFJetRef& thisJet,
+                                        const edm::Handle<reco::GenParticleCollection>& genParticles,
+                                        const std::vector<reco::GenTau>& genTaus,
+                                        const std::vector<reco::GenTau>& genTausLikeJets,
+                                        TaujetJet& out ) {
+
+  if (debug) std::cout << " Passed Jet " << " Pt:" << thisJet->pt()  << " Eta:" << thisJet->eta()  << " Phi:" << thisJet->phi() 
+		       << " jetE:" << thisJet->energy() << " jetM:" << thisJet->mass() 
+		       << " photonE:" << thisJet->photonEnergy()  
+		       << " chargedHadronEnergy:" << thisJet->chargedHadronEnergy()  
+		       << " neutralHadronEnergy :" << thisJet->neutralHadronEnergy()
+		       << " electronEnergy	 :" << thisJet->electronEnergy	()
+		       << " muonEnergy		 :" << thisJet->muonEnergy		()
+		       << " HFHadronEnergy	 :" << thisJet->HFHadronEnergy	()
+		       << " HFEMEnergy		 :" << thisJet->HFEMEnergy		()
+		       << " chargedEmEnergy	 :" << thisJet->chargedEmEnergy	()
+		       << " chargedMuEnergy	 :" << thisJet->chargedMuEnergy	()
+		       << " neutralEmEnergy	 :" << thisJet->neutralEmEnergy	()
+		       << std::endl;
+
+  out.pT  = std::abs(thisJet->pt());
+  out.m0  = thisJet->mass();
+  out.eta = thisJet->eta();
+  out.phi = thisJet->phi();
+  out.E   = thisJet->energy();
+
+  math::XYZTLorentzVector neutral_PF;
+
+  math::XYZTLorentzVector p4_leading = math::XYZTLorentzVector(0,0,0,0); 
+  reco::PFCandidatePtr leading_pfC;
+
+  float neutral_ECAL = 0; // store ECAL energy deposits
+
+  double total_energy = 0; // total energy of event
+  double eta_sum = 0; //sum of E_i*eta_i for all i
+  double phi_sum = 0;
+  double total_energy1 = 0; // total energy of event
+  double eta_sum1 = 0; //sum of E_i*eta_i for all i
+  double phi_sum1 = 0;
+  double total_energy2 = 0; // total energy of event
+  double eta_sum2 = 0; //sum of E_i*eta_i for all i
+  double phi_sum2 = 0;
+
+  // Index loop: getPFConstituents() would copy the Ptrs into a new vector for every jet
+  for (unsigned iC(0); iC != thisJet->numberOfDaughters(); ++iC){
+    reco::PFCandidatePtr pfC = thisJet->getPFConstituent( iC );
+
+    // Loop over all PF candidates and make energy weighted average position
+
+    // propagate all particles 
+    double magneticField = magneticField_;
+    math::XYZTLorentzVector  prop_p4(pfC->p4().px(),pfC->p4().py(),pfC->p4().pz(),sqrt(pow(pfC->p(),2)+pfC->mass()*pfC->mass())); //setup 4-vector 
+    BaseParticlePropagator propagator = BaseParticlePropagator(
+        RawParticle(prop_p4, math::XYZTLorentzVector(pfC->vx(), pfC->vy(), pfC->vz(), 0.),
+                    pfC->charge()),0.,0.,magneticField);
+    propagator.propagateToEcalEntrance(false); // propogate to ECAL entrance
+    auto pfC_position = propagator.particle().vertex().Vect();
+
+    eta_sum += pfC_position.eta()*pfC->energy();
+    phi_sum += pfC_position.phi()*pfC->energy();
+    total_energy += pfC->energy();
+
+    if (pfC->particleId() == 1 || pfC->particleId() ==4){
+      // Store gamma and hPM for position
+      eta_sum1 += pfC_position.eta()*pfC->energy();
+      phi_sum1 += pfC_position.phi()*pfC->energy();
+      total_energy1 += pfC->energy();
+    }
+    if (pfC->particleId() == 4 || pfC->particleId()==2){
+      // Store gamma and e for position
+      eta_sum2 += pfC_position.eta()*pfC->energy();
+      phi_sum2 += pfC_position.phi()*pfC->energy();
+      total_energy2 += pfC->energy();
+    }
+
+    if (pfC->particleId()==4){
+
+      auto n_p4_vec = pfC->p4();
+      neutral_PF += n_p4_vec;
+      neutral_ECAL += pfC->ecalEnergy(); // going with corrected energy for now
+
+    } else if (pfC->particleId()==1){
+
+      if (pfC->p4().pt() > p4_leading.pt()){
+        // store leading hadron propagated
+        math::XYZTLorentzVector propagated_p4(pfC->p4().pt(), pfC_position.eta(), pfC_position.phi(), pfC->p4().mass());
+        p4_leading = propagated_p4;
+        leading_pfC = pfC;
+      }
+    }
+  } 
+
+  // find indices for leading prong
+  DetId id_leading( findDetIdECAL( p4_leading.eta(), p4_leading.phi() ) );
+  EBDetId ebId( id_leading );
+  int leading_iphi_ = ebId.iphi() - 1;
+  int leading_ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
+
+  //find indices for neutral component of jet
+  DetId id_neutral( findDetIdECAL( neutral_PF.eta(), neutral_PF.phi() ) );
+  EBDetId ebId_neutral( id_neutral );
+  int neutral_iphi_ = ebId_neutral.iphi() - 1;
+  int neutral_ieta_ = ebId_neutral.ieta() > 0 ? ebId_neutral.ieta()-1 : ebId_neutral.ieta();
+
+  // find indices for centering on all PFc
+  double eta_avg = eta_sum/total_energy;
+  double phi_avg = phi_sum/total_energy;
+  DetId id_jet( findDetIdECAL( eta_avg, phi_avg ) );
+  EBDetId ebId_jet( id_jet );
+  int jet_sum_iphi_ = ebId_jet.iphi() - 1;
+  int jet_sum_ieta_ = ebId_jet.ieta() > 0 ? ebId_jet.ieta()-1 : ebId_jet.ieta();
+
+  // find indices for centering on gamma and charged hadrons
+  double eta_avg1 = eta_sum1/total_energy1;
+  double phi_avg1 = phi_sum1/total_energy1;
+  DetId id_jet1( findDetIdECAL( eta_avg1, phi_avg1 ) );
+  EBDetId ebId_jet1( id_jet1 );
+  int jet_sum_iphi1_ = ebId_jet1.iphi() - 1;
+  int jet_sum_ieta1_ = ebId_jet1.ieta() > 0 ? ebId_jet1.ieta()-1 : ebId_jet1.ieta();
+
+  // find indices for centering on egamma
+  double eta_avg2 = eta_sum2/total_energy2;
+  double phi_avg2 = phi_sum2/total_energy2;
+  DetId id_jet2( findDetIdECAL( eta_avg2, phi_avg2 ) );
+  EBDetId ebId_jet2( id_jet2 );
+  int jet_sum_iphi2_ = ebId_jet2.iphi() - 1;
+  int jet_sum_ieta2_ = ebId_jet2.ieta() > 0 ? ebId_jet2.ieta()-1 : ebId_jet2.ieta();
+
+  const auto centre_pos = getCellPosition(ebId_jet2);
+  double jet_sum_phi2_ = centre_pos.phi();
+  double jet_sum_eta2_ = centre_pos.eta();
+
+  std::pair<int, reco::GenTau> match = getTruthLabelForTauJets(thisJet, genParticles, genTaus, genTausLikeJets, 0.4, false);
+  int truthLabel = match.first;
+  out.truthLabel = truthLabel;
+
+  int truthDM=-1;
+  float neutral_pT=0.;
+  float neutral_M=0.;
+  float neutral_eta=0.;
+  float neutral_phi=0.;
+
+  if (abs(truthLabel)==15) {
+    truthDM = match.second.decay_mode();
+    neutral_pT = match.second.neutral_p4().pt();
+    neutral_M = match.second.neutral_p4().mass();
+    neutral_eta = match.second.neutral_p4().eta();
+    neutral_phi = match.second.neutral_p4().phi();
+
+    // Save charged prongs and index:
+    for (const auto &charged : match.second.charge_p4_indv()){
+      // Find ieta iphi index
+      DetId id_leading( findDetIdECAL( charged.eta(), charged.phi() ) );
+      EBDetId ebId( id_leading );
+      int charged_iphi_ = ebId.iphi() - 1;
+      int charged_ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
+
+      out.charged_indv_p.push_back(charged.energy());
+      out.charged_indv_eta.push_back(charged_ieta_);
+      out.charged_indv_phi.push_back(charged_iphi_);
+    } 
+    for (auto x : match.second.pis_at_ecal()){
+      double p = x.second;
+      double eta = x.first.eta();
+      double phi = x.first.phi();
+      double releta = eta-jet_sum_eta2_;
+      double relphi = phi-jet_sum_phi2_;
+      relphi = TVector2::Phi_mpi_pi(relphi);
+      out.charged_indv_relp.push_back(p);
+      out.charged_indv_releta.push_back(releta);
+      out.charged_indv_relphi.push_back(relphi);
+
+      // also store in crystal units:
+      DetId id( findDetIdECAL( eta, phi ) );
+      EBDetId ebId( id );
+
+      // get index of the crystal
+      float iphi = ebId.iphi() -1;
+      float ieta = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta(); 
+
+      // now work out how far along the crystal the particle overlapped to get a continuous number
+      float minEta_, maxEta_, minPhi_, maxPhi_;
+      getCellEtaPhiBox( ebId, minEta_, maxEta_, minPhi_, maxPhi_ );
+
+      float ieta_cont = ieta+(eta-minEta_)/(maxEta_-minEta_);
+      float iphi_cont = iphi+(phi-minPhi_)/(maxPhi_-minPhi_);  
+
+      out.charged_indv_releta_crystal.push_back(ieta_cont);
+      out.charged_indv_relphi_crystal.push_back(iphi_cont);
+    }
+    if (match.second.neutral_p4_indv().size()>0){
+      for (const auto &neutral : match.second.neutral_p4_indv()){
+        DetId id_neutral( findDetIdECAL( neutral.eta(), neutral.phi() ) );
+        EBDetId ebId_neutral( id_neutral );
+        int neutral_iphi_ = ebId_neutral.iphi() - 1;
+        int neutral_ieta_ = ebId_neutral.ieta() > 0 ? ebId_neutral.ieta()-1 : ebId_neutral.ieta();
+
+        out.neutral_indv_p.push_back(neutral.energy());
+        out.neutral_indv_eta.push_back(neutral_ieta_);
+        out.neutral_indv_phi.push_back(neutral_iphi_);
+      }
+    } else{
+      out.neutral_indv_p.push_back(-1);
+      out.neutral_indv_eta.push_back(-100); 
+      out.neutral_indv_phi.push_back(-100);
+    }
+    if (match.second.pi0s_at_ecal().size()>0){
+      for (auto x : match.second.pi0s_at_ecal()){
+        double p = x.second;
+        double eta = x.first.eta(); 
+        double phi = x.first.phi(); 
+        double releta = eta-jet_sum_eta2_;
+        double relphi = phi-jet_sum_phi2_; 
+        relphi = TVector2::Phi_mpi_pi(relphi);
+        out.neutral_indv_relp.push_back(p);
+        out.neutral_indv_releta.push_back(releta);
+        out.neutral_indv_relphi.push_back(relphi);
+
+        // also store in crystal units:
+        DetId id( findDetIdECAL( eta, phi ) );
+        EBDetId ebId( id );
+
+        // get index of the crystal
+        float iphi = ebId.iphi() -1;
+        float ieta = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta(); 
+
+        // now work out how far along the crystal the particle overlapped to get a continuous number
+        float minEta_, maxEta_, minPhi_, maxPhi_;
+        getCellEtaPhiBox( ebId, minEta_, maxEta_, minPhi_, maxPhi_ );
+
+        float ieta_cont = ieta+(eta-minEta_)/(maxEta_-minEta_);
+        float iphi_cont = iphi+(phi-minPhi_)/(maxPhi_-minPhi_); 
+
+        out.neutral_indv_releta_crystal.push_back(ieta_cont);
+        out.neutral_indv_relphi_crystal.push_back(iphi_cont);
+
+        // uncomment below to determine actual direction
+        //math::XYZVector direction = GetPi0Direction(match.second.vertex(), releta, relphi, jet_sum_eta2_, jet_sum_phi2_);
+      }
+    } else{
+      out.neutral_indv_relp.push_back(0.);
+      out.neutral_indv_releta.push_back(0.);
+      out.neutral_indv_relphi.push_back(0.);
+    }
+
+  } else{
+    out.charged_indv_p.push_back(-1);
+    out.neutral_indv_p.push_back(-1);
+    out.charged_indv_eta.push_back(-100);
+    out.neutral_indv_eta.push_back(-100);
+    out.charged_indv_phi.push_back(-100);
+    out.neutral_indv_phi.push_back(-100);
+  }
+
+  out.truthDM = truthDM;
+  out.neutral_pT = neutral_pT;
+  out.neutral_m0 = neutral_M;
+  out.neutral_eta = neutral_eta;
+  out.neutral_phi = neutral_phi;
+
+  out.leading_eta = p4_leading.eta();
+  out.leading_phi = p4_leading.phi();
+  out.leading_ieta = leading_ieta_;
+  out.leading_iphi = leading_iphi_;
+  out.leading_energy = p4_leading.energy();
+
+  out.neutralsum_eta = neutral_PF.eta();
+  out.neutralsum_phi = neutral_PF.phi();
+  out.neutralsum_ieta = neutral_ieta_;
+  out.neutralsum_iphi = neutral_iphi_;
+  out.neutralsum_pt = neutral_PF.pt();
+  out.neutralsum_ECAL = neutral_ECAL;
+
+  out.centre_ieta = jet_sum_ieta_;
+  out.centre_iphi = jet_sum_iphi_;
+  out.centre1_ieta = jet_sum_ieta1_;
+  out.centre1_iphi = jet_sum_iphi1_;
+  out.centre2_ieta = jet_sum_ieta2_;
+  out.centre2_iphi = jet_sum_iphi2_;
+  out.centre2_eta = jet_sum_eta2_;
+  out.centre2_phi = jet_sum_phi2_;
+
+} // processJet_taujet()
+
 // Fill branches and histograms _____________________________________________________//
+// The jets are processed in parallel if 'parallelFills', each into
+// its own record; records are then written out in vJetIdxs order,
+// so the output does not depend on the number of threads.
 void RecHitAnalyzer::fillEvtSel_jet_taujet( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
 
   edm::Handle<reco::PFJetCollection> jets;
@@ -242,356 +570,87 @@ void RecHitAnalyzer::fillEvtSel_jet_taujet( const edm::Event& iEvent, const edm:
 
   edm::Handle<reco::VertexCollection> vertexInfo;
   iEvent.getByToken(vertexCollectionT_, vertexInfo);
-  const reco::VertexCollection& vtxs = *vertexInfo;
-	      
-  edm::ESHandle<MagneticField> magfield;
-  iSetup.get<IdealMagneticFieldRecord>().get(magfield);
-
-  // Provides access to global cell position
-  edm::ESHandle<CaloGeometry> caloGeomH_;
-  iSetup.get<CaloGeometryRecord>().get( caloGeomH_ );
-  const CaloGeometry* caloGeom = caloGeomH_.product();
 
-  h_taujet_jet_nJet->Fill( vJetIdxs.size() );
-  // Fill branches and histograms 
-  for(int thisJetIdx : vJetIdxs){
-    reco::PFJetRef thisJet( jets, thisJetIdx );
-    if ( debug ) std::cout << " >> Jet[" << thisJetIdx << "] Pt:" << thisJet->pt() << std::endl;
-
-    if (debug) std::cout << " Passed Jet " << " Pt:" << thisJet->pt()  << " Eta:" << thisJet->eta()  << " Phi:" << thisJet->phi() 
-			 << " jetE:" << thisJet->energy() << " jetM:" << thisJet->mass() 
-			 << " photonE:" << thisJet->photonEnergy()  
-			 << " chargedHadronEnergy:" << thisJet->chargedHadronEnergy()  
-			 << " neutralHadronEnergy :" << thisJet->neutralHadronEnergy()
-			 << " electronEnergy	 :" << thisJet->electronEnergy	()
-			 << " muonEnergy		 :" << thisJet->muonEnergy		()
-			 << " HFHadronEnergy	 :" << thisJet->HFHadronEnergy	()
-			 << " HFEMEnergy		 :" << thisJet->HFEMEnergy		()
-			 << " chargedEmEnergy	 :" << thisJet->chargedEmEnergy	()
-			 << " chargedMuEnergy	 :" << thisJet->chargedMuEnergy	()
-			 << " neutralEmEnergy	 :" << thisJet->neutralEmEnergy	()
-			 << std::endl;
-
-    h_taujet_jet_pT->Fill( std::abs(thisJet->pt()) );
-    h_taujet_jet_E->Fill( thisJet->energy() );
-    h_taujet_jet_m0->Fill( thisJet->mass() );
-    h_taujet_jet_eta->Fill( thisJet->eta() );
-    vTaujet_jet_pT_.push_back( std::abs(thisJet->pt()) );
-    vTaujet_jet_m0_.push_back( thisJet->mass() );
-    vTaujet_jet_eta_.push_back( thisJet->eta() );
-    vTaujet_jet_phi_.push_back( thisJet->phi() );
-
-    std::vector<reco::PFCandidatePtr> pfCands = thisJet->getPFConstituents();
-
-    math::XYZTLorentzVector neutral_PF;
-
-    math::XYZTLorentzVector p4_leading = math::XYZTLorentzVector(0,0,0,0); 
-    reco::PFCandidatePtr leading_pfC;
-
-
-    float neutral_ECAL = 0; // store ECAL energy deposits
-
-    double total_energy = 0; // total energy of event
-    double eta_sum = 0; //sum of E_i*eta_i for all i
-    double phi_sum = 0;
-    double total_energy1 = 0; // total energy of event
-    double eta_sum1 = 0; //sum of E_i*eta_i for all i
-    double phi_sum1 = 0;
-    double total_energy2 = 0; // total energy of event
-    double eta_sum2 = 0; //sum of E_i*eta_i for all i
-    double phi_sum2 = 0;
-
-
-    for (const auto &pfC : pfCands){
-      
-      
-      // Loop over all PF candidates and make energy weighted average position
-      
-      // propagate all particles 
-      double magneticField = (magfield.product() ? magfield.product()->inTesla(GlobalPoint(0., 0., 0.)).z() : 0.0);
-      math::XYZTLorentzVector  prop_p4(pfC->p4().px(),pfC->p4().py(),pfC->p4().pz(),sqrt(pow(pfC->p(),2)+pfC->mass()*pfC->mass())); //setup 4-vector 
-      BaseParticlePropagator propagator = BaseParticlePropagator(
-          RawParticle(prop_p4, math::XYZTLorentzVector(pfC->vx(), pfC->vy(), pfC->vz(), 0.),
-                      pfC->charge()),0.,0.,magneticField);
-      propagator.propagateToEcalEntrance(false); // propogate to ECAL entrance
-      auto pfC_position = propagator.particle().vertex().Vect();
-      
-      eta_sum += pfC_position.eta()*pfC->energy();
-      phi_sum += pfC_position.phi()*pfC->energy();
-      total_energy += pfC->energy();
-
-      if (pfC->particleId() == 1 || pfC->particleId() ==4){
-        // Store gamma and hPM for position
-        eta_sum1 += pfC_position.eta()*pfC->energy();
-        phi_sum1 += pfC_position.phi()*pfC->energy();
-        total_energy1 += pfC->energy();
-      }
-      if (pfC->particleId() == 4 || pfC->particleId()==2){
-        // Store gamma and e for position
-        eta_sum2 += pfC_position.eta()*pfC->energy();
-        phi_sum2 += pfC_position.phi()*pfC->energy();
-        total_energy2 += pfC->energy();
-      }
+  // Gen taus and tau-like gen jets, built once for all jets
+  const std::vector<reco::GenTau> genTaus = BuildTauJets( genParticles, magneticField_, false, true );
+  const std::vector<reco::GenTau> genTausLikeJets = BuildTauLikeJets( genJets, magneticField_ );
 
-      if (pfC->particleId()==4){
-        
-        auto n_p4_vec = pfC->p4();
-        neutral_PF += n_p4_vec;
-        neutral_ECAL += pfC->ecalEnergy(); // going with corrected energy for now
-
-      } else if (pfC->particleId()==1){
-        
-        if (pfC->p4().pt() > p4_leading.pt()){
-          // store leading hadron propagated
-          math::XYZTLorentzVector propagated_p4(pfC->p4().pt(), pfC_position.eta(), pfC_position.phi(), pfC->p4().mass());
-          p4_leading = propagated_p4;
-          leading_pfC = pfC;
-        }
-      } else {
-
-        }
-        } 
-
-    
-    double magneticField = (magfield.product() ? magfield.product()->inTesla(GlobalPoint(0., 0., 0.)).z() : 0.0);
-
-    // find indices for leading prong
-    DetId id_leading( spr::findDetIdECAL( caloGeom, p4_leading.eta(), p4_leading.phi(), false ) );
-    EBDetId ebId( id_leading );
-    int leading_iphi_ = ebId.iphi() - 1;
-    int leading_ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
-    
-    //find indices for neutral component of jet
-    DetId id_neutral( spr::findDetIdECAL( caloGeom, neutral_PF.eta(), neutral_PF.phi(), false ) );
-    EBDetId ebId_neutral( id_neutral );
-    int neutral_iphi_ = ebId_neutral.iphi() - 1;
-    int neutral_ieta_ = ebId_neutral.ieta() > 0 ? ebId_neutral.ieta()-1 : ebId_neutral.ieta();
-
-    // find indices for centering on all PFc
-    double eta_avg = eta_sum/total_energy;
-    double phi_avg = phi_sum/total_energy;
-    DetId id_jet( spr::findDetIdECAL( caloGeom, eta_avg, phi_avg, false ) );
-    EBDetId ebId_jet( id_jet );
-    int jet_sum_iphi_ = ebId_jet.iphi() - 1;
-    int jet_sum_ieta_ = ebId_jet.ieta() > 0 ? ebId_jet.ieta()-1 : ebId_jet.ieta();
-
-    // find indices for centering on gamma and charged hadrons
-    double eta_avg1 = eta_sum1/total_energy1;
-    double phi_avg1 = phi_sum1/total_energy1;
-    DetId id_jet1( spr::findDetIdECAL( caloGeom, eta_avg1, phi_avg1, false ) );
-    EBDetId ebId_jet1( id_jet1 );
-    int jet_sum_iphi1_ = ebId_jet1.iphi() - 1;
-    int jet_sum_ieta1_ = ebId_jet1.ieta() > 0 ? ebId_jet1.ieta()-1 : ebId_jet1.ieta();
-
-    // find indices for centering on egamma
-    double eta_avg2 = eta_sum2/total_energy2;
-    double phi_avg2 = phi_sum2/total_energy2;
-    DetId id_jet2( spr::findDetIdECAL( caloGeom, eta_avg2, phi_avg2, false ) );
-    EBDetId ebId_jet2( id_jet2 );
-    int jet_sum_iphi2_ = ebId_jet2.iphi() - 1;
-    int jet_sum_ieta2_ = ebId_jet2.ieta() > 0 ? ebId_jet2.ieta()-1 : ebId_jet2.ieta();
-
-    const auto centre_pos = caloGeom->getPosition(ebId_jet2);
-    double jet_sum_phi2_ = centre_pos.phi();
-    double jet_sum_eta2_ = centre_pos.eta();
-
-    std::pair<int, reco::GenTau*> match = getTruthLabelForTauJets(thisJet, genParticles, genJets, magneticField, 0.4, false);
-    int truthLabel = match.first;
-    vTaujet_jet_truthLabel_      .push_back(truthLabel);
-
-    int truthDM=-1;
-    float neutral_pT=0.;
-    float neutral_M=0.;
-    float neutral_eta=0.;
-    float neutral_phi=0.;
-    vector<float> charge_p_indv;
-    vector<float> neutral_p_indv;
-    vector<float> charge_eta_indv;
-    vector<float> neutral_eta_indv;
-    vector<float> charge_phi_indv;
-    vector<float> neutral_phi_indv;
-
-    vector<double> charge_relp_indv;
-    vector<double> neutral_relp_indv;
-    vector<double> charge_releta_indv;
-    vector<double> neutral_releta_indv;
-    vector<double> charge_relphi_indv;
-    vector<double> neutral_relphi_indv;
-
-    vector<float> charge_releta_crystal_indv;
-    vector<float> neutral_releta_crystal_indv;
-    vector<float> charge_relphi_crystal_indv;
-    vector<float> neutral_relphi_crystal_indv;
-
-    if (abs(truthLabel)==15) {
-      truthDM = match.second->decay_mode();
-      neutral_pT = match.second->neutral_p4().pt();
-      neutral_M = match.second->neutral_p4().mass();
-      neutral_eta = match.second->neutral_p4().eta();
-      neutral_phi = match.second->neutral_p4().phi();
-
-      // Save charged prongs and index:
-      for (const auto &charged : match.second->charge_p4_indv()){
-          // Find ieta iphi index
-          DetId id_leading( spr::findDetIdECAL( caloGeom, charged.eta(), charged.phi(), false ) );
-          EBDetId ebId( id_leading );
-          int charged_iphi_ = ebId.iphi() - 1;
-          int charged_ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
-          
-          charge_p_indv.push_back(charged.energy());
-          charge_eta_indv.push_back(charged_ieta_);
-          charge_phi_indv.push_back(charged_iphi_);
-      } 
-      for (auto x : match.second->pis_at_ecal()){
-          double p = x.second;
-          double eta = x.first.eta();
-          double phi = x.first.phi();
-          double releta = eta-jet_sum_eta2_;
-          double relphi = phi-jet_sum_phi2_;
-          relphi = TVector2::Phi_mpi_pi(relphi);
-          charge_relp_indv.push_back(p);
-          charge_releta_indv.push_back(releta);
-          charge_relphi_indv.push_back(relphi);
-
-          // also store in crystal units:
-          DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
-          EBDetId ebId( id );
-
-          // get index of the crystal
-          float iphi = ebId.iphi() -1;
-          float ieta = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta(); 
-
-          // now work out how far along the crystal the particle overlapped to get a continuous number
-          const auto repCorners = caloGeom->getGeometry(ebId)->getCornersREP();
-          float minEta_ = repCorners[2].eta();
-          float maxEta_ = repCorners[0].eta();
-          float minPhi_ = repCorners[2].phi();
-          float maxPhi_ = repCorners[0].phi();
-
-          float ieta_cont = ieta+(eta-minEta_)/(maxEta_-minEta_);
-          float iphi_cont = iphi+(phi-minPhi_)/(maxPhi_-minPhi_);  
-
-          charge_releta_crystal_indv.push_back(ieta_cont);
-          charge_relphi_crystal_indv.push_back(iphi_cont);
-        }
-      if (match.second->neutral_p4_indv().size()>0){
-        for (const auto &neutral : match.second->neutral_p4_indv()){
-            DetId id_neutral( spr::findDetIdECAL( caloGeom, neutral.eta(), neutral.phi(), false ) );
-            EBDetId ebId_neutral( id_neutral );
-            int neutral_iphi_ = ebId_neutral.iphi() - 1;
-            int neutral_ieta_ = ebId_neutral.ieta() > 0 ? ebId_neutral.ieta()-1 : ebId_neutral.ieta();
-
-
-            neutral_p_indv.push_back(neutral.energy());
-            neutral_eta_indv.push_back(neutral_ieta_);
-            neutral_phi_indv.push_back(neutral_iphi_);
-          }
-      } else{
-        neutral_p_indv.push_back(-1);
-        neutral_eta_indv.push_back(-100); 
-        neutral_phi_indv.push_back(-100);
-        
-      }
-      if (match.second->pi0s_at_ecal().size()>0){
-        for (auto x : match.second->pi0s_at_ecal()){
-            double p = x.second;
-            double eta = x.first.eta(); 
-            double phi = x.first.phi(); 
-            double releta = eta-jet_sum_eta2_;
-            double relphi = phi-jet_sum_phi2_; 
-            relphi = TVector2::Phi_mpi_pi(relphi);
-            neutral_relp_indv.push_back(p);
-            neutral_releta_indv.push_back(releta);
-            neutral_relphi_indv.push_back(relphi);
-
-            // also store in crystal units:
-            DetId id( spr::findDetIdECAL( caloGeom, eta, phi, false ) );
-            EBDetId ebId( id );
-
-            // get index of the crystal
-            float iphi = ebId.iphi() -1;
-            float ieta = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta(); 
-      
-            // now work out how far along the crystal the particle overlapped to get a continuous number
-            const auto repCorners = caloGeom->getGeometry(ebId)->getCornersREP();
-            float minEta_ = repCorners[2].eta();
-            float maxEta_ = repCorners[0].eta();
-            float minPhi_ = repCorners[2].phi();
-            float maxPhi_ = repCorners[0].phi();
-
-            float ieta_cont = ieta+(eta-minEta_)/(maxEta_-minEta_);
-            float iphi_cont = iphi+(phi-minPhi_)/(maxPhi_-minPhi_); 
-
-            neutral_releta_crystal_indv.push_back(ieta_cont);
-            neutral_relphi_crystal_indv.push_back(iphi_cont);
-
-            // uncomment below to determine actual direction
-            //math::XYZVector direction = GetPi0Direction(match.second->vertex(), releta, relphi, jet_sum_eta2_, jet_sum_phi2_);
-
-          }
-      } else{
-        neutral_relp_indv.push_back(0.);
-        neutral_releta_indv.push_back(0.);
-        neutral_relphi_indv.push_back(0.);
-      }
-      
-    } else{
-      charge_p_indv.push_back(-1);
-      neutral_p_indv.push_back(-1);
-      charge_eta_indv.push_back(-100);
-      neutral_eta_indv.push_back(-100);
-      charge_phi_indv.push_back(-100);
-      neutral_phi_indv.push_back(-100);
+  vector<TaujetJet> taujets( vJetIdxs.size() );
+  auto processJets = [&]( const tbb::blocked_range<size_t>& range ) {
+    for ( size_t iJ = range.begin(); iJ != range.end(); ++iJ ) {
+      reco::PFJetRef thisJet( jets, vJetIdxs[iJ] );
+      if ( debug ) std::cout << " >> Jet[" << vJetIdxs[iJ] << "] Pt:" << thisJet->pt() << std::endl;
+      processJet_taujet( thisJet, genParticles, genTaus, genTausLikeJets, taujets[iJ] );
     }
+  };
+  tbb::blocked_range<size_t> allJets( 0, taujets.size(), 1 );
+  if ( parallelFills_ ) {
+    tbb::parallel_for( allJets, processJets );
+  } else {
+    processJets( allJets );
+  }
 
-    vTaujet_jet_truthDM_.push_back(truthDM);
-    vTaujet_jet_neutral_pT_.push_back(neutral_pT);
-    vTaujet_jet_neutral_m0_.push_back(neutral_M);
-    vTaujet_jet_neutral_eta_.push_back(neutral_eta);
-    vTaujet_jet_neutral_phi_.push_back(neutral_phi);
-
-    vTaujet_jet_charged_indv_p_.push_back(charge_p_indv);
-    vTaujet_jet_neutral_indv_p_.push_back(neutral_p_indv);
-    vTaujet_jet_charged_indv_eta_.push_back(charge_eta_indv);
-    vTaujet_jet_neutral_indv_eta_.push_back(neutral_eta_indv);
-    vTaujet_jet_charged_indv_phi_.push_back(charge_phi_indv);
-    vTaujet_jet_neutral_indv_phi_.push_back(neutral_phi_indv);
-
-    vTaujet_jet_leading_eta_.push_back(p4_leading.eta());
-    vTaujet_jet_leading_phi_.push_back(p4_leading.phi());
-    vTaujet_jet_leading_ieta_.push_back(leading_ieta_);
-    vTaujet_jet_leading_iphi_.push_back(leading_iphi_);
-    vTaujet_jet_leading_energy_.push_back(p4_leading.energy());
-
-    vTaujet_jet_neutralsum_eta_.push_back(neutral_PF.eta());
-    vTaujet_jet_neutralsum_phi_.push_back(neutral_PF.phi());
-    vTaujet_jet_neutralsum_ieta_.push_back(neutral_ieta_);
-    vTaujet_jet_neutralsum_iphi_.push_back(neutral_iphi_);
-    vTaujet_jet_neutralsum_pt_.push_back(neutral_PF.pt());
-    vTaujet_jet_neutralsum_ECAL_.push_back(neutral_ECAL);
-
-    vTaujet_jet_centre_ieta_.push_back(jet_sum_ieta_);
-    vTaujet_jet_centre_iphi_.push_back(jet_sum_iphi_);
-    vTaujet_jet_centre1_ieta_.push_back(jet_sum_ieta1_);
-    vTaujet_jet_centre1_iphi_.push_back(jet_sum_iphi1_);
-    vTaujet_jet_centre2_ieta_.push_back(jet_sum_ieta2_);
-    vTaujet_jet_centre2_iphi_.push_back(jet_sum_iphi2_);
-    vTaujet_jet_centre2_eta_.push_back(jet_sum_eta2_);
-    vTaujet_jet_centre2_phi_.push_back(jet_sum_phi2_); 
-
-    vTaujet_jet_charged_indv_relp_.push_back(charge_relp_indv);
-    vTaujet_jet_neutral_indv_relp_.push_back(neutral_relp_indv);
-    vTaujet_jet_charged_indv_releta_.push_back(charge_releta_indv);
-    vTaujet_jet_neutral_indv_releta_.push_back(neutral_releta_indv);
-    vTaujet_jet_charged_indv_relphi_.push_back(charge_relphi_indv);
-    vTaujet_jet_neutral_indv_relphi_.push_back(neutral_relphi_indv);
-   
-    vTaujet_jet_charged_indv_releta_crystal_.push_back(charge_releta_crystal_indv);
-    vTaujet_jet_neutral_indv_releta_crystal_.push_back(neutral_releta_crystal_indv);
-    vTaujet_jet_charged_indv_relphi_crystal_.push_back(charge_relphi_crystal_indv);
-    vTaujet_jet_neutral_indv_relphi_crystal_.push_back(neutral_relphi_crystal_indv);
- 
-  }//vJetIdxs
+  // Fill branches and histograms 
+  h_taujet_jet_nJet->Fill( vJetIdxs.size() );
+  for ( const TaujetJet& jet : taujets ) {
+
+    h_taujet_jet_pT->Fill( jet.pT );
+    h_taujet_jet_E->Fill( jet.E );
+    h_taujet_jet_m0->Fill( jet.m0 );
+    h_taujet_jet_eta->Fill( jet.eta );
+    vTaujet_jet_pT_.push_back( jet.pT );
+    vTaujet_jet_m0_.push_back( jet.m0 );
+    vTaujet_jet_eta_.push_back( jet.eta );
+    vTaujet_jet_phi_.push_back( jet.phi );
+    vTaujet_jet_truthLabel_.push_back( jet.truthLabel );
+
+    vTaujet_jet_truthDM_.push_back( jet.truthDM );
+    vTaujet_jet_neutral_pT_.push_back( jet.neutral_pT );
+    vTaujet_jet_neutral_m0_.push_back( jet.neutral_m0 );
+    vTaujet_jet_neutral_eta_.push_back( jet.neutral_eta );
+    vTaujet_jet_neutral_phi_.push_back( jet.neutral_phi );
+
+    appendRow( vTaujet_jet_charged_indv_p_, jet.charged_indv_p );
+    appendRow( vTaujet_jet_neutral_indv_p_, jet.neutral_indv_p );
+    appendRow( vTaujet_jet_charged_indv_eta_, jet.charged_indv_eta );
+    appendRow( vTaujet_jet_neutral_indv_eta_, jet.neutral_indv_eta );
+    appendRow( vTaujet_jet_charged_indv_phi_, jet.charged_indv_phi );
+    appendRow( vTaujet_jet_neutral_indv_phi_, jet.neutral_indv_phi );
+
+    vTaujet_jet_leading_eta_.push_back( jet.leading_eta );
+    vTaujet_jet_leading_phi_.push_back( jet.leading_phi );
+    vTaujet_jet_leading_ieta_.push_back( jet.leading_ieta );
+    vTaujet_jet_leading_iphi_.push_back( jet.leading_iphi );
+    vTaujet_jet_leading_energy_.push_back( jet.leading_energy );
+
+    vTaujet_jet_neutralsum_eta_.push_back( jet.neutralsum_eta );
+    vTaujet_jet_neutralsum_phi_.push_back( jet.neutralsum_phi );
+    vTaujet_jet_neutralsum_ieta_.push_back( jet.neutralsum_ieta );
+    vTaujet_jet_neutralsum_iphi_.push_back( jet.neutralsum_iphi );
+    vTaujet_jet_neutralsum_pt_.push_back( jet.neutralsum_pt );
+    vTaujet_jet_neutralsum_ECAL_.push_back( jet.neutralsum_ECAL );
+
+    vTaujet_jet_centre_ieta_.push_back( jet.centre_ieta );
+    vTaujet_jet_centre_iphi_.push_back( jet.centre_iphi );
+    vTaujet_jet_centre1_ieta_.push_back( jet.centre1_ieta );
+    vTaujet_jet_centre1_iphi_.push_back( jet.centre1_iphi );
+    vTaujet_jet_centre2_ieta_.push_back( jet.centre2_ieta );
+    vTaujet_jet_centre2_iphi_.push_back( jet.centre2_iphi );
+    vTaujet_jet_centre2_eta_.push_back( jet.centre2_eta );
+    vTaujet_jet_centre2_phi_.push_back( jet.centre2_phi );
+
+    appendRow( vTaujet_jet_charged_indv_relp_, jet.charged_indv_relp );
+    appendRow( vTaujet_jet_neutral_indv_relp_, jet.neutral_indv_relp );
+    appendRow( vTaujet_jet_charged_indv_releta_, jet.charged_indv_releta );
+    appendRow( vTaujet_jet_neutral_indv_releta_, jet.neutral_indv_releta );
+    appendRow( vTaujet_jet_charged_indv_relphi_, jet.charged_indv_relphi );
+    appendRow( vTaujet_jet_neutral_indv_relphi_, jet.neutral_indv_relphi );
+
+    appendRow( vTaujet_jet_charged_indv_releta_crystal_, jet.charged_indv_releta_crystal );
+    appendRow( vTaujet_jet_neutral_indv_releta_crystal_, jet.neutral_indv_releta_crystal );
+    appendRow( vTaujet_jet_charged_indv_relphi_crystal_, jet.charged_indv_relphi_crystal );
+    appendRow( vTaujet_jet_neutral_indv_relphi_crystal_, jet.neutral_indv_relphi_crystal );
 
+  }//vJetIdxs
 
 } // fillEvtSel_jet_taujet()
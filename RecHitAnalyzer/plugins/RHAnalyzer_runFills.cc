@@ -0,0 +1,119 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "tbb/flow_graph.h"
+
+// Run fill functions ////////////////////////////////
+// Each image channel fill reads its own inputs and writes its own
+// buffers and histograms (file-level globals of its RHAnalyzer_fill*.cc),
+// so with 'parallelFills' they run as independent tasks of a flow
+// graph, on the TBB arena of the framework. The pyramid levels and
+// channel statistics read the filled images: they run after all
+// channel fills, in order. Otherwise everything runs serially.
+// A new channel fill must not share any state with another one,
+// or has to be chained after it.
+//
+// With 'detectorImages', the fills whose images are in the
+// DetectorImage product decode them instead (getDetectorImages()).
+
+typedef void (RecHitAnalyzer::*FillFn) ( const edm::Event&, const edm::EventSetup& );
+typedef tbb::flow::continue_node<tbb::flow::continue_msg> FillNode;
+
+// Run fills ___________________________________________________________________//
+void RecHitAnalyzer::runFills ( const edm::Event& iEvent, const edm::EventSetup& iSetup ) {
+
+  // Independent of each other
+  std::vector<FillFn> channelFills;
+  // After all channel fills, in order
+  std::vector<FillFn> imageFills;
+  if ( writeImages_ ) {
+    channelFills = {
+      &RecHitAnalyzer::fillEB,
+      &RecHitAnalyzer::fillEE,
+      &RecHitAnalyzer::fillES,
+      //&RecHitAnalyzer::fillESatEE,
+      &RecHitAnalyzer::fillHBHE,
+      &RecHitAnalyzer::fillECALatHCAL,
+      &RecHitAnalyzer::fillECALstitched,
+      &RecHitAnalyzer::fillHCALatEBEE,
+      &RecHitAnalyzer::fillTracksAtEBEE,
+      &RecHitAnalyzer::fillTracksAtECALstitched,
+      &RecHitAnalyzer::fillPFCandsAtEBEE,
+      &RecHitAnalyzer::fillPFCandsAtECALstitched,
+      //&RecHitAnalyzer::fillTRKvolumeAtEBEE,
+      &RecHitAnalyzer::fillJetInfoAtECALstitched,
+      &RecHitAnalyzer::fillPFEB
+      //&RecHitAnalyzer::fillPFHBHE
+    };
+    if ( doTRKlayers_ ) channelFills.push_back( &RecHitAnalyzer::fillTRKlayersAtEBEE );
+    if ( doEBdigis_ ) channelFills.push_back( &RecHitAnalyzer::fillEBdigis );
+    imageFills.push_back( &RecHitAnalyzer::fillImagePyramid );
+    if ( doChannelStats_ ) imageFills.push_back( &RecHitAnalyzer::fillChannelStats );
+  }
+  if ( writeHits_ ) channelFills.push_back( &RecHitAnalyzer::fillHitList );
+
+  if ( !parallelFills_ ) {
+    for ( FillFn fill : channelFills ) (this->*fill)( iEvent, iSetup );
+    for ( FillFn fill : imageFills ) (this->*fill)( iEvent, iSetup );
+    return;
+  }
+
+  tbb::flow::graph g;
+  tbb::flow::broadcast_node<tbb::flow::continue_msg> start( g );
+  std::vector<std::unique_ptr<FillNode>> nodes;
+  auto makeNode = [&]( FillFn fill ) -> FillNode& {
+    nodes.emplace_back( new FillNode( g, [this, fill, &iEvent, &iSetup]( const tbb::flow::continue_msg& ) {
+      (this->*fill)( iEvent, iSetup );
+    } ) );
+    return *nodes.back();
+  };
+
+  std::vector<FillNode*> channelNodes;
+  for ( FillFn fill : channelFills ) {
+    FillNode& node = makeNode( fill );
+    tbb::flow::make_edge( start, node );
+    channelNodes.push_back( &node );
+  }
+  // The first image fill waits for all channel fills, then a chain
+  FillNode* last = nullptr;
+  for ( FillFn fill : imageFills ) {
+    FillNode& node = makeNode( fill );
+    if ( last ) {
+      tbb::flow::make_edge( *last, node );
+    } else {
+      for ( FillNode* channelNode : channelNodes ) tbb::flow::make_edge( *channelNode, node );
+    }
+    last = &node;
+  }
+
+  // Exceptions thrown by a fill are rethrown here
+  start.try_put( tbb::flow::continue_msg() );
+  g.wait_for_all();
+
+} // runFills()
+
+// Get images from the DetectorImage product ___________________________________//
+// Decode the product channels 'names' into the registered images of
+// the same names. Returns false if no product is used, the caller
+// then fills the images itself.
+bool RecHitAnalyzer::getDetectorImages ( const edm::Event& iEvent, const std::vector<std::string>& names ) {
+
+  if ( !useDetectorImages_ ) return false;
+
+  edm::Handle<img::DetectorImage> detectorImagesH_;
+  iEvent.getByToken( detectorImagesT_, detectorImagesH_ );
+
+  for ( const std::string& name : names ) {
+    const ImageChannel& channel = imageChannels_.at( name );
+    const img::DetectorImageChannel* source = detectorImagesH_->find( name );
+    if ( !source ) {
+      throw cms::Exception("RecHitAnalyzer") << "detectorImages: no channel " << name << " in the product";
+    }
+    if ( source->nRows != channel.nRows || source->nCols != channel.nCols ) {
+      throw cms::Exception("RecHitAnalyzer") << "detectorImages: channel " << name << " is "
+        << source->nRows << "x" << source->nCols << ", expected " << channel.nRows << "x" << channel.nCols;
+    }
+    detectorImagesH_->decode( name, *channel.image );
+  }
+  return true;
+
+} // getDetectorImages()
@@ -0,0 +1,248 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "PhysicsTools/ONNXRuntime/interface/ONNXRuntime.h"
+
+#include <chrono>
+
+// Run in-situ inference ////////////////////////////////////
+// Score the images with an ONNX model while they are produced,
+// instead of writing them out, as configured by 'inference'.
+// The input of an item is the stack of 'channels' (registered
+// images or pyramid levels): in JetLevel mode a cropSize x cropSize
+// crop around each selected jet seed (as crop_jet() of
+// convert_root2pq_jet.py), in EventLevel mode the full images.
+// Items are batched across events and jets; a batch of 'batchSize'
+// runs on the CPU with 'nThreads' intra-op threads, the rest at
+// endJob. Each item gives one entry of the Scores tree: the event
+// keys, jet index (-1 in EventLevel mode), prescale weight and the
+// model outputs. RHTree stays empty. Must run after the fill
+// functions.
+
+// Filled by runEvtSel / runEvtSel_jet
+extern float evtWeight_;
+extern std::vector<float> vJetSeed_iphi_;
+extern std::vector<float> vJetSeed_ieta_;
+extern std::vector<float> vJetWeight_;
+
+TTree* InferenceTree;
+unsigned int vInf_runId_;
+unsigned int vInf_lumiId_;
+unsigned long long vInf_eventId_;
+int vInf_jetIdx_;
+float vInf_weight_;
+std::vector<float> vInf_scores_;
+
+std::unique_ptr<cms::Ort::ONNXRuntime> inferenceModel_;
+std::string inferenceInput_;
+std::vector<std::string> inferenceOutputs_;
+struct InferenceChannel {
+  const img::ImageBuffer* image;
+  int nRows;
+  int nCols;
+  int scale; // image pixels per HBHE tower, JetLevel
+};
+std::vector<InferenceChannel> vInf_channels_;
+bool inferenceChannelsLast_;
+int inferenceBatchSize_;
+int vInf_nRows_, vInf_nCols_; // of one item
+
+// Items of the pending batch
+struct InferenceItem {
+  unsigned int run;
+  unsigned int lumi;
+  unsigned long long event;
+  int jet;
+  float weight;
+};
+std::vector<InferenceItem> vInf_items_;
+std::vector<float> vInf_input_;
+
+// Throughput
+long long nInf_items_;
+long long nInf_batches_;
+double tInf_input_;
+double tInf_model_;
+
+typedef std::chrono::steady_clock InfClock;
+static double secondsSince ( InfClock::time_point t0 ) {
+  return std::chrono::duration<double>( InfClock::now() - t0 ).count();
+}
+
+// Initialize branches _____________________________________________________//
+void RecHitAnalyzer::branchesInference ( const edm::ParameterSet& cfg, edm::Service<TFileService> &fs ) {
+
+  inferenceInput_        = cfg.getParameter<std::string>("inputName");
+  inferenceOutputs_      = cfg.getParameter<std::vector<std::string>>("outputNames");
+  inferenceChannelsLast_ = cfg.getParameter<bool>("channelsLast");
+  inferenceBatchSize_    = cfg.getParameter<int>("batchSize");
+  int cropSize           = cfg.getParameter<int>("cropSize");
+  int nThreads           = cfg.getParameter<int>("nThreads");
+  if ( inferenceBatchSize_ < 1 || nThreads < 1 ) {
+    throw cms::Exception("RecHitAnalyzer") << "inference: batchSize and nThreads must be >= 1";
+  }
+
+  // Registered image or pyramid level
+  for ( const std::string& name : cfg.getParameter<std::vector<std::string>>("channels") ) {
+    auto channel = imageChannels_.find( name );
+    if ( channel != imageChannels_.end() ) {
+      vInf_channels_.push_back( InferenceChannel{ channel->second.image, channel->second.nRows, channel->second.nCols, 0 } );
+      continue;
+    }
+    bool found = false;
+    for ( PyramidLevel& level : pyramidLevels_ ) {
+      std::string bname = level.channel + ( level.upsample ? "_up" : "_down" ) + std::to_string( level.factor );
+      if ( bname != name ) continue;
+      int nRows = level.upsample ? level.source.nRows*level.factor : ( level.source.nRows+level.factor-1 )/level.factor;
+      int nCols = level.upsample ? level.source.nCols*level.factor : ( level.source.nCols+level.factor-1 )/level.factor;
+      vInf_channels_.push_back( InferenceChannel{ &level.image, nRows, nCols, 0 } );
+      found = true;
+    }
+    if ( !found ) throw cms::Exception("RecHitAnalyzer") << "inference: no image channel " << name;
+  }
+  if ( vInf_channels_.empty() ) throw cms::Exception("RecHitAnalyzer") << "inference: no channels";
+
+  if ( doJets_ ) {
+    // Seeds are HBHE towers: the channels must have the stitched
+    // ECAL (280x360) or HBHE (56x72) layout, at any multiple
+    for ( InferenceChannel& channel : vInf_channels_ ) {
+      channel.scale = channel.nCols/HBHE_IPHI_NUM;
+      if ( channel.nCols != channel.scale*HBHE_IPHI_NUM || channel.nRows != channel.scale*2*(HBHE_IETA_MAX_HE-1) ) {
+        throw cms::Exception("RecHitAnalyzer") << "inference: " << channel.nRows << "x" << channel.nCols
+          << " channel not aligned with the HBHE towers, cannot crop around jet seeds";
+      }
+    }
+    vInf_nRows_ = cropSize;
+    vInf_nCols_ = cropSize;
+  } else {
+    vInf_nRows_ = vInf_channels_.front().nRows;
+    vInf_nCols_ = vInf_channels_.front().nCols;
+    for ( const InferenceChannel& channel : vInf_channels_ ) {
+      if ( channel.nRows != vInf_nRows_ || channel.nCols != vInf_nCols_ ) {
+        throw cms::Exception("RecHitAnalyzer") << "inference: EventLevel channels must have the same shape";
+      }
+    }
+  }
+
+  Ort::SessionOptions options;
+  options.SetIntraOpNumThreads( nThreads );
+  options.SetInterOpNumThreads( 1 );
+  std::string modelPath = cfg.getParameter<std::string>("modelPath");
+  inferenceModel_.reset( new cms::Ort::ONNXRuntime( modelPath, &options ) );
+  std::cout << " >> Inference with " << modelPath << ": " << vInf_channels_.size() << "x"
+            << vInf_nRows_ << "x" << vInf_nCols_ << " inputs, batches of " << inferenceBatchSize_ << std::endl;
+
+  // Not in RHTree: one entry per scored jet or event
+  InferenceTree = fs->make<TTree>("Scores", "Model scores");
+  InferenceTree->Branch("runId",   &vInf_runId_);
+  InferenceTree->Branch("lumiId",  &vInf_lumiId_);
+  InferenceTree->Branch("eventId", &vInf_eventId_);
+  InferenceTree->Branch("jetIdx",  &vInf_jetIdx_);
+  InferenceTree->Branch("weight",  &vInf_weight_);
+  InferenceTree->Branch("scores",  &vInf_scores_);
+
+  vInf_input_.reserve( inferenceBatchSize_*vInf_channels_.size()*vInf_nRows_*vInf_nCols_ );
+  nInf_items_ = 0;
+  nInf_batches_ = 0;
+  tInf_input_ = 0.;
+  tInf_model_ = 0.;
+
+} // branchesInference()
+
+// Add the event to the batch __________________________________________________//
+void RecHitAnalyzer::queueInference ( const edm::Event& iEvent ) {
+
+  InfClock::time_point t0 = InfClock::now();
+
+  int nChannels = vInf_channels_.size();
+  int nPixels = vInf_nRows_*vInf_nCols_;
+  // (C,H,W) or (H,W,C) per item
+  int channelStride = inferenceChannelsLast_ ? 1 : nPixels;
+  int pixelStride   = inferenceChannelsLast_ ? nChannels : 1;
+
+  unsigned int nItems = doJets_ ? vJetIdxs.size() : 1;
+  for ( unsigned int iI = 0; iI < nItems; iI++ ) {
+
+    InferenceItem item{ iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(),
+                        doJets_ ? vJetIdxs[iI] : -1, doJets_ ? vJetWeight_[iI] : evtWeight_ };
+    size_t offset = vInf_input_.size();
+    vInf_input_.resize( offset + nChannels*nPixels );
+    float* input = vInf_input_.data() + offset;
+
+    for ( int iC = 0; iC < nChannels; iC++ ) {
+      const InferenceChannel& channel = vInf_channels_[iC];
+      float* out = input + iC*channelStride;
+      if ( doJets_ ) {
+        int scale = channel.scale;
+        img::cropImage( *channel.image, channel.nRows, channel.nCols,
+                        int( vJetSeed_ieta_[iI] )*scale + scale/2, int( vJetSeed_iphi_[iI] )*scale + scale/2,
+                        vInf_nRows_, out, vInf_nCols_*pixelStride, pixelStride );
+      } else {
+        for ( int idx = 0; idx < nPixels; idx++ ) out[idx*pixelStride] = channel.image->get(idx);
+      }
+    }
+    vInf_items_.push_back( item );
+
+    if ( int( vInf_items_.size() ) == inferenceBatchSize_ ) {
+      tInf_input_ += secondsSince( t0 );
+      runInferenceBatch();
+      t0 = InfClock::now();
+    }
+
+  } // items
+
+  tInf_input_ += secondsSince( t0 );
+
+} // queueInference()
+
+// Score the pending batch _____________________________________________________//
+void RecHitAnalyzer::runInferenceBatch () {
+
+  if ( vInf_items_.empty() ) return;
+
+  int64_t nItems = vInf_items_.size();
+  std::vector<int64_t> shape = inferenceChannelsLast_
+    ? std::vector<int64_t>{ nItems, vInf_nRows_, vInf_nCols_, int64_t( vInf_channels_.size() ) }
+    : std::vector<int64_t>{ nItems, int64_t( vInf_channels_.size() ), vInf_nRows_, vInf_nCols_ };
+
+  InfClock::time_point t0 = InfClock::now();
+  cms::Ort::FloatArrays inputs( 1 );
+  inputs[0].swap( vInf_input_ );
+  cms::Ort::FloatArrays outputs = inferenceModel_->run( { inferenceInput_ }, inputs, { shape }, inferenceOutputs_, nItems );
+  tInf_model_ += secondsSince( t0 );
+  // Give the buffer back, keeping its capacity
+  vInf_input_.swap( inputs[0] );
+  vInf_input_.clear();
+
+  // Concatenated outputs of each item
+  for ( int64_t iI = 0; iI < nItems; iI++ ) {
+    const InferenceItem& item = vInf_items_[iI];
+    vInf_runId_   = item.run;
+    vInf_lumiId_  = item.lumi;
+    vInf_eventId_ = item.event;
+    vInf_jetIdx_  = item.jet;
+    vInf_weight_  = item.weight;
+    vInf_scores_.clear();
+    for ( const std::vector<float>& output : outputs ) {
+      size_t dim = output.size()/nItems;
+      vInf_scores_.insert( vInf_scores_.end(), output.begin() + iI*dim, output.begin() + ( iI+1 )*dim );
+    }
+    InferenceTree->Fill();
+  }
+
+  nInf_items_ += nItems;
+  nInf_batches_++;
+  vInf_items_.clear();
+
+} // runInferenceBatch()
+
+// Score what is left and report throughput ____________________________________//
+void RecHitAnalyzer::endInference () {
+
+  runInferenceBatch();
+  std::cout << " inference: " << nInf_items_ << ( doJets_ ? " jets" : " events" ) << " in " << nInf_batches_ << " batches"
+            << ", inputs " << tInf_input_ << " s, model " << tInf_model_ << " s";
+  if ( tInf_model_ > 0. ) std::cout << " (" << nInf_items_/tInf_model_ << "/s)";
+  std::cout << std::endl;
+  inferenceModel_.reset();
+
+} // endInference()
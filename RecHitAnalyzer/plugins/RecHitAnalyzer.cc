@@ -10,6 +10,7 @@
 //
 
 #include "MLAnalyzer/RecHitAnalyzer/interface/RecHitAnalyzer.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 //
 // constructors and destructor
@@ -19,7 +20,6 @@ RecHitAnalyzer::RecHitAnalyzer(const edm::ParameterSet& iConfig)
   //EBRecHitCollectionT_    = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("EBRecHitCollection"));
   EBRecHitCollectionT_    = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedEBRecHitCollection"));
   //EBDigiCollectionT_      = consumes<EBDigiCollection>(iConfig.getParameter<edm::InputTag>("selectedEBDigiCollection"));
-  //EBDigiCollectionT_      = consumes<EBDigiCollection>(iConfig.getParameter<edm::InputTag>("EBDigiCollection"));
   EERecHitCollectionT_    = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedEERecHitCollection"));
   ESRecHitCollectionT_    = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedESRecHitCollection"));
   //EERecHitCollectionT_    = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("EERecHitCollection"));
@@ -49,6 +49,11 @@ RecHitAnalyzer::RecHitAnalyzer(const edm::ParameterSet& iConfig)
   maxJetEta_ = iConfig.getParameter<double>("maxJetEta");
   z0PVCut_   = iConfig.getParameter<double>("z0PVCut");
 
+  hltSelector_ = img::TriggerSelector(iConfig.getParameter<std::vector<std::string>>("hltPaths"));
+  if ( !hltSelector_.empty() ) {
+    trgResultsT_ = consumes<edm::TriggerResults>(iConfig.getParameter<edm::InputTag>("trgResults"));
+  }
+
   std::cout << " >> Mode set to " << mode_ << std::endl;
   if ( mode_ == "JetLevel" ) {
     doJets_ = true;
@@ -61,6 +66,109 @@ RecHitAnalyzer::RecHitAnalyzer(const edm::ParameterSet& iConfig)
     doJets_ = false;
   }
 
+  // Calorimeter geometry and B-field from a local snapshot instead of the EventSetup
+  caloGeom_ = nullptr;
+  magneticField_ = 0.;
+  std::string geometrySnapshot = iConfig.getParameter<std::string>("geometrySnapshot");
+  if ( !geometrySnapshot.empty() ) {
+    geoSnapshot_.reset( new img::GeometrySnapshot );
+    try {
+      geoSnapshot_->read( geometrySnapshot );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+    std::cout << " >> Using geometry snapshot " << geometrySnapshot << std::endl;
+  }
+
+  // Up/downsampled copies of registered image channels
+  for ( const edm::ParameterSet& level : iConfig.getParameter<std::vector<edm::ParameterSet>>("imagePyramid") ) {
+    PyramidLevel pyramidLevel;
+    pyramidLevel.channel  = level.getParameter<std::string>("channel");
+    pyramidLevel.factor   = level.getParameter<int>("factor");
+    pyramidLevel.upsample = level.getParameter<bool>("upsample");
+    if ( pyramidLevel.factor < 2 ) {
+      throw cms::Exception("RecHitAnalyzer") << "imagePyramid: factor must be >= 2 for " << pyramidLevel.channel;
+    }
+    pyramidLevels_.push_back( pyramidLevel );
+  }
+
+  // Output: dense images and/or a flat hit list for point-cloud models
+  writeImages_  = iConfig.getParameter<bool>("writeImages");
+  writeHits_    = iConfig.getParameter<bool>("writeHits");
+  hitListJetDR_ = iConfig.getParameter<double>("hitListJetDR");
+  doTRKlayers_  = iConfig.getParameter<bool>("doTRKlayers");
+  doEBdigis_    = iConfig.getParameter<bool>("doEBdigis");
+  if ( doEBdigis_ ) {
+    EBDigiCollectionT_ = consumes<EBDigiCollection>(iConfig.getParameter<edm::InputTag>("EBDigiCollection"));
+    std::string layout = iConfig.getParameter<std::string>("ebDigiLayout");
+    if ( layout == "sampleMajor" ) {
+      ebDigiLayout_ = img::kSampleMajor;
+    } else if ( layout == "crystalMajor" ) {
+      ebDigiLayout_ = img::kCrystalMajor;
+    } else {
+      throw cms::Exception("RecHitAnalyzer") << "ebDigiLayout must be sampleMajor or crystalMajor, not " << layout;
+    }
+    ebDigiSeedSample_ = iConfig.getParameter<int>("ebDigiSeedSample");
+    if ( ebDigiSeedSample_ < 0 || ebDigiSeedSample_ >= img::EB_DIGI_NSAMPLES ) {
+      throw cms::Exception("RecHitAnalyzer") << "ebDigiSeedSample must be in [0," << img::EB_DIGI_NSAMPLES << ")";
+    }
+  }
+  doChannelStats_ = iConfig.getParameter<bool>("channelStats");
+  parallelFills_ = iConfig.getParameter<bool>("parallelFills");
+  edm::InputTag detectorImages = iConfig.getParameter<edm::InputTag>("detectorImages");
+  useDetectorImages_ = !detectorImages.label().empty();
+  if ( useDetectorImages_ ) {
+    detectorImagesT_ = consumes<img::DetectorImage>( detectorImages );
+    std::cout << " >> Reading images from " << detectorImages.encode() << std::endl;
+  }
+  tkTransformsCacheId_ = 0;
+
+  // Deterministic prescale of the selected events or jets
+  edm::ParameterSet prescaleCfg = iConfig.getParameter<edm::ParameterSet>("prescale");
+  try {
+    prescaler_.configure( prescaleCfg.getParameter<std::vector<double>>("xEdges"),
+                          prescaleCfg.getParameter<std::vector<double>>("yEdges"),
+                          prescaleCfg.getParameter<std::vector<double>>("keepProb"),
+                          prescaleCfg.getParameter<unsigned int>("seed") );
+  } catch ( std::runtime_error& e ) {
+    throw cms::Exception("RecHitAnalyzer") << e.what();
+  }
+  nPrescaled_ = 0;
+  if ( !prescaler_.empty() ) {
+    std::cout << " >> Prescaling selected " << ( doJets_ ? "jets in (pT,|eta|)" : "events in (m0,pT)" ) << std::endl;
+  }
+
+  // Two-pass workflow: selection-only pass writing an event list,
+  // or image pass restricted to the events of a list
+  selectionOnly_ = iConfig.getParameter<bool>("selectionOnly");
+  eventListName_ = iConfig.getParameter<std::string>("eventList");
+  nJetIdxMismatch_ = 0;
+  writeEventIndex_ = iConfig.getParameter<bool>("writeEventIndex");
+  asyncOutputQueue_ = iConfig.getParameter<int>("asyncOutputQueue");
+  edm::ParameterSet inferenceCfg = iConfig.getParameter<edm::ParameterSet>("inference");
+  doInference_ = !selectionOnly_ && !inferenceCfg.getParameter<std::string>("modelPath").empty();
+  if ( doInference_ ) {
+    if ( !writeImages_ ) throw cms::Exception("RecHitAnalyzer") << "inference needs writeImages";
+    // Only the scores are written: nothing in RHTree to index
+    writeEventIndex_ = false;
+  }
+  if ( selectionOnly_ && eventListName_.empty() ) {
+    throw cms::Exception("RecHitAnalyzer") << "selectionOnly requires an eventList output file";
+  }
+  if ( !eventListName_.empty() ) {
+    eventList_.reset( new img::EventList );
+    try {
+      if ( selectionOnly_ ) {
+        eventList_->open( eventListName_ );
+        std::cout << " >> Selection only, writing event list " << eventListName_ << std::endl;
+      } else {
+        eventList_->read( eventListName_ );
+        std::cout << " >> Reading event list " << eventListName_ << ": " << eventList_->size() << " events" << std::endl;
+      }
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+  }
 
 
   // Initialize file writer
@@ -79,21 +187,44 @@ RecHitAnalyzer::RecHitAnalyzer(const edm::ParameterSet& iConfig)
   } else {
     branchesEvtSel( RHTree, fs );
   }
-  branchesEB           ( RHTree, fs );
-  branchesEE           ( RHTree, fs );
-  branchesES           ( RHTree, fs );
-  //branchesESatEE           ( RHTree, fs );
-  branchesHBHE         ( RHTree, fs );
-  branchesECALatHCAL   ( RHTree, fs );
-  branchesECALstitched ( RHTree, fs );
-  branchesHCALatEBEE   ( RHTree, fs );
-  branchesTracksAtEBEE(RHTree, fs);
-  branchesTracksAtECALstitched( RHTree, fs);
-  branchesPFCandsAtEBEE(RHTree, fs);
-  branchesPFCandsAtECALstitched( RHTree, fs);
-  branchesJetInfoAtECALstitched( RHTree, fs);
-  branchesPFEB           ( RHTree, fs );
+  // Selection-only pass: no image branches, RHTree stays empty
+  if ( selectionOnly_ ) return;
+  if ( writeImages_ ) {
+    branchesEB           ( RHTree, fs );
+    branchesEE           ( RHTree, fs );
+    branchesES           ( RHTree, fs );
+    //branchesESatEE           ( RHTree, fs );
+    branchesHBHE         ( RHTree, fs );
+    branchesECALatHCAL   ( RHTree, fs );
+    branchesECALstitched ( RHTree, fs );
+    branchesHCALatEBEE   ( RHTree, fs );
+    branchesTracksAtEBEE(RHTree, fs);
+    branchesTracksAtECALstitched( RHTree, fs);
+    branchesPFCandsAtEBEE(RHTree, fs);
+    branchesPFCandsAtECALstitched( RHTree, fs);
+    branchesJetInfoAtECALstitched( RHTree, fs);
+    branchesPFEB           ( RHTree, fs );
+    if ( doTRKlayers_ ) branchesTRKlayersAtEBEE( RHTree, fs );
+    if ( doEBdigis_ ) branchesEBdigis( RHTree, fs );
+    // Must come last: uses the images registered above
+    branchesImagePyramid ( RHTree, fs );
+    if ( doChannelStats_ ) branchesChannelStats( RHTree, fs );
+  }
+  if ( writeHits_ ) branchesHitList( RHTree, fs );
 
+  // After the image pyramid: its levels can be model inputs
+  if ( doInference_ ) branchesInference( inferenceCfg, fs );
+
+  // All branches are set: hand the filling to the writer thread
+  if ( asyncOutputQueue_ > 0 && !doInference_ ) {
+    try {
+      treeWriter_.start( RHTree, asyncOutputQueue_ );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+    std::cout << " >> Writing RHTree asynchronously, queue of " << asyncOutputQueue_
+              << ": no other module may write to the TFileService file" << std::endl;
+  }
 
 } // constructor
 //
@@ -117,8 +248,32 @@ RecHitAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
   nTotal++;
   using namespace edm;
 
+  // ----- Skip events not in the event list ----- //
+
+  const img::EventList::Entry* listedEvent = nullptr;
+  if ( eventList_ && !selectionOnly_ ) {
+    listedEvent = eventList_->find( iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event() );
+    if ( !listedEvent ) {
+      h_sel->Fill( 0. );
+      return;
+    }
+  }
+
   // ----- Apply event selection cuts ----- //
 
+  if ( !hltSelector_.empty() ) {
+    edm::Handle<edm::TriggerResults> trgs;
+    iEvent.getByToken( trgResultsT_, trgs );
+    hltSelector_.setMenu( iEvent.triggerNames( *trgs ) );
+    if ( hltSelector_.acceptAny( *trgs ) != 1 ) {
+      h_sel->Fill( 0. );
+      return;
+    }
+  }
+
+  // Jet seeds need the calorimeter geometry
+  setupCaloGeometry( iSetup );
+
   bool passedSelection = false;
   if ( doJets_ ) {
     passedSelection = runEvtSel_jet( iEvent, iSetup );
@@ -131,31 +286,54 @@ RecHitAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     return;
   }
 
-  fillEB( iEvent, iSetup );
-  fillEE( iEvent, iSetup );
-  fillES( iEvent, iSetup );
-  //fillESatEE( iEvent, iSetup );
-  fillHBHE( iEvent, iSetup );
-  fillECALatHCAL( iEvent, iSetup );
-  fillECALstitched( iEvent, iSetup );
-  fillHCALatEBEE( iEvent, iSetup );
-  fillTracksAtEBEE( iEvent, iSetup );
-  fillTracksAtECALstitched( iEvent, iSetup );
-  fillPFCandsAtEBEE( iEvent, iSetup );
-  fillPFCandsAtECALstitched( iEvent, iSetup );
-  //fillTRKlayersAtEBEE( iEvent, iSetup );
-  //fillTRKlayersAtECAL( iEvent, iSetup );
-  //fillTRKvolumeAtEBEE( iEvent, iSetup );
-  //fillTRKvolumeAtECAL( iEvent, iSetup );
-  fillJetInfoAtECALstitched( iEvent, iSetup );
-  fillPFEB( iEvent, iSetup );
-  //fillPFHBHE( iEvent, iSetup );
+  if ( selectionOnly_ ) {
+    eventList_->write( iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), vJetIdxs );
+    h_sel->Fill( 1. );
+    nPassed++;
+    return;
+  }
+
+  setupMagneticField( iSetup );
+
+  // The list was written by a different selection than the one run now
+  if ( listedEvent && listedEvent->jetIdxs != vJetIdxs ) nJetIdxMismatch_++;
+
+  if ( doJets_ ) fillEvtSel_jet( iEvent, iSetup );
+
+  // Image and hit list fills, in parallel if 'parallelFills'
+  runFills( iEvent, iSetup );
 
   ////////////// 4-Momenta //////////
   //fillFC( iEvent, iSetup );
 
+  // Score the images instead of writing them
+  if ( doInference_ ) {
+    queueInference( iEvent );
+    h_sel->Fill( 1. );
+    nPassed++;
+    return;
+  }
+
   // Fill RHTree
-  RHTree->Fill();
+  long long entry = treeWriter_.running() ? treeWriter_.nPushed() : RHTree->GetEntries();
+  if ( treeWriter_.running() ) {
+    try {
+      treeWriter_.push();
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+  } else {
+    RHTree->Fill();
+  }
+  if ( writeEventIndex_ ) {
+    if ( doJets_ ) {
+      for ( unsigned int iJ = 0; iJ < vJetIdxs.size(); iJ++ ) {
+        eventIndex_.add( iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), vJetIdxs[iJ], entry, iJ );
+      }
+    } else {
+      eventIndex_.add( iEvent.id().run(), iEvent.id().luminosityBlock(), iEvent.id().event(), -1, entry, 0 );
+    }
+  }
   h_sel->Fill( 1. );
   nPassed++;
 
@@ -173,7 +351,36 @@ RecHitAnalyzer::beginJob(const edm::EventSetup& iSetup)
 void 
 RecHitAnalyzer::endJob() 
 {
+  if ( treeWriter_.running() ) {
+    try {
+      treeWriter_.stop();
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+    std::cout << " async output: waited for the writer in " << treeWriter_.nWaits() << "/" << treeWriter_.nPushed() << " events" << std::endl;
+  }
+  if ( doInference_ ) endInference();
   std::cout << " selected: " << nPassed << "/" << nTotal << std::endl;
+  if ( !prescaler_.empty() ) {
+    std::cout << " prescaled away: " << nPrescaled_ << ( doJets_ ? " jets" : " events" ) << std::endl;
+  }
+  if ( nJetIdxMismatch_ > 0 ) {
+    std::cout << " !! WARNING: " << nJetIdxMismatch_ << " events selected different jets than in " << eventListName_ << std::endl;
+  }
+  if ( eventList_ ) eventList_->close();
+  if ( !channelStats_.empty() ) writeChannelStats();
+  if ( writeEventIndex_ && !selectionOnly_ ) {
+    edm::Service<TFileService> fs;
+    std::string dataFile = fs->file().GetName();
+    std::string indexFile = dataFile + ".idx";
+    size_t slash = dataFile.rfind( '/' );
+    try {
+      eventIndex_.write( indexFile, slash == std::string::npos ? dataFile : dataFile.substr( slash+1 ) );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("RecHitAnalyzer") << e.what();
+    }
+    std::cout << " >> Event index: " << indexFile << ", " << eventIndex_.size() << " entries" << std::endl;
+  }
 }
 
 // ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
@@ -289,9 +496,9 @@ int RecHitAnalyzer::getTruthLabel(const reco::PFJetRef& recJet, edm::Handle<reco
   return -99;
 }
 
-std::vector<reco::GenTau *> BuildTauJets(edm::Handle<reco::GenParticleCollection> genParticles, double magneticField, bool include_leptonic, bool use_prompt) {
+std::vector<reco::GenTau> RecHitAnalyzer::BuildTauJets(edm::Handle<reco::GenParticleCollection> genParticles, double magneticField, bool include_leptonic, bool use_prompt) {
   // Warning: returned tau type works for taus decayed by Pythia8 but might not work for other generators e.g tauola!
-  std::vector<reco::GenTau *> taus;
+  std::vector<reco::GenTau> taus;
   for (reco::GenParticleCollection::const_iterator iGen = genParticles->begin();
        iGen != genParticles->end();
        ++iGen) {
@@ -358,25 +565,25 @@ std::vector<reco::GenTau *> BuildTauJets(edm::Handle<reco::GenParticleCollection
       if(count_tot==3 && count_pi==1 && count_pi0==2) tauFlag=2;
       if(count_tot==3 && count_pi==3 && count_pi0==0) tauFlag=10;
       if(count_tot==4 && count_pi==3 && count_pi0==1) tauFlag=11;
-      reco::GenTau *tau = new reco::GenTau(iGen->charge(), iGen->p4(), vtx, iGen->pdgId(), iGen->status(), true);   
-      tau->set_decay_mode(tauFlag);
-      tau->set_charge_p4(charge_vec); 
-      tau->set_neutral_p4(neutral_vec);
-      tau->set_lead_pi0_p4(lead_pi0_vec); 
-      tau->set_nu_p4(nuvec);
-      tau->set_charge_p4_indv(charge_vec_all);
-      tau->set_neutral_p4_indv(neutral_vec_all);
-      tau->set_pis_at_ecal(propogated_pis);
-      tau->set_pi0s_at_ecal(propogated_pi0s);
+      reco::GenTau tau(iGen->charge(), iGen->p4(), vtx, iGen->pdgId(), iGen->status(), true);   
+      tau.set_decay_mode(tauFlag);
+      tau.set_charge_p4(charge_vec); 
+      tau.set_neutral_p4(neutral_vec);
+      tau.set_lead_pi0_p4(lead_pi0_vec); 
+      tau.set_nu_p4(nuvec);
+      tau.set_charge_p4_indv(charge_vec_all);
+      tau.set_neutral_p4_indv(neutral_vec_all);
+      tau.set_pis_at_ecal(propogated_pis);
+      tau.set_pi0s_at_ecal(propogated_pi0s);
       taus.push_back(tau);
     }
   }
   return taus;
 }
 
-std::vector<reco::GenTau *> BuildTauLikeJets(edm::Handle<reco::GenJetCollection> genJets, double magneticField) {
+std::vector<reco::GenTau> RecHitAnalyzer::BuildTauLikeJets(edm::Handle<reco::GenJetCollection> genJets, double magneticField) {
 
-  std::vector<reco::GenTau *> taus;
+  std::vector<reco::GenTau> taus;
   for (reco::GenJetCollection::const_iterator iJet = genJets->begin();
        iJet != genJets->end();
        ++iJet) {
@@ -427,7 +634,7 @@ std::vector<reco::GenTau *> BuildTauLikeJets(edm::Handle<reco::GenJetCollection>
        if(n.Pt()>lead_pi0_p4.Pt()) lead_pi0_p4=n;
      }
 
-    std::vector<reco::GenTau*> tau_cands = {};
+    std::vector<reco::GenTau> tau_cands = {};
 
     // try 1-prong combinations
     
@@ -435,25 +642,25 @@ std::vector<reco::GenTau *> BuildTauLikeJets(edm::Handle<reco::GenJetCollection>
       bool realTau = false;
       double dR_pi = std::fabs(ROOT::Math::VectorUtil::DeltaR(x->p4(),iJet->p4()));
       if(dR_pi>0.1) continue; //tau-like jets must be narrow
-      reco::GenTau *t = new reco::GenTau();
+      reco::GenTau t;
       std::vector<math::XYZTLorentzVector> charge = {x->p4()};
       if (x->motherRefVector().size()>0 && std::abs(x->motherRefVector()[0]->pdgId())==15) realTau=true;
-      t->set_charge_p4_indv(charge);
-      t->set_charge_p4(x->p4());
-      t->set_neutral_p4_indv(neutral);
-      t->set_neutral_p4(tot_neutral);
-      t->set_decay_mode(std::min((int)neutral.size(),9));
-      t->set_lead_pi0_p4(lead_pi0_p4);
-      t->setP4(tot_neutral+x->p4());
+      t.set_charge_p4_indv(charge);
+      t.set_charge_p4(x->p4());
+      t.set_neutral_p4_indv(neutral);
+      t.set_neutral_p4(tot_neutral);
+      t.set_decay_mode(std::min((int)neutral.size(),9));
+      t.set_lead_pi0_p4(lead_pi0_p4);
+      t.setP4(tot_neutral+x->p4());
       // require isolation-like selection to reject jets that aren't tau-like
-      if ((iJet->pt()-t->vis_p4().Pt())/t->vis_p4().Pt() > 0.2) continue;
+      if ((iJet->pt()-t.vis_p4().Pt())/t.vis_p4().Pt() > 0.2) continue;
       if(realTau) continue; // veto real taus
-      t->setPdgId(6);
+      t.setPdgId(6);
       std::vector<std::pair<math::XYZVector,double>> propogated_pis = {};
       std::pair<math::XYZVector, double> charge_prop = std::make_pair(ExtrapolateToECAL(x, magneticField), x->p());
       propogated_pis.push_back(charge_prop);
-      t->set_pis_at_ecal(propogated_pis);
-      t->set_pi0s_at_ecal(propogated_pi0s);
+      t.set_pis_at_ecal(propogated_pis);
+      t.set_pi0s_at_ecal(propogated_pi0s);
       tau_cands.push_back(t);
     } 
     
@@ -462,26 +669,26 @@ std::vector<reco::GenTau *> BuildTauLikeJets(edm::Handle<reco::GenJetCollection>
     // take highest pT tau candidate
     if(tau_cands.size()==0) continue;
     double lead_pt=0.;
-    reco::GenTau *lead_tau;
-    for(auto t : tau_cands) {
-      if(t->vis_p4().Pt()>lead_pt) {
-        lead_tau = t;
-        lead_pt = t->vis_p4().Pt();
+    const reco::GenTau *lead_tau = nullptr;
+    for(const auto& t : tau_cands) {
+      if(t.vis_p4().Pt()>lead_pt) {
+        lead_tau = &t;
+        lead_pt = t.vis_p4().Pt();
       }
     }
-    taus.push_back(lead_tau); 
+    if(lead_tau) taus.push_back(*lead_tau);
   }
 
   return taus;
 }
 
 
-std::pair<int, reco::GenTau*> RecHitAnalyzer::getTruthLabelForTauJets(const reco::PFJetRef& recJet, edm::Handle<reco::GenParticleCollection> genParticles, edm::Handle<reco::GenJetCollection> genJets, double magneticField, float dRMatch , bool debug ){
+// gen_taus and gen_taus_like_jets from BuildTauJets(genParticles, magneticField, false, true)
+// and BuildTauLikeJets(genJets, magneticField), built once per event
+std::pair<int, reco::GenTau> RecHitAnalyzer::getTruthLabelForTauJets(const reco::PFJetRef& recJet, edm::Handle<reco::GenParticleCollection> genParticles, const std::vector<reco::GenTau>& gen_taus, const std::vector<reco::GenTau>& gen_taus_like_jets, float dRMatch , bool debug ){
   if ( debug ) {
     std::cout << " Matching reco jetPt:" << recJet->pt() << " jetEta:" << recJet->eta() << " jetPhi:" << recJet->phi() << std::endl;
   }
-  std::vector<reco::GenTau *> gen_taus = BuildTauJets(genParticles, magneticField, false, true);
-  std::vector<reco::GenTau *> gen_taus_like_jets = BuildTauLikeJets(genJets, magneticField);
   std::vector<const reco::GenParticle *> gen_leptons;
   for (reco::GenParticleCollection::const_iterator iGen = genParticles->begin();
        iGen != genParticles->end();
@@ -490,7 +697,7 @@ std::pair<int, reco::GenTau*> RecHitAnalyzer::getTruthLabelForTauJets(const reco
   }
 
 
-  reco::GenTau *gen_tau = new reco::GenTau(); 
+  const reco::GenTau *gen_tau = nullptr;
   float minDR=-1.;
   int match_pdgId=0;
 
@@ -510,38 +717,38 @@ std::pair<int, reco::GenTau*> RecHitAnalyzer::getTruthLabelForTauJets(const reco
   }
 
   // match to taus
-  for (auto part : gen_taus) {
+  for (const reco::GenTau& part : gen_taus) {
 
-    float dR = reco::deltaR( recJet->eta(),recJet->phi(), part->vis_p4().eta(),part->vis_p4().phi() );
+    float dR = reco::deltaR( recJet->eta(),recJet->phi(), part.vis_p4().eta(),part.vis_p4().phi() );
 
-    if ( debug ) std::cout << " \t >> dR " << dR << " id:" << part->pdgId() << " status:" << part->status() << " nDaught:" << part->numberOfDaughters() << " pt:"<< part->vis_p4().pt() << " eta:" << part->vis_p4().eta() << " phi:" << part->vis_p4().phi() << " nMoms:" << part->numberOfMothers()<< std::endl;
+    if ( debug ) std::cout << " \t >> dR " << dR << " id:" << part.pdgId() << " status:" << part.status() << " nDaught:" << part.numberOfDaughters() << " pt:"<< part.vis_p4().pt() << " eta:" << part.vis_p4().eta() << " phi:" << part.vis_p4().phi() << " nMoms:" << part.numberOfMothers()<< std::endl;
 
     if ( dR > dRMatch ) continue;
     if(minDR<0 || dR<minDR) {
       minDR = dR;
-      match_pdgId = part->pdgId();
-      gen_tau = part;
-      if ( debug ) std::cout << " Matched pdgID " << part->pdgId() << std::endl;
+      match_pdgId = part.pdgId();
+      gen_tau = &part;
+      if ( debug ) std::cout << " Matched pdgID " << part.pdgId() << std::endl;
     }
   }
 
-  if(minDR>=0) return std::make_pair(match_pdgId, gen_tau);
+  if(minDR>=0) return std::make_pair(match_pdgId, gen_tau ? *gen_tau : reco::GenTau());
   else {
     // when we have a jet try to match to a tau-like jet
-    for (auto part : gen_taus_like_jets) {
+    for (const reco::GenTau& part : gen_taus_like_jets) {
 
-      float dR = reco::deltaR( recJet->eta(),recJet->phi(), part->vis_p4().eta(),part->vis_p4().phi() );
+      float dR = reco::deltaR( recJet->eta(),recJet->phi(), part.vis_p4().eta(),part.vis_p4().phi() );
 
-      if ( debug ) std::cout << " \t >> dR " << dR << " id:" << part->pdgId() << " status:" << part->status() << " nDaught:" << part->numberOfDaughters() << " pt:"<< part->vis_p4().pt() << " eta:" << part->vis_p4().eta() << " phi:" << part->vis_p4().phi() << " nMoms:" << part->numberOfMothers()<< std::endl;
+      if ( debug ) std::cout << " \t >> dR " << dR << " id:" << part.pdgId() << " status:" << part.status() << " nDaught:" << part.numberOfDaughters() << " pt:"<< part.vis_p4().pt() << " eta:" << part.vis_p4().eta() << " phi:" << part.vis_p4().phi() << " nMoms:" << part.numberOfMothers()<< std::endl;
 
       if ( dR > dRMatch ) continue;
       if(minDR<0 || dR<minDR) {
         minDR = dR;
-        gen_tau = part;
-        if ( debug ) std::cout << " Matched pdgID " << part->pdgId() << std::endl;
+        gen_tau = &part;
+        if ( debug ) std::cout << " Matched pdgID " << part.pdgId() << std::endl;
       }
     }
-    return std::make_pair(6, gen_tau);
+    return std::make_pair(6, gen_tau ? *gen_tau : reco::GenTau());
   }
 }
 
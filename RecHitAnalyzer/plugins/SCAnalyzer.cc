@@ -50,6 +50,8 @@ Implementation:
 #include "TMath.h"
 
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
 
 //
 // class declaration
@@ -80,6 +82,9 @@ class SCAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
     edm::EDGetTokenT<reco::PhotonCollection> photonCollectionT_;
     edm::EDGetTokenT<EcalRecHitCollection> EBRecHitCollectionT_;
     edm::EDGetTokenT<reco::GenParticleCollection> genParticleCollectionT_;
+    // Full EB image from a DetectorImageProducer product, if 'detectorImages' is set
+    bool useDetectorImages_;
+    edm::EDGetTokenT<img::DetectorImage> detectorImagesT_;
 
     static const int nPhotons = 1;
     static const int crop_size = 32;
@@ -130,6 +135,9 @@ SCAnalyzer::SCAnalyzer(const edm::ParameterSet& iConfig)
   photonCollectionT_ = consumes<reco::PhotonCollection>(iConfig.getParameter<edm::InputTag>("gedPhotonCollection"));
   EBRecHitCollectionT_ = consumes<EcalRecHitCollection>(iConfig.getParameter<edm::InputTag>("reducedEBRecHitCollection"));
   genParticleCollectionT_ = consumes<reco::GenParticleCollection>(iConfig.getParameter<edm::InputTag>("genParticleCollection"));
+  edm::InputTag detectorImages = iConfig.getParameter<edm::InputTag>("detectorImages");
+  useDetectorImages_ = !detectorImages.label().empty();
+  if ( useDetectorImages_ ) detectorImagesT_ = consumes<img::DetectorImage>( detectorImages );
 
   //now do what ever initialization is needed
   usesResource("TFileService");
@@ -399,26 +407,38 @@ SCAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
   */
 
   // Fill full EB for comparison
-  vEB_energy_.assign(EBDetId::kSizeForDenseIndexing,0.);
-  for(EcalRecHitCollection::const_iterator iRHit = EBRecHitsH->begin();
-      iRHit != EBRecHitsH->end();
-      ++iRHit) {
+  // From the DetectorImage product if given, without monitoring histogram:
+  // EB_energy_noZS, all rechits as below, not the zero-suppressed EB_energy
+  if ( useDetectorImages_ ) {
+    edm::Handle<img::DetectorImage> detectorImagesH;
+    iEvent.getByToken(detectorImagesT_, detectorImagesH);
+    try {
+      detectorImagesH->decode( "EB_energy_noZS", vEB_energy_ );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("SCAnalyzer") << "detectorImages: " << e.what();
+    }
+  } else {
+    vEB_energy_.assign(EBDetId::kSizeForDenseIndexing,0.);
+    for(EcalRecHitCollection::const_iterator iRHit = EBRecHitsH->begin();
+        iRHit != EBRecHitsH->end();
+        ++iRHit) {
 
-    // Get detector id and convert to histogram-friendly coordinates
-    EBDetId ebId( iRHit->id() );
-    iphi_ = ebId.iphi()-1;
-    ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
-    //std::cout << "ECAL | (ieta,iphi): (" << ebId.ieta() << "," << ebId.iphi() << ")" <<std::endl;
+      // Get detector id and convert to histogram-friendly coordinates
+      EBDetId ebId( iRHit->id() );
+      iphi_ = ebId.iphi()-1;
+      ieta_ = ebId.ieta() > 0 ? ebId.ieta()-1 : ebId.ieta();
+      //std::cout << "ECAL | (ieta,iphi): (" << ebId.ieta() << "," << ebId.iphi() << ")" <<std::endl;
 
-    // Fill some histograms to monitor distributions
-    // These will contain *cumulative* statistics and as such
-    // should be used for monitoring purposes only
-    hEB_energy->Fill( iphi_,ieta_,iRHit->energy() );
+      // Fill some histograms to monitor distributions
+      // These will contain *cumulative* statistics and as such
+      // should be used for monitoring purposes only
+      hEB_energy->Fill( iphi_,ieta_,iRHit->energy() );
 
-    // Fill branch arrays
-    idx = ebId.hashedIndex(); // (ieta_+EBDetId::MAX_IETA)*EBDetId::MAX_IPHI + iphi_
-    vEB_energy_[idx] = iRHit->energy();
-  } // EB rechits
+      // Fill branch arrays
+      idx = ebId.hashedIndex(); // (ieta_+EBDetId::MAX_IETA)*EBDetId::MAX_IPHI + iphi_
+      vEB_energy_[idx] = iRHit->energy();
+    } // EB rechits
+  }
 
   /*
   //edm::Handle<edm::View<reco::GsfElectron>> electrons;
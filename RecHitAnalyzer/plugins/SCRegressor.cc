@@ -39,8 +39,13 @@ SCRegressor::SCRegressor(const edm::ParameterSet& iConfig)
   trackCollectionT_ = consumes<pat::IsolatedTrackCollection>(iConfig.getParameter<edm::InputTag>("trackCollection"));
   rhoLabel_ = consumes<double>(iConfig.getParameter<edm::InputTag>("rhoLabel"));
   trgResultsT_ = consumes<edm::TriggerResults>(iConfig.getParameter<edm::InputTag>("trgResults"));
+  hltSelector_ = img::TriggerSelector(iConfig.getParameter<std::vector<std::string>>("hltPaths"));
   genInfoT_ = consumes<GenEventInfoProduct>(iConfig.getParameter<edm::InputTag>("generator"));
   lheEventT_ = consumes<LHEEventProduct>(iConfig.getParameter<edm::InputTag>("lhe"));
+  mvptCfg_ = iConfig.getParameter<edm::ParameterSet>("mvptHist");
+  edm::InputTag detectorImages = iConfig.getParameter<edm::InputTag>("detectorImages");
+  useDetectorImages_ = !detectorImages.label().empty();
+  if ( useDetectorImages_ ) detectorImagesT_ = consumes<img::DetectorImage>( detectorImages );
 
   //now do what ever initialization is needed
   usesResource("TFileService");
@@ -70,6 +75,7 @@ SCRegressor::SCRegressor(const edm::ParameterSet& iConfig)
   //branchesTracksAtEBEE     ( RHTree, fs );
   branchesPhoVars     ( RHTree, fs );
   //branchesEvtWgt     ( RHTree, fs );
+  branchesMvPt     ( RHTree, fs );
 
   hNpassed_img = fs->make<TH1F>("hNpassed_img", "isPassed;isPassed;N", 2, 0., 2);
 }
@@ -228,6 +234,7 @@ SCRegressor::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
   //fillTracksAtEBEE     ( iEvent, iSetup );
   fillPhoVars     ( iEvent, iSetup );
   //fillEvtWgt     ( iEvent, iSetup );
+  fillMvPt     ( iEvent, iSetup );
 
   //nPassed++;
   nPassed += nPho;
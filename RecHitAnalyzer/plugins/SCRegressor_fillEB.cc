@@ -1,4 +1,5 @@
 #include "MLAnalyzer/RecHitAnalyzer/interface/SCRegressor.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 // Fill EB rec hits ////////////////////////////////
 // Store event rechits in a vector of length equal
@@ -32,6 +33,19 @@ void SCRegressor::fillEB ( const edm::Event& iEvent, const edm::EventSetup& iSet
   int iphi_, ieta_, idx_; // rows:ieta, cols:iphi
   float energy_;
 
+  // Images from the DetectorImage product, without monitoring histograms
+  if ( useDetectorImages_ ) {
+    edm::Handle<img::DetectorImage> detectorImagesH_;
+    iEvent.getByToken( detectorImagesT_, detectorImagesH_ );
+    try {
+      detectorImagesH_->decode( "EB_energy", vEB_energy_ );
+      detectorImagesH_->decode( "EB_time", vEB_time_ );
+    } catch ( std::runtime_error& e ) {
+      throw cms::Exception("SCRegressor") << "detectorImages: " << e.what();
+    }
+    return;
+  }
+
   vEB_energy_.assign( EBDetId::kSizeForDenseIndexing, 0. );
   vEB_time_.assign( EBDetId::kSizeForDenseIndexing, 0. );
 
@@ -0,0 +1,33 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/SCRegressor.h"
+
+// Fill (m0,pT) occupancy //////////////////////////////////
+// Occupancy of the stored SCs in (SC_mass, SC_pT), after the
+// pT and dR cuts of the mass-vs-pT flattening, filled while
+// producing so the weights need no pass over the output.
+// Histograms of separate jobs add up (hadd), and
+// make_mvpt_friend.py turns them into per-SC weights and drop
+// probabilities. Must run after the selection filling SC_*.
+
+// Initialize branches _____________________________________________________//
+void SCRegressor::branchesMvPt ( TTree* tree, edm::Service<TFileService> &fs )
+{
+
+  hMvPt = fs->make<TH2F>("mvpt", "N(m_{0},p_{T});m_{0};p_{T}",
+      mvptCfg_.getParameter<int>("nBinsM"),  mvptCfg_.getParameter<double>("mMin"),  mvptCfg_.getParameter<double>("mMax"),
+      mvptCfg_.getParameter<int>("nBinsPt"), mvptCfg_.getParameter<double>("ptMin"), mvptCfg_.getParameter<double>("ptMax") );
+  mvptMinPt_ = mvptCfg_.getParameter<double>("minPt");
+  mvptMaxDR_ = mvptCfg_.getParameter<double>("maxDR");
+
+} // branchesMvPt()
+
+// Fill (m0,pT) occupancy __________________________________________________//
+void SCRegressor::fillMvPt ( const edm::Event& iEvent, const edm::EventSetup& iSetup )
+{
+
+  for ( unsigned int iSC = 0; iSC < vSC_mass_.size(); iSC++ ) {
+    if ( vSC_pT_[iSC] < mvptMinPt_ ) continue;
+    if ( vSC_DR_[iSC] > mvptMaxDR_ ) continue;
+    hMvPt->Fill( vSC_mass_[iSC], vSC_pT_[iSC] );
+  }
+
+} // fillMvPt()
@@ -160,31 +160,13 @@ bool SCRegressor::runDiPhotonSel ( const edm::Event& iEvent, const edm::EventSet
   edm::Handle<edm::TriggerResults> trgs;
   iEvent.getByToken( trgResultsT_, trgs );
 
-  const edm::TriggerNames &triggerNames = iEvent.triggerNames( *trgs );
-  if ( debug ) std::cout << " N triggers:" << trgs->size() << std::endl;
-  for ( unsigned int iT = 0; iT < trgs->size(); iT++ ) {
-    if ( debug ) std::cout << " name["<<iT<<"]:"<<triggerNames.triggerName(iT)<< std::endl;
+  // Path indices are only re-resolved when the trigger menu changes
+  hltSelector_.setMenu( iEvent.triggerNames( *trgs ) );
+  if ( debug ) {
+    std::cout << " N matches: " << hltSelector_.matchedPaths().size() << std::endl;
+    for ( auto const& path : hltSelector_.matchedPaths() ) std::cout << " name: " << path << std::endl;
   }
-
-  int hltAccept = -1;
-  //std::string trgName = "HLT_Diphoton30PV_18PV_R9Id_AND_IsoCaloId_AND_HE_R9Id_PixelVeto_Mass55_v*";
-  std::string trgName = "HLT_Diphoton30PV_18PV_R9Id_AND_IsoCaloId_AND_HE_R9Id_*_Mass55_v*";
-  std::vector< std::vector<std::string>::const_iterator > trgMatches = edm::regexMatch( triggerNames.triggerNames(), trgName );
-  if ( debug ) std::cout << " N matches: " << trgMatches.size() << std::endl;
-
-  if ( !trgMatches.empty() ) {
-    //std::vector<std::string>  HLTPathsByName_;
-    //std::vector<unsigned int> HLTPathsByIndex_;
-    hltAccept = 0;
-    for ( auto const& iT : trgMatches ) {
-      if ( debug ) std::cout << " name["<<triggerNames.triggerIndex(*iT)<<"]:"<< *iT << " -> " << trgs->accept(triggerNames.triggerIndex(*iT)) << std::endl;
-      //HLTPathsByName_.push_back( *iT );
-      //HLTPathsByIndex_.push_back( triggerNames.triggerIndex(*iT) );
-      if ( trgs->accept(triggerNames.triggerIndex(*iT)) ) hltAccept = 1;
-      break;
-    }
-  }
-  hltAccept_ = hltAccept;
+  hltAccept_ = hltSelector_.acceptAny( *trgs );
   /*
   // Ensure trigger acceptance
   hNpassed_hlt->Fill(0.);
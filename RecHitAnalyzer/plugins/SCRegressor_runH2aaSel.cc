@@ -73,23 +73,8 @@ bool SCRegressor::runH2aaSel ( const edm::Event& iEvent, const edm::EventSetup&
   edm::Handle<edm::TriggerResults> trgs;
   iEvent.getByToken( trgResultsT_, trgs );
 
-  const edm::TriggerNames &triggerNames = iEvent.triggerNames( *trgs );
-  //std::cout << ">> N triggers:" << trgs->size() << std::endl;
-  for ( unsigned int iT = 0; iT < trgs->size(); iT++ ) {
-    //std::cout << " name["<<iT<<"]:"<<triggerNames.triggerName(iT)<< std::endl;
-  }
-
-  int hltAccept = -1;
-  std::string trgName = "HLT_Diphoton30PV_18PV_R9Id_AND_IsoCaloId_AND_HE_R9Id_*_Mass55_v*";
-  std::vector< std::vector<std::string>::const_iterator > trgMatches = edm::regexMatch( triggerNames.triggerNames(), trgName );
-
-  if ( !trgMatches.empty() ) {
-    hltAccept = 0;
-    for ( auto const& iT : trgMatches ) {
-      if ( trgs->accept(triggerNames.triggerIndex(*iT)) ) hltAccept = 1;
-    }
-  }
-  hltAccept_ = hltAccept;
+  hltSelector_.setMenu( iEvent.triggerNames( *trgs ) );
+  hltAccept_ = hltSelector_.acceptAny( *trgs );
   */
 
   return true;
@@ -14,24 +14,59 @@ options.register('processMode',
     mult=VarParsing.VarParsing.multiplicity.singleton,
     mytype=VarParsing.VarParsing.varType.string,
     info = "process mode: JetLevel or EventLevel")
+options.register('geometrySnapshot', 
+    default='', 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.string,
+    info = "calorimeter geometry snapshot file: if set, geometry DB and GlobalTag are not loaded")
+options.register('selectionOnly', 
+    default=False, 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.bool,
+    info = "only run the event selection and write the accepted events to eventList")
+options.register('eventList', 
+    default='', 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.string,
+    info = "event list: written with selectionOnly, else only the listed events are processed")
+options.register('nThreads', 
+    default=1, 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.int,
+    info = "framework threads, also used by the parallel image fills (parallelFills)")
+options.register('parallelFills', 
+    default=False, 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.bool,
+    info = "run the image fills of an event as parallel tasks on the framework threads")
+options.register('detectorImages', 
+    default=False, 
+    mult=VarParsing.VarParsing.multiplicity.singleton,
+    mytype=VarParsing.VarParsing.varType.bool,
+    info = "build the calorimeter images once with DetectorImageProducer and read them from its product")
 options.parseArguments()
 
 process = cms.Process("FEVTAnalyzer")
 process.load("FWCore.MessageService.MessageLogger_cfi")
-process.load("Configuration.StandardSequences.GeometryDB_cff")
-process.load("Configuration.StandardSequences.FrontierConditions_GlobalTag_cff")
-#process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_condDBv2_cff')
-#process.load("Configuration.StandardSequences.GeometryRecoDB_cff")
-#process.load("Geometry.CMSCommonData.cmsIdealGeometryXML_cfi");
-#process.load("Geometry.CaloEventSetup.CaloGeometry_cfi");
-#process.load("Geometry.CaloEventSetup.CaloTopology_cfi");
-process.GlobalTag.globaltag = cms.string('80X_dataRun2_HLT_v12')
-process.es_prefer_GlobalTag = cms.ESPrefer('PoolDBESSource','GlobalTag')
+if options.geometrySnapshot == '':
+  process.load("Configuration.StandardSequences.GeometryDB_cff")
+  process.load("Configuration.StandardSequences.FrontierConditions_GlobalTag_cff")
+  #process.load('Configuration.StandardSequences.FrontierConditions_GlobalTag_condDBv2_cff')
+  #process.load("Configuration.StandardSequences.GeometryRecoDB_cff")
+  #process.load("Geometry.CMSCommonData.cmsIdealGeometryXML_cfi");
+  #process.load("Geometry.CaloEventSetup.CaloGeometry_cfi");
+  #process.load("Geometry.CaloEventSetup.CaloTopology_cfi");
+  process.GlobalTag.globaltag = cms.string('80X_dataRun2_HLT_v12')
+  process.es_prefer_GlobalTag = cms.ESPrefer('PoolDBESSource','GlobalTag')
 
 process.maxEvents = cms.untracked.PSet( 
     input = cms.untracked.int32(options.maxEvents) 
     )
 
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.nThreads)
+    )
+
 process.source = cms.Source("PoolSource",
     fileNames = cms.untracked.vstring(
       options.inputFiles
@@ -40,11 +75,28 @@ process.source = cms.Source("PoolSource",
     )
 print " >> Loaded",len(options.inputFiles),"input files from list."
 
+# Image pass of the two-pass workflow: only read the selected events
+if options.eventList != '' and not options.selectionOnly:
+  selectedEvents = []
+  for line in open(options.eventList):
+    if line.startswith('#') or not line.strip(): continue
+    run, lumi, event = line.split()[:3]
+    selectedEvents.append('%s:%s:%s'%(run, lumi, event))
+  process.source.eventsToProcess = cms.untracked.VEventRange(selectedEvents)
+  print " >> Processing",len(selectedEvents),"events from list",options.eventList
+
 
 
 
 process.load("MLAnalyzer.RecHitAnalyzer.RHAnalyzer_cfi")
 process.fevt.mode = cms.string(options.processMode)
+if options.geometrySnapshot != '':
+  process.fevt.geometrySnapshot = cms.string(options.geometrySnapshot)
+  print " >> Using geometry snapshot:",options.geometrySnapshot
+process.fevt.selectionOnly = cms.bool(options.selectionOnly)
+process.fevt.parallelFills = cms.bool(options.parallelFills)
+if options.eventList != '':
+  process.fevt.eventList = cms.string(options.eventList)
 #process.fevt.mode = cms.string("JetLevel") # for when using crab
 #process.fevt.mode = cms.string("EventLevel") # for when using crab
 print " >> Processing as:",(process.fevt.mode)
@@ -55,6 +107,12 @@ process.TFileService = cms.Service("TFileService",
     )
 
 #process.SimpleMemoryCheck = cms.Service( "SimpleMemoryCheck", ignoreTotal = cms.untracked.int32(1) )
-process.p = cms.Path(process.fevt)
+if options.detectorImages:
+  process.load("MLAnalyzer.RecHitAnalyzer.DetectorImageProducer_cfi")
+  process.fevt.detectorImages = cms.InputTag('detectorImages')
+  process.detectorImages.geometrySnapshot = process.fevt.geometrySnapshot
+  process.p = cms.Path(process.detectorImages + process.fevt)
+else:
+  process.p = cms.Path(process.fevt)
 
 
@@ -0,0 +1,12 @@
+import FWCore.ParameterSet.Config as cms 
+
+# Calorimeter images as an img::DetectorImage product, read by
+# RecHitAnalyzer, SCRegressor and SCAnalyzer with detectorImages = 'detectorImages'.
+# To keep them in a skim: outputCommands.append('keep img::DetectorImage_*_*_*')
+detectorImages = cms.EDProducer('DetectorImageProducer'
+    , reducedEBRecHitCollection = cms.InputTag('reducedEcalRecHitsEB')
+    , reducedEERecHitCollection = cms.InputTag('reducedEcalRecHitsEE')
+    , reducedHBHERecHitCollection = cms.InputTag('reducedHcalRecHits:hbhereco')
+    # GeometrySnapshotDumper output for the EE cell centers, as RecHitAnalyzer
+    , geometrySnapshot = cms.string("")
+    )
@@ -0,0 +1,25 @@
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+
+# Write the calorimeter geometry snapshot used by RecHitAnalyzer (geometrySnapshot=...)
+# Must use the same geometry and GlobalTag as ConfFile_cfg.py
+options = VarParsing.VarParsing('analysis')
+options.setDefault('outputFile', 'geometrySnapshot.bin')
+options.parseArguments()
+
+process = cms.Process("GeometrySnapshot")
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.load("Configuration.StandardSequences.GeometryDB_cff")
+process.load("Configuration.StandardSequences.MagneticField_cff")
+process.load("Configuration.StandardSequences.FrontierConditions_GlobalTag_cff")
+process.GlobalTag.globaltag = cms.string('80X_dataRun2_HLT_v12')
+process.es_prefer_GlobalTag = cms.ESPrefer('PoolDBESSource','GlobalTag')
+
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(1) )
+process.source = cms.Source("EmptySource")
+
+process.dumpGeometry = cms.EDAnalyzer('GeometrySnapshotDumper'
+    , outputFile = cms.string(options.outputFile)
+    )
+
+process.p = cms.Path(process.dumpGeometry)
@@ -8,7 +8,6 @@ fevt = cms.EDAnalyzer('RecHitAnalyzer'
     , reducedEBRecHitCollection = cms.InputTag('reducedEcalRecHitsEB')
     #, EERecHitCollection = cms.InputTag('ecalRecHit:EcalRecHitsEE')
     , reducedEERecHitCollection = cms.InputTag('reducedEcalRecHitsEE')
-    #, EBDigiCollection = cms.InputTag('simEcalDigis:ebDigis')
     #, selectedEBDigiCollection = cms.InputTag('selectDigi:selectedEcalEBDigiCollection')
     , reducedHBHERecHitCollection = cms.InputTag('reducedHcalRecHits:hbhereco')
     , genParticleCollection = cms.InputTag('genParticles')
@@ -24,6 +23,91 @@ fevt = cms.EDAnalyzer('RecHitAnalyzer'
     , jetTagCollection    = cms.InputTag("pfCombinedInclusiveSecondaryVertexV2BJetTags")
     , ipTagInfoCollection = cms.InputTag("pfImpactParameterTagInfos")
     , mode = cms.string("JetLevel")
+    # Require any of these HLT paths (wildcards allowed), none if empty
+    , trgResults = cms.InputTag("TriggerResults","","HLT")
+    , hltPaths = cms.vstring()
+    # Calorimeter geometry snapshot from GeometrySnapshotDumper.
+    # If set, the geometry DB/GlobalTag are not needed.
+    , geometrySnapshot = cms.string("")
+    # Two-pass workflow: with selectionOnly, only run the event
+    # selection and write the accepted events to eventList.
+    # Otherwise, if eventList is set, only the listed events are imaged.
+    , selectionOnly = cms.bool(False)
+    # Extra up/downsampled image branches <channel>_down<factor> or
+    # <channel>_up<factor>, e.g.
+    # cms.PSet(channel = cms.string("ECAL_energy"), factor = cms.int32(5), upsample = cms.bool(False))
+    , imagePyramid = cms.VPSet()
+    # Output: dense images and/or a flat hit list (hits_* branches) for
+    # point-cloud models. With hitListJetDR > 0 in JetLevel mode, only
+    # hits within that dR of a selected jet are kept.
+    , writeImages = cms.bool(True)
+    , writeHits = cms.bool(False)
+    , hitListJetDR = cms.double(-1.)
+    # Tracker hits per layer at EB/EE: TRKlayers_key/_value sparse tensor.
+    # Needs the track rechits, which are not in AOD.
+    , doTRKlayers = cms.bool(False)
+    # EB digis: EB_adc, the 10 samples minus the mean of the 3 presamples,
+    # cropped 32x32 around the crystal with the largest ebDigiSeedSample.
+    # As (sample,ieta,iphi) with ebDigiLayout "sampleMajor", or
+    # (ieta,iphi,sample) with "crystalMajor". Needs the digis, e.g.
+    # 'selectDigi:selectedEcalEBDigiCollection' in RECO
+    , doEBdigis = cms.bool(False)
+    , EBDigiCollection = cms.InputTag('simEcalDigis:ebDigis')
+    , ebDigiLayout = cms.string("sampleMajor")
+    , ebDigiSeedSample = cms.int32(6)
+    # Run the independent image/hit list fills of an event as parallel
+    # tasks on the framework threads (process.options.numberOfThreads).
+    # Opt-in: the fills write disjoint branches, but the serial fills
+    # remain the reference for production output
+    , parallelFills = cms.bool(False)
+    # Read the EB, HBHE and ECAL stitched images from a DetectorImage
+    # product (DetectorImageProducer_cfi, or kept in a skim) instead of
+    # building them from the rechits, e.g. cms.InputTag('detectorImages').
+    # Empty: build them here
+    , detectorImages = cms.InputTag('')
+    # Fill RHTree on a writer thread: the event loop copies each entry
+    # into a queue of this many entries (blocking when full) and the
+    # writer serializes and compresses them, in order. 0: synchronous.
+    # The writer thread writes baskets to the TFileService file outside
+    # the framework's TFileService serialization: only enable it when
+    # this module is the only one writing to that file
+    , asyncOutputQueue = cms.int32(0)
+    # In-situ inference: with a modelPath (local ONNX file), stack
+    # 'channels' (image branches or pyramid levels) into the model input,
+    # cropSize x cropSize around each jet seed in JetLevel mode (stitched
+    # ECAL/HBHE layouts only) or full images in EventLevel mode, NCHW
+    # unless channelsLast. Batches of batchSize jets/events are scored
+    # with nThreads CPU threads and only the outputs are written, to the
+    # Scores tree; RHTree stays empty. Empty modelPath: no inference.
+    # HBHE_energy_up5 needs that imagePyramid level
+    , inference = cms.PSet(
+        modelPath = cms.string(''),
+        inputName = cms.string('input'),
+        outputNames = cms.vstring(), # all outputs if empty
+        channels = cms.vstring('ECAL_tracksPt', 'ECAL_energy', 'HBHE_energy_up5'),
+        cropSize = cms.int32(125),
+        channelsLast = cms.bool(False),
+        batchSize = cms.int32(64),
+        nThreads = cms.int32(1)
+        )
+    # Per-channel pixel statistics of the images, written at the end
+    # of the job to the ChannelStats tree, see merge_ChannelStats.py
+    , channelStats = cms.bool(False)
+    # Deterministic prescale of the selected events (x,y = m0,pT of the
+    # diphoton) or, in JetLevel mode, jets (x,y = pT,|eta|): keep with
+    # probability keepProb[iX*nY+iY], 1 outside the edges. Kept ones get
+    # evtWeight / jetWeight = 1/p. With nJets > 0, jet events are kept
+    # or dropped whole, by their leading jet. Empty edges: no prescale.
+    , prescale = cms.PSet(
+        xEdges = cms.vdouble(),
+        yEdges = cms.vdouble(),
+        keepProb = cms.vdouble(),
+        seed = cms.uint32(0)
+        )
+    , eventList = cms.string("")
+    # Sorted (run,lumi,event,jet) -> RHTree entry index of the output,
+    # written next to it as <output>.idx, see event_index.py
+    , writeEventIndex = cms.bool(True)
 
     # Jet level cfg
     , nJets = cms.int32(-1)
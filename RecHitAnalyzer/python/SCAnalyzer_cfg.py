@@ -55,6 +55,8 @@ process.fevt = cms.EDAnalyzer('SCAnalyzer'
     , reducedEBRecHitCollection = cms.InputTag('reducedEcalRecHitsEB')
     , genParticleCollection = cms.InputTag('genParticles')
     , genJetCollection = cms.InputTag('ak4GenJets')
+    # Full EB image from a DetectorImage product (zero suppressed), '' to build it here
+    , detectorImages = cms.InputTag('')
     )
 
 process.TFileService = cms.Service("TFileService",
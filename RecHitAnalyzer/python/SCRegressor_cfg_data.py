@@ -78,8 +78,17 @@ process.fevt = cms.EDAnalyzer('SCRegressor'
     , trackCollection = cms.InputTag("generalTracks")
     , rhoLabel = cms.InputTag("fixedGridRhoFastjetAll")
     , trgResults = cms.InputTag("TriggerResults","","HLT")
+    , hltPaths = cms.vstring('HLT_Diphoton30PV_18PV_R9Id_AND_IsoCaloId_AND_HE_R9Id_*_Mass55_v*')
     , generator = cms.InputTag("generator")
     , lhe = cms.InputTag("lhe")
+    # Read EB_energy/EB_time from a DetectorImage product instead of the rechits, '' to build them here
+    , detectorImages = cms.InputTag('')
+    # (m0,pT) occupancy of the stored SCs, for make_mvpt_friend.py
+    , mvptHist = cms.PSet(
+        nBinsM = cms.int32(16), mMin = cms.double(0.), mMax = cms.double(1.6),
+        nBinsPt = cms.int32(20), ptMin = cms.double(20.), ptMax = cms.double(100.),
+        minPt = cms.double(20.), maxDR = cms.double(10*0.0174)
+        )
     )
 
 process.TFileService = cms.Service("TFileService",
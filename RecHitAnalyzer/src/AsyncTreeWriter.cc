@@ -0,0 +1,223 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/AsyncTreeWriter.h"
+
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TLeaf.h"
+#include "TClass.h"
+#include "TBufferFile.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace img {
+
+  template <typename T>
+  static void copyObject ( TClass*, const void* from, void* to ) {
+    *static_cast<T*>( to ) = *static_cast<const T*>( from );
+  }
+
+  // Any other class: through its streamer, uncompressed
+  static void copyStreamed ( TClass* cl, const void* from, void* to ) {
+    TBufferFile buffer( TBuffer::kWrite );
+    cl->Streamer( const_cast<void*>( from ), buffer );
+    buffer.SetReadMode();
+    buffer.SetBufferOffset( 0 );
+    cl->Streamer( to, buffer );
+  }
+
+  static AsyncTreeWriter::CopyFn findCopy ( TClass* cl );
+
+  // Only reached running if the job failed before stop(): the tree
+  // may be gone already, so just drain the queue and leave it alone
+  AsyncTreeWriter::~AsyncTreeWriter () {
+    if ( !running() ) return;
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      stopping_ = true;
+      queue_.clear();
+    }
+    queued_.notify_one();
+    thread_.join();
+    release();
+  }
+
+  void AsyncTreeWriter::start ( TTree* tree, int queueSize ) {
+
+    if ( running() ) throw std::runtime_error( "AsyncTreeWriter: already started" );
+    if ( queueSize < 1 ) throw std::runtime_error( "AsyncTreeWriter: queue size must be >= 1" );
+
+    columns_.clear();
+    TObjArray* branches = tree->GetListOfBranches();
+    for ( int iB = 0; iB < branches->GetEntriesFast(); iB++ ) {
+      TBranch* branch = static_cast<TBranch*>( branches->UncheckedAt( iB ) );
+      std::string name = branch->GetName();
+      if ( branch->GetListOfBranches()->GetEntriesFast() > 0 ) {
+        throw std::runtime_error( "AsyncTreeWriter: split branch " + name + " not supported" );
+      }
+      Column column = Column();
+      column.branch = branch;
+      if ( branch->InheritsFrom( TBranchElement::Class() ) ) {
+        TBranchElement* element = static_cast<TBranchElement*>( branch );
+        column.cl = TClass::GetClass( element->GetClassName() );
+        column.live = element->GetObject();
+        if ( !column.cl || !column.live ) {
+          throw std::runtime_error( "AsyncTreeWriter: no object for branch " + name );
+        }
+        column.copy = findCopy( column.cl );
+      } else {
+        TObjArray* leaves = branch->GetListOfLeaves();
+        TLeaf* leaf = leaves->GetEntriesFast() == 1 ? static_cast<TLeaf*>( leaves->UncheckedAt( 0 ) ) : nullptr;
+        if ( !leaf || leaf->GetLeafCount() ) {
+          throw std::runtime_error( "AsyncTreeWriter: branch " + name + " is not a single fixed-size leaf" );
+        }
+        column.nBytes = leaf->GetLenType()*leaf->GetLenStatic();
+        column.live = branch->GetAddress();
+        if ( !column.live ) throw std::runtime_error( "AsyncTreeWriter: no address for branch " + name );
+      }
+      columns_.push_back( column );
+    }
+
+    slots_.assign( queueSize+1, std::vector<void*>() );
+    free_.clear();
+    for ( unsigned int iS = 0; iS < slots_.size(); iS++ ) {
+      for ( const Column& column : columns_ ) {
+        slots_[iS].push_back( column.cl ? column.cl->New() : new double[ ( column.nBytes+7 )/8 ] );
+      }
+      free_.push_back( iS );
+    }
+
+    tree_ = tree;
+    queue_.clear();
+    stopping_ = false;
+    error_ = nullptr;
+    nPushed_ = 0;
+    nWaits_ = 0;
+    thread_ = std::thread( &AsyncTreeWriter::run, this );
+
+  } // start()
+
+  void AsyncTreeWriter::push () {
+
+    int iS;
+    {
+      std::unique_lock<std::mutex> lock( mutex_ );
+      if ( free_.empty() && !error_ ) {
+        nWaits_++;
+        freed_.wait( lock, [this] { return !free_.empty() || error_; } );
+      }
+      if ( error_ ) std::rethrow_exception( error_ );
+      iS = free_.back();
+      free_.pop_back();
+    }
+
+    // The slot is ours until queued
+    std::vector<void*>& objects = slots_[iS];
+    for ( unsigned int iC = 0; iC < columns_.size(); iC++ ) {
+      const Column& column = columns_[iC];
+      if ( column.cl ) {
+        column.copy( column.cl, column.live, objects[iC] );
+      } else {
+        std::memcpy( objects[iC], column.live, column.nBytes );
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      queue_.push_back( iS );
+    }
+    queued_.notify_one();
+    nPushed_++;
+
+  } // push()
+
+  void AsyncTreeWriter::run () {
+
+    while ( true ) {
+      int iS;
+      {
+        std::unique_lock<std::mutex> lock( mutex_ );
+        queued_.wait( lock, [this] { return !queue_.empty() || stopping_; } );
+        if ( queue_.empty() ) return;
+        iS = queue_.front();
+        queue_.pop_front();
+      }
+      try {
+        bind( slots_[iS] );
+        if ( tree_->Fill() < 0 ) throw std::runtime_error( "AsyncTreeWriter: TTree::Fill failed" );
+      } catch ( ... ) {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        error_ = std::current_exception();
+        freed_.notify_all();
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        free_.push_back( iS );
+      }
+      freed_.notify_one();
+    }
+
+  } // run()
+
+  void AsyncTreeWriter::bind ( const std::vector<void*>& objects ) {
+    for ( unsigned int iC = 0; iC < columns_.size(); iC++ ) {
+      const Column& column = columns_[iC];
+      if ( column.cl ) {
+        static_cast<TBranchElement*>( column.branch )->SetObject( objects[iC] );
+      } else {
+        column.branch->SetAddress( objects[iC] );
+      }
+    }
+  }
+
+  void AsyncTreeWriter::stop () {
+
+    if ( !running() ) return;
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      stopping_ = true;
+    }
+    queued_.notify_one();
+    thread_.join();
+
+    std::vector<void*> live;
+    for ( const Column& column : columns_ ) live.push_back( column.live );
+    bind( live );
+    release();
+    tree_ = nullptr;
+    if ( error_ ) std::rethrow_exception( error_ );
+
+  } // stop()
+
+  void AsyncTreeWriter::release () {
+    for ( std::vector<void*>& objects : slots_ ) {
+      for ( unsigned int iC = 0; iC < columns_.size(); iC++ ) {
+        if ( columns_[iC].cl ) {
+          columns_[iC].cl->Destructor( objects[iC] );
+        } else {
+          delete[] static_cast<double*>( objects[iC] );
+        }
+      }
+    }
+    slots_.clear();
+  }
+
+  // Plain assignment for the branch types of the image trees
+  static AsyncTreeWriter::CopyFn findCopy ( TClass* cl ) {
+    static const std::vector<std::pair<TClass*, AsyncTreeWriter::CopyFn>> known = {
+      { TClass::GetClass<std::vector<float>>(),                 &copyObject<std::vector<float>> },
+      { TClass::GetClass<std::vector<double>>(),                &copyObject<std::vector<double>> },
+      { TClass::GetClass<std::vector<int>>(),                   &copyObject<std::vector<int>> },
+      { TClass::GetClass<std::vector<unsigned int>>(),          &copyObject<std::vector<unsigned int>> },
+      { TClass::GetClass<std::vector<std::vector<float>>>(),    &copyObject<std::vector<std::vector<float>>> },
+      { TClass::GetClass<std::vector<std::vector<int>>>(),      &copyObject<std::vector<std::vector<int>>> }
+    };
+    for ( const auto& entry : known ) {
+      if ( entry.first == cl ) return entry.second;
+    }
+    return &copyStreamed;
+  }
+
+} // namespace img
@@ -0,0 +1,105 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ChannelStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace img {
+
+  static const double LOG_GAMMA = std::log( ( 1.+QuantileSketch::ALPHA )/( 1.-QuantileSketch::ALPHA ) );
+
+  int QuantileSketch::bucket ( double absV ) {
+    int idx = int( std::ceil( std::log( absV )/LOG_GAMMA ) );
+    return std::min( std::max( idx, IDX_MIN ), IDX_MAX );
+  }
+
+  // Value of a bucket, relative error <= ALPHA to all its entries
+  double QuantileSketch::bucketValue ( int idx ) {
+    return 2.*std::exp( idx*LOG_GAMMA )/( 1.+std::exp( LOG_GAMMA ) );
+  }
+
+  void QuantileSketch::add ( float v ) {
+    if ( v > 0. ) pos_[ bucket( v )-IDX_MIN ]++;
+    else if ( v < 0. ) neg_[ bucket( -v )-IDX_MIN ]++;
+    else nZero_++;
+  }
+
+  void QuantileSketch::merge ( const QuantileSketch& other ) {
+    for ( int i = 0; i < NBUCKETS; i++ ) {
+      pos_[i] += other.pos_[i];
+      neg_[i] += other.neg_[i];
+    }
+    nZero_ += other.nZero_;
+  }
+
+  long long QuantileSketch::count () const {
+    long long n = nZero_;
+    for ( int i = 0; i < NBUCKETS; i++ ) n += pos_[i] + neg_[i];
+    return n;
+  }
+
+  double QuantileSketch::quantile ( double q ) const {
+
+    long long n = count();
+    if ( n == 0 ) return 0.;
+    long long rank = std::min( (long long)( q*( n-1 ) ), n-1 );
+
+    // Ascending: most negative first, then zeros, then positive
+    long long seen = 0;
+    for ( int i = NBUCKETS-1; i >= 0; i-- ) {
+      seen += neg_[i];
+      if ( seen > rank ) return -bucketValue( i+IDX_MIN );
+    }
+    seen += nZero_;
+    if ( seen > rank ) return 0.;
+    for ( int i = 0; i < NBUCKETS; i++ ) {
+      seen += pos_[i];
+      if ( seen > rank ) return bucketValue( i+IDX_MIN );
+    }
+    return bucketValue( IDX_MAX );
+
+  } // quantile()
+
+  void ChannelStats::add ( float v ) {
+    if ( count == 0 ) min = max = v;
+    min = std::min( min, v );
+    max = std::max( max, v );
+    count++;
+    if ( v != 0. ) nNonZero++;
+    double delta = v - mean;
+    mean += delta/count;
+    m2 += delta*( v - mean );
+    sketch.add( v );
+  }
+
+  void ChannelStats::addZeros ( long long n ) {
+    if ( n <= 0 ) return;
+    if ( count == 0 ) min = max = 0.;
+    min = std::min( min, 0.f );
+    max = std::max( max, 0.f );
+    // merge() with a block of n zeros: mean 0, m2 0
+    long long N = count + n;
+    m2 += mean*mean*( double( count )*n/N );
+    mean *= double( count )/N;
+    count = N;
+    sketch.addZeros( n );
+  }
+
+  void ChannelStats::merge ( const ChannelStats& other ) {
+    if ( other.count == 0 ) return;
+    if ( count == 0 ) {
+      min = other.min;
+      max = other.max;
+    } else {
+      min = std::min( min, other.min );
+      max = std::max( max, other.max );
+    }
+    long long n = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta*other.count/n;
+    m2 += other.m2 + delta*delta*( double( count )*other.count/n );
+    count = n;
+    nNonZero += other.nNonZero;
+    sketch.merge( other.sketch );
+  }
+
+} // namespace img
@@ -0,0 +1,100 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace img {
+
+  DetectorImageChannel& DetectorImage::newChannel ( const std::string& name, int nRows, int nCols ) {
+    if ( find( name ) ) throw std::runtime_error( "DetectorImage: duplicate channel " + name );
+    channels_.emplace_back();
+    DetectorImageChannel& channel = channels_.back();
+    channel.name = name;
+    channel.nRows = nRows;
+    channel.nCols = nCols;
+    return channel;
+  }
+
+  void DetectorImage::add ( const std::string& name, const ImageBuffer& image, int nRows, int nCols ) {
+
+    if ( image.size() != nRows*nCols ) throw std::runtime_error( "DetectorImage: wrong size for channel " + name );
+    DetectorImageChannel& channel = newChannel( name, nRows, nCols );
+
+    // Non-zero pixels can only be in the dirty tiles
+    std::vector<int> tiles( image.dirtyTiles() );
+    std::sort( tiles.begin(), tiles.end() );
+    for ( int iT : tiles ) {
+      int end = std::min( ( iT+1 )*ImageBuffer::TILE_SIZE, image.size() );
+      for ( int idx = iT*ImageBuffer::TILE_SIZE; idx < end; idx++ ) {
+        if ( image.get(idx) == 0. ) continue;
+        channel.index.push_back( idx );
+        channel.value.push_back( image.get(idx) );
+      }
+    }
+
+    if ( 2*channel.index.size() < image.pixels().size() ) {
+      channel.sparse = true;
+    } else {
+      channel.index.clear();
+      channel.value = image.pixels();
+    }
+
+  } // add()
+
+  void DetectorImage::add ( const std::string& name, const std::vector<float>& image, int nRows, int nCols ) {
+
+    if ( int( image.size() ) != nRows*nCols ) throw std::runtime_error( "DetectorImage: wrong size for channel " + name );
+    DetectorImageChannel& channel = newChannel( name, nRows, nCols );
+
+    size_t nNonZero = image.size() - std::count( image.begin(), image.end(), 0.f );
+    channel.sparse = 2*nNonZero < image.size();
+    if ( !channel.sparse ) {
+      channel.value = image;
+      return;
+    }
+    channel.index.reserve( nNonZero );
+    channel.value.reserve( nNonZero );
+    for ( unsigned int idx = 0; idx < image.size(); idx++ ) {
+      if ( image[idx] == 0. ) continue;
+      channel.index.push_back( idx );
+      channel.value.push_back( image[idx] );
+    }
+
+  } // add()
+
+  const DetectorImageChannel* DetectorImage::find ( const std::string& name ) const {
+    for ( const DetectorImageChannel& channel : channels_ ) {
+      if ( channel.name == name ) return &channel;
+    }
+    return nullptr;
+  }
+
+  const DetectorImageChannel& DetectorImage::get ( const std::string& name ) const {
+    const DetectorImageChannel* channel = find( name );
+    if ( !channel ) throw std::runtime_error( "DetectorImage: no channel " + name );
+    return *channel;
+  }
+
+  void DetectorImage::decode ( const std::string& name, ImageBuffer& image ) const {
+    const DetectorImageChannel& channel = get( name );
+    image.reset( channel.nRows*channel.nCols );
+    if ( channel.sparse ) {
+      for ( size_t i = 0; i < channel.index.size(); i++ ) image[ channel.index[i] ] = channel.value[i];
+    } else {
+      for ( size_t idx = 0; idx < channel.value.size(); idx++ ) {
+        if ( channel.value[idx] != 0. ) image[idx] = channel.value[idx];
+      }
+    }
+  }
+
+  void DetectorImage::decode ( const std::string& name, std::vector<float>& image ) const {
+    const DetectorImageChannel& channel = get( name );
+    if ( !channel.sparse ) {
+      image = channel.value;
+      return;
+    }
+    image.assign( channel.nRows*channel.nCols, 0. );
+    for ( size_t i = 0; i < channel.index.size(); i++ ) image[ channel.index[i] ] = channel.value[i];
+  }
+
+} // namespace img
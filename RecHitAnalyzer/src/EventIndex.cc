@@ -0,0 +1,187 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+namespace img {
+
+  static const char MAGIC[8] = { 'I', 'M', 'G', 'I', 'D', 'X', '0', '1' };
+  static const uint32_t VERSION = 1;
+
+  struct Footer {
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t nRecords;
+    uint64_t nameLength;
+    IndexKey minKey;
+    IndexKey maxKey;
+  };
+  static_assert( sizeof( IndexKey ) == 24, "IndexKey layout" );
+  static_assert( sizeof( IndexRecord ) == 40, "IndexRecord layout" );
+  static_assert( sizeof( Footer ) == 80, "Footer layout" );
+
+  bool operator< ( const IndexKey& a, const IndexKey& b ) {
+    return std::tie( a.run, a.lumi, a.event, a.jet ) < std::tie( b.run, b.lumi, b.event, b.jet );
+  }
+
+  void EventIndexWriter::add ( unsigned int run, unsigned int lumi, unsigned long long event, int jet,
+                               long long entry, long long offset ) {
+    IndexRecord record;
+    record.key = IndexKey{ run, lumi, event, jet };
+    record.entry = entry;
+    record.offset = offset;
+    records_.push_back( record );
+  }
+
+  void EventIndexWriter::write ( const std::string& indexFile, const std::string& dataFile ) {
+
+    std::sort( records_.begin(), records_.end(),
+        []( const IndexRecord& a, const IndexRecord& b ) { return a.key < b.key; } );
+
+    Footer footer = Footer();
+    std::memcpy( footer.magic, MAGIC, sizeof( MAGIC ) );
+    footer.version = VERSION;
+    footer.recordSize = sizeof( IndexRecord );
+    footer.nRecords = records_.size();
+    footer.nameLength = dataFile.size();
+    if ( !records_.empty() ) {
+      footer.minKey = records_.front().key;
+      footer.maxKey = records_.back().key;
+    }
+
+    std::ofstream out( indexFile, std::ios::binary );
+    if ( !out ) throw std::runtime_error( "EventIndex: cannot open " + indexFile + " for writing" );
+    if ( !records_.empty() ) {
+      out.write( reinterpret_cast<const char*>( records_.data() ), records_.size()*sizeof( IndexRecord ) );
+    }
+    out.write( dataFile.data(), dataFile.size() );
+    out.write( reinterpret_cast<const char*>( &footer ), sizeof( footer ) );
+    out.close();
+    if ( !out ) throw std::runtime_error( "EventIndex: failed writing " + indexFile );
+
+  } // write()
+
+  void EventIndexReader::open ( const std::string& indexFile ) {
+
+    std::ifstream in( indexFile, std::ios::binary );
+    if ( !in ) throw std::runtime_error( "EventIndex: cannot open " + indexFile );
+    in.seekg( 0, std::ios::end );
+    long long fileSize = in.tellg();
+
+    Footer footer;
+    if ( fileSize < (long long)sizeof( footer ) ) throw std::runtime_error( "EventIndex: not an index: " + indexFile );
+    in.seekg( fileSize - sizeof( footer ) );
+    in.read( reinterpret_cast<char*>( &footer ), sizeof( footer ) );
+    if ( !in || std::memcmp( footer.magic, MAGIC, sizeof( MAGIC ) ) != 0 ) {
+      throw std::runtime_error( "EventIndex: not an index: " + indexFile );
+    }
+    if ( footer.version != VERSION || footer.recordSize != sizeof( IndexRecord ) ) {
+      throw std::runtime_error( "EventIndex: unsupported version in " + indexFile );
+    }
+    if ( (long long)( footer.nRecords*sizeof( IndexRecord ) + footer.nameLength + sizeof( footer ) ) != fileSize ) {
+      throw std::runtime_error( "EventIndex: truncated index " + indexFile );
+    }
+
+    std::string name( footer.nameLength, '\0' );
+    in.seekg( footer.nRecords*sizeof( IndexRecord ) );
+    in.read( &name[0], name.size() );
+    if ( !in ) throw std::runtime_error( "EventIndex: truncated index " + indexFile );
+
+    indexFile_ = indexFile;
+    nRecords_ = footer.nRecords;
+    minKey_ = footer.minKey;
+    maxKey_ = footer.maxKey;
+    size_t slash = indexFile.rfind( '/' );
+    if ( name.empty() || name[0] == '/' || name.find( "://" ) != std::string::npos || slash == std::string::npos ) {
+      dataFile_ = name;
+    } else {
+      dataFile_ = indexFile.substr( 0, slash+1 ) + name;
+    }
+
+  } // open()
+
+  void EventIndexReader::scan ( const IndexKey& lo, const IndexKey& hi, std::vector<IndexRecord>& out ) const {
+
+    if ( nRecords_ == 0 || hi < lo || maxKey_ < lo || hi < minKey_ ) return;
+
+    std::ifstream in( indexFile_, std::ios::binary );
+    if ( !in ) throw std::runtime_error( "EventIndex: cannot open " + indexFile_ );
+    IndexRecord record;
+    auto readAt = [&]( uint64_t i ) {
+      in.seekg( i*sizeof( IndexRecord ) );
+      in.read( reinterpret_cast<char*>( &record ), sizeof( record ) );
+      if ( !in ) throw std::runtime_error( "EventIndex: read error in " + indexFile_ );
+    };
+
+    // First record >= lo
+    uint64_t first = 0, count = nRecords_;
+    while ( count > 0 ) {
+      uint64_t step = count/2;
+      readAt( first+step );
+      if ( record.key < lo ) {
+        first += step+1;
+        count -= step+1;
+      } else {
+        count = step;
+      }
+    }
+
+    // Then sequentially, in blocks
+    const uint64_t BLOCK = 256;
+    std::vector<IndexRecord> block;
+    in.seekg( first*sizeof( IndexRecord ) );
+    for ( uint64_t i = first; i < nRecords_; i += BLOCK ) {
+      block.resize( std::min( BLOCK, nRecords_-i ) );
+      in.read( reinterpret_cast<char*>( block.data() ), block.size()*sizeof( IndexRecord ) );
+      if ( !in ) throw std::runtime_error( "EventIndex: read error in " + indexFile_ );
+      for ( const IndexRecord& r : block ) {
+        if ( hi < r.key ) return;
+        out.push_back( r );
+      }
+    }
+
+  } // scan()
+
+  void EventIndexSet::add ( const std::string& indexFile ) {
+    EventIndexReader reader;
+    reader.open( indexFile );
+    readers_.push_back( reader );
+  }
+
+  std::vector<EventIndexSet::Hit> EventIndexSet::find ( unsigned int run, unsigned int lumi,
+                                                        unsigned long long event, int jet ) const {
+    IndexKey lo{ run, lumi, event, jet };
+    IndexKey hi = lo;
+    if ( jet < 0 ) {
+      lo.jet = INT32_MIN;
+      hi.jet = INT32_MAX;
+    }
+    return scan( lo, hi );
+  }
+
+  std::vector<EventIndexSet::Hit> EventIndexSet::scan ( const IndexKey& lo, const IndexKey& hi ) const {
+
+    std::vector<Hit> hits;
+    std::vector<IndexRecord> records;
+    for ( unsigned int iF = 0; iF < readers_.size(); iF++ ) {
+      records.clear();
+      readers_[iF].scan( lo, hi, records );
+      for ( const IndexRecord& r : records ) hits.push_back( Hit{ r, int( iF ) } );
+    }
+    std::sort( hits.begin(), hits.end(), []( const Hit& a, const Hit& b ) {
+      return a.record.key < b.record.key || ( !( b.record.key < a.record.key ) && a.file < b.file );
+    } );
+    return hits;
+
+  } // scan()
+
+  uint64_t EventIndexSet::size () const {
+    uint64_t n = 0;
+    for ( const EventIndexReader& reader : readers_ ) n += reader.size();
+    return n;
+  }
+
+} // namespace img
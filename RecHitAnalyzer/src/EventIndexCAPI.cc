@@ -0,0 +1,73 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventIndexCAPI.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventIndex.h"
+
+#include <stdexcept>
+#include <string>
+
+static thread_local std::string lastError;
+
+static int copyHits ( const std::vector<img::EventIndexSet::Hit>& found, img_index_hit* hits, int maxHits ) {
+  for ( int i = 0; i < int( found.size() ) && i < maxHits; i++ ) {
+    const img::IndexRecord& r = found[i].record;
+    hits[i] = img_index_hit{ r.key.run, r.key.lumi, r.key.event, r.key.jet, found[i].file, r.entry, r.offset };
+  }
+  return int( found.size() );
+}
+
+void* img_index_open ( const char** indexFiles, int nFiles ) {
+  img::EventIndexSet* index = new img::EventIndexSet;
+  try {
+    for ( int i = 0; i < nFiles; i++ ) index->add( indexFiles[i] );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    delete index;
+    return nullptr;
+  }
+  return index;
+}
+
+void img_index_close ( void* index ) {
+  delete static_cast<img::EventIndexSet*>( index );
+}
+
+int img_index_find ( void* index, unsigned int run, unsigned int lumi, unsigned long long event, int jet,
+                     img_index_hit* hits, int maxHits ) {
+  try {
+    return copyHits( static_cast<img::EventIndexSet*>( index )->find( run, lumi, event, jet ), hits, maxHits );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+}
+
+int img_index_scan ( void* index,
+                     unsigned int runLo, unsigned int lumiLo, unsigned long long eventLo, int jetLo,
+                     unsigned int runHi, unsigned int lumiHi, unsigned long long eventHi, int jetHi,
+                     img_index_hit* hits, int maxHits ) {
+  try {
+    img::IndexKey lo{ runLo, lumiLo, eventLo, jetLo };
+    img::IndexKey hi{ runHi, lumiHi, eventHi, jetHi };
+    return copyHits( static_cast<img::EventIndexSet*>( index )->scan( lo, hi ), hits, maxHits );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+}
+
+int img_index_nfiles ( void* index ) {
+  return static_cast<img::EventIndexSet*>( index )->nFiles();
+}
+
+long long img_index_size ( void* index ) {
+  return static_cast<img::EventIndexSet*>( index )->size();
+}
+
+const char* img_index_file ( void* index, int file ) {
+  img::EventIndexSet* set = static_cast<img::EventIndexSet*>( index );
+  if ( file < 0 || file >= int( set->nFiles() ) ) return nullptr;
+  return set->dataFile( file ).c_str();
+}
+
+const char* img_index_error () {
+  return lastError.c_str();
+}
@@ -0,0 +1,72 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/EventList.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace img {
+
+  static bool entryLess ( const EventList::Entry& a, const EventList::Entry& b ) {
+    return std::tie( a.run, a.lumi, a.event ) < std::tie( b.run, b.lumi, b.event );
+  }
+
+  void EventList::read ( const std::string& fileName ) {
+
+    std::ifstream in( fileName );
+    if ( !in ) throw std::runtime_error( "EventList: cannot open " + fileName );
+
+    entries_.clear();
+    std::string line;
+    int lineNo = 0;
+    while ( std::getline( in, line ) ) {
+      lineNo++;
+      if ( line.empty() || line[0] == '#' ) continue;
+      std::istringstream fields( line );
+      Entry entry;
+      int nJets = 0;
+      if ( !( fields >> entry.run >> entry.lumi >> entry.event >> nJets ) || nJets < 0 )
+        throw std::runtime_error( "EventList: bad line " + std::to_string( lineNo ) + " in " + fileName );
+      entry.jetIdxs.resize( nJets );
+      for ( int& idx : entry.jetIdxs ) {
+        if ( !( fields >> idx ) )
+          throw std::runtime_error( "EventList: bad line " + std::to_string( lineNo ) + " in " + fileName );
+      }
+      entries_.push_back( entry );
+    }
+    std::sort( entries_.begin(), entries_.end(), entryLess );
+
+  } // read()
+
+  const EventList::Entry* EventList::find ( unsigned int run, unsigned int lumi, unsigned long long event ) const {
+
+    Entry key{ run, lumi, event, {} };
+    auto it = std::lower_bound( entries_.begin(), entries_.end(), key, entryLess );
+    if ( it == entries_.end() || entryLess( key, *it ) ) return nullptr;
+    return &(*it);
+
+  } // find()
+
+  void EventList::open ( const std::string& fileName ) {
+
+    out_.open( fileName );
+    if ( !out_ ) throw std::runtime_error( "EventList: cannot open " + fileName + " for writing" );
+    out_ << "# run lumi event nJets jetIdxs..." << std::endl;
+
+  } // open()
+
+  void EventList::write ( unsigned int run, unsigned int lumi, unsigned long long event, const std::vector<int>& jetIdxs ) {
+
+    out_ << run << " " << lumi << " " << event << " " << jetIdxs.size();
+    for ( int idx : jetIdxs ) out_ << " " << idx;
+    out_ << "\n";
+
+  } // write()
+
+  void EventList::close () {
+
+    if ( out_.is_open() ) out_.close();
+
+  } // close()
+
+} // namespace img
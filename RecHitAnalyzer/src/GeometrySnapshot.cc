@@ -0,0 +1,263 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/GeometrySnapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace img {
+
+  static const char     SNAPSHOT_MAGIC[8] = { 'M','L','G','E','O','S','N','P' };
+  static const uint32_t SNAPSHOT_VERSION  = 2; // 2: EE boxes
+
+  static const int    EB_NIETA = 170;
+  static const int    EB_NIPHI = 360;
+  static const double PI       = 3.14159265358979323846;
+
+  // EE lookup grid in (x/|z|,y/|z|)
+  static const double EE_UV_MAX    = 0.6;
+  static const double EE_UV_BUCKET = 0.01;
+  static const int    EE_NBUCKETS  = int( 2*EE_UV_MAX/EE_UV_BUCKET ); // per axis
+
+  static double etaOf ( const GeometrySnapshot::Point& p ) {
+    return std::asinh( p.z/std::sqrt( p.x*p.x + p.y*p.y ) );
+  }
+
+  static double deltaPhi ( double a, double b ) {
+    double d = a - b;
+    while ( d >  PI ) d -= 2*PI;
+    while ( d < -PI ) d += 2*PI;
+    return d;
+  }
+
+  static int eeBucket ( int iz, double u, double v ) {
+    int bu = int( std::floor( ( u+EE_UV_MAX )/EE_UV_BUCKET ) );
+    int bv = int( std::floor( ( v+EE_UV_MAX )/EE_UV_BUCKET ) );
+    if ( bu < 0 || bu >= EE_NBUCKETS || bv < 0 || bv >= EE_NBUCKETS ) return -1;
+    return ( iz*EE_NBUCKETS + bv )*EE_NBUCKETS + bu;
+  }
+
+  // Corner extent __________________________________________________________//
+  // Same wrapping as reco::deltaPhi and TVector2::Phi_mpi_pi
+  GeometrySnapshot::EtaPhiBox GeometrySnapshot::cornerBox ( const float* eta, const float* phi, int n ) {
+
+    double minDPhi = 0., maxDPhi = 0.;
+    EtaPhiBox box{ eta[0], eta[0], 0., 0. };
+    for ( int iC = 1; iC < n; iC++ ) {
+      double dPhi = double( phi[iC] ) - phi[0];
+      while ( dPhi >   PI ) dPhi -= 2*PI;
+      while ( dPhi <= -PI ) dPhi += 2*PI;
+      minDPhi = std::min( minDPhi, dPhi );
+      maxDPhi = std::max( maxDPhi, dPhi );
+      box.minEta = std::min( box.minEta, eta[iC] );
+      box.maxEta = std::max( box.maxEta, eta[iC] );
+    }
+    double minPhi = phi[0] + minDPhi, maxPhi = phi[0] + maxDPhi;
+    while ( minPhi >=  PI ) minPhi -= 2*PI;
+    while ( minPhi <  -PI ) minPhi += 2*PI;
+    while ( maxPhi >=  PI ) maxPhi -= 2*PI;
+    while ( maxPhi <  -PI ) maxPhi += 2*PI;
+    box.minPhi = minPhi;
+    box.maxPhi = maxPhi;
+    return box;
+
+  } // cornerBox()
+
+  // Binary I/O _____________________________________________________________//
+  template<class T>
+  static void writeArray ( std::ofstream& out, const std::vector<T>& v ) {
+    uint32_t n = v.size();
+    out.write( reinterpret_cast<const char*>( &n ), sizeof(n) );
+    out.write( reinterpret_cast<const char*>( v.data() ), n*sizeof(T) );
+  }
+
+  template<class T>
+  static void readArray ( std::ifstream& in, std::vector<T>& v ) {
+    uint32_t n = 0;
+    in.read( reinterpret_cast<char*>( &n ), sizeof(n) );
+    if ( !in ) throw std::runtime_error( "GeometrySnapshot: truncated file" );
+    v.resize( n );
+    in.read( reinterpret_cast<char*>( v.data() ), n*sizeof(T) );
+    if ( !in ) throw std::runtime_error( "GeometrySnapshot: truncated file" );
+  }
+
+  void GeometrySnapshot::write ( const std::string& fileName ) const {
+
+    std::ofstream out( fileName, std::ios::binary );
+    if ( !out ) throw std::runtime_error( "GeometrySnapshot: cannot open " + fileName + " for writing" );
+    out.write( SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) );
+    out.write( reinterpret_cast<const char*>( &SNAPSHOT_VERSION ), sizeof(SNAPSHOT_VERSION) );
+    out.write( reinterpret_cast<const char*>( &bFieldZ ), sizeof(bFieldZ) );
+    writeArray( out, ebCenter );
+    writeArray( out, ebBox );
+    writeArray( out, eeCenter );
+    writeArray( out, eeBox );
+    writeArray( out, esCenter );
+    writeArray( out, hbheSubdet );
+    writeArray( out, hbheCenter );
+    writeArray( out, hbheBox );
+    if ( !out ) throw std::runtime_error( "GeometrySnapshot: error writing " + fileName );
+
+  } // write()
+
+  void GeometrySnapshot::read ( const std::string& fileName ) {
+
+    std::ifstream in( fileName, std::ios::binary );
+    if ( !in ) throw std::runtime_error( "GeometrySnapshot: cannot open " + fileName );
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    uint32_t version = 0;
+    in.read( magic, sizeof(magic) );
+    in.read( reinterpret_cast<char*>( &version ), sizeof(version) );
+    if ( !in || std::memcmp( magic, SNAPSHOT_MAGIC, sizeof(magic) ) != 0 )
+      throw std::runtime_error( "GeometrySnapshot: " + fileName + " is not a geometry snapshot" );
+    if ( version != SNAPSHOT_VERSION )
+      throw std::runtime_error( "GeometrySnapshot: unsupported version in " + fileName + ", rerun GeometrySnapshotDumper" );
+    in.read( reinterpret_cast<char*>( &bFieldZ ), sizeof(bFieldZ) );
+    readArray( in, ebCenter );
+    readArray( in, ebBox );
+    readArray( in, eeCenter );
+    readArray( in, eeBox );
+    readArray( in, esCenter );
+    readArray( in, hbheSubdet );
+    readArray( in, hbheCenter );
+    readArray( in, hbheBox );
+    if ( ebCenter.size() != size_t( EB_NIETA*EB_NIPHI ) || ebBox.size() != ebCenter.size() )
+      throw std::runtime_error( "GeometrySnapshot: bad EB arrays in " + fileName );
+    if ( eeCenter.size() != size_t( EE_NCELLS ) || eeBox.size() != eeCenter.size() )
+      throw std::runtime_error( "GeometrySnapshot: bad EE arrays in " + fileName );
+    if ( esCenter.size() != size_t( ES_NCELLS ) )
+      throw std::runtime_error( "GeometrySnapshot: bad ES arrays in " + fileName );
+    if ( hbheSubdet.size() != size_t( HBHE_NCELLS ) || hbheCenter.size() != hbheSubdet.size() || hbheBox.size() != hbheSubdet.size() )
+      throw std::runtime_error( "GeometrySnapshot: bad HBHE arrays in " + fileName );
+
+    index();
+
+  } // read()
+
+  // Lookup tables __________________________________________________________//
+  void GeometrySnapshot::index () {
+
+    // EB rows are ordered in eta, columns follow iphi
+    ebRowEta_.assign( EB_NIETA, 0. );
+    ebColPhi_.assign( EB_NIPHI, 0. );
+    std::vector<double> sinSum( EB_NIPHI, 0. ), cosSum( EB_NIPHI, 0. );
+    for ( int row = 0; row < EB_NIETA; row++ ) {
+      double etaSum = 0.;
+      for ( int col = 0; col < EB_NIPHI; col++ ) {
+        const Point& p = ebCenter[row*EB_NIPHI + col];
+        etaSum += etaOf( p );
+        double phi = std::atan2( p.y, p.x );
+        sinSum[col] += std::sin( phi );
+        cosSum[col] += std::cos( phi );
+      }
+      ebRowEta_[row] = etaSum/EB_NIPHI;
+    }
+    for ( int col = 0; col < EB_NIPHI; col++ ) ebColPhi_[col] = std::atan2( sinSum[col], cosSum[col] );
+
+    // EE crystals bucketed by the direction of their centers
+    int nBuckets = 2*EE_NBUCKETS*EE_NBUCKETS;
+    std::vector<int> bucketOf( eeCenter.size(), -1 );
+    eeBucketStart_.assign( nBuckets+1, 0 );
+    for ( size_t i = 0; i < eeCenter.size(); i++ ) {
+      const Point& p = eeCenter[i];
+      if ( p.z == 0. ) continue;
+      bucketOf[i] = eeBucket( p.z > 0. ? 1 : 0, p.x/std::abs( p.z ), p.y/std::abs( p.z ) );
+      if ( bucketOf[i] >= 0 ) eeBucketStart_[ bucketOf[i]+1 ]++;
+    }
+    for ( int b = 0; b < nBuckets; b++ ) eeBucketStart_[b+1] += eeBucketStart_[b];
+    eeBucketCells_.assign( eeBucketStart_[nBuckets], -1 );
+    std::vector<int> fill( eeBucketStart_.begin(), eeBucketStart_.end()-1 );
+    for ( size_t i = 0; i < eeCenter.size(); i++ ) {
+      if ( bucketOf[i] >= 0 ) eeBucketCells_[ fill[ bucketOf[i] ]++ ] = i;
+    }
+
+    // HBHE towers are looked up at depth 1
+    hbheDepth1_.clear();
+    for ( int idx = 0; idx < HBHE_NCELLS; idx += HBHE_DEPTH_NUM ) {
+      if ( hbheSubdet[idx] != 0 ) hbheDepth1_.push_back( idx );
+    }
+
+  } // index()
+
+  int GeometrySnapshot::findEB ( double eta, double phi ) const {
+
+    if ( ebRowEta_.empty() ) return -1;
+
+    // Nearest row and column, then closest center among the neighbors
+    int row = std::lower_bound( ebRowEta_.begin(), ebRowEta_.end(), float(eta) ) - ebRowEta_.begin();
+    int col = int( std::lround( deltaPhi( phi, ebColPhi_[0] )/( 2*PI/EB_NIPHI ) ) );
+    col = ( col + EB_NIPHI )%EB_NIPHI;
+
+    int best = -1;
+    double bestDR2 = 1.e9;
+    for ( int r = row-2; r <= row+1; r++ ) {
+      if ( r < 0 || r >= EB_NIETA ) continue;
+      for ( int dc = -1; dc <= 1; dc++ ) {
+        int c = ( col + dc + EB_NIPHI )%EB_NIPHI;
+        const Point& p = ebCenter[r*EB_NIPHI + c];
+        double dEta = etaOf( p ) - eta;
+        double dPhi = deltaPhi( std::atan2( p.y, p.x ), phi );
+        double dR2 = dEta*dEta + dPhi*dPhi;
+        if ( dR2 < bestDR2 ) { bestDR2 = dR2; best = r*EB_NIPHI + c; }
+      }
+    }
+    return best;
+
+  } // findEB()
+
+  int GeometrySnapshot::findEE ( double eta, double phi ) const {
+
+    if ( eeBucketStart_.empty() || eta == 0. ) return -1;
+
+    // Direction of the query in units of |z|
+    int iz = eta > 0. ? 1 : 0;
+    double rhoOverZ = 1./std::sinh( std::abs( eta ) );
+    double u = rhoOverZ*std::cos( phi );
+    double v = rhoOverZ*std::sin( phi );
+
+    int best = -1;
+    double bestD2 = 1.e9;
+    for ( int dv = -1; dv <= 1; dv++ ) {
+      for ( int du = -1; du <= 1; du++ ) {
+        int b = eeBucket( iz, u + du*EE_UV_BUCKET, v + dv*EE_UV_BUCKET );
+        if ( b < 0 ) continue;
+        for ( int k = eeBucketStart_[b]; k < eeBucketStart_[b+1]; k++ ) {
+          const Point& p = eeCenter[ eeBucketCells_[k] ];
+          double du_ = p.x/std::abs( p.z ) - u;
+          double dv_ = p.y/std::abs( p.z ) - v;
+          double d2 = du_*du_ + dv_*dv_;
+          if ( d2 < bestD2 ) { bestD2 = d2; best = eeBucketCells_[k]; }
+        }
+      }
+    }
+    return best;
+
+  } // findEE()
+
+  int GeometrySnapshot::findHBHE ( double eta, double phi ) const {
+
+    int best = -1;
+    double bestDR2 = 1.e9;
+    for ( int idx : hbheDepth1_ ) {
+      const EtaPhiBox& box = hbheBox[idx];
+      if ( eta < box.minEta || eta > box.maxEta ) continue;
+      bool isBoundary = box.minPhi > box.maxPhi;
+      if ( !isBoundary && ( phi < box.minPhi || phi > box.maxPhi ) ) continue;
+      if (  isBoundary && ( phi < box.minPhi && phi > box.maxPhi ) ) continue;
+      return idx;
+    }
+    // Outside all cell extents (e.g. |eta| > 3): take the closest center
+    for ( int idx : hbheDepth1_ ) {
+      const Point& p = hbheCenter[idx];
+      double dEta = etaOf( p ) - eta;
+      double dPhi = deltaPhi( std::atan2( p.y, p.x ), phi );
+      double dR2 = dEta*dEta + dPhi*dPhi;
+      if ( dR2 < bestDR2 ) { bestDR2 = dR2; best = idx; }
+    }
+    return best;
+
+  } // findHBHE()
+
+} // namespace img
@@ -0,0 +1,84 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageAugment.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/Hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace img {
+
+  static int wrap ( int i, int n ) {
+    return ( i % n + n ) % n;
+  }
+
+  Augmentation drawAugmentation ( const AugmentConfig& config, int nRows, int nCols, uint64_t seed, uint64_t key ) {
+
+    int step = config.step;
+    if ( step < 1 || nCols % step != 0 ) {
+      throw std::runtime_error( "ImageAugment: step " + std::to_string( step ) + " does not divide " + std::to_string( nCols ) + " columns" );
+    }
+    uint64_t state = mix( seed ^ mix( key ) );
+    Augmentation aug;
+    if ( config.rotate ) aug.phiShift = step*int( mix( state++ ) % ( nCols/step ) );
+    if ( config.reflect ) aug.etaFlip = mix( state++ ) & 1;
+    // Crop offset from the center in [-jitter, jitter], by steps
+    int nSteps = config.jitter/step;
+    int cropRows = config.cropRows > 0 ? config.cropRows : nRows;
+    int cropCols = config.cropCols > 0 ? config.cropCols : nCols;
+    aug.cropRow = ( nRows - cropRows )/2;
+    aug.cropCol = ( nCols - cropCols )/2;
+    if ( nSteps > 0 ) {
+      aug.cropRow += step*( int( mix( state++ ) % ( 2*nSteps+1 ) ) - nSteps );
+      aug.cropCol += step*( int( mix( state++ ) % ( 2*nSteps+1 ) ) - nSteps );
+    }
+    return aug;
+
+  } // drawAugmentation()
+
+  Augmentation scaled ( const Augmentation& aug, int ratio ) {
+    if ( ratio < 1 || aug.phiShift % ratio || aug.cropRow % ratio || aug.cropCol % ratio ) {
+      throw std::runtime_error( "ImageAugment: transform not in whole pixels of an image " + std::to_string( ratio ) + " times coarser" );
+    }
+    Augmentation out = aug;
+    out.phiShift /= ratio;
+    out.cropRow /= ratio;
+    out.cropCol /= ratio;
+    return out;
+  }
+
+  void transformImages ( const float* in, int n, int nChannels, int nRows, int nCols,
+                         const Augmentation* aug, int outRows, int outCols, float* out,
+                         const float* pad ) {
+
+    size_t inSize = size_t( nRows )*nCols;
+    size_t outSize = size_t( outRows )*outCols;
+    for ( int i = 0; i < n; i++ ) {
+      const Augmentation& a = aug[i];
+      // Input column of output column 0
+      int firstCol = wrap( a.cropCol - a.phiShift, nCols );
+      for ( int c = 0; c < nChannels; c++ ) {
+        const float* src = in + ( size_t( i )*nChannels + c )*inSize;
+        float* dst = out + ( size_t( i )*nChannels + c )*outSize;
+        for ( int r = 0; r < outRows; r++ ) {
+          float* dstRow = dst + size_t( r )*outCols;
+          int row = a.cropRow + r;
+          if ( row < 0 || row >= nRows ) {
+            std::fill( dstRow, dstRow + outCols, pad ? pad[c] : 0.f );
+            continue;
+          }
+          const float* srcRow = src + size_t( a.etaFlip ? nRows-1-row : row )*nCols;
+          // Contiguous runs up to the phi wrap
+          for ( int done = 0, col = firstCol; done < outCols; ) {
+            int len = std::min( outCols - done, nCols - col );
+            std::memcpy( dstRow + done, srcRow + col, len*sizeof( float ) );
+            done += len;
+            col = 0;
+          }
+        }
+      }
+    }
+
+  } // transformImages()
+
+} // namespace img
@@ -0,0 +1,368 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace img {
+
+  static const double PI = 3.14159265358979323846;
+
+  // Bin finding ____________________________________________________________//
+  // Reproduces TAxis::FindBin so projected images are identical
+  // to the ones obtained by filling TH2F helpers.
+
+  int findFixBin ( double x, int nbins, double xmin, double xmax ) {
+    if ( x < xmin ) return 0;
+    if ( !(x < xmax) ) return nbins+1;
+    return 1 + int( nbins*(x-xmin)/(xmax-xmin) );
+  }
+
+  int findVarBin ( double x, int nbins, const double* edges ) {
+    if ( x < edges[0] ) return 0;
+    if ( !(x < edges[nbins]) ) return nbins+1;
+    return int( std::upper_bound( edges, edges+nbins+1, x ) - edges );
+  }
+
+  // Fill EB image __________________________________________________________//
+  void fillEBImage ( const std::vector<EBHit>& hits,
+                     ImageBuffer& vEnergy, ImageBuffer& vTime ) {
+
+    vEnergy.reset( EB_NCELLS );
+    vTime.reset( EB_NCELLS );
+
+    int idx_;
+    for ( const EBHit& hit : hits ) {
+      if ( hit.energy <= zs ) continue;
+      idx_ = ebIndex( hit.ieta, hit.iphi ); // (ieta_+EBDetId::MAX_IETA)*EBDetId::MAX_IPHI + iphi_
+      vEnergy[idx_] = hit.energy;
+      vTime[idx_] = hit.time;
+    }
+
+  } // fillEBImage()
+
+  // Fill stitched ECAL image _______________________________________________//
+  // EE (phi,eta) bins are accumulated directly into their image pixels:
+  // the bin -> pixel map is one-to-one so the float sums are the same
+  // as the ones of the TH2F helpers. Hit energies are > zs, so every
+  // filled pixel also passes the zero-suppression of the projection.
+  void fillECALstitchedImage ( const std::vector<EBHit>& ebHits, const std::vector<EtaPhiHit>& eeHits,
+                               ImageBuffer& vEnergy ) {
+
+    vEnergy.reset( ECAL_NCELLS );
+
+    int ieta_, idx_;
+    int ietaBin, iphiBin;
+
+    // Fill EE-(phi,eta) and EE+(phi,eta) projections
+    for ( const EtaPhiHit& hit : eeHits ) {
+      if ( hit.energy <= zs ) continue;
+      ietaBin = findVarBin( hit.eta, EE_PROJ_NETA, hit.iz > 0 ? eta_bins_EEp : eta_bins_EEm );
+      if ( ietaBin < 1 || ietaBin > EE_PROJ_NETA ) continue;
+      iphiBin = findFixBin( hit.phi, EB_IPHI_MAX, -PI, PI );
+      if ( iphiBin < 1 || iphiBin > EB_IPHI_MAX ) continue;
+      ieta_ = ecalRowOffset( hit.iz > 0 ? 2 : 0 ) + ietaBin-1;
+      idx_ = ieta_*EB_IPHI_MAX + ecalProjIphi( iphiBin );
+      vEnergy[idx_] += hit.energy;
+    }
+
+    // Fill middle part of ECAL(ieta,iphi) with the EB rechits.
+    for ( const EBHit& hit : ebHits ) {
+      if ( hit.energy <= zs ) continue;
+      ieta_ = hit.ieta > 0 ? hit.ieta-1 : hit.ieta;
+      ieta_ += EB_IETA_MAX + ecalRowOffset(1);
+      idx_ = ieta_*EB_IPHI_MAX + hit.iphi-1;
+      vEnergy[idx_] = hit.energy;
+    }
+
+  } // fillECALstitchedImage()
+
+  // Fill HBHE images _______________________________________________________//
+  // As in the TH2F helper, the second half of a coarse tower
+  // at the last image column falls in the overflow and is dropped.
+  void fillHBHEImage ( const std::vector<HBHEHit>& hits,
+                       ImageBuffer& vEnergyEB, ImageBuffer& vEnergy ) {
+
+    vEnergyEB.reset( HBHE_NCELLS_EB );
+    vEnergy.reset( HBHE_NCELLS );
+
+    int iphi_, ieta_, ietaAbs, idx_;
+    float energy_;
+    for ( const HBHEHit& hit : hits ) {
+
+      energy_ = hit.energy;
+      if ( energy_ <= zs ) continue;
+      iphi_ = hbheImageIphi( hit.iphi );
+      ieta_ = hbheImageIeta( hit.ieta );
+      ietaAbs = hit.ieta > 0 ? hit.ieta : -hit.ieta;
+      idx_ = ( ieta_+HBHE_IETA_MAX_HE-1 )*HBHE_IPHI_NUM + iphi_;
+
+      // NOTE: HBHE iphis only occur in even numbers in coarse region
+      // => Fill adjacent (odd) iphi bin and split energy evenly.
+      if ( ietaAbs > HBHE_IETA_MAX_FINE ) {
+        vEnergy[idx_] += energy_*0.5;
+        if ( iphi_+1 < HBHE_IPHI_NUM ) vEnergy[idx_+1] += energy_*0.5;
+        continue;
+      }
+      vEnergy[idx_] += energy_;
+
+      // Fill EB-overlapping HBHE image
+      if ( ietaAbs > HBHE_IETA_MAX_EB ) continue;
+      vEnergyEB[ ( ieta_+HBHE_IETA_MAX_EB )*HBHE_IPHI_NUM + iphi_ ] += energy_;
+
+    } // HBHE rechits
+
+  } // fillHBHEImage()
+
+  // Fill HCAL at EE image __________________________________________________//
+  void fillHCALatEEImage ( const std::vector<HBHETower>& towers, const std::vector<EECell>& eeCells,
+                           ImageBuffer vEnergy[2], std::vector<int>& selected,
+                           std::vector<std::pair<int,float> >* monitor ) {
+
+    vEnergy[0].reset( EE_NC_PER_ZSIDE );
+    vEnergy[1].reset( EE_NC_PER_ZSIDE );
+    if ( monitor ) monitor->clear();
+
+    bool isBoundary;
+    float eta, phi;
+    for ( const HBHETower& tower : towers ) {
+
+      if ( tower.energy <= zs ) continue;
+      isBoundary = tower.minPhi > tower.maxPhi;
+
+      // Collect the EE crystals whose centers lie within the tower
+      selected.clear();
+      for ( int i = 0; i < int(eeCells.size()); i++ ) {
+        eta = eeCells[i].eta;
+        phi = eeCells[i].phi;
+        if ( eta < tower.minEta || eta > tower.maxEta ) continue;
+        if ( isBoundary ) {
+          if ( phi < tower.minPhi && phi > tower.maxPhi ) continue;
+        } else {
+          if ( phi < tower.minPhi || phi > tower.maxPhi ) continue;
+        }
+        selected.push_back( i );
+      }
+      if ( selected.empty() ) continue;
+
+      // Split the tower energy evenly between them
+      float energy_ = tower.energy/float( selected.size() );
+      for ( int i : selected ) {
+        const EECell& cell = eeCells[i];
+        vEnergy[cell.iz][cell.iy*EE_MAX_IX + cell.ix] += energy_;
+        if ( monitor ) monitor->push_back( std::make_pair( i, tower.energy ) );
+      }
+
+    } // towers
+
+  } // fillHCALatEEImage()
+
+  // Fill stitched track images _____________________________________________//
+  // Tracks are accumulated pixel by pixel in the same order as the
+  // original TH2F helpers. Track pT is positive, so every pixel
+  // hit in EE passes the zero-suppression on the pT projection.
+  void fillTracksAtECALstitchedImage ( const std::vector<TrackAtECAL>& tracks, double z0PVCut,
+                                       ImageBuffer* vChannels[nTrackChannels] ) {
+
+    for ( int ch = 0; ch < nTrackChannels; ch++ ) vChannels[ch]->reset( ECAL_NCELLS );
+
+    int ieta_, idx_;
+    int ietaBin, iphiBin;
+    for ( int region = 0; region < 2; region++ ) {
+      // EE first, then EB
+      for ( const TrackAtECAL& trk : tracks ) {
+
+        if ( trk.isEB != (region == 1) ) continue;
+        if ( trk.isEB ) {
+          if ( trk.pt <= zs ) continue;
+          ieta_ = trk.ieta > 0 ? trk.ieta-1 : trk.ieta;
+          ieta_ += EB_IETA_MAX + ecalRowOffset(1);
+          idx_ = ieta_*EB_IPHI_MAX + trk.iphi-1;
+        } else {
+          ietaBin = findVarBin( trk.eta, EE_PROJ_NETA, trk.iz > 0 ? eta_bins_EEp : eta_bins_EEm );
+          if ( ietaBin < 1 || ietaBin > EE_PROJ_NETA ) continue;
+          iphiBin = findFixBin( trk.phi, EB_IPHI_MAX, -PI, PI );
+          if ( iphiBin < 1 || iphiBin > EB_IPHI_MAX ) continue;
+          ieta_ = ecalRowOffset( trk.iz > 0 ? 2 : 0 ) + ietaBin-1;
+          idx_ = ieta_*EB_IPHI_MAX + ecalProjIphi( iphiBin );
+        }
+
+        (*vChannels[kTrkPt])[idx_]  += trk.pt;
+        (*vChannels[kTrkQPt])[idx_] += trk.qpt;
+        if ( std::abs( trk.z0 ) < z0PVCut ) {
+          (*vChannels[kTrkPt_PV])[idx_]    += trk.pt;
+          (*vChannels[kTrkQPt_PV])[idx_]   += trk.qpt;
+          (*vChannels[kTrkd0_PV])[idx_]    += float( trk.d0 );
+          (*vChannels[kTrkz0_PV])[idx_]    += float( trk.z0 );
+          (*vChannels[kTrkd0sig_PV])[idx_] += trk.d0sig;
+          (*vChannels[kTrkz0sig_PV])[idx_] += trk.z0sig;
+        } else {
+          (*vChannels[kTrkPt_nPV])[idx_]   += trk.pt;
+          (*vChannels[kTrkQPt_nPV])[idx_]  += trk.qpt;
+        }
+
+      } // tracks
+    } // EE, EB
+
+  } // fillTracksAtECALstitchedImage()
+
+  // Fill SC crop ___________________________________________________________//
+  void fillSCCrop ( const std::vector<EBHit>& hits, int ietaSeed, int iphiSeed,
+                    float* energy, float* energyT, float* energyZ, float* time ) {
+
+    int iphi_, ieta_, idx_; // rows:ieta, cols:iphi
+    int iphi_crop, ieta_crop;
+    int iphi_shift = iphiSeed - 15;
+    int ieta_shift = ietaSeed - 15;
+    for ( const EBHit& hit : hits ) {
+
+      if ( hit.energy < zs ) continue;
+
+      iphi_ = hit.iphi-1; // [0,...,359]
+      ieta_ = hit.ieta > 0 ? hit.ieta-1 : hit.ieta; // [-85,...,-1,0,...,84]
+      ieta_ += EB_IETA_MAX; // [0,...,169]
+
+      // Convert to [0,...,31][0,...,31]
+      ieta_crop = ieta_ - ieta_shift;
+      iphi_crop = iphi_ - iphi_shift;
+      if ( iphi_crop >= EB_IPHI_MAX ) iphi_crop = iphi_crop - EB_IPHI_MAX; // get wrap-around hits
+      if ( iphi_crop < 0 ) iphi_crop = iphi_crop + EB_IPHI_MAX; // get wrap-around hits
+
+      if ( ieta_crop < 0 || ieta_crop > SC_CROP_SIZE-1 ) continue;
+      if ( iphi_crop < 0 || iphi_crop > SC_CROP_SIZE-1 ) continue;
+
+      // Convert to [0,...,32*32-1]
+      idx_ = ieta_crop*SC_CROP_SIZE + iphi_crop;
+
+      energy[idx_]  = hit.energy;
+      energyT[idx_] = hit.energy/std::cosh( double(hit.eta) );
+      energyZ[idx_] = hit.energy*std::abs( std::tanh( double(hit.eta) ) );
+      time[idx_]    = hit.time;
+
+    } // EB rechits
+
+  } // fillSCCrop()
+
+  // Image pyramid _________________________________________________________//
+  void downsampleImage ( const ImageBuffer& src, int nRows, int nCols, int factor, ImageBuffer& dst ) {
+
+    int nColsDst = ( nCols+factor-1 )/factor;
+    dst.reset( ( ( nRows+factor-1 )/factor )*nColsDst );
+
+    const float* pixels = src.pixels().data();
+    int nPixels = nRows*nCols;
+    for ( int iT : src.dirtyTiles() ) {
+      int end = std::min( ( iT+1 )*ImageBuffer::TILE_SIZE, nPixels );
+      for ( int idx = iT*ImageBuffer::TILE_SIZE; idx < end; idx++ ) {
+        if ( pixels[idx] == 0. ) continue;
+        dst[ ( idx/nCols/factor )*nColsDst + ( idx%nCols )/factor ] += pixels[idx];
+      }
+    }
+
+  } // downsampleImage()
+
+  void upsampleImage ( const ImageBuffer& src, int nRows, int nCols, int factor, ImageBuffer& dst ) {
+
+    int nColsDst = nCols*factor;
+    dst.reset( nRows*factor*nColsDst );
+
+    const float* pixels = src.pixels().data();
+    int nPixels = nRows*nCols;
+    float scale = 1./( factor*factor );
+    for ( int iT : src.dirtyTiles() ) {
+      int end = std::min( ( iT+1 )*ImageBuffer::TILE_SIZE, nPixels );
+      for ( int idx = iT*ImageBuffer::TILE_SIZE; idx < end; idx++ ) {
+        if ( pixels[idx] == 0. ) continue;
+        float value = pixels[idx]*scale;
+        int first = ( idx/nCols )*factor*nColsDst + ( idx%nCols )*factor;
+        for ( int dr = 0; dr < factor; dr++ ) {
+          for ( int dc = 0; dc < factor; dc++ ) dst[ first + dr*nColsDst + dc ] = value;
+        }
+      }
+    }
+
+  } // upsampleImage()
+
+  void cropImage ( const ImageBuffer& src, int nRows, int nCols, int row, int col, int size,
+                   float* out, int rowStride, int colStride ) {
+
+    const float* pixels = src.pixels().data();
+    int firstRow = row - size/2;
+    int firstCol = ( ( col - size/2 ) % nCols + nCols ) % nCols;
+    for ( int r = 0; r < size; r++ ) {
+      float* outRow = out + r*rowStride;
+      int iRow = firstRow + r;
+      if ( iRow < 0 || iRow >= nRows ) {
+        for ( int c = 0; c < size; c++ ) outRow[c*colStride] = 0.;
+        continue;
+      }
+      const float* srcRow = pixels + iRow*nCols;
+      int iCol = firstCol;
+      for ( int c = 0; c < size; c++ ) {
+        outRow[c*colStride] = srcRow[iCol];
+        if ( ++iCol == nCols ) iCol = 0;
+      }
+    }
+
+  } // cropImage()
+
+  // EB digis _______________________________________________________________//
+  void fillEBDigiImage ( const std::vector<EBDigi>& digis, DigiLayout layout, int seedSample,
+                         ImageBuffer& vAdc, int& ietaSeed, int& iphiSeed ) {
+
+    vAdc.reset( EB_DIGI_NSAMPLES*EB_NCELLS );
+
+    int seed = -1;
+    float seedAdc = 0.;
+    float pulse[EB_DIGI_NSAMPLES];
+    for ( const EBDigi& digi : digis ) {
+
+      float pedestal = 0.;
+      for ( int iS = 0; iS < EB_DIGI_NPRESAMPLES; iS++ ) pedestal += digi.adc[iS];
+      pedestal /= EB_DIGI_NPRESAMPLES;
+      for ( int iS = 0; iS < EB_DIGI_NSAMPLES; iS++ ) pulse[iS] = digi.adc[iS] - pedestal;
+
+      int idx = ebIndex( digi.ieta, digi.iphi );
+      if ( layout == kCrystalMajor ) {
+        for ( int iS = 0; iS < EB_DIGI_NSAMPLES; iS++ ) vAdc[ idx*EB_DIGI_NSAMPLES + iS ] = pulse[iS];
+      } else {
+        for ( int iS = 0; iS < EB_DIGI_NSAMPLES; iS++ ) vAdc[ iS*EB_NCELLS + idx ] = pulse[iS];
+      }
+
+      if ( seed < 0 || pulse[seedSample] > seedAdc || ( pulse[seedSample] == seedAdc && idx < seed ) ) {
+        seed = idx;
+        seedAdc = pulse[seedSample];
+      }
+
+    } // EB digis
+
+    ietaSeed = seed < 0 ? -1 : seed/EB_IPHI_MAX;
+    iphiSeed = seed < 0 ? -1 : seed%EB_IPHI_MAX;
+
+  } // fillEBDigiImage()
+
+  void cropEBDigiImage ( const ImageBuffer& vAdc, DigiLayout layout, int ieta, int iphi, int size, float* out ) {
+
+    // Each crop row is at most two runs of whole EB columns (phi wraps)
+    const float* adc = vAdc.pixels().data();
+    int firstRow = ieta - size/2;
+    int firstCol = ( ( iphi - size/2 ) % EB_IPHI_MAX + EB_IPHI_MAX ) % EB_IPHI_MAX;
+    int nFirst = std::min( size, EB_IPHI_MAX-firstCol );
+    int nSamples = layout == kCrystalMajor ? 1 : EB_DIGI_NSAMPLES;
+    int nPerCell = layout == kCrystalMajor ? EB_DIGI_NSAMPLES : 1;
+    for ( int iS = 0; iS < nSamples; iS++ ) {
+      for ( int r = 0; r < size; r++ ) {
+        float* outRow = out + ( iS*size + r )*size*nPerCell;
+        int iRow = firstRow + r;
+        if ( iRow < 0 || iRow >= 2*EB_IETA_MAX ) {
+          std::fill( outRow, outRow + size*nPerCell, 0. );
+          continue;
+        }
+        const float* srcRow = adc + ( iS*EB_NCELLS + iRow*EB_IPHI_MAX )*nPerCell;
+        std::copy( srcRow + firstCol*nPerCell, srcRow + ( firstCol+nFirst )*nPerCell, outRow );
+        std::copy( srcRow, srcRow + ( size-nFirst )*nPerCell, outRow + nFirst*nPerCell );
+      }
+    }
+
+  } // cropEBDigiImage()
+
+} // namespace img
@@ -0,0 +1,407 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageShard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace img {
+
+  static const char MAGIC[8] = { 'I', 'M', 'G', 'S', 'H', 'D', '0', '1' };
+  static const uint32_t VERSION = 2;
+
+  struct ColumnRecord {
+    char     name[ShardWriter::MAX_NAME+1];
+    uint32_t type;
+    uint32_t nDims;
+    uint32_t shape[ShardWriter::MAX_DIMS];
+    uint64_t offset;
+    uint32_t sparse;
+    float    scale;
+  };
+
+  // Version 1, dense columns only
+  struct ColumnRecordV1 {
+    char     name[48];
+    uint32_t type;
+    uint32_t nDims;
+    uint32_t shape[ShardWriter::MAX_DIMS];
+    uint64_t offset;
+  };
+
+  struct Footer {
+    char     magic[8];
+    uint32_t version;
+    uint32_t columnSize;
+    uint64_t nColumns;
+    uint64_t nRows;
+    uint64_t rowBytes;
+  };
+  static_assert( sizeof( ColumnRecord ) == 80, "ColumnRecord layout" );
+  static_assert( sizeof( ColumnRecordV1 ) == 80, "ColumnRecordV1 layout" );
+  static_assert( sizeof( Footer ) == 40, "Footer layout" );
+
+  // Slot of a sparse column: number of elements, position of the payload
+  struct SparseSlot {
+    uint32_t n;
+    uint32_t offset;
+  };
+
+  static size_t typeSize ( ShardType type ) {
+    return type == ShardType::Int64 ? 8 : 4;
+  }
+
+  static size_t align ( size_t n, size_t a ) {
+    return ( n + a-1 )/a*a;
+  }
+
+  static int16_t quantize ( float value, float scale ) {
+    long q = std::lround( value/scale );
+    return std::max( -32768L, std::min( 32767L, q ) );
+  }
+
+  size_t ShardColumn::size () const {
+    size_t n = 1;
+    for ( int dim : shape ) n *= dim;
+    return n;
+  }
+
+  size_t ShardColumn::nBytes () const {
+    return size()*typeSize( type );
+  }
+
+  size_t ShardColumn::elementBytes () const {
+    return scale > 0. ? 2 : typeSize( type );
+  }
+
+  // Stored size and alignment of the fixed slot of a column
+  static size_t slotBytes ( const ShardColumn& col ) {
+    return col.sparse ? sizeof( SparseSlot ) : col.size()*col.elementBytes();
+  }
+  static size_t slotAlign ( const ShardColumn& col ) {
+    return col.sparse ? 4 : col.elementBytes();
+  }
+
+  // Only reached open if the job failed: no footer, so readers
+  // reject the incomplete file
+  ShardWriter::~ShardWriter () {
+    if ( out_.is_open() ) out_.close();
+  }
+
+  void ShardWriter::addColumn ( const std::string& name, ShardType type, const std::vector<int>& shape,
+                                bool sparse, float scale ) {
+
+    if ( out_.is_open() ) throw std::runtime_error( "ImageShard: column " + name + " added after open()" );
+    if ( name.empty() || name.size() > MAX_NAME ) throw std::runtime_error( "ImageShard: bad column name " + name );
+    if ( column( name ) >= 0 ) throw std::runtime_error( "ImageShard: duplicate column " + name );
+    if ( shape.size() > MAX_DIMS ) throw std::runtime_error( "ImageShard: too many dimensions for column " + name );
+    for ( int dim : shape ) {
+      if ( dim < 1 ) throw std::runtime_error( "ImageShard: bad shape for column " + name );
+    }
+    if ( ( sparse || scale != 0. ) && type != ShardType::Float32 ) {
+      throw std::runtime_error( "ImageShard: only float32 columns can be sparse or quantized, not " + name );
+    }
+    if ( sparse && shape.empty() ) throw std::runtime_error( "ImageShard: scalar column " + name + " cannot be sparse" );
+    if ( !( scale >= 0. ) ) throw std::runtime_error( "ImageShard: bad scale for column " + name );
+
+    ShardColumn col{ name, type, shape, sparse, scale };
+    size_t end = columns_.empty() ? 0 : columns_.back().offset + columns_.back().nBytes();
+    col.offset = align( end, typeSize( type ) );
+    size_t storedEnd = columns_.empty() ? 0 : columns_.back().storedOffset + slotBytes( columns_.back() );
+    col.storedOffset = align( storedEnd, slotAlign( col ) );
+    columns_.push_back( col );
+    rowBytes_ = align( col.offset + col.nBytes(), 8 );
+    storedBytes_ = align( col.storedOffset + slotBytes( col ), 8 );
+    encoded_ |= sparse || scale > 0.;
+    variable_ |= sparse;
+
+  } // addColumn()
+
+  int ShardWriter::column ( const std::string& name ) const {
+    for ( unsigned int iC = 0; iC < columns_.size(); iC++ ) {
+      if ( columns_[iC].name == name ) return iC;
+    }
+    return -1;
+  }
+
+  void ShardWriter::open ( const std::string& file ) {
+    if ( columns_.empty() ) throw std::runtime_error( "ImageShard: no columns for " + file );
+    out_.open( file, std::ios::binary | std::ios::trunc );
+    if ( !out_ ) throw std::runtime_error( "ImageShard: cannot open " + file + " for writing" );
+    file_ = file;
+    nRows_ = 0;
+    position_ = 0;
+    rowOffsets_.clear();
+  }
+
+  void ShardWriter::write ( const char* rows, size_t nRows ) {
+    if ( nRows == 0 ) return;
+    if ( encoded_ ) {
+      for ( size_t iR = 0; iR < nRows; iR++ ) {
+        encode( rows + iR*rowBytes_ );
+        if ( variable_ ) rowOffsets_.push_back( position_ );
+        out_.write( encodedRow_.data(), encodedRow_.size() );
+        position_ += encodedRow_.size();
+      }
+    } else {
+      out_.write( rows, nRows*rowBytes_ );
+      position_ += nRows*rowBytes_;
+    }
+    if ( !out_ ) throw std::runtime_error( "ImageShard: failed writing " + file_ );
+    nRows_ += nRows;
+  }
+
+  // Dense row into encodedRow_
+  void ShardWriter::encode ( const char* row ) {
+
+    encodedRow_.assign( storedBytes_, 0 );
+    for ( const ShardColumn& col : columns_ ) {
+
+      char* slot = encodedRow_.data() + col.storedOffset;
+      if ( col.scale <= 0. && !col.sparse ) {
+        std::memcpy( slot, row + col.offset, col.nBytes() );
+        continue;
+      }
+      const float* values = reinterpret_cast<const float*>( row + col.offset );
+      size_t size = col.size();
+
+      if ( !col.sparse ) {
+        for ( size_t i = 0; i < size; i++ ) {
+          int16_t q = quantize( values[i], col.scale );
+          std::memcpy( slot + 2*i, &q, 2 );
+        }
+        continue;
+      }
+
+      // Sparse: indices then values, after what is already in the row
+      std::vector<uint32_t> indices;
+      for ( size_t i = 0; i < size; i++ ) {
+        if ( values[i] == 0. ) continue;
+        if ( col.scale > 0. && quantize( values[i], col.scale ) == 0 ) continue;
+        indices.push_back( i );
+      }
+      SparseSlot sparse{ uint32_t( indices.size() ), uint32_t( encodedRow_.size() ) };
+      std::memcpy( slot, &sparse, sizeof( sparse ) );
+      size_t payload = encodedRow_.size();
+      encodedRow_.resize( payload + indices.size()*( 4 + col.elementBytes() ) );
+      char* p = encodedRow_.data() + payload;
+      if ( !indices.empty() ) std::memcpy( p, indices.data(), 4*indices.size() );
+      p += 4*indices.size();
+      for ( size_t i = 0; i < indices.size(); i++ ) {
+        if ( col.scale > 0. ) {
+          int16_t q = quantize( values[indices[i]], col.scale );
+          std::memcpy( p + 2*i, &q, 2 );
+        } else {
+          std::memcpy( p + 4*i, &values[indices[i]], 4 );
+        }
+      }
+      encodedRow_.resize( align( encodedRow_.size(), 4 ) );
+
+    }
+    encodedRow_.resize( align( encodedRow_.size(), 8 ) );
+
+  } // encode()
+
+  void ShardWriter::close () {
+
+    if ( !out_.is_open() ) return;
+    if ( variable_ ) {
+      rowOffsets_.push_back( position_ );
+      out_.write( reinterpret_cast<const char*>( rowOffsets_.data() ), 8*rowOffsets_.size() );
+    }
+    for ( const ShardColumn& col : columns_ ) {
+      ColumnRecord record = ColumnRecord();
+      std::strncpy( record.name, col.name.c_str(), MAX_NAME );
+      record.type = static_cast<uint32_t>( col.type );
+      record.nDims = col.shape.size();
+      for ( unsigned int iD = 0; iD < col.shape.size(); iD++ ) record.shape[iD] = col.shape[iD];
+      record.offset = col.storedOffset;
+      record.sparse = col.sparse;
+      record.scale = col.scale;
+      out_.write( reinterpret_cast<const char*>( &record ), sizeof( record ) );
+    }
+
+    Footer footer = Footer();
+    std::memcpy( footer.magic, MAGIC, sizeof( MAGIC ) );
+    footer.version = VERSION;
+    footer.columnSize = sizeof( ColumnRecord );
+    footer.nColumns = columns_.size();
+    footer.nRows = nRows_;
+    footer.rowBytes = variable_ ? 0 : storedBytes_;
+    out_.write( reinterpret_cast<const char*>( &footer ), sizeof( footer ) );
+    out_.close();
+    rowOffsets_.clear();
+    if ( !out_ ) throw std::runtime_error( "ImageShard: failed writing " + file_ );
+
+  } // close()
+
+  // ShardReader ____//
+
+  ShardReader::~ShardReader () {
+    close();
+  }
+
+  void ShardReader::open ( const std::string& file ) {
+
+    close();
+    file_ = file;
+    fd_ = ::open( file.c_str(), O_RDONLY );
+    if ( fd_ < 0 ) throw std::runtime_error( "ImageShard: cannot open " + file );
+    struct stat st;
+    if ( fstat( fd_, &st ) != 0 ) throw std::runtime_error( "ImageShard: cannot stat " + file );
+    mapBytes_ = st.st_size;
+    if ( mapBytes_ < sizeof( Footer ) ) throw std::runtime_error( "ImageShard: " + file + " is not an image shard" );
+    void* map = mmap( nullptr, mapBytes_, PROT_READ, MAP_SHARED, fd_, 0 );
+    if ( map == MAP_FAILED ) {
+      mapBytes_ = 0;
+      throw std::runtime_error( "ImageShard: cannot map " + file );
+    }
+    data_ = static_cast<const char*>( map );
+
+    Footer footer;
+    std::memcpy( &footer, data_ + mapBytes_ - sizeof( footer ), sizeof( footer ) );
+    if ( std::memcmp( footer.magic, MAGIC, sizeof( MAGIC ) ) != 0 || footer.version < 1 || footer.version > VERSION
+         || footer.columnSize != sizeof( ColumnRecord )
+         || footer.nColumns*sizeof( ColumnRecord ) + sizeof( Footer ) > mapBytes_ ) {
+      throw std::runtime_error( "ImageShard: " + file + " is not an image shard" );
+    }
+    nRows_ = footer.nRows;
+    rowBytes_ = footer.rowBytes;
+    size_t schema = mapBytes_ - sizeof( Footer ) - footer.nColumns*sizeof( ColumnRecord );
+
+    for ( uint64_t iC = 0; iC < footer.nColumns; iC++ ) {
+      const char* p = data_ + schema + iC*sizeof( ColumnRecord );
+      ShardColumn col;
+      uint32_t nDims;
+      const uint32_t* shape;
+      if ( footer.version == 1 ) {
+        ColumnRecordV1 record;
+        std::memcpy( &record, p, sizeof( record ) );
+        col.name.assign( record.name, strnlen( record.name, sizeof( record.name ) ) );
+        col.type = static_cast<ShardType>( record.type );
+        nDims = record.nDims;
+        col.storedOffset = col.offset = record.offset;
+        shape = reinterpret_cast<const uint32_t*>( p + offsetof( ColumnRecordV1, shape ) );
+      } else {
+        ColumnRecord record;
+        std::memcpy( &record, p, sizeof( record ) );
+        col.name.assign( record.name, strnlen( record.name, sizeof( record.name ) ) );
+        col.type = static_cast<ShardType>( record.type );
+        nDims = record.nDims;
+        col.storedOffset = col.offset = record.offset;
+        col.sparse = record.sparse;
+        col.scale = record.scale;
+        shape = reinterpret_cast<const uint32_t*>( p + offsetof( ColumnRecord, shape ) );
+      }
+      if ( nDims > ShardWriter::MAX_DIMS || static_cast<uint32_t>( col.type ) > 2 ) {
+        throw std::runtime_error( "ImageShard: bad column " + col.name + " in " + file );
+      }
+      for ( uint32_t iD = 0; iD < nDims; iD++ ) col.shape.push_back( shape[iD] );
+      columns_.push_back( col );
+    }
+
+    if ( rowBytes_ == 0 && nRows_ > 0 ) {
+      size_t table = 8*( nRows_+1 );
+      if ( table > schema ) throw std::runtime_error( "ImageShard: " + file + " is truncated" );
+      rowOffsets_ = reinterpret_cast<const uint64_t*>( data_ + schema - table );
+    } else if ( rowBytes_*nRows_ > schema ) {
+      throw std::runtime_error( "ImageShard: " + file + " is truncated" );
+    }
+
+  } // open()
+
+  void ShardReader::close () {
+    if ( data_ ) munmap( const_cast<char*>( data_ ), mapBytes_ );
+    if ( fd_ >= 0 ) ::close( fd_ );
+    data_ = nullptr;
+    fd_ = -1;
+    mapBytes_ = 0;
+    nRows_ = 0;
+    rowBytes_ = 0;
+    rowOffsets_ = nullptr;
+    columns_.clear();
+  }
+
+  int ShardReader::column ( const std::string& name ) const {
+    for ( unsigned int iC = 0; iC < columns_.size(); iC++ ) {
+      if ( columns_[iC].name == name ) return iC;
+    }
+    return -1;
+  }
+
+  void ShardReader::decodeFloat ( const char* row, const ShardColumn& col, float* out,
+                                  const float* shift, const float* factor ) const {
+
+    size_t size = col.size();
+    size_t nChannels = col.shape.empty() ? 1 : col.shape[0];
+    size_t channelSize = size/nChannels;
+    const char* slot = row + col.storedOffset;
+
+    if ( col.sparse ) {
+      SparseSlot sparse;
+      std::memcpy( &sparse, slot, sizeof( sparse ) );
+      for ( size_t iC = 0; iC < nChannels; iC++ ) {
+        float zero = shift ? -shift[iC]*factor[iC] : 0.;
+        std::fill( out + iC*channelSize, out + ( iC+1 )*channelSize, zero );
+      }
+      const char* indices = row + sparse.offset;
+      const char* values = indices + 4*sparse.n;
+      for ( uint32_t i = 0; i < sparse.n; i++ ) {
+        uint32_t idx;
+        std::memcpy( &idx, indices + 4*i, 4 );
+        if ( idx >= size ) throw std::runtime_error( "ImageShard: bad sparse index in " + col.name + " of " + file_ );
+        float value;
+        if ( col.scale > 0. ) {
+          int16_t q;
+          std::memcpy( &q, values + 2*i, 2 );
+          value = q*col.scale;
+        } else {
+          std::memcpy( &value, values + 4*i, 4 );
+        }
+        if ( shift ) {
+          size_t iC = idx/channelSize;
+          value = ( value - shift[iC] )*factor[iC];
+        }
+        out[idx] = value;
+      }
+      return;
+    }
+
+    switch ( col.type ) {
+      case ShardType::Float32:
+        if ( col.scale > 0. ) {
+          const int16_t* q = reinterpret_cast<const int16_t*>( slot );
+          for ( size_t i = 0; i < size; i++ ) out[i] = q[i]*col.scale;
+        } else {
+          std::memcpy( out, slot, 4*size );
+        }
+        break;
+      case ShardType::Int32:
+        for ( size_t i = 0; i < size; i++ ) out[i] = reinterpret_cast<const int32_t*>( slot )[i];
+        break;
+      case ShardType::Int64:
+        for ( size_t i = 0; i < size; i++ ) out[i] = reinterpret_cast<const int64_t*>( slot )[i];
+        break;
+    }
+    if ( shift ) {
+      for ( size_t iC = 0; iC < nChannels; iC++ ) {
+        float s = shift[iC], f = factor[iC];
+        float* channel = out + iC*channelSize;
+        for ( size_t i = 0; i < channelSize; i++ ) channel[i] = ( channel[i] - s )*f;
+      }
+    }
+
+  } // decodeFloat()
+
+  void ShardReader::decodeInt ( const char* row, const ShardColumn& col, void* out ) const {
+    if ( col.type == ShardType::Float32 ) throw std::runtime_error( "ImageShard: column " + col.name + " is not an integer" );
+    std::memcpy( out, row + col.storedOffset, col.nBytes() );
+  }
+
+} // namespace img
@@ -0,0 +1,74 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/Prescaler.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/Hash.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+namespace img {
+
+  // Bin of v in edges, -1 outside
+  static int findBin ( const std::vector<double>& edges, double v ) {
+    if ( v < edges.front() || v >= edges.back() ) return -1;
+    return int( std::upper_bound( edges.begin(), edges.end(), v ) - edges.begin() ) - 1;
+  }
+
+  void Prescaler::configure ( const std::vector<double>& xEdges, const std::vector<double>& yEdges,
+                              const std::vector<double>& keepProb, unsigned int seed ) {
+
+    seed_ = seed;
+    xEdges_.clear();
+    yEdges_.clear();
+    keepProb_.clear();
+    if ( xEdges.empty() && yEdges.empty() && keepProb.empty() ) return;
+
+    std::ostringstream err;
+    if ( xEdges.size() < 2 || yEdges.size() < 2 ) {
+      err << "Prescaler: need at least 2 x and 2 y edges";
+    } else if ( !std::is_sorted( xEdges.begin(), xEdges.end() ) || !std::is_sorted( yEdges.begin(), yEdges.end() ) ) {
+      err << "Prescaler: edges must be increasing";
+    } else if ( keepProb.size() != ( xEdges.size()-1 )*( yEdges.size()-1 ) ) {
+      err << "Prescaler: " << keepProb.size() << " keep probabilities for "
+          << xEdges.size()-1 << "x" << yEdges.size()-1 << " bins";
+    } else {
+      for ( double p : keepProb ) {
+        if ( p >= 0. && p <= 1. ) continue;
+        err << "Prescaler: keep probability " << p << " not in [0,1]";
+        break;
+      }
+    }
+    if ( !err.str().empty() ) throw std::runtime_error( err.str() );
+
+    xEdges_ = xEdges;
+    yEdges_ = yEdges;
+    keepProb_ = keepProb;
+
+  } // configure()
+
+  double Prescaler::keepProb ( double x, double y ) const {
+    if ( empty() ) return 1.;
+    int iX = findBin( xEdges_, x );
+    int iY = findBin( yEdges_, y );
+    if ( iX < 0 || iY < 0 ) return 1.;
+    return keepProb_[ iX*( yEdges_.size()-1 ) + iY ];
+  }
+
+  double Prescaler::sample ( double x, double y, unsigned int run, unsigned int lumi,
+                             unsigned long long event, int idx ) const {
+    double p = keepProb( x, y );
+    if ( p >= 1. ) return 1.;
+    if ( p <= 0. ) return 0.;
+    return uniform( run, lumi, event, idx, seed_ ) < p ? 1./p : 0.;
+  }
+
+  double Prescaler::uniform ( unsigned int run, unsigned int lumi,
+                              unsigned long long event, int idx, unsigned int seed ) {
+    uint64_t h = mix( ( uint64_t( seed ) << 32 ) | run );
+    h = mix( h ^ ( ( uint64_t( lumi ) << 32 ) | uint32_t( idx ) ) );
+    h = mix( h ^ event );
+    // Top 53 bits
+    return ( h >> 11 )*( 1./9007199254740992. );
+  }
+
+} // namespace img
@@ -0,0 +1,334 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ShardLoader.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/Hash.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace img {
+
+  // Rows of a shard kept together when shuffling
+  static const long long ROW_BLOCK = 256;
+
+  // Counter-based generator, the same sequence on every platform
+  // (unlike std::shuffle)
+  struct Random {
+    uint64_t state;
+    uint64_t below ( uint64_t n ) { return mix( state++ ) % n; }
+    template <typename T>
+    void shuffle ( std::vector<T>& v ) {
+      for ( size_t i = v.size(); i > 1; i-- ) std::swap( v[i-1], v[below( i )] );
+    }
+  };
+
+  ShardLoader::~ShardLoader () {
+    stop();
+  }
+
+  void ShardLoader::open ( const Config& config ) {
+
+    stop();
+    if ( config.files.empty() ) throw std::runtime_error( "ShardLoader: no shards" );
+    if ( config.batchSize < 1 || config.nThreads < 1 || config.prefetch < 1 ) {
+      throw std::runtime_error( "ShardLoader: batch size, threads and prefetch must be >= 1" );
+    }
+    config_ = config;
+    readers_.clear();
+    columnIndex_.clear();
+    columns_.clear();
+    outBytes_.clear();
+    augmentRatio_.clear();
+    nRows_ = 0;
+
+    for ( const std::string& file : config_.files ) {
+      readers_.emplace_back( new ShardReader );
+      ShardReader& reader = *readers_.back();
+      reader.open( file );
+      nRows_ += reader.nRows();
+
+      // Columns of the first shard, matched by name in the others
+      if ( columns_.empty() ) {
+        std::vector<std::string> names = config_.columns;
+        if ( names.empty() ) {
+          for ( const ShardColumn& col : reader.columns() ) names.push_back( col.name );
+        }
+        for ( const std::string& name : names ) {
+          int iC = reader.column( name );
+          if ( iC < 0 ) throw std::runtime_error( "ShardLoader: no column " + name + " in " + file );
+          ShardColumn col = reader.columns()[iC];
+          col.sparse = false;
+          col.scale = 0.;
+          col.offset = col.storedOffset = 0;
+          columns_.push_back( col );
+          outBytes_.push_back( col.type == ShardType::Float32 ? 4*col.size() : col.nBytes() );
+        }
+      }
+      std::vector<int> index;
+      for ( const ShardColumn& col : columns_ ) {
+        int iC = reader.column( col.name );
+        if ( iC < 0 || reader.columns()[iC].type != col.type || reader.columns()[iC].shape != col.shape ) {
+          throw std::runtime_error( "ShardLoader: column " + col.name + " of " + file + " differs from " + config_.files.front() );
+        }
+        index.push_back( iC );
+      }
+      columnIndex_.push_back( index );
+    }
+    nShardColumns_ = columns_.size();
+    shift_.assign( columns_.size(), std::vector<float>() );
+    factor_.assign( columns_.size(), std::vector<float>() );
+    augmentRatio_.assign( columns_.size(), 0 );
+
+  } // open()
+
+  void ShardLoader::setNormalization ( const std::string& column, const std::vector<float>& mean, const std::vector<float>& std ) {
+
+    auto it = std::find_if( columns_.begin(), columns_.end(), [&]( const ShardColumn& c ) { return c.name == column; } );
+    if ( it == columns_.end() ) throw std::runtime_error( "ShardLoader: no column " + column );
+    if ( it->type != ShardType::Float32 ) throw std::runtime_error( "ShardLoader: column " + column + " is not float" );
+    size_t nChannels = it->shape.empty() ? 1 : it->shape[0];
+    if ( mean.size() != nChannels || std.size() != nChannels ) {
+      throw std::runtime_error( "ShardLoader: " + std::to_string( nChannels ) + " channels in column " + column );
+    }
+    // Not while workers are decoding with the current values
+    stop();
+    size_t iC = it - columns_.begin();
+    shift_[iC] = mean;
+    factor_[iC].resize( nChannels );
+    for ( size_t i = 0; i < nChannels; i++ ) factor_[iC][i] = std[i] > 0. ? 1./std[i] : 1.;
+
+  } // setNormalization()
+
+  void ShardLoader::setAugmentation ( const std::vector<std::string>& columns, const AugmentConfig& config ) {
+
+    if ( readers_.empty() ) throw std::runtime_error( "ShardLoader: not open" );
+    if ( columns_.size() > nShardColumns_ ) throw std::runtime_error( "ShardLoader: augmentation already set" );
+    if ( columns.empty() ) throw std::runtime_error( "ShardLoader: no columns to augment" );
+
+    auto find = [&]( const std::string& name ) {
+      for ( size_t iC = 0; iC < nShardColumns_; iC++ ) {
+        if ( columns_[iC].name != name ) continue;
+        if ( columns_[iC].type != ShardType::Float32 || columns_[iC].shape.size() != 3 ) {
+          throw std::runtime_error( "ShardLoader: column " + name + " is not a float (C,H,W) image" );
+        }
+        return iC;
+      }
+      throw std::runtime_error( "ShardLoader: no column " + name );
+    };
+
+    // Transforms are drawn for the first column
+    const ShardColumn& ref = columns_[find( columns[0] )];
+    int nRows = ref.shape[1], nCols = ref.shape[2];
+    int cropRows = config.cropRows > 0 ? config.cropRows : nRows;
+    int cropCols = config.cropCols > 0 ? config.cropCols : nCols;
+    if ( cropRows > nRows || cropCols > nCols ) throw std::runtime_error( "ShardLoader: crop larger than " + ref.name );
+    drawAugmentation( config, nRows, nCols, 0, 0 ); // checks the step
+
+    std::vector<int> ratios( nShardColumns_, 0 );
+    for ( const std::string& name : columns ) {
+      size_t iC = find( name );
+      const ShardColumn& col = columns_[iC];
+      int ratio = nCols/col.shape[2];
+      if ( ratio < 1 || nRows != ratio*col.shape[1] || nCols != ratio*col.shape[2] ) {
+        throw std::runtime_error( "ShardLoader: column " + name + " is not a whole number of times coarser than " + ref.name );
+      }
+      if ( ( ratio > 1 && config.step % ratio ) || cropRows % ratio || cropCols % ratio
+           || ( nRows - cropRows )/2 % ratio || ( nCols - cropCols )/2 % ratio ) {
+        throw std::runtime_error( "ShardLoader: augmentation of " + ref.name + " is not in whole pixels of " + name );
+      }
+      ratios[iC] = ratio;
+    }
+
+    stop();
+    augment_ = config;
+    augmentRows_ = nRows;
+    augmentCols_ = nCols;
+    for ( size_t iC = 0; iC < nShardColumns_; iC++ ) {
+      if ( !ratios[iC] ) continue;
+      augmentRatio_[iC] = ratios[iC];
+      columns_[iC].shape = { columns_[iC].shape[0], cropRows/ratios[iC], cropCols/ratios[iC] };
+      outBytes_[iC] = 4*columns_[iC].size();
+    }
+    ShardColumn transform{ "augment", ShardType::Int32, { 4 } };
+    columns_.push_back( transform );
+    outBytes_.push_back( transform.nBytes() );
+
+  } // setAugmentation()
+
+  long long ShardLoader::nBatches () const {
+    return config_.dropLast ? nRows_/config_.batchSize : ( nRows_ + config_.batchSize-1 )/config_.batchSize;
+  }
+
+  void ShardLoader::startEpoch ( int epoch ) {
+
+    stop();
+    if ( readers_.empty() ) throw std::runtime_error( "ShardLoader: not open" );
+
+    // Order of the epoch
+    epoch_ = epoch;
+    Random random{ mix( config_.seed ^ mix( epoch ) ) };
+    bool shuffle = config_.shuffleBuffer > 1;
+    std::vector<int> files( readers_.size() );
+    std::iota( files.begin(), files.end(), 0 );
+    if ( shuffle ) random.shuffle( files );
+
+    order_.clear();
+    order_.reserve( nRows_ );
+    std::vector<Sample> buffer;
+    for ( int iF : files ) {
+      long long n = readers_[iF]->nRows();
+      std::vector<long long> blocks( ( n + ROW_BLOCK-1 )/ROW_BLOCK );
+      std::iota( blocks.begin(), blocks.end(), 0LL );
+      if ( shuffle ) random.shuffle( blocks );
+      for ( long long block : blocks ) {
+        for ( long long row = block*ROW_BLOCK; row < std::min( n, ( block+1 )*ROW_BLOCK ); row++ ) {
+          Sample sample{ iF, row };
+          if ( !shuffle ) {
+            order_.push_back( sample );
+          } else if ( buffer.size() < size_t( config_.shuffleBuffer ) ) {
+            buffer.push_back( sample );
+          } else {
+            size_t k = random.below( buffer.size() );
+            order_.push_back( buffer[k] );
+            buffer[k] = sample;
+          }
+        }
+      }
+    }
+    random.shuffle( buffer );
+    order_.insert( order_.end(), buffer.begin(), buffer.end() );
+
+    // Batches and workers
+    nEpochBatches_ = nBatches();
+    batches_.resize( config_.prefetch );
+    for ( Batch& batch : batches_ ) {
+      batch.columns.resize( columns_.size() );
+      for ( size_t iC = 0; iC < columns_.size(); iC++ ) batch.columns[iC].resize( config_.batchSize*outBytes_[iC] );
+      batch.index = -1;
+    }
+    nextFill_ = 0;
+    nextRead_ = 0;
+    holding_ = false;
+    error_ = nullptr;
+    for ( int iT = 0; iT < config_.nThreads; iT++ ) workers_.emplace_back( &ShardLoader::work, this );
+
+  } // startEpoch()
+
+  int ShardLoader::next ( std::vector<const void*>& data ) {
+
+    std::unique_lock<std::mutex> lock( mutex_ );
+    if ( holding_ ) {
+      batches_[( nextRead_-1 ) % config_.prefetch].index = -1;
+      holding_ = false;
+      freed_.notify_all();
+    }
+    if ( nextRead_ >= nEpochBatches_ ) return 0;
+
+    Batch& batch = batches_[nextRead_ % config_.prefetch];
+    filled_.wait( lock, [&]() { return batch.index == nextRead_ || error_; } );
+    if ( error_ ) std::rethrow_exception( error_ );
+
+    data.clear();
+    for ( const std::vector<char>& column : batch.columns ) data.push_back( column.data() );
+    holding_ = true;
+    long long first = nextRead_*config_.batchSize;
+    nextRead_++;
+    return std::min<long long>( config_.batchSize, order_.size() - first );
+
+  } // next()
+
+  void ShardLoader::stop () {
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      stopping_ = true;
+    }
+    freed_.notify_all();
+    for ( std::thread& worker : workers_ ) worker.join();
+    workers_.clear();
+    stopping_ = false;
+    nEpochBatches_ = 0;
+    holding_ = false;
+  }
+
+  void ShardLoader::work () {
+
+    while ( true ) {
+
+      long long iB;
+      {
+        std::unique_lock<std::mutex> lock( mutex_ );
+        // Batch iB goes in the slot of batch iB - prefetch, once returned and freed
+        freed_.wait( lock, [&]() {
+          return stopping_ || error_ || nextFill_ >= nEpochBatches_
+                 || ( nextFill_ < nextRead_ - holding_ + config_.prefetch
+                      && batches_[nextFill_ % config_.prefetch].index < 0 );
+        } );
+        if ( stopping_ || error_ || nextFill_ >= nEpochBatches_ ) return;
+        iB = nextFill_++;
+      }
+
+      Batch& batch = batches_[iB % config_.prefetch];
+      try {
+        fill( iB, batch );
+      } catch ( ... ) {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        if ( !error_ ) error_ = std::current_exception();
+        filled_.notify_all();
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock( mutex_ );
+      batch.index = iB;
+      filled_.notify_all();
+
+    }
+
+  } // work()
+
+  void ShardLoader::fill ( long long iB, Batch& batch ) {
+
+    long long first = iB*config_.batchSize;
+    long long last = std::min<long long>( first + config_.batchSize, order_.size() );
+    bool augment = columns_.size() > nShardColumns_;
+    std::vector<float> image, pad;
+    for ( long long i = first; i < last; i++ ) {
+      const Sample& sample = order_[i];
+      const ShardReader& reader = *readers_[sample.file];
+      const char* row = reader.row( sample.row );
+      Augmentation aug;
+      if ( augment ) {
+        // Keyed by position, so the same for any number of threads
+        aug = drawAugmentation( augment_, augmentRows_, augmentCols_, mix( config_.seed ) ^ mix( ~uint64_t( epoch_ ) ), i );
+        int32_t* out = reinterpret_cast<int32_t*>( batch.columns.back().data() ) + 4*( i-first );
+        out[0] = aug.phiShift;
+        out[1] = aug.etaFlip;
+        out[2] = aug.cropRow;
+        out[3] = aug.cropCol;
+      }
+      for ( size_t iC = 0; iC < nShardColumns_; iC++ ) {
+        const ShardColumn& col = reader.columns()[columnIndex_[sample.file][iC]];
+        char* out = batch.columns[iC].data() + ( i-first )*outBytes_[iC];
+        if ( col.type != ShardType::Float32 ) {
+          reader.decodeInt( row, col, out );
+          continue;
+        }
+        bool norm = !shift_[iC].empty();
+        const float* shift = norm ? shift_[iC].data() : nullptr;
+        const float* factor = norm ? factor_[iC].data() : nullptr;
+        if ( !augmentRatio_[iC] ) {
+          reader.decodeFloat( row, col, reinterpret_cast<float*>( out ), shift, factor );
+          continue;
+        }
+        // Decoded whole, then transformed into the batch
+        image.resize( col.size() );
+        reader.decodeFloat( row, col, image.data(), shift, factor );
+        pad.assign( col.shape[0], 0. );
+        for ( int iP = 0; norm && iP < col.shape[0]; iP++ ) pad[iP] = -shift[iP]*factor[iP];
+        Augmentation scaledAug = scaled( aug, augmentRatio_[iC] );
+        transformImages( image.data(), 1, col.shape[0], col.shape[1], col.shape[2], &scaledAug,
+                         columns_[iC].shape[1], columns_[iC].shape[2], reinterpret_cast<float*>( out ), pad.data() );
+      }
+    }
+
+  } // fill()
+
+} // namespace img
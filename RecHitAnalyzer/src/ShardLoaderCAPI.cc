@@ -0,0 +1,117 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/ShardLoaderCAPI.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ShardLoader.h"
+
+#include <stdexcept>
+#include <string>
+
+static thread_local std::string lastError;
+
+void* img_loader_open ( const char** files, int nFiles, const char** columns, int nColumns,
+                        int batchSize, int nThreads, int shuffleBuffer, unsigned long long seed,
+                        int dropLast, int prefetch ) {
+  img::ShardLoader::Config config;
+  config.files.assign( files, files+nFiles );
+  config.columns.assign( columns, columns+nColumns );
+  config.batchSize = batchSize;
+  config.nThreads = nThreads;
+  config.shuffleBuffer = shuffleBuffer;
+  config.seed = seed;
+  config.dropLast = dropLast != 0;
+  config.prefetch = prefetch;
+  img::ShardLoader* loader = new img::ShardLoader;
+  try {
+    loader->open( config );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    delete loader;
+    return nullptr;
+  }
+  return loader;
+}
+
+void img_loader_close ( void* loader ) {
+  delete static_cast<img::ShardLoader*>( loader );
+}
+
+int img_loader_ncolumns ( void* loader ) {
+  return static_cast<img::ShardLoader*>( loader )->columns().size();
+}
+
+const char* img_loader_column_name ( void* loader, int column ) {
+  return static_cast<img::ShardLoader*>( loader )->columns().at( column ).name.c_str();
+}
+
+int img_loader_column_shape ( void* loader, int column, int* type, int* shape ) {
+  const img::ShardLoader* l = static_cast<img::ShardLoader*>( loader );
+  if ( column < 0 || column >= int( l->columns().size() ) ) {
+    lastError = "ShardLoader: no column " + std::to_string( column );
+    return -1;
+  }
+  const img::ShardColumn& col = l->columns()[column];
+  *type = static_cast<int>( col.type );
+  for ( unsigned int iD = 0; iD < col.shape.size(); iD++ ) shape[iD] = col.shape[iD];
+  return col.shape.size();
+}
+
+long long img_loader_rows ( void* loader ) {
+  return static_cast<img::ShardLoader*>( loader )->nRows();
+}
+
+long long img_loader_batches ( void* loader ) {
+  return static_cast<img::ShardLoader*>( loader )->nBatches();
+}
+
+int img_loader_set_norm ( void* loader, const char* column, const float* mean, const float* std, int n ) {
+  try {
+    static_cast<img::ShardLoader*>( loader )->setNormalization( column, std::vector<float>( mean, mean+n ),
+                                                                 std::vector<float>( std, std+n ) );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+  return 0;
+}
+
+int img_loader_set_augment ( void* loader, const char** columns, int nColumns, int rotate, int reflect,
+                             int step, int cropRows, int cropCols, int jitter ) {
+  img::AugmentConfig config;
+  config.rotate = rotate != 0;
+  config.reflect = reflect != 0;
+  config.step = step;
+  config.cropRows = cropRows;
+  config.cropCols = cropCols;
+  config.jitter = jitter;
+  try {
+    static_cast<img::ShardLoader*>( loader )->setAugmentation( std::vector<std::string>( columns, columns+nColumns ), config );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+  return 0;
+}
+
+int img_loader_start_epoch ( void* loader, int epoch ) {
+  try {
+    static_cast<img::ShardLoader*>( loader )->startEpoch( epoch );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+  return 0;
+}
+
+int img_loader_next ( void* loader, const void** data ) {
+  try {
+    std::vector<const void*> columns;
+    int n = static_cast<img::ShardLoader*>( loader )->next( columns );
+    for ( unsigned int iC = 0; iC < columns.size(); iC++ ) data[iC] = columns[iC];
+    return n;
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+}
+
+const char* img_loader_error () {
+  return lastError.c_str();
+}
@@ -0,0 +1,81 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/SparseRemap.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/ImageKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace img {
+
+  static const double PI = 3.14159265358979323846;
+
+  void etaPhiOverlaps ( const CellBox& box, const EtaPhiGrid& grid,
+                        std::vector<std::pair<int,float> >& overlaps ) {
+
+    double phiWidth = ( grid.phiMax - grid.phiMin )/grid.nPhi;
+
+    // Cell without extent: bin of its corner, as TH2::Fill
+    if ( box.maxEta <= box.minEta || box.maxPhi == box.minPhi ) {
+      int etaBin = findVarBin( box.minEta, grid.nEta, grid.etaEdges );
+      int phiBin = findFixBin( box.minPhi, grid.nPhi, grid.phiMin, grid.phiMax );
+      if ( etaBin < 1 || etaBin > grid.nEta || phiBin < 1 || phiBin > grid.nPhi ) return;
+      overlaps.push_back( std::make_pair( ( etaBin-1 )*grid.nPhi + phiBin-1, 1.f ) );
+      return;
+    }
+
+    // Unwrap phi so that minPhi < maxPhi
+    double minPhi = box.minPhi;
+    double maxPhi = box.maxPhi < box.minPhi ? box.maxPhi + 2*PI : box.maxPhi;
+    double area = ( box.maxEta - box.minEta )*( maxPhi - minPhi );
+
+    for ( int iEta = 0; iEta < grid.nEta; iEta++ ) {
+      double dEta = std::min<double>( box.maxEta, grid.etaEdges[iEta+1] ) - std::max<double>( box.minEta, grid.etaEdges[iEta] );
+      if ( dEta <= 0. ) continue;
+      int firstPhi = int( std::floor( ( minPhi - grid.phiMin )/phiWidth ) );
+      int lastPhi  = int( std::floor( ( maxPhi - grid.phiMin )/phiWidth ) );
+      for ( int iPhi = firstPhi; iPhi <= lastPhi; iPhi++ ) {
+        double lo = grid.phiMin + iPhi*phiWidth;
+        double dPhi = std::min( maxPhi, lo+phiWidth ) - std::max( minPhi, lo );
+        if ( dPhi <= 0. ) continue;
+        int phiBin = ( ( iPhi % grid.nPhi ) + grid.nPhi ) % grid.nPhi;
+        overlaps.push_back( std::make_pair( iEta*grid.nPhi + phiBin, float( dEta*dPhi/area ) ) );
+      }
+    }
+
+  } // etaPhiOverlaps()
+
+  void SparseRemap::build ( int nSrc, int nDst, std::vector<Entry>& entries ) {
+
+    std::sort( entries.begin(), entries.end(), []( const Entry& a, const Entry& b ) {
+      return a.src != b.src ? a.src < b.src : a.dst < b.dst;
+    } );
+
+    nDst_ = nDst;
+    rowStart_.assign( nSrc+1, 0 );
+    dst_.clear();
+    weight_.clear();
+    int lastSrc = -1;
+    for ( const Entry& e : entries ) {
+      if ( e.src == lastSrc && dst_.back() == e.dst ) {
+        weight_.back() += e.weight;
+        continue;
+      }
+      dst_.push_back( e.dst );
+      weight_.push_back( e.weight );
+      rowStart_[e.src+1] = dst_.size();
+      lastSrc = e.src;
+    }
+    // Rows without entries start where the previous one ended
+    for ( int iS = 1; iS <= nSrc; iS++ ) rowStart_[iS] = std::max( rowStart_[iS], rowStart_[iS-1] );
+
+  } // build()
+
+  void SparseRemap::apply ( const float* src, ImageBuffer& dst ) const {
+
+    for ( int iS = 0; iS < nSrc(); iS++ ) {
+      if ( src[iS] == 0. ) continue;
+      for ( int k = rowStart_[iS]; k < rowStart_[iS+1]; k++ ) dst[ dst_[k] ] += src[iS]*weight_[k];
+    }
+
+  } // apply()
+
+} // namespace img
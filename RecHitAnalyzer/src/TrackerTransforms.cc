@@ -0,0 +1,65 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/TrackerTransforms.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace img {
+
+  void TrackerTransforms::clear () {
+    rawIds_.clear();
+    modules_.clear();
+  }
+
+  void TrackerTransforms::add ( unsigned int rawId, const Module& module ) {
+    rawIds_.push_back( rawId );
+    modules_.push_back( module );
+  }
+
+  void TrackerTransforms::finalize () {
+
+    std::vector<int> order( rawIds_.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(), [this]( int a, int b ) { return rawIds_[a] < rawIds_[b]; } );
+
+    std::vector<unsigned int> rawIds;
+    std::vector<Module> modules;
+    rawIds.reserve( order.size() );
+    modules.reserve( order.size() );
+    for ( int i : order ) {
+      rawIds.push_back( rawIds_[i] );
+      modules.push_back( modules_[i] );
+    }
+    rawIds_.swap( rawIds );
+    modules_.swap( modules );
+
+  } // finalize()
+
+  int TrackerTransforms::index ( unsigned int rawId ) const {
+    std::vector<unsigned int>::const_iterator it = std::lower_bound( rawIds_.begin(), rawIds_.end(), rawId );
+    if ( it == rawIds_.end() || *it != rawId ) return -1;
+    return it - rawIds_.begin();
+  }
+
+  void transformHits ( const TrackerTransforms& table, TrackerHitBatch& hits ) {
+
+    int n = hits.size();
+    hits.gx.resize( n );
+    hits.gy.resize( n );
+    hits.gz.resize( n );
+    const int* module = hits.module.data();
+    const float* lx = hits.lx.data();
+    const float* ly = hits.ly.data();
+    const float* lz = hits.lz.data();
+    float* gx = hits.gx.data();
+    float* gy = hits.gy.data();
+    float* gz = hits.gz.data();
+    for ( int i = 0; i < n; i++ ) {
+      const TrackerTransforms::Module& m = table.module( module[i] );
+      gx[i] = m.rot[0]*lx[i] + m.rot[1]*ly[i] + m.rot[2]*lz[i] + m.pos[0];
+      gy[i] = m.rot[3]*lx[i] + m.rot[4]*ly[i] + m.rot[5]*lz[i] + m.pos[1];
+      gz[i] = m.rot[6]*lx[i] + m.rot[7]*ly[i] + m.rot[8]*lz[i] + m.pos[2];
+    }
+
+  } // transformHits()
+
+} // namespace img
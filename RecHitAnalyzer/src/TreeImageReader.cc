@@ -0,0 +1,212 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/TreeImageReader.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TBasket.h"
+#include "TBuffer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace img {
+
+  // Entry header of a vector<float> branch: byte count, version, size
+  static const int HEADER_BYTES = 10;
+  static const uint32_t BYTE_COUNT_MASK = 0x40000000;
+
+  static uint32_t bigEndian32 ( const char* p ) {
+    uint32_t u;
+    std::memcpy( &u, p, 4 );
+    return __builtin_bswap32( u );
+  }
+
+  // 'size' big-endian floats from p into out[i*stride]
+  static void swapFloats ( const char* p, size_t size, float* out, size_t stride ) {
+    for ( size_t i = 0; i < size; i++ ) {
+      uint32_t u = bigEndian32( p + 4*i );
+      std::memcpy( out + i*stride, &u, 4 );
+    }
+  }
+
+  // Check an entry of nBytes at p holds 'size' floats
+  static bool checkEntry ( const char* p, long long nBytes, size_t size ) {
+    if ( nBytes != HEADER_BYTES + 4*(long long)size ) return false;
+    if ( !( bigEndian32( p ) & BYTE_COUNT_MASK ) ) return false;
+    return bigEndian32( p+6 ) == size;
+  }
+
+  // Entry i of a basket: [begin, end) in its buffer
+  static void entryBytes ( TBasket* basket, int i, int& begin, int& end ) {
+    int nEntries = basket->GetNevBuf();
+    int* offsets = basket->GetEntryOffset();
+    if ( offsets ) {
+      begin = offsets[i];
+      end = i+1 < nEntries ? offsets[i+1] : basket->GetLast();
+    } else {
+      // Entries of equal size
+      int size = ( basket->GetLast() - basket->GetKeylen() )/nEntries;
+      begin = basket->GetKeylen() + i*size;
+      end = begin + size;
+    }
+  }
+
+  TreeImageReader::TreeImageReader () {}
+
+  TreeImageReader::~TreeImageReader () {
+    for ( File& file : files_ ) {
+      file.file.reset();
+      for ( Column& column : file.columns ) delete column.object;
+    }
+  }
+
+  void TreeImageReader::open ( const std::vector<std::string>& files, const std::string& treeName,
+                               const std::vector<std::string>& branches, int nRows, int nCols ) {
+
+    if ( !files_.empty() ) throw std::runtime_error( "TreeImageReader: already open" );
+    if ( branches.empty() || nRows < 1 || nCols < 1 ) throw std::runtime_error( "TreeImageReader: no branches or bad shape" );
+    branchNames_ = branches;
+    nRows_ = nRows;
+    nCols_ = nCols;
+
+    nEntries_ = 0;
+    for ( const std::string& name : files ) {
+      File file;
+      file.file.reset( TFile::Open( name.c_str() ) );
+      if ( !file.file || file.file->IsZombie() ) throw std::runtime_error( "TreeImageReader: cannot open " + name );
+      file.tree = dynamic_cast<TTree*>( file.file->Get( treeName.c_str() ) );
+      if ( !file.tree ) throw std::runtime_error( "TreeImageReader: no " + treeName + " in " + name );
+      file.first = nEntries_;
+      file.nEntries = file.tree->GetEntries();
+      nEntries_ += file.nEntries;
+      files_.push_back( std::move( file ) );
+      openColumns( files_.back() );
+    }
+
+  } // open()
+
+  void TreeImageReader::openColumns ( File& file ) {
+
+    size_t size = size_t( nRows_ )*nCols_;
+    file.tree->SetBranchStatus( "*", 0 );
+    file.tree->SetCacheSize( 32 << 20 );
+    // Stable addresses for the streamed objects
+    file.columns.reserve( branchNames_.size() );
+    for ( const std::string& name : branchNames_ ) {
+
+      TBranch* branch = file.tree->GetBranch( name.c_str() );
+      if ( !branch ) throw std::runtime_error( "TreeImageReader: no branch " + name + " in " + file.file->GetName() );
+      file.tree->SetBranchStatus( name.c_str(), 1 );
+      file.tree->AddBranchToCache( branch, true );
+      Column column{ branch, false, nullptr };
+
+      // Raw if the first entry decodes as an unsplit vector<float>
+      TBranchElement* element = dynamic_cast<TBranchElement*>( branch );
+      if ( element && std::string( element->GetClassName() ) == "vector<float>"
+           && branch->GetListOfBranches()->GetEntriesFast() == 0 && file.nEntries > 0 ) {
+        TBasket* basket = branch->GetBasket( 0 );
+        if ( basket && basket->GetNevBuf() > 0 ) {
+          int begin, end;
+          entryBytes( basket, 0, begin, end );
+          column.raw = checkEntry( basket->GetBufferRef()->Buffer() + begin, end-begin, size );
+        }
+      }
+      file.columns.push_back( column );
+      if ( !column.raw ) {
+        file.columns.back().object = new std::vector<float>;
+        file.tree->SetBranchAddress( name.c_str(), &file.columns.back().object );
+      }
+
+    }
+    file.tree->StopCacheLearningPhase();
+
+  } // openColumns()
+
+  void TreeImageReader::read ( long long first, long long last, float* out, bool channelsLast ) {
+
+    if ( first < 0 || last > nEntries_ || first > last ) throw std::runtime_error( "TreeImageReader: entries out of range" );
+
+    size_t nPixels = size_t( nRows_ )*nCols_;
+    size_t nChannels = branchNames_.size();
+    size_t entryStride = nChannels*nPixels;
+    size_t pixelStride = channelsLast ? nChannels : 1;
+    size_t channelStride = channelsLast ? 1 : nPixels;
+
+    for ( File& file : files_ ) {
+      long long begin = std::max( first, file.first );
+      long long end = std::min( last, file.first + file.nEntries );
+      if ( begin >= end ) continue;
+      file.tree->SetCacheEntryRange( begin - file.first, end - file.first );
+      float* fileOut = out + ( begin-first )*entryStride;
+      for ( size_t iC = 0; iC < nChannels; iC++ ) {
+        const Column& column = file.columns[iC];
+        if ( column.raw ) {
+          readRaw( column, begin - file.first, end - file.first, fileOut + iC*channelStride, entryStride, pixelStride );
+        } else {
+          readStreamed( file, column, begin - file.first, end - file.first, fileOut + iC*channelStride, entryStride, pixelStride );
+        }
+      }
+    }
+
+  } // read()
+
+  void TreeImageReader::readRaw ( const Column& column, long long first, long long last, float* out,
+                                  size_t entryStride, size_t pixelStride ) {
+
+    TBranch* branch = column.branch;
+    size_t size = size_t( nRows_ )*nCols_;
+    // First entry of each basket
+    const Long64_t* basketEntry = branch->GetBasketEntry();
+    int nBaskets = branch->GetWriteBasket()+1;
+
+    long long entry = first;
+    while ( entry < last ) {
+      int iB = std::upper_bound( basketEntry, basketEntry + nBaskets, entry ) - basketEntry - 1;
+      // The cache prefetches around the read entry
+      branch->GetTree()->LoadTree( entry );
+      TBasket* basket = branch->GetBasket( iB );
+      if ( !basket ) throw std::runtime_error( std::string( "TreeImageReader: cannot read basket of " ) + branch->GetName() );
+      const char* buffer = basket->GetBufferRef()->Buffer();
+      long long basketEnd = std::min( last, basketEntry[iB] + basket->GetNevBuf() );
+      if ( basketEnd <= entry ) throw std::runtime_error( std::string( "TreeImageReader: entry not in its basket in " ) + branch->GetName() );
+      for ( ; entry < basketEnd; entry++ ) {
+        int begin, end;
+        entryBytes( basket, entry - basketEntry[iB], begin, end );
+        if ( !checkEntry( buffer + begin, end-begin, size ) ) {
+          throw std::runtime_error( std::string( "TreeImageReader: unexpected entry size in " ) + branch->GetName() );
+        }
+        swapFloats( buffer + begin + HEADER_BYTES, size, out + ( entry-first )*entryStride, pixelStride );
+      }
+    }
+
+  } // readRaw()
+
+  void TreeImageReader::readStreamed ( const File& file, const Column& column, long long first, long long last, float* out,
+                                       size_t entryStride, size_t pixelStride ) {
+
+    size_t size = size_t( nRows_ )*nCols_;
+    for ( long long entry = first; entry < last; entry++ ) {
+      if ( column.branch->GetEntry( entry ) <= 0 || column.object->size() != size ) {
+        throw std::runtime_error( std::string( "TreeImageReader: bad entry in " ) + column.branch->GetName()
+                                  + " of " + file.file->GetName() );
+      }
+      float* entryOut = out + ( entry-first )*entryStride;
+      const std::vector<float>& pixels = *column.object;
+      for ( size_t idx = 0; idx < size; idx++ ) entryOut[idx*pixelStride] = pixels[idx];
+    }
+
+  } // readStreamed()
+
+  int TreeImageReader::nRaw () const {
+    if ( files_.empty() ) return 0;
+    return std::count_if( files_.front().columns.begin(), files_.front().columns.end(), []( const Column& c ) { return c.raw; } );
+  }
+
+  int TreeImageReader::nStreamed () const {
+    return files_.empty() ? 0 : nChannels() - nRaw();
+  }
+
+} // namespace img
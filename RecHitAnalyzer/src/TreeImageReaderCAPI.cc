@@ -0,0 +1,47 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/TreeImageReaderCAPI.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/TreeImageReader.h"
+
+#include <stdexcept>
+#include <string>
+
+static thread_local std::string lastError;
+
+void* img_treereader_open ( const char** files, int nFiles, const char* treeName,
+                            const char** branches, int nBranches, int nRows, int nCols ) {
+  img::TreeImageReader* reader = new img::TreeImageReader;
+  try {
+    reader->open( std::vector<std::string>( files, files+nFiles ), treeName,
+                  std::vector<std::string>( branches, branches+nBranches ), nRows, nCols );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    delete reader;
+    return nullptr;
+  }
+  return reader;
+}
+
+void img_treereader_close ( void* reader ) {
+  delete static_cast<img::TreeImageReader*>( reader );
+}
+
+long long img_treereader_entries ( void* reader ) {
+  return static_cast<img::TreeImageReader*>( reader )->nEntries();
+}
+
+int img_treereader_nraw ( void* reader ) {
+  return static_cast<img::TreeImageReader*>( reader )->nRaw();
+}
+
+int img_treereader_read ( void* reader, long long first, long long last, float* out, int channelsLast ) {
+  try {
+    static_cast<img::TreeImageReader*>( reader )->read( first, last, out, channelsLast != 0 );
+  } catch ( std::exception& e ) {
+    lastError = e.what();
+    return -1;
+  }
+  return 0;
+}
+
+const char* img_treereader_error () {
+  return lastError.c_str();
+}
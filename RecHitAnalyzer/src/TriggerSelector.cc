@@ -0,0 +1,43 @@
+#include "MLAnalyzer/RecHitAnalyzer/interface/TriggerSelector.h"
+
+#include <stdexcept>
+
+#include "FWCore/Utilities/interface/RegexMatch.h"
+
+namespace img {
+
+  void TriggerSelector::setMenu ( const edm::TriggerNames& triggerNames ) {
+
+    if ( triggerNames.parameterSetID() == menuId_ && menuId_.isValid() ) return;
+    menuId_ = triggerNames.parameterSetID();
+
+    pathIdxs_.clear();
+    pathNames_.clear();
+    for ( const std::string& pattern : patterns_ ) {
+      for ( auto const& iT : edm::regexMatch( triggerNames.triggerNames(), pattern ) ) {
+        unsigned int idx = triggerNames.triggerIndex( *iT );
+        bool isNew = true;
+        for ( unsigned int known : pathIdxs_ ) isNew = isNew && known != idx;
+        if ( !isNew ) continue;
+        pathIdxs_.push_back( idx );
+        pathNames_.push_back( *iT );
+      }
+    }
+    if ( pathIdxs_.size() > 64 ) {
+      throw std::runtime_error( "TriggerSelector: more than 64 HLT paths matched" );
+    }
+    pathMask_ = pathIdxs_.size() == 64 ? ~uint64_t(0) : ( uint64_t(1) << pathIdxs_.size() ) - 1;
+
+  } // setMenu()
+
+  uint64_t TriggerSelector::acceptedPaths ( const edm::TriggerResults& results ) const {
+
+    uint64_t accepted = 0;
+    for ( unsigned int iP = 0; iP < pathIdxs_.size(); iP++ ) {
+      if ( results.accept( pathIdxs_[iP] ) ) accepted |= uint64_t(1) << iP;
+    }
+    return accepted;
+
+  } // acceptedPaths()
+
+} // namespace img
@@ -1 +1,3 @@
 #include "MLAnalyzer/RecHitAnalyzer/interface/GenTau.h"
+#include "MLAnalyzer/RecHitAnalyzer/interface/DetectorImage.h"
+#include "DataFormats/Common/interface/Wrapper.h"
@@ -0,0 +1,134 @@
+from __future__ import print_function
+import os
+import filecmp
+import argparse
+import subprocess
+import numpy as np
+import ROOT
+from image_shard import read_shard
+
+# Consistency check of convertRHTree (jet mode) on a small synthetic
+# RHTree, written with a fixed seed:
+#  - the shard and its index are byte-identical for --threads 1 and
+#    --threads N, with chunks small enough for every worker to get some
+#  - every row matches the Parquet output of convert_root2pq_jet.py
+#    on the same file, images up to float32 rounding (the script works
+#    in float64)
+# Exits with 1 on any difference. Without --python, only the thread
+# check runs.
+#
+# e.g. python check_convertRHTree.py -o CHECK --threads 8 --python python2
+
+ECAL_SHAPE, HBHE_SHAPE = (280, 360), (56, 72)
+
+def make_input(path, n_events, seed):
+    '''RHTree with sparse random images and jets away from the eta edges
+    (crop_jet only handles crops inside the image), phi wrap included'''
+    rng = np.random.RandomState(seed)
+    f = ROOT.TFile(path, 'RECREATE')
+    f.mkdir('recHitAnalyzer').cd()
+    tree = ROOT.TTree('RHTree', 'RHTree')
+    runId, lumiId, eventId = np.zeros(1, dtype=np.uint32), np.zeros(1, dtype=np.uint32), np.zeros(1, dtype=np.uint64)
+    tree.Branch('runId', runId, 'runId/i')
+    tree.Branch('lumiId', lumiId, 'lumiId/i')
+    tree.Branch('eventId', eventId, 'eventId/l')
+    names = ['ECAL_tracksPt', 'ECAL_energy', 'HBHE_energy', 'jetPt', 'jetPhi', 'jetEta',
+             'jetSeed_iphi', 'jetSeed_ieta', 'jet_truthLabel', 'jet_truthDM']
+    vecs = dict((name, ROOT.std.vector('float')()) for name in names)
+    for name in names:
+        tree.Branch(name, vecs[name])
+    jetIdx = ROOT.std.vector('int')()
+    tree.Branch('jetIdx', jetIdx)
+
+    for iEvt in range(n_events):
+        runId[0], lumiId[0], eventId[0] = 1+iEvt%2, 10+iEvt%3, 1000+iEvt//2
+        for v in vecs.values():
+            v.clear()
+        jetIdx.clear()
+        for name, shape, occ in [('ECAL_tracksPt', ECAL_SHAPE, 0.002), ('ECAL_energy', ECAL_SHAPE, 0.02), ('HBHE_energy', HBHE_SHAPE, 0.05)]:
+            n = shape[0]*shape[1]
+            vecs[name].resize(n, 0.)
+            for i in np.flatnonzero(rng.random_sample(n) < occ):
+                vecs[name][int(i)] = float(rng.exponential(2.))
+        for iJ in range(rng.randint(0, 4)):
+            vecs['jetPt'].push_back(float(rng.uniform(20., 200.)))
+            vecs['jetPhi'].push_back(float(rng.uniform(-np.pi, np.pi)))
+            vecs['jetEta'].push_back(float(rng.uniform(-1.5, 1.5)))
+            vecs['jetSeed_iphi'].push_back(float(rng.randint(0, HBHE_SHAPE[1])))
+            vecs['jetSeed_ieta'].push_back(float(rng.randint(12, 44)))
+            vecs['jet_truthLabel'].push_back(float(rng.randint(0, 2)))
+            vecs['jet_truthDM'].push_back(float(rng.randint(0, 12)))
+            jetIdx.push_back(iJ)
+        tree.Fill()
+
+    f.Write()
+    f.Close()
+
+def convert(exe, infile, outdir, threads, chunk):
+    if not os.path.isdir(outdir):
+        os.makedirs(outdir)
+    subprocess.check_call([exe, '--mode', 'jet', '-i', infile, '-o', outdir, '-d', 'check', '-n', '0',
+                           '--threads', str(threads), '--chunk', str(chunk)])
+    return '%s/check.shard.0'%outdir
+
+def compare_reference(shard_file, pq_file):
+    import pyarrow.parquet as pq
+    shard = read_shard(shard_file)
+    ref = pq.read_table(pq_file).to_pydict()
+    if len(ref['pt']) != len(shard):
+        print(' !! %d rows, reference %d'%(len(shard), len(ref['pt'])))
+        return False
+    ok = True
+    for name in shard.dtype.names:
+        x = np.asarray(shard[name], dtype=np.float64)
+        y = np.array(ref[name], dtype=np.float64).reshape(x.shape)
+        diff = np.abs(x-y).max() if x.size else 0.
+        tol = 1e-6*max(1., np.abs(y).max() if y.size else 0.)
+        print(' >> %-8s max |diff| = %g'%(name, diff))
+        if diff > tol:
+            ok = False
+    return ok
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Check convertRHTree against itself across thread counts and against convert_root2pq_jet.py.')
+    parser.add_argument('-o', '--outdir', default='CHECK', type=str, help='Work directory.')
+    parser.add_argument('-e', '--exe', default='convertRHTree', type=str, help='convertRHTree executable.')
+    parser.add_argument('-n', '--events', default=40, type=int, help='Synthetic events.')
+    parser.add_argument('-s', '--seed', default=1, type=int, help='Synthetic input seed.')
+    parser.add_argument('-j', '--threads', default=4, type=int, help='Threads of the multithreaded conversion.')
+    parser.add_argument('--python', default=None, type=str, help='Interpreter of convert_root2pq_jet.py, to compare against it.')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.outdir):
+        os.makedirs(args.outdir)
+    infile = '%s/RHTree_check.root'%args.outdir
+    make_input(infile, args.events, args.seed)
+    print(' >> Input file:', infile)
+
+    ok = True
+    serial = convert(args.exe, infile, '%s/threads1'%args.outdir, 1, 3)
+    threaded = convert(args.exe, infile, '%s/threads%d'%(args.outdir, args.threads), args.threads, 3)
+    for ext in ['', '.idx']:
+        same = filecmp.cmp(serial+ext, threaded+ext, shallow=False)
+        print(' >> %s: 1 vs %d threads %s'%(os.path.basename(serial+ext), args.threads, 'identical' if same else 'DIFFERENT'))
+        ok = ok and same
+
+    if args.python:
+        script = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'convert_root2pq_jet.py')
+        refdir = '%s/reference'%args.outdir
+        if not os.path.isdir(refdir):
+            os.makedirs(refdir)
+        subprocess.check_call([args.python, script, '-i', infile, '-o', refdir, '-d', 'check', '-n', '0'])
+        same = compare_reference(serial, '%s/check.parquet.0'%refdir)
+        print(' >> convertRHTree vs convert_root2pq_jet.py: %s'%('match' if same else 'DIFFERENT'))
+        ok = ok and same
+
+    print(' >> %s'%('OK' if ok else 'FAILED'))
+    if not ok:
+        raise SystemExit(1)
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
@@ -21,6 +21,15 @@ def load_X(tree, start_, stop_, branches_, readouts, scale):
     X /= scale 
     return X
 
+@delayed
+def load_X_bulk(files, start_, stop_, branches_, readouts, scale, tree='fevt/RHTree'):
+    # As load_X, from the file names: the C++ reader fills the
+    # (events, readouts[0], readouts[1], branches) array directly
+    from rhtree_reader import RHTreeReader
+    X = RHTreeReader(files, branches_, readouts, tree).read(start_, stop_)
+    X /= scale
+    return X
+
 @delayed
 def load_single(tree, start_, stop_, branches_):
     X = tree2array(tree, start=start_, stop=stop_, branches=branches_)
@@ -164,9 +164,10 @@ for iEvt in range(iEvtStart,iEvtEnd):
                 ,rhTree.pho_bdt[i]
             ]
 
-        data['X'] = np.array(rhTree.SC_energy[i]).reshape(1,32,32)
-        sc_energyT = np.array(rhTree.SC_energyT[i]).reshape(1,32,32)
-        sc_energyZ = np.array(rhTree.SC_energyZ[i]).reshape(1,32,32)
+        # SC_* hold the crops of all photons back to back
+        data['X'] = np.array(rhTree.SC_energy).reshape(-1,1,32,32)[i]
+        sc_energyT = np.array(rhTree.SC_energyT).reshape(-1,1,32,32)[i]
+        sc_energyZ = np.array(rhTree.SC_energyZ).reshape(-1,1,32,32)[i]
         data['Xtz'] = np.concatenate((sc_energyT, sc_energyZ), axis=0)
 
         #data['X_aod'] = np.array(rhTree.SCaod_energy[i]).reshape(1,32,32)
@@ -114,7 +114,7 @@ for iEvt in range(iEvtStart,iEvtEnd):
     d['ieta'] = list(rhTree.SC_ieta)
 
     d['X'] = np.array(rhTree.SC_energy).reshape(-1,1,32,32) # nPho, nChannel, nRows, nCols
-    d['Xtz'] = np.transpose([rhTree.SC_energyT, rhTree.SC_energyZ], [1,0,2]).reshape(-1,2,32,32) # nPho, nChannel, nRows, nCols
+    d['Xtz'] = np.concatenate([np.array(rhTree.SC_energyT).reshape(-1,1,32,32), np.array(rhTree.SC_energyZ).reshape(-1,1,32,32)], axis=1) # nPho, nChannel, nRows, nCols
     d['X_aod'] = np.array(rhTree.SCaod_energy).reshape(-1,1,32,32) # nPho, nChannel, nRows, nCols
     d['Xtz_aod'] = np.transpose([rhTree.SCaod_energyT, rhTree.SCaod_energyZ], [1,0,2]).reshape(-1,2,32,32) # nPho, nChannel, nRows, nCols
 
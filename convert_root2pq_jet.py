@@ -10,6 +10,7 @@ from numpy.lib.stride_tricks import as_strided
 print("Numpy related packages imported")
 
 import argparse
+from event_index import write_index
 
 print("Successfully installed packages")
 
@@ -94,6 +95,7 @@ assert iEvtEnd <= nEvts
 print " >> Processing entries: [",iEvtStart,"->",iEvtEnd,")"
 
 nJets = 0
+idx_records = [] # (run, lumi, event, jet, row group, row) for the event index
 data = {} # Arrays to be written to parquet should be saved to data dict
 sw = ROOT.TStopwatch()
 sw.Start()
@@ -126,6 +128,7 @@ for iEvt in range(iEvtStart,iEvtEnd):
     DM = rhTree.jet_truthDM #add DM
     # pdgIds = rhTree.jetPdgIds # Doesn't exist
     njets = len(pts) #change to pt since y doesn't exist
+    jetIdxs = rhTree.jetIdx if rhTree.GetBranch('jetIdx') else range(len(pts)) # older outputs: position
 
     for i in range(njets):
 
@@ -150,10 +153,12 @@ for iEvt in range(iEvtStart,iEvtEnd):
             writer = pq.ParquetWriter(outStr, table.schema, compression='snappy')
 
         writer.write_table(table)
+        idx_records.append((rhTree.runId, rhTree.lumiId, rhTree.eventId, jetIdxs[i], nJets, 0)) # one row group per jet
 
         nJets += 1
 
 writer.close()
+write_index(outStr+'.idx', outStr, idx_records)
 print " >> nJets:",nJets
 print " >> Real time:",sw.RealTime()/60.,"minutes"
 print " >> CPU time: ",sw.CpuTime() /60.,"minutes"
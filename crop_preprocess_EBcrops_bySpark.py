@@ -1,3 +1,5 @@
+# NOTE: superseded by RecHitAnalyzer doEBdigis = True, which writes the
+# pedestal-subtracted 32x32 EB_adc crops directly (see fillEBdigis)
 from pyspark import SparkContext
 from pyspark.sql import SQLContext
 
@@ -0,0 +1,168 @@
+from __future__ import print_function
+import os
+import glob
+import struct
+import ctypes
+import argparse
+
+# Random access to produced images by run:lumi:event[:jet].
+#
+# Every output file <f> carries a sorted index <f>.idx of
+# (run, lumi, event, jet) -> (entry, offset), see
+# RecHitAnalyzer/interface/EventIndex.h for the layout: RHTree entry
+# and jet position for RecHitAnalyzer outputs (written by the
+# analyzer), row group and row for Parquet (written by the converters
+# with write_index()), row and 0 for image shards (written by
+# convertRHTree). Lookups go through the C++ reader of the
+# package library, which only reads the index footers of files whose
+# key range can match.
+#
+# e.g. python event_index.py -i 'IMG/*.idx' find 1:2345:678901
+#      python event_index.py -i 'IMG/*.idx' scan 1:2345:0 1:2346:0
+#      python event_index.py build IMG/output_1.root  # index an older output
+
+RECORD = struct.Struct('<IIQiiqq')   # run lumi event jet pad entry offset
+FOOTER = struct.Struct('<8sIIQQ')    # magic version recordSize nRecords nameLength
+KEY = struct.Struct('<IIQii')        # run lumi event jet pad
+MAGIC = b'IMGIDX01'
+JET_MIN, JET_MAX = -2**31, 2**31-1
+
+def write_index(index_file, data_file, records):
+    '''records: (run, lumi, event, jet, entry, offset) tuples, any order.
+    data_file is stored relative to the index directory.'''
+    records = sorted(records)
+    with open(index_file, 'wb') as f:
+        for r in records:
+            f.write(RECORD.pack(r[0], r[1], r[2], r[3], 0, r[4], r[5]))
+        name = os.path.basename(data_file).encode()
+        f.write(name)
+        f.write(FOOTER.pack(MAGIC, 1, RECORD.size, len(records), len(name)))
+        lo = records[0][:4] if records else (0, 0, 0, 0)
+        hi = records[-1][:4] if records else (0, 0, 0, 0)
+        f.write(KEY.pack(lo[0], lo[1], lo[2], lo[3], 0))
+        f.write(KEY.pack(hi[0], hi[1], hi[2], hi[3], 0))
+
+class Hit(ctypes.Structure):
+    # As img_index_hit
+    _fields_ = [('run', ctypes.c_uint), ('lumi', ctypes.c_uint), ('event', ctypes.c_ulonglong),
+                ('jet', ctypes.c_int), ('file', ctypes.c_int),
+                ('entry', ctypes.c_longlong), ('offset', ctypes.c_longlong)]
+
+def default_lib():
+    if 'IMG_INDEX_LIB' in os.environ:
+        return os.environ['IMG_INDEX_LIB']
+    return '%s/lib/%s/libMLAnalyzerRecHitAnalyzer.so'%(os.environ.get('CMSSW_BASE', '.'), os.environ.get('SCRAM_ARCH', ''))
+
+class EventIndex:
+    '''Index over the .idx files of a dataset, through the C API
+    of RecHitAnalyzer/interface/EventIndexCAPI.h'''
+
+    def __init__(self, index_files, lib=None):
+        self.lib = ctypes.CDLL(lib if lib is not None else default_lib())
+        self.lib.img_index_open.restype = ctypes.c_void_p
+        self.lib.img_index_open.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_int]
+        self.lib.img_index_close.argtypes = [ctypes.c_void_p]
+        self.lib.img_index_find.argtypes = [ctypes.c_void_p, ctypes.c_uint, ctypes.c_uint, ctypes.c_ulonglong, ctypes.c_int,
+                                            ctypes.POINTER(Hit), ctypes.c_int]
+        self.lib.img_index_scan.argtypes = [ctypes.c_void_p] + 2*[ctypes.c_uint, ctypes.c_uint, ctypes.c_ulonglong, ctypes.c_int] \
+                                           + [ctypes.POINTER(Hit), ctypes.c_int]
+        self.lib.img_index_nfiles.argtypes = [ctypes.c_void_p]
+        self.lib.img_index_size.argtypes = [ctypes.c_void_p]
+        self.lib.img_index_size.restype = ctypes.c_longlong
+        self.lib.img_index_file.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self.lib.img_index_file.restype = ctypes.c_char_p
+        self.lib.img_index_error.restype = ctypes.c_char_p
+
+        paths = (ctypes.c_char_p*len(index_files))(*[f.encode() for f in index_files])
+        self.handle = self.lib.img_index_open(paths, len(index_files))
+        if not self.handle:
+            raise IOError(self.lib.img_index_error().decode())
+        self.files = [self.lib.img_index_file(self.handle, i).decode() for i in range(self.lib.img_index_nfiles(self.handle))]
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.lib.img_index_close(self.handle)
+
+    def __len__(self):
+        return self.lib.img_index_size(self.handle)
+
+    def _call(self, fn, *args):
+        # Retry with room for all hits
+        n_max = 16
+        while True:
+            hits = (Hit*n_max)()
+            n = fn(self.handle, *(args + (hits, n_max)))
+            if n < 0:
+                raise IOError(self.lib.img_index_error().decode())
+            if n <= n_max:
+                return [(h.run, h.lumi, h.event, h.jet, self.files[h.file], h.entry, h.offset) for h in hits[:n]]
+            n_max = n
+
+    def find(self, run, lumi, event, jet=-1):
+        '''(run, lumi, event, jet, data file, entry, offset) of all
+        jets of the event if jet < 0'''
+        return self._call(self.lib.img_index_find, run, lumi, event, jet)
+
+    def scan(self, lo, hi):
+        '''All records with lo <= (run, lumi, event[, jet]) <= hi'''
+        lo = tuple(lo) + (JET_MIN,)*(4-len(lo))
+        hi = tuple(hi) + (JET_MAX,)*(4-len(hi))
+        return self._call(self.lib.img_index_scan, *(lo + hi))
+
+def build_root_index(data_file, tree_name):
+    '''Index an existing RecHitAnalyzer output'''
+    import ROOT
+    tf = ROOT.TFile.Open(data_file)
+    tree = tf.Get(tree_name)
+    has_jets = bool(tree.GetBranch('jetIdx'))
+    tree.SetBranchStatus('*', 0)
+    for b in ['runId', 'lumiId', 'eventId'] + (['jetIdx'] if has_jets else []):
+        tree.SetBranchStatus(b, 1)
+    records = []
+    for entry, evt in enumerate(tree):
+        if has_jets:
+            records.extend((evt.runId, evt.lumiId, evt.eventId, j, entry, i) for i, j in enumerate(evt.jetIdx))
+        else:
+            records.append((evt.runId, evt.lumiId, evt.eventId, -1, entry, 0))
+    tf.Close()
+    write_index(data_file+'.idx', data_file, records)
+    print(' >> Output file: %s.idx, %d entries'%(data_file, len(records)))
+
+def parse_key(s):
+    return tuple(int(k) for k in s.split(':'))
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Look up images by run:lumi:event[:jet].')
+    parser.add_argument('-i', '--infiles', default=[], type=str, action='append', help='Index files (wildcards allowed), repeatable.')
+    parser.add_argument('-l', '--lib', default=None, type=str, help='Package library, default $CMSSW_BASE/lib/$SCRAM_ARCH.')
+    parser.add_argument('-t', '--tree', default='fevt/RHTree', type=str, help='RHTree to index, for build.')
+    parser.add_argument('cmd', choices=['find', 'scan', 'build'], help='find key | scan lo hi | build data files')
+    parser.add_argument('args', nargs='+', help='run:lumi:event[:jet] keys or data files.')
+    args = parser.parse_args()
+
+    if args.cmd == 'build':
+        for f in args.args:
+            build_root_index(f, args.tree)
+        return
+
+    files = []
+    for f in args.infiles:
+        files.extend(sorted(glob.glob(f)) if '*' in f else [f])
+    assert len(files) > 0
+    index = EventIndex(files, args.lib)
+    print(' >> %d files, %d entries'%(len(files), len(index)))
+
+    if args.cmd == 'find':
+        hits = index.find(*parse_key(args.args[0]))
+    else:
+        assert len(args.args) == 2
+        hits = index.scan(parse_key(args.args[0]), parse_key(args.args[1]))
+    for run, lumi, event, jet, f, entry, offset in hits:
+        print('%d:%d:%d jet %d -> %s entry %d offset %d'%(run, lumi, event, jet, f, entry, offset))
+    print(' >> %d found'%len(hits))
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
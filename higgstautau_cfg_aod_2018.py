@@ -85,8 +85,43 @@ process.recHitAnalyzer = cms.EDAnalyzer('RecHitAnalyzer'
     , jetTagCollection    = cms.InputTag("pfCombinedInclusiveSecondaryVertexV2BJetTags")
     , ipTagInfoCollection = cms.InputTag("pfImpactParameterTagInfos")
     , mode = cms.string("JetLevel")
+    , trgResults = cms.InputTag("TriggerResults","","HLT")
+    , hltPaths = cms.vstring()
     , PFEBRecHitCollection = cms.InputTag('particleFlowRecHitECAL:Cleaned')
     , PFHBHERecHitCollection = cms.InputTag('particleFlowRecHitHBHE:Cleaned')
+    , geometrySnapshot = cms.string("")
+    , selectionOnly = cms.bool(False)
+    , imagePyramid = cms.VPSet()
+    , writeImages = cms.bool(True)
+    , writeHits = cms.bool(False)
+    , hitListJetDR = cms.double(-1.)
+    , doTRKlayers = cms.bool(False)
+    , doEBdigis = cms.bool(False)
+    , EBDigiCollection = cms.InputTag('simEcalDigis:ebDigis')
+    , ebDigiLayout = cms.string("sampleMajor")
+    , ebDigiSeedSample = cms.int32(6)
+    , parallelFills = cms.bool(False)
+    , detectorImages = cms.InputTag('')
+    , asyncOutputQueue = cms.int32(0)
+    , inference = cms.PSet(
+        modelPath = cms.string(''),
+        inputName = cms.string('input'),
+        outputNames = cms.vstring(),
+        channels = cms.vstring('ECAL_tracksPt', 'ECAL_energy', 'HBHE_energy_up5'),
+        cropSize = cms.int32(125),
+        channelsLast = cms.bool(False),
+        batchSize = cms.int32(64),
+        nThreads = cms.int32(1)
+        )
+    , channelStats = cms.bool(False)
+    , prescale = cms.PSet(
+        xEdges = cms.vdouble(),
+        yEdges = cms.vdouble(),
+        keepProb = cms.vdouble(),
+        seed = cms.uint32(0)
+        )
+    , eventList = cms.string("")
+    , writeEventIndex = cms.bool(True)
 
     # Jet level cfg
     , nJets = cms.int32(-1)
@@ -0,0 +1,92 @@
+from __future__ import print_function
+import os
+import struct
+import argparse
+import numpy as np
+
+# Training shards written by convertRHTree, see
+# RecHitAnalyzer/interface/ImageShard.h for the layout: rows followed
+# by the column table and a footer. read_shard() maps the rows of a
+# shard with fixed-size rows as a numpy structured array, so columns are
+# read straight from the page cache without decoding, e.g.
+# X = shard['X_jet'][i:i+batch]. Quantized columns (convertRHTree
+# --quantize) come out as int16, to be multiplied by column_scales().
+# Shards with sparse columns (--sparse) have rows of varying size and
+# are read with shard_loader.py. The event index of a shard (<shard>.idx,
+# see event_index.py) gives the row of a jet or photon as its entry.
+#
+# e.g. python image_shard.py -i pq/DYToTauTau.shard.1 -c pt -c ieta
+
+FOOTER = struct.Struct('<8sIIQQQ')       # magic version columnSize nColumns nRows rowBytes
+COLUMNS = {1: struct.Struct('<48sII4IQ'), # name type nDims shape[4] offset
+           2: struct.Struct('<40sII4IQIf')} # ... sparse scale
+MAGIC = b'IMGSHD01'
+TYPES = ['<f4', '<i4', '<i8']            # ShardType
+
+def read_columns(path):
+    '''(nRows, rowBytes, [(name, type, shape, offset, sparse, scale)]),
+    rowBytes being 0 for rows of varying size'''
+    with open(path, 'rb') as f:
+        f.seek(0, os.SEEK_END)
+        size = f.tell()
+        if size < FOOTER.size:
+            raise IOError('%s: not an image shard'%path)
+        f.seek(size - FOOTER.size)
+        magic, version, column_size, n_columns, n_rows, row_bytes = FOOTER.unpack(f.read(FOOTER.size))
+        if magic != MAGIC or version not in COLUMNS or column_size != COLUMNS[version].size:
+            raise IOError('%s: not an image shard'%path)
+        f.seek(size - FOOTER.size - n_columns*column_size)
+        columns = []
+        for i in range(n_columns):
+            c = COLUMNS[version].unpack(f.read(column_size))
+            sparse, scale = (c[8], c[9]) if version > 1 else (0, 0.)
+            columns.append((c[0].rstrip(b'\0').decode(), TYPES[c[1]], tuple(c[3:3+c[2]]), c[7], bool(sparse), scale))
+    return n_rows, row_bytes, columns
+
+def read_schema(path):
+    '''(nRows, numpy dtype of a row)'''
+    n_rows, row_bytes, columns = read_columns(path)
+    if row_bytes == 0:
+        raise IOError('%s: sparse columns, read with shard_loader.py'%path)
+    names, formats, offsets = [], [], []
+    for name, dtype, shape, offset, sparse, scale in columns:
+        dtype = '<i2' if scale > 0. else dtype
+        names.append(name)
+        formats.append((dtype, shape) if shape else dtype)
+        offsets.append(offset)
+    return n_rows, np.dtype({'names': names, 'formats': formats, 'offsets': offsets, 'itemsize': row_bytes})
+
+def column_scales(path):
+    '''Scale of each quantized column: value = int16 x scale'''
+    return dict((c[0], c[5]) for c in read_columns(path)[2] if c[5] > 0.)
+
+def read_shard(path):
+    '''Rows of a shard as a read-only structured memmap'''
+    n_rows, dtype = read_schema(path)
+    if n_rows == 0:
+        return np.zeros(0, dtype=dtype)
+    return np.memmap(path, dtype=dtype, mode='r', shape=(n_rows,))
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Print the schema and first rows of an image shard.')
+    parser.add_argument('-i', '--infile', required=True, type=str, help='Input shard.')
+    parser.add_argument('-c', '--columns', default=[], type=str, action='append', help='Scalar columns to print, repeatable.')
+    parser.add_argument('-n', '--nrows', default=5, type=int, help='Rows to print.')
+    args = parser.parse_args()
+
+    n_rows, row_bytes, columns = read_columns(args.infile)
+    print(' >> Input file: %s, %d rows of %s bytes'%(args.infile, n_rows, row_bytes if row_bytes else 'varying'))
+    for name, dtype, shape, offset, sparse, scale in columns:
+        print('    %-12s %-6s %-16s offset %d%s%s'%(name, dtype, shape, offset,
+              ' sparse' if sparse else '', ' scale %g'%scale if scale > 0. else ''))
+    if args.columns:
+        shard = read_shard(args.infile)
+        scales = column_scales(args.infile)
+        for name in args.columns:
+            print(' >> %s:'%name, shard[name][:args.nrows]*scales.get(name, 1))
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
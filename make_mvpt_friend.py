@@ -0,0 +1,136 @@
+from __future__ import print_function
+import os
+import glob
+import numpy as np
+import argparse
+import ROOT
+
+# Mass-vs-pT flattening without re-reading the images.
+#
+# SCRegressor fills the (m0,pT) occupancy of the stored SCs in the
+# 'mvpt' histogram of each job output. This script adds them up over
+# all outputs, derives the drop probabilities of the passes of
+# get_mvpt_weights_dR.py from the histogram alone, and writes per
+# input file a friend tree with, in the RHTree entry order:
+#   runId, lumiId, eventId : to check/join against RHTree
+#   SC_pdrop : probability to drop each SC, over all passes
+#   SC_wgt   : flattening weight <N>/N(m0,pT) of each SC
+# SCs outside the histogram or failing its pT/dR cuts get pdrop = 1,
+# wgt = 0. Only the SC_mass, SC_pT and id branches of RHTree are read.
+#
+# As in the pass loop of get_mvpt_weights_dR.py, an SC draws one random
+# number and is kept only if it is above the drop probability of every
+# pass, i.e. pdrop = max over passes. Pass p sees the occupancy kept
+# with the max over passes 0..p-1.
+#
+# e.g. python make_mvpt_friend.py -i 'IMG/output_*.root' -o WEIGHTS/friends -n 2
+
+def drop_probs(h, p_drop_scale):
+    # As get_mvpt_weights_dR.py, from the pass occupancy h
+    w = h/h.max()
+    floor = np.mean(w.flatten()) - 2.*np.std(w.flatten())
+    if floor < 0.:
+        print(" >> Forcing floor to %f -> 0."%floor)
+        floor = 0.
+    w[w < floor] = floor
+    w = w/w.max()
+    w = w-w.min()
+    return p_drop_scale*w
+
+def find_bin(x, edges):
+    # -1 if out of range
+    i = np.searchsorted(edges, x, side='right')-1
+    return i if 0 <= i < len(edges)-1 else -1
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Write (m0,pT) flattening weights as RHTree friends.')
+    parser.add_argument('-i', '--infiles', required=True, type=str, nargs='+', help='SCRegressor outputs (wildcards allowed).')
+    parser.add_argument('-d', '--dir', default='fevt', type=str, help='Analyzer module label.')
+    parser.add_argument('-o', '--outdir', default='WEIGHTS', type=str, help='Output directory.')
+    parser.add_argument('-n', '--passes', default=2, type=int, help='Number of drop passes.')
+    parser.add_argument('-p', '--p_drop', default=1., type=float, help='p(drop) scale.')
+    parser.add_argument('--minPt', default=20., type=float, help='SC pT cut, as mvptHist.minPt.')
+    parser.add_argument('--maxDR', default=10*0.0174, type=float, help='SC dR cut, as mvptHist.maxDR.')
+    args = parser.parse_args()
+
+    files = []
+    for f in args.infiles:
+        files.extend(sorted(glob.glob(f)) if '*' in f else [f])
+    assert len(files) > 0
+    print(" >> %d input files"%len(files))
+
+    # Merge the occupancy histograms
+    hsum = None
+    for f in files:
+        tf = ROOT.TFile.Open(f)
+        h = tf.Get('%s/mvpt'%args.dir)
+        if hsum is None:
+            hsum = h.Clone('mvpt_sum')
+            hsum.SetDirectory(0)
+        else:
+            hsum.Add(h)
+        tf.Close()
+    nM, nPt = hsum.GetNbinsX(), hsum.GetNbinsY()
+    m_edges = np.array([hsum.GetXaxis().GetBinLowEdge(i+1) for i in range(nM+1)])
+    pt_edges = np.array([hsum.GetYaxis().GetBinLowEdge(i+1) for i in range(nPt+1)])
+    h0 = np.array([[hsum.GetBinContent(i+1, j+1) for j in range(nPt)] for i in range(nM)])
+    print(" >> N(SC) in mvpt:", h0.sum())
+    assert h0.sum() > 0
+
+    # Drop passes on the histogram: expected occupancy after each pass
+    pdrop_all = np.zeros_like(h0)
+    for p in range(args.passes):
+        pdrop = drop_probs(h0*(1.-pdrop_all), args.p_drop)
+        pdrop_all = np.maximum(pdrop_all, pdrop)
+        print(" >> Pass %d: p(drop) min, max: %f, %f, N(SC) kept: %.0f"%(p, pdrop.min(), pdrop.max(), (h0*(1.-pdrop_all)).sum()))
+    wgt = np.zeros_like(h0)
+    wgt[h0 > 0] = h0[h0 > 0].mean()/h0[h0 > 0]
+
+    if not os.path.isdir(args.outdir):
+        os.makedirs(args.outdir)
+    np.savez('%s/mvpt_weights_pdrop%.2f_passes%d.npz'%(args.outdir, args.p_drop, args.passes),
+             mvpt=h0, pdrop=pdrop_all, wgt=wgt, m_edges=m_edges, pt_edges=pt_edges)
+
+    # Friend trees, one per input file
+    for f in files:
+        tf = ROOT.TFile.Open(f)
+        tree = tf.Get('%s/RHTree'%args.dir)
+        tree.SetBranchStatus('*', 0)
+        for b in ['runId', 'lumiId', 'eventId', 'SC_mass', 'SC_pT', 'SC_DR']:
+            tree.SetBranchStatus(b, 1)
+
+        outFileStr = '%s/%s_mvpt.root'%(args.outdir, os.path.basename(f).replace('.root', ''))
+        outFile = ROOT.TFile(outFileStr, 'RECREATE')
+        friend = ROOT.TTree('mvptWeights', 'SC (m0,pT) weights, RHTree friend')
+        runId, lumiId, eventId = np.zeros(1, dtype=np.uint32), np.zeros(1, dtype=np.uint32), np.zeros(1, dtype=np.uint64)
+        SC_pdrop, SC_wgt = ROOT.std.vector('float')(), ROOT.std.vector('float')()
+        friend.Branch('runId', runId, 'runId/i')
+        friend.Branch('lumiId', lumiId, 'lumiId/i')
+        friend.Branch('eventId', eventId, 'eventId/l')
+        friend.Branch('SC_pdrop', SC_pdrop)
+        friend.Branch('SC_wgt', SC_wgt)
+
+        for entry in tree:
+            runId[0], lumiId[0], eventId[0] = entry.runId, entry.lumiId, entry.eventId
+            SC_pdrop.clear()
+            SC_wgt.clear()
+            for m0, pt, dR in zip(entry.SC_mass, entry.SC_pT, entry.SC_DR):
+                i, j = find_bin(m0, m_edges), find_bin(pt, pt_edges)
+                if i < 0 or j < 0 or pt < args.minPt or dR > args.maxDR:
+                    SC_pdrop.push_back(1.)
+                    SC_wgt.push_back(0.)
+                    continue
+                SC_pdrop.push_back(pdrop_all[i, j])
+                SC_wgt.push_back(wgt[i, j])
+            friend.Fill()
+
+        outFile.Write()
+        outFile.Close()
+        tf.Close()
+        print(" >> Output file:", outFileStr)
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
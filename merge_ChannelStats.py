@@ -0,0 +1,110 @@
+from __future__ import print_function
+import os
+import sys
+import json
+import numpy as np
+import argparse
+import ROOT
+
+# Merge the per-channel image statistics written by RecHitAnalyzer
+# (ChannelStats tree, see RecHitAnalyzer/interface/ChannelStats.h)
+# over any number of job outputs, and print/write the normalisation
+# constants: occupancy, mean, std and quantiles of each channel.
+#
+# e.g. python merge_ChannelStats.py -i 'output_*.root' -o channelStats.json
+
+# Must match img::QuantileSketch
+ALPHA = 0.01
+IDX_MIN = -700
+LOG_GAMMA = np.log((1.+ALPHA)/(1.-ALPHA))
+
+def bucket_values(n):
+    idx = np.arange(n) + IDX_MIN
+    return 2.*np.exp(idx*LOG_GAMMA)/(1.+np.exp(LOG_GAMMA))
+
+class Stats:
+    def __init__(self, entry):
+        self.count = float(entry.count)
+        self.nNonZero = float(entry.nNonZero)
+        self.mean = entry.mean
+        self.m2 = entry.m2
+        self.min = entry.min
+        self.max = entry.max
+        self.nZero = float(entry.sketch_nZero)
+        self.pos = np.array(entry.sketch_pos, dtype=np.float64)
+        self.neg = np.array(entry.sketch_neg, dtype=np.float64)
+
+    # Chan et al. pairwise merge, as img::ChannelStats::merge
+    def merge(self, other):
+        if other.count == 0: return
+        n = self.count + other.count
+        delta = other.mean - self.mean
+        self.mean += delta*other.count/n
+        self.m2 += other.m2 + delta*delta*self.count*other.count/n
+        self.min = min(self.min, other.min) if self.count > 0 else other.min
+        self.max = max(self.max, other.max) if self.count > 0 else other.max
+        self.count = n
+        self.nNonZero += other.nNonZero
+        self.nZero += other.nZero
+        self.pos += other.pos
+        self.neg += other.neg
+
+    def std(self):
+        return np.sqrt(self.m2/(self.count-1)) if self.count > 1 else 0.
+
+    # As img::QuantileSketch::quantile
+    def quantile(self, q):
+        values = np.concatenate([-bucket_values(len(self.neg))[::-1], [0.], bucket_values(len(self.pos))])
+        counts = np.concatenate([self.neg[::-1], [self.nZero], self.pos])
+        n = counts.sum()
+        if n == 0: return 0.
+        rank = min(int(q*(n-1)), n-1)
+        return values[np.searchsorted(np.cumsum(counts), rank, side='right')]
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Merge RecHitAnalyzer channel statistics.')
+    parser.add_argument('-i', '--infiles', required=True, type=str, nargs='+', help='Input root files (wildcards allowed).')
+    parser.add_argument('-t', '--tree', default='fevt/ChannelStats', type=str, help='ChannelStats tree, <module label>/ChannelStats.')
+    parser.add_argument('-o', '--outfile', default=None, type=str, help='Output json file.')
+    parser.add_argument('-q', '--quantiles', default=[0.5, 0.9, 0.99, 0.999], type=float, nargs='+', help='Quantiles to report.')
+    args = parser.parse_args()
+
+    tree = ROOT.TChain(args.tree)
+    for f in args.infiles:
+        tree.Add(f)
+    print(" >> Input entries:", tree.GetEntries())
+
+    stats = {}
+    for entry in tree:
+        name = str(entry.name)
+        if name in stats:
+            stats[name].merge(Stats(entry))
+        else:
+            stats[name] = Stats(entry)
+
+    out = {}
+    for name in sorted(stats):
+        s = stats[name]
+        out[name] = {
+            'count': s.count,
+            'occupancy': s.nNonZero/s.count if s.count > 0 else 0.,
+            'mean': s.mean,
+            'std': s.std(),
+            'min': float(s.min),
+            'max': float(s.max),
+            'quantiles': dict(('%g'%q, float(s.quantile(q))) for q in args.quantiles)
+        }
+        print(" >> %s: occupancy %.4g, mean %.4g, std %.4g, max %.4g, quantiles %s"
+              %(name, out[name]['occupancy'], s.mean, s.std(), s.max,
+                ', '.join('q%g=%.4g'%(q, out[name]['quantiles']['%g'%q]) for q in args.quantiles)))
+
+    if args.outfile is not None:
+        with open(args.outfile, 'w') as f:
+            json.dump(out, f, indent=2, sort_keys=True)
+        print(" >> Output file:", args.outfile)
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
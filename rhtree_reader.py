@@ -0,0 +1,97 @@
+from __future__ import print_function
+import time
+import ctypes
+import argparse
+import numpy as np
+from event_index import default_lib
+
+# Bulk reads of RHTree image branches into one preallocated array.
+#
+# RHTreeReader.read() fills a float32 (N, H, W, C) array (or
+# (N, C, H, W)) with the fixed-length vector<float> branches of an
+# entry range, channel c being branches[c], in a single call to the
+# C++ reader of the package library (RecHitAnalyzer/interface/
+# TreeImageReader.h). The reader decodes the baskets directly into
+# the array, so unlike tree2array + np.concatenate/reshape/transpose
+# (load_X in convert_Tree2Dask_utils.py) no Python object is made per
+# event. Pass out= to reuse an array across calls.
+#
+# e.g. python rhtree_reader.py -i output_1.root -b ECAL_tracksPt -b ECAL_energy -s 280 360
+
+class RHTreeReader:
+    '''Reader over the trees of a list of files, through the C API
+    of RecHitAnalyzer/interface/TreeImageReaderCAPI.h'''
+
+    def __init__(self, files, branches, shape, tree='fevt/RHTree', lib=None):
+        self.lib = ctypes.CDLL(lib if lib is not None else default_lib())
+        self.lib.img_treereader_open.restype = ctypes.c_void_p
+        self.lib.img_treereader_open.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_int, ctypes.c_char_p,
+                                                 ctypes.POINTER(ctypes.c_char_p), ctypes.c_int, ctypes.c_int, ctypes.c_int]
+        self.lib.img_treereader_close.argtypes = [ctypes.c_void_p]
+        self.lib.img_treereader_entries.argtypes = [ctypes.c_void_p]
+        self.lib.img_treereader_entries.restype = ctypes.c_longlong
+        self.lib.img_treereader_nraw.argtypes = [ctypes.c_void_p]
+        self.lib.img_treereader_read.argtypes = [ctypes.c_void_p, ctypes.c_longlong, ctypes.c_longlong,
+                                                 ctypes.c_void_p, ctypes.c_int]
+        self.lib.img_treereader_error.restype = ctypes.c_char_p
+
+        self.branches = list(branches)
+        self.shape = tuple(shape)
+        c_files = (ctypes.c_char_p*len(files))(*[f.encode() for f in files])
+        c_branches = (ctypes.c_char_p*len(self.branches))(*[b.encode() for b in self.branches])
+        self.handle = self.lib.img_treereader_open(c_files, len(files), tree.encode(),
+                                                   c_branches, len(self.branches), self.shape[0], self.shape[1])
+        if not self.handle:
+            raise IOError(self.lib.img_treereader_error().decode())
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.lib.img_treereader_close(self.handle)
+
+    def __len__(self):
+        return self.lib.img_treereader_entries(self.handle)
+
+    def n_raw(self):
+        '''Branches decoded from the baskets, the others are streamed'''
+        return self.lib.img_treereader_nraw(self.handle)
+
+    def read(self, start, stop, out=None, channels_last=True):
+        '''Entries [start, stop) as (N, H, W, C), or (N, C, H, W)'''
+        n = stop - start
+        c = len(self.branches)
+        shape = (n,) + self.shape + (c,) if channels_last else (n, c) + self.shape
+        if out is None:
+            out = np.empty(shape, dtype=np.float32)
+        assert out.shape == shape and out.dtype == np.float32 and out.flags['C_CONTIGUOUS']
+        if self.lib.img_treereader_read(self.handle, start, stop, out.ctypes.data, int(channels_last)) < 0:
+            raise IOError(self.lib.img_treereader_error().decode())
+        return out
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Time bulk reads of RHTree image branches.')
+    parser.add_argument('-i', '--infiles', required=True, type=str, nargs='+', help='Input root files.')
+    parser.add_argument('-t', '--tree', default='fevt/RHTree', type=str, help='Tree name.')
+    parser.add_argument('-b', '--branches', required=True, type=str, action='append', help='Image branch, repeatable, in channel order.')
+    parser.add_argument('-s', '--shape', required=True, type=int, nargs=2, help='Image rows and columns.')
+    parser.add_argument('-c', '--chunk', default=256, type=int, help='Entries per read.')
+    parser.add_argument('-l', '--lib', default=None, type=str, help='Package library, default $CMSSW_BASE/lib/$SCRAM_ARCH.')
+    args = parser.parse_args()
+
+    reader = RHTreeReader(args.infiles, args.branches, args.shape, args.tree, args.lib)
+    n = len(reader)
+    print(' >> %d entries, %d/%d branches read from the baskets'%(n, reader.n_raw(), len(args.branches)))
+    out = None
+    t0 = time.time()
+    for start in range(0, n, args.chunk):
+        stop = min(start + args.chunk, n)
+        out = reader.read(start, stop, out if out is not None and len(out) == stop-start else None)
+    dt = time.time() - t0
+    print(' >> Read in %.2f s (%.1f entries/s)'%(dt, n/dt if dt > 0 else 0.))
+    if out is not None:
+        print(' >> Last chunk:', out.shape, 'sum per channel', out.sum(axis=(0,1,2)))
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()
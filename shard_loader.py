@@ -0,0 +1,180 @@
+from __future__ import print_function
+import json
+import time
+import ctypes
+import argparse
+import numpy as np
+from event_index import default_lib
+
+# Multithreaded training batches from image shards written by
+# convertRHTree (RecHitAnalyzer/interface/ShardLoader.h).
+#
+# The C++ loader reads and decodes the shards in its own threads,
+# ahead of the training loop: sparse columns are expanded, quantized
+# ones dequantized and float columns normalised per channel, so the
+# Python side only receives finished batches. These are numpy views of
+# the loader's buffers, without a copy: a batch is valid until the next
+# one is requested, pass it to the framework (torch.from_numpy(...).to
+# (device), tf.constant(...)) or copy it before then.
+#
+# Image columns can be augmented on the fly (set_augment(), see
+# RecHitAnalyzer/interface/ImageAugment.h): phi rotations, eta
+# reflections and random crops, the same for all channels of a row and,
+# with step=5, for its ECAL and HBHE images. Use step=10 if the ECAL
+# image has its EE resampled in 2x2 blocks (convertRHTree shards), so
+# the rotations do not split the blocks. The transform of each row
+# comes as an extra int32 column 'augment' (phi shift, eta flip, crop
+# row, crop column), e.g. to correct the ieta/iphi targets.
+#
+# The order and augmentation of an epoch depend only on seed and epoch,
+# so a run can be resumed or repeated exactly.
+#
+# e.g. python shard_loader.py -i pq/DYToTauTau.shard.* -c X_jet -c truth -b 32 -j 8 --shuffle 10000
+
+TYPES = [np.float32, np.int32, np.int64]  # ShardType
+
+def channel_norm(stats_file, channels):
+    '''(mean, std) of the channels from a merge_ChannelStats.py json file'''
+    with open(stats_file) as f:
+        stats = json.load(f)
+    return [stats[c]['mean'] for c in channels], [stats[c]['std'] for c in channels]
+
+class ShardLoader:
+    '''Batch iterator over shards, through the C API of
+    RecHitAnalyzer/interface/ShardLoaderCAPI.h'''
+
+    def __init__(self, files, columns=None, batch_size=32, threads=4, shuffle=0, seed=0,
+                 drop_last=False, prefetch=8, lib=None):
+        self.lib = ctypes.CDLL(lib if lib is not None else default_lib())
+        self.lib.img_loader_open.restype = ctypes.c_void_p
+        self.lib.img_loader_open.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_int,
+                                             ctypes.POINTER(ctypes.c_char_p), ctypes.c_int,
+                                             ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_ulonglong,
+                                             ctypes.c_int, ctypes.c_int]
+        self.lib.img_loader_close.argtypes = [ctypes.c_void_p]
+        self.lib.img_loader_ncolumns.argtypes = [ctypes.c_void_p]
+        self.lib.img_loader_column_name.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self.lib.img_loader_column_name.restype = ctypes.c_char_p
+        self.lib.img_loader_column_shape.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                                     ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+        self.lib.img_loader_rows.argtypes = [ctypes.c_void_p]
+        self.lib.img_loader_rows.restype = ctypes.c_longlong
+        self.lib.img_loader_batches.argtypes = [ctypes.c_void_p]
+        self.lib.img_loader_batches.restype = ctypes.c_longlong
+        self.lib.img_loader_set_norm.argtypes = [ctypes.c_void_p, ctypes.c_char_p,
+                                                 ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float), ctypes.c_int]
+        self.lib.img_loader_set_augment.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), ctypes.c_int,
+                                                    ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+        self.lib.img_loader_start_epoch.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self.lib.img_loader_next.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p)]
+        self.lib.img_loader_error.restype = ctypes.c_char_p
+
+        columns = list(columns) if columns else []
+        c_files = (ctypes.c_char_p*len(files))(*[f.encode() for f in files])
+        c_columns = (ctypes.c_char_p*max(len(columns), 1))(*[c.encode() for c in columns])
+        self.handle = self.lib.img_loader_open(c_files, len(files), c_columns, len(columns),
+                                               batch_size, threads, shuffle, seed, int(drop_last), prefetch)
+        if not self.handle:
+            raise IOError(self.lib.img_loader_error().decode())
+
+        self.batch_size = batch_size
+        self._read_columns()
+
+    def _read_columns(self):
+        '''name, dtype and row shape of each column'''
+        self.columns = []
+        for i in range(self.lib.img_loader_ncolumns(self.handle)):
+            dtype, shape = ctypes.c_int(), (ctypes.c_int*4)()
+            n_dims = self.lib.img_loader_column_shape(self.handle, i, ctypes.byref(dtype), shape)
+            name = self.lib.img_loader_column_name(self.handle, i).decode()
+            self.columns.append((name, TYPES[dtype.value], tuple(shape[:n_dims])))
+        self._data = (ctypes.c_void_p*len(self.columns))()
+
+    def __del__(self):
+        if getattr(self, 'handle', None):
+            self.lib.img_loader_close(self.handle)
+
+    def __len__(self):
+        '''Batches per epoch'''
+        return self.lib.img_loader_batches(self.handle)
+
+    def n_rows(self):
+        return self.lib.img_loader_rows(self.handle)
+
+    def set_norm(self, column, mean, std):
+        '''(x - mean[c])/std[c] for channel c of a float column'''
+        mean = np.ascontiguousarray(mean, dtype=np.float32)
+        std = np.ascontiguousarray(std, dtype=np.float32)
+        c_float_p = ctypes.POINTER(ctypes.c_float)
+        if self.lib.img_loader_set_norm(self.handle, column.encode(), mean.ctypes.data_as(c_float_p),
+                                        std.ctypes.data_as(c_float_p), len(mean)) < 0:
+            raise ValueError(self.lib.img_loader_error().decode())
+
+    def set_augment(self, columns, rotate=False, reflect=False, step=1, crop=(0, 0), jitter=0):
+        '''Transform the image columns, the first being the reference,
+        crop = (rows, cols) of the reference, 0 for no crop'''
+        c_columns = (ctypes.c_char_p*len(columns))(*[c.encode() for c in columns])
+        if self.lib.img_loader_set_augment(self.handle, c_columns, len(columns), int(rotate), int(reflect),
+                                           step, crop[0], crop[1], jitter) < 0:
+            raise ValueError(self.lib.img_loader_error().decode())
+        self._read_columns()
+
+    def epoch(self, epoch):
+        '''Batches of an epoch, dicts of column name -> numpy view'''
+        if self.lib.img_loader_start_epoch(self.handle, epoch) < 0:
+            raise IOError(self.lib.img_loader_error().decode())
+        while True:
+            n = self.lib.img_loader_next(self.handle, self._data)
+            if n < 0:
+                raise IOError(self.lib.img_loader_error().decode())
+            if n == 0:
+                return
+            batch = {}
+            for (name, dtype, shape), ptr in zip(self.columns, self._data):
+                c_type = np.ctypeslib.as_ctypes_type(dtype)
+                buf = ctypes.cast(ptr, ctypes.POINTER(c_type))
+                batch[name] = np.ctypeslib.as_array(buf, shape=(self.batch_size,) + shape)[:n]
+            yield batch
+
+## MAIN ##
+def main():
+
+    parser = argparse.ArgumentParser(description='Time training batches read from image shards.')
+    parser.add_argument('-i', '--infiles', required=True, type=str, nargs='+', help='Input shards.')
+    parser.add_argument('-c', '--columns', default=[], type=str, action='append', help='Column to load, repeatable, default all.')
+    parser.add_argument('-b', '--batch', default=32, type=int, help='Batch size.')
+    parser.add_argument('-j', '--threads', default=4, type=int, help='Reader threads.')
+    parser.add_argument('--shuffle', default=0, type=int, help='Shuffle buffer in rows, 0 for no shuffling.')
+    parser.add_argument('--seed', default=0, type=int, help='Shuffling seed.')
+    parser.add_argument('-e', '--epochs', default=1, type=int, help='Epochs.')
+    parser.add_argument('--norm', default=None, type=str, nargs=2, metavar=('COLUMN', 'JSON'), help='Normalise a column with merge_ChannelStats.py output.')
+    parser.add_argument('--channels', default=[], type=str, nargs='+', help='Channel names of the --norm column, in order.')
+    parser.add_argument('--augment', default=[], type=str, nargs='+', help='Image columns to augment, reference first.')
+    parser.add_argument('--rotate', action='store_true', help='Random phi rotations of the --augment columns.')
+    parser.add_argument('--reflect', action='store_true', help='Random eta reflections of the --augment columns.')
+    parser.add_argument('--step', default=1, type=int, help='Rotation and crop steps, 5 to keep ECAL and HBHE aligned, 10 if the EE is resampled (convertRHTree).')
+    parser.add_argument('--crop', default=[0, 0], type=int, nargs=2, help='Crop rows and columns of the reference.')
+    parser.add_argument('--jitter', default=0, type=int, help='Crop offset from the center, up to +-jitter.')
+    parser.add_argument('-l', '--lib', default=None, type=str, help='Package library, default $CMSSW_BASE/lib/$SCRAM_ARCH.')
+    args = parser.parse_args()
+
+    loader = ShardLoader(args.infiles, args.columns, args.batch, args.threads, args.shuffle, args.seed, lib=args.lib)
+    if args.augment:
+        loader.set_augment(args.augment, args.rotate, args.reflect, args.step, args.crop, args.jitter)
+    print(' >> %d rows, %d batches per epoch'%(loader.n_rows(), len(loader)))
+    for name, dtype, shape in loader.columns:
+        print('    %-12s %-8s %s'%(name, np.dtype(dtype).str, shape))
+    if args.norm is not None:
+        loader.set_norm(args.norm[0], *channel_norm(args.norm[1], args.channels))
+
+    for e in range(args.epochs):
+        t0 = time.time()
+        n = 0
+        for batch in loader.epoch(e):
+            n += len(next(iter(batch.values())))
+        dt = time.time() - t0
+        print(' >> Epoch %d: %d rows in %.2f s (%.1f rows/s)'%(e, n, dt, n/dt if dt > 0 else 0.))
+
+#_____ Call main() ______#
+if __name__ == '__main__':
+    main()